@@ -12,6 +12,7 @@
 		'module_test_sources':
 		[
 			'<@(engine_test_source_files)',
+			'<@(engine_development_test_source_files)',
 			'src/dummystartupstack.cpp',
 		],
 		'module_test_include_dirs':
@@ -126,6 +126,9 @@ void MCBitmapEffectsFinalize(MCBitmapEffectsRef self)
 	if (self == NULL)
 		return;
 
+	// Free the cached blurs.
+	MCGBitmapEffectsCacheRelease(self -> cache);
+
 	// Free the effects object.
 	delete self;
 }
@@ -165,8 +168,11 @@ bool MCBitmapEffectsAssign(MCBitmapEffectsRef& self, MCBitmapEffectsRef src)
 			return false;
 
 		// Copy across the source - since MCBitmapEffects is just a POD type
-		// at the moment this is easy.
+		// at the moment this is easy. The cache belongs to the source, though.
 		memcpy(t_new_self, src, sizeof(MCBitmapEffects));
+		t_new_self -> cache = nil;
+		t_new_self -> generation = 0;
+		t_new_self -> epoch = 0;
 	}
 	else
 		t_new_self = NULL;
@@ -442,6 +448,7 @@ IO_stat MCBitmapEffectsUnpickle(MCBitmapEffectsRef& self, MCObjectInputStream& p
 		return IO_ERROR;
 
 	t_new_self -> mask = 0;
+	t_new_self -> cache = nil;
 
 	// Now read in the contents
 	IO_stat t_stat;
@@ -592,6 +599,49 @@ void MCBitmapEffectsComputeBounds(MCBitmapEffectsRef self, const MCRectangle& p_
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// The number of times the caches of all objects have been invalidated. Each
+// effects object compares this with the epoch it last rendered at.
+static uint32_t s_bitmap_effects_epoch = 0;
+
+void MCBitmapEffectsContentChanged(MCBitmapEffectsRef self)
+{
+	if (self == nil)
+		return;
+
+	self -> generation += 1;
+}
+
+void MCBitmapEffectsInvalidateCaches(void)
+{
+	s_bitmap_effects_epoch += 1;
+}
+
+void MCBitmapEffectsGetCache(MCBitmapEffectsRef self, MCGBitmapEffectsCacheRef& r_cache, uint32_t& r_generation)
+{
+	// Caches are only useful for blur effects.
+	if (self == nil || (self -> mask & kMCBitmapEffectTypeAllBlurBits) == 0)
+	{
+		r_cache = nil;
+		r_generation = 0;
+		return;
+	}
+
+	if (self -> epoch != s_bitmap_effects_epoch)
+	{
+		self -> generation += 1;
+		self -> epoch = s_bitmap_effects_epoch;
+	}
+
+	// If the cache can't be created, the effects are rendered without one.
+	if (self -> cache == nil)
+		MCGBitmapEffectsCacheCreate(self -> cache);
+
+	r_cache = self -> cache;
+	r_generation = self -> generation;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 static void MCBitmapEffectFetchProperty(MCExecContext& ctxt, MCBitmapEffect *effect, MCBitmapEffectProperty p_prop, MCExecValue& r_value)
 {
     if (effect == nil)
@@ -1048,8 +1098,11 @@ bool MCBitmapEffectsSetProperty(MCExecContext& ctxt, MCBitmapEffectsRef& self, M
             if (self == nil)
                 return false;
             
-            // Only need to initialize the mask.
+            // Only need to initialize the mask and cache.
             self -> mask = 0;
+            self -> cache = nil;
+            self -> generation = 0;
+            self -> epoch = 0;
         }
         
         // Now copy in the updated effect.
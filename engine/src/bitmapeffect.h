@@ -21,6 +21,8 @@ struct MCBitmapEffects;
 struct MCExecValue;
 typedef MCBitmapEffects *MCBitmapEffectsRef;
 
+typedef struct __MCGBitmapEffectsCache *MCGBitmapEffectsCacheRef;
+
 void MCBitmapEffectsInitialize(MCBitmapEffectsRef& r_dst);
 void MCBitmapEffectsFinalize(MCBitmapEffectsRef dst);
 
@@ -49,6 +51,18 @@ void MCBitmapEffectsComputeClip(MCBitmapEffectsRef self, const MCRectangle& shap
 // account the effects.
 void MCBitmapEffectsComputeBounds(MCBitmapEffectsRef self, const MCRectangle& shape, MCRectangle& r_bounds);
 
+// This method notes that the content the effects are applied to has changed,
+// so any blurred masks cached from previous renders can't be used.
+void MCBitmapEffectsContentChanged(MCBitmapEffectsRef self);
+
+// This method notes that the content of every object might have changed (for
+// example, because the whole stack is being redrawn).
+void MCBitmapEffectsInvalidateCaches(void);
+
+// This method fetches the cache to use when rendering the effects (creating it
+// if needed), along with the current generation of the content.
+void MCBitmapEffectsGetCache(MCBitmapEffectsRef self, MCGBitmapEffectsCacheRef& r_cache, uint32_t& r_generation);
+
 // This record contains details about a layer which the render method uses to
 // do the drawing.
 struct MCBitmapEffectLayer
@@ -208,6 +222,13 @@ struct MCBitmapEffects
 	
 	// The effect fields.
 	MCBitmapEffect effects[kMCBitmapEffectType_Count];
+	
+	// The blurred masks from previous renders (created on first render), and
+	// the generation of the content they were computed from. These are not
+	// copied when the effects are assigned.
+	MCGBitmapEffectsCacheRef cache;
+	uint32_t generation;
+	uint32_t epoch;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -32,6 +32,12 @@ struct MCBsDiffOutputStream
 };
 
 bool MCBsDiffBuild(MCBsDiffInputStream *old_stream, MCBsDiffInputStream *new_stream, MCBsDiffOutputStream *patch_stream);
+
+// Builds a patch as MCBsDiffBuild() does, but diffing the new file in chunks of
+// the given size rather than ones large enough that most files are a single
+// chunk.
+bool MCBsDiffBuildInChunks(MCBsDiffInputStream *old_stream, MCBsDiffInputStream *new_stream, MCBsDiffOutputStream *patch_stream, uint32_t chunk_size);
+
 bool MCBsDiffApply(MCBsDiffInputStream *patch_stream, MCBsDiffInputStream *input_stream, MCBsDiffOutputStream *output_stream);
 
 #endif
@@ -15,15 +15,249 @@ You should have received a copy of the GNU General Public License
 along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #include "foundation.h"
+#include "graphics.h"
 #include "bsdiff.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
-static bool bsdiffmain(MCBsDiffInputStream *old_stream, MCBsDiffInputStream *new_stream, MCBsDiffOutputStream *patch_stream);
+/* The new file is diffed as independent chunks of this size, which are
+	scanned in parallel. A new file no larger than this is diffed as a
+	single chunk, exactly as it would be in one pass. */
+#define kMCBsDiffChunkSize (16 * 1024 * 1024)
+
+static bool bsdiffmain(MCBsDiffInputStream *old_stream, MCBsDiffInputStream *new_stream, MCBsDiffOutputStream *patch_stream, uint32_t chunk_size);
 
 bool MCBsDiffBuild(MCBsDiffInputStream *p_old_stream, MCBsDiffInputStream *p_new_stream, MCBsDiffOutputStream *p_patch_stream)
 {
-	return bsdiffmain(p_old_stream, p_new_stream, p_patch_stream);
+	return bsdiffmain(p_old_stream, p_new_stream, p_patch_stream, kMCBsDiffChunkSize);
+}
+
+bool MCBsDiffBuildInChunks(MCBsDiffInputStream *p_old_stream, MCBsDiffInputStream *p_new_stream, MCBsDiffOutputStream *p_patch_stream, uint32_t p_chunk_size)
+{
+	if (p_chunk_size == 0)
+		return false;
+	
+	return bsdiffmain(p_old_stream, p_new_stream, p_patch_stream, p_chunk_size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The suffix array of the old file is built with SA-IS (Nong, Zhang & Chan),
+// which takes linear time and, using 32-bit indices, needs little more than the
+// array itself. Each suffix is S-type if it is smaller than the one following
+// it, and L-type otherwise; the types are kept one bit per suffix. The string
+// is treated as ending with a virtual sentinel which is smaller than any
+// character, so byte strings can be sorted without being widened.
+
+static inline bool MCBsDiffSuffixIsS(const uint8_t *p_types, int32_t p_index)
+{
+	return (p_types[p_index >> 3] & (1 << (p_index & 7))) != 0;
+}
+
+static inline void MCBsDiffSuffixSetS(uint8_t *p_types, int32_t p_index)
+{
+	p_types[p_index >> 3] |= (1 << (p_index & 7));
+}
+
+// A leftmost S-type suffix (LMS) is an S-type suffix following an L-type one.
+static inline bool MCBsDiffSuffixIsLMS(const uint8_t *p_types, int32_t p_index)
+{
+	return p_index > 0 && MCBsDiffSuffixIsS(p_types, p_index) && !MCBsDiffSuffixIsS(p_types, p_index - 1);
+}
+
+// Computes the start (or end) of each character's bucket in the suffix array.
+template<typename T>
+static void MCBsDiffSuffixGetBuckets(const T *p_string, int32_t p_length, int32_t *r_buckets, int32_t p_alphabet_size, bool p_end)
+{
+	for(int32_t i = 0; i < p_alphabet_size; i++)
+		r_buckets[i] = 0;
+	for(int32_t i = 0; i < p_length; i++)
+		r_buckets[p_string[i]]++;
+
+	int32_t t_sum;
+	t_sum = 0;
+	for(int32_t i = 0; i < p_alphabet_size; i++)
+	{
+		t_sum += r_buckets[i];
+		r_buckets[i] = p_end ? t_sum : t_sum - r_buckets[i];
+	}
+}
+
+// Places the L-type suffixes, in order, from the sorted suffixes already in the
+// array.
+template<typename T>
+static void MCBsDiffSuffixInduceL(const T *p_string, int32_t *x_suffixes, int32_t p_length, const uint8_t *p_types, int32_t *p_buckets, int32_t p_alphabet_size)
+{
+	MCBsDiffSuffixGetBuckets(p_string, p_length, p_buckets, p_alphabet_size, false);
+
+	// The suffix before the sentinel is always L-type, and comes first as the
+	// sentinel sorts before everything else.
+	x_suffixes[p_buckets[p_string[p_length - 1]]++] = p_length - 1;
+
+	for(int32_t i = 0; i < p_length; i++)
+	{
+		int32_t j;
+		j = x_suffixes[i] - 1;
+		if (j >= 0 && !MCBsDiffSuffixIsS(p_types, j))
+			x_suffixes[p_buckets[p_string[j]]++] = j;
+	}
+}
+
+// Places the S-type suffixes, in order, from the L-type suffixes.
+template<typename T>
+static void MCBsDiffSuffixInduceS(const T *p_string, int32_t *x_suffixes, int32_t p_length, const uint8_t *p_types, int32_t *p_buckets, int32_t p_alphabet_size)
+{
+	MCBsDiffSuffixGetBuckets(p_string, p_length, p_buckets, p_alphabet_size, true);
+
+	for(int32_t i = p_length - 1; i >= 0; i--)
+	{
+		int32_t j;
+		j = x_suffixes[i] - 1;
+		if (j >= 0 && MCBsDiffSuffixIsS(p_types, j))
+			x_suffixes[--p_buckets[p_string[j]]] = j;
+	}
+}
+
+// Fills r_suffixes with the start of each suffix of p_string, in sorted order.
+// The characters of p_string must be less than p_alphabet_size.
+template<typename T>
+static bool MCBsDiffSuffixSort(const T *p_string, int32_t *r_suffixes, int32_t p_length, int32_t p_alphabet_size)
+{
+	if (p_length <= 1)
+	{
+		if (p_length == 1)
+			r_suffixes[0] = 0;
+		return true;
+	}
+
+	uint8_t *t_types;
+	if (!MCMemoryNewArray((p_length + 7) / 8, t_types))
+		return false;
+
+	int32_t *t_buckets;
+	if (!MCMemoryNewArray(p_alphabet_size, t_buckets))
+	{
+		MCMemoryDeleteArray(t_types);
+		return false;
+	}
+
+	// Classify the suffixes, the last being L-type as it is followed by the
+	// sentinel.
+	for(int32_t i = p_length - 2; i >= 0; i--)
+		if (p_string[i] < p_string[i + 1] ||
+				(p_string[i] == p_string[i + 1] && MCBsDiffSuffixIsS(t_types, i + 1)))
+			MCBsDiffSuffixSetS(t_types, i);
+
+	// Sort the LMS substrings by placing the LMS suffixes at the ends of their
+	// buckets and inducing the rest.
+	for(int32_t i = 0; i < p_length; i++)
+		r_suffixes[i] = -1;
+
+	MCBsDiffSuffixGetBuckets(p_string, p_length, t_buckets, p_alphabet_size, true);
+	for(int32_t i = 1; i < p_length; i++)
+		if (MCBsDiffSuffixIsLMS(t_types, i))
+			r_suffixes[--t_buckets[p_string[i]]] = i;
+
+	MCBsDiffSuffixInduceL(p_string, r_suffixes, p_length, t_types, t_buckets, p_alphabet_size);
+	MCBsDiffSuffixInduceS(p_string, r_suffixes, p_length, t_types, t_buckets, p_alphabet_size);
+
+	// Gather the sorted LMS substrings at the front of the array.
+	int32_t t_lms_count;
+	t_lms_count = 0;
+	for(int32_t i = 0; i < p_length; i++)
+		if (MCBsDiffSuffixIsLMS(t_types, r_suffixes[i]))
+			r_suffixes[t_lms_count++] = r_suffixes[i];
+
+	// Name each LMS substring by its rank, equal substrings getting the same
+	// name. LMS suffixes are at least two apart, so halving their position
+	// gives each a distinct slot in the back of the array.
+	for(int32_t i = t_lms_count; i < p_length; i++)
+		r_suffixes[i] = -1;
+
+	int32_t t_name_count, t_previous;
+	t_name_count = 0;
+	t_previous = -1;
+	for(int32_t i = 0; i < t_lms_count; i++)
+	{
+		int32_t t_position;
+		t_position = r_suffixes[i];
+
+		bool t_different;
+		t_different = false;
+		for(int32_t d = 0; ; d++)
+		{
+			if (t_previous == -1 ||
+					t_position + d == p_length || t_previous + d == p_length ||
+					p_string[t_position + d] != p_string[t_previous + d] ||
+					MCBsDiffSuffixIsS(t_types, t_position + d) != MCBsDiffSuffixIsS(t_types, t_previous + d))
+			{
+				t_different = true;
+				break;
+			}
+
+			if (d > 0 && (MCBsDiffSuffixIsLMS(t_types, t_position + d) || MCBsDiffSuffixIsLMS(t_types, t_previous + d)))
+				break;
+		}
+
+		if (t_different)
+		{
+			t_name_count++;
+			t_previous = t_position;
+		}
+
+		r_suffixes[t_lms_count + t_position / 2] = t_name_count - 1;
+	}
+
+	// Pack the names, in string order, at the end of the array to form the
+	// reduced string.
+	for(int32_t i = p_length - 1, j = p_length - 1; i >= t_lms_count; i--)
+		if (r_suffixes[i] >= 0)
+			r_suffixes[j--] = r_suffixes[i];
+
+	// Sort the suffixes of the reduced string, recursing if any names are
+	// repeated.
+	int32_t *t_reduced_suffixes, *t_reduced_string;
+	t_reduced_suffixes = r_suffixes;
+	t_reduced_string = r_suffixes + p_length - t_lms_count;
+
+	bool t_success;
+	t_success = true;
+	if (t_name_count < t_lms_count)
+		t_success = MCBsDiffSuffixSort<int32_t>(t_reduced_string, t_reduced_suffixes, t_lms_count, t_name_count);
+	else
+		for(int32_t i = 0; i < t_lms_count; i++)
+			t_reduced_suffixes[t_reduced_string[i]] = i;
+
+	if (t_success)
+	{
+		// Map the reduced suffixes back to the LMS suffixes they stand for,
+		// place them at the ends of their buckets in order, and induce the
+		// rest.
+		for(int32_t i = 1, j = 0; i < p_length; i++)
+			if (MCBsDiffSuffixIsLMS(t_types, i))
+				t_reduced_string[j++] = i;
+		for(int32_t i = 0; i < t_lms_count; i++)
+			t_reduced_suffixes[i] = t_reduced_string[t_reduced_suffixes[i]];
+		for(int32_t i = t_lms_count; i < p_length; i++)
+			r_suffixes[i] = -1;
+
+		MCBsDiffSuffixGetBuckets(p_string, p_length, t_buckets, p_alphabet_size, true);
+		for(int32_t i = t_lms_count - 1; i >= 0; i--)
+		{
+			int32_t j;
+			j = r_suffixes[i];
+			r_suffixes[i] = -1;
+			r_suffixes[--t_buckets[p_string[j]]] = j;
+		}
+
+		MCBsDiffSuffixInduceL(p_string, r_suffixes, p_length, t_types, t_buckets, p_alphabet_size);
+		MCBsDiffSuffixInduceS(p_string, r_suffixes, p_length, t_types, t_buckets, p_alphabet_size);
+	}
+
+	MCMemoryDeleteArray(t_buckets);
+	MCMemoryDeleteArray(t_types);
+
+	return t_success;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -58,105 +292,6 @@ bool MCBsDiffBuild(MCBsDiffInputStream *p_old_stream, MCBsDiffInputStream *p_new
 
 typedef uint8_t u_char;
 
-static void split(off_t *I,off_t *V,off_t start,off_t len,off_t h)
-{
-	off_t i,j,k,x,tmp,jj,kk;
-
-	if(len<16) {
-		for(k=start;k<start+len;k+=j) {
-			j=1;x=V[I[k]+h];
-			for(i=1;k+i<start+len;i++) {
-				if(V[I[k+i]+h]<x) {
-					x=V[I[k+i]+h];
-					j=0;
-				};
-				if(V[I[k+i]+h]==x) {
-					tmp=I[k+j];I[k+j]=I[k+i];I[k+i]=tmp;
-					j++;
-				};
-			};
-			for(i=0;i<j;i++) V[I[k+i]]=k+j-1;
-			if(j==1) I[k]=-1;
-		};
-		return;
-	};
-
-	x=V[I[start+len/2]+h];
-	jj=0;kk=0;
-	for(i=start;i<start+len;i++) {
-		if(V[I[i]+h]<x) jj++;
-		if(V[I[i]+h]==x) kk++;
-	};
-	jj+=start;kk+=jj;
-
-	i=start;j=0;k=0;
-	while(i<jj) {
-		if(V[I[i]+h]<x) {
-			i++;
-		} else if(V[I[i]+h]==x) {
-			tmp=I[i];I[i]=I[jj+j];I[jj+j]=tmp;
-			j++;
-		} else {
-			tmp=I[i];I[i]=I[kk+k];I[kk+k]=tmp;
-			k++;
-		};
-	};
-
-	while(jj+j<kk) {
-		if(V[I[jj+j]+h]==x) {
-			j++;
-		} else {
-			tmp=I[jj+j];I[jj+j]=I[kk+k];I[kk+k]=tmp;
-			k++;
-		};
-	};
-
-	if(jj>start) split(I,V,start,jj-start,h);
-
-	for(i=0;i<kk-jj;i++) V[I[jj+i]]=kk-1;
-	if(jj==kk-1) I[jj]=-1;
-
-	if(start+len>kk) split(I,V,kk,start+len-kk,h);
-}
-
-static void qsufsort(off_t *I,off_t *V,u_char *old,off_t oldsize)
-{
-	off_t buckets[256];
-	off_t i,h,len;
-
-	for(i=0;i<256;i++) buckets[i]=0;
-	for(i=0;i<oldsize;i++) buckets[old[i]]++;
-	for(i=1;i<256;i++) buckets[i]+=buckets[i-1];
-	for(i=255;i>0;i--) buckets[i]=buckets[i-1];
-	buckets[0]=0;
-
-	for(i=0;i<oldsize;i++) I[++buckets[old[i]]]=i;
-	I[0]=oldsize;
-	for(i=0;i<oldsize;i++) V[i]=buckets[old[i]];
-	V[oldsize]=0;
-	for(i=1;i<256;i++) if(buckets[i]==buckets[i-1]+1) I[buckets[i]]=-1;
-	I[0]=-1;
-
-	for(h=1;I[0]!=-(oldsize+1);h+=h) {
-		len=0;
-		for(i=0;i<oldsize+1;) {
-			if(I[i]<0) {
-				len-=I[i];
-				i-=I[i];
-			} else {
-				if(len) I[i-len]=-len;
-				len=V[I[i]]+1-i;
-				split(I,V,i,len,h);
-				i+=len;
-				len=0;
-			};
-		};
-		if(len) I[i-len]=-len;
-	};
-
-	for(i=0;i<oldsize+1;i++) I[V[i]]=i;
-}
-
 static off_t matchlen(u_char *old,off_t oldsize,u_char *newp,off_t newsize)
 {
 	off_t i;
@@ -167,7 +302,7 @@ static off_t matchlen(u_char *old,off_t oldsize,u_char *newp,off_t newsize)
 	return i;
 }
 
-static off_t search(off_t *I,u_char *old,off_t oldsize,
+static off_t search(int32_t *I,u_char *old,off_t oldsize,
 		u_char *newp,off_t newsize,off_t st,off_t en,off_t *pos)
 {
 	off_t x,y;
@@ -211,11 +346,58 @@ static void offtout(off_t x,u_char *buf)
 	if(x<0) buf[7]|=0x80;
 }
 
-static bool bsdiffmain(MCBsDiffInputStream *p_old_file, MCBsDiffInputStream *p_new_file, MCBsDiffOutputStream *p_patch_file)
+struct MCBsDiffChunk
 {
-	u_char *old,*newp;
-	off_t oldsize,newsize;
-	off_t *I,*V;
+	/* The range of the new file the chunk covers */
+	off_t start, end;
+
+	/* The position in the old file the chunk is diffed from, and the
+		position reached after the diff bytes of its last control entry */
+	off_t old_start, old_end;
+
+	/* Control triples, with the diff and extra bytes being written to
+		db and eb at the start of the chunk */
+	int32_t *ctrl;
+	uindex_t ctrl_count, ctrl_capacity;
+	off_t dblen, eblen;
+
+	bool success;
+};
+
+struct MCBsDiffScan
+{
+	int32_t *I;
+	u_char *old, *newp;
+	off_t oldsize;
+	u_char *db, *eb;
+	MCBsDiffChunk *chunks;
+};
+
+static bool ctrlout(MCBsDiffChunk *c,off_t x,off_t y,off_t z)
+{
+	if(c->ctrl_count+3>c->ctrl_capacity) {
+		uindex_t t_capacity;
+		t_capacity=c->ctrl_capacity;
+		if(!MCMemoryResizeArray(MCMax(t_capacity*2,(uindex_t)48),c->ctrl,t_capacity))
+			return false;
+		c->ctrl_capacity=t_capacity;
+	};
+
+	c->ctrl[c->ctrl_count++]=(int32_t)x;
+	c->ctrl[c->ctrl_count++]=(int32_t)y;
+	c->ctrl[c->ctrl_count++]=(int32_t)z;
+
+	return true;
+}
+
+static void bsdiffscan(void *p_context,uint32_t p_index)
+{
+	MCBsDiffScan *d=(MCBsDiffScan *)p_context;
+	MCBsDiffChunk *c=&d->chunks[p_index];
+	int32_t *I=d->I;
+	u_char *old=d->old,*newp=d->newp;
+	off_t oldsize=d->oldsize,newsize=c->end;
+	u_char *db=d->db+c->start,*eb=d->eb+c->start;
 	off_t scan,pos,len;
 	off_t lastscan,lastpos,lastoffset;
 	off_t oldscore,scsc;
@@ -223,13 +405,111 @@ static bool bsdiffmain(MCBsDiffInputStream *p_old_file, MCBsDiffInputStream *p_n
 	off_t overlap,Ss,lens;
 	off_t i;
 	off_t dblen,eblen;
+
+	dblen=0;
+	eblen=0;
+
+	/* Each chunk starts off assuming the new and old files line up, as a
+		single pass does at the start of the file */
+	scan=c->start;len=0;pos=0;
+	lastscan=c->start;lastpos=MIN(c->start,oldsize);lastoffset=lastpos-lastscan;
+	c->old_start=lastpos;
+	c->success=true;
+	while(c->success && scan<newsize) {
+		oldscore=0;
+
+		for(scsc=scan+=len;scan<newsize;scan++) {
+			len=search(I,old,oldsize,newp+scan,newsize-scan,
+					0,oldsize,&pos);
+
+			for(;scsc<scan+len;scsc++)
+			if((scsc+lastoffset<oldsize) &&
+				(old[scsc+lastoffset] == newp[scsc]))
+				oldscore++;
+
+			if(((len==oldscore) && (len!=0)) || 
+				(len>oldscore+8)) break;
+
+			if((scan+lastoffset<oldsize) &&
+				(old[scan+lastoffset] == newp[scan]))
+				oldscore--;
+		};
+
+		if((len!=oldscore) || (scan==newsize)) {
+			s=0;Sf=0;lenf=0;
+			for(i=0;(lastscan+i<scan)&&(lastpos+i<oldsize);) {
+				if(old[lastpos+i]==newp[lastscan+i]) s++;
+				i++;
+				if(s*2-i>Sf*2-lenf) { Sf=s; lenf=i; };
+			};
+
+			lenb=0;
+			if(scan<newsize) {
+				s=0;Sb=0;
+				for(i=1;(scan>=lastscan+i)&&(pos>=i);i++) {
+					if(old[pos-i]==newp[scan-i]) s++;
+					if(s*2-i>Sb*2-lenb) { Sb=s; lenb=i; };
+				};
+			};
+
+			if(lastscan+lenf>scan-lenb) {
+				overlap=(lastscan+lenf)-(scan-lenb);
+				s=0;Ss=0;lens=0;
+				for(i=0;i<overlap;i++) {
+					if(newp[lastscan+lenf-overlap+i]==
+					   old[lastpos+lenf-overlap+i]) s++;
+					if(newp[scan-lenb+i]==
+					   old[pos-lenb+i]) s--;
+					if(s>Ss) { Ss=s; lens=i+1; };
+				};
+
+				lenf+=lens-overlap;
+				lenb-=lens;
+			};
+
+			for(i=0;i<lenf;i++)
+				db[dblen+i]=newp[lastscan+i]-old[lastpos+i];
+			for(i=0;i<(scan-lenb)-(lastscan+lenf);i++)
+				eb[eblen+i]=newp[lastscan+lenf+i];
+
+			dblen+=lenf;
+			eblen+=(scan-lenb)-(lastscan+lenf);
+
+			c->success=ctrlout(c,lenf,(scan-lenb)-(lastscan+lenf),(pos-lenb)-(lastpos+lenf));
+			c->old_end=lastpos+lenf;
+
+			lastscan=scan-lenb;
+			lastpos=pos-lenb;
+			lastoffset=pos-scan;
+		};
+	};
+
+	c->dblen=dblen;
+	c->eblen=eblen;
+}
+
+static bool bsdiffmain(MCBsDiffInputStream *p_old_file, MCBsDiffInputStream *p_new_file, MCBsDiffOutputStream *p_patch_file, uint32_t p_chunk_size)
+{
+	u_char *old,*newp;
+	off_t oldsize,newsize;
+	int32_t *I;
+	off_t i;
+	off_t dblen,eblen;
 	u_char *db,*eb;
+	MCBsDiffChunk *chunks;
+	uint32_t chunkcount;
 
 	// if(argc!=4) errx(1,"usage: %s oldfile newfile patchfile\n",argv[0]);
 	bool t_success;
 	t_success = true;
-    
-    V = NULL;
+
+	old = NULL;
+	newp = NULL;
+	I = NULL;
+	db = NULL;
+	eb = NULL;
+	chunks = NULL;
+	chunkcount = 0;
 
 	/* Allocate oldsize+1 bytes instead of oldsize bytes to ensure
 		that we never try to malloc(0) and get a NULL pointer */
@@ -254,14 +534,13 @@ static bool bsdiffmain(MCBsDiffInputStream *p_old_file, MCBsDiffInputStream *p_n
 		((V=malloc((oldsize+1)*sizeof(off_t)))==NULL)) err(1,NULL);*/
 	if (t_success)
 		t_success = MCMemoryNewArray(oldsize + 1, I);
-	if (t_success)
-		t_success = MCMemoryNewArray(oldsize + 1, V);
 
-    if (t_success)
-        qsufsort(I,V,old,oldsize);
-
-	/*free(V);*/
-    MCMemoryDeleteArray(V);
+	/* The empty suffix sorts first, followed by the old file's own */
+	if (t_success)
+	{
+		I[0] = oldsize;
+		t_success = MCBsDiffSuffixSort(old, I + 1, oldsize, 256);
+	}
 
 	/* Allocate newsize+1 bytes instead of newsize bytes to ensure
 		that we never try to malloc(0) and get a NULL pointer */
@@ -326,97 +605,55 @@ static bool bsdiffmain(MCBsDiffInputStream *p_old_file, MCBsDiffInputStream *p_n
 	/* Compute the differences, writing ctrl as we go */
 	/*if ((pfbz2 = BZ2_bzWriteOpen(&bz2err, pf, 9, 0, 0)) == NULL)
 		errx(1, "BZ2_bzWriteOpen, bz2err = %d", bz2err);*/
-	scan=0;len=0;
-	lastscan=0;lastpos=0;lastoffset=0;
-	while(t_success && scan<newsize) {
-		oldscore=0;
-
-		for(scsc=scan+=len;scan<newsize;scan++) {
-			len=search(I,old,oldsize,newp+scan,newsize-scan,
-					0,oldsize,&pos);
-
-			for(;scsc<scan+len;scsc++)
-			if((scsc+lastoffset<oldsize) &&
-				(old[scsc+lastoffset] == newp[scsc]))
-				oldscore++;
-
-			if(((len==oldscore) && (len!=0)) || 
-				(len>oldscore+8)) break;
+	if (t_success)
+	{
+		chunkcount = (uint32_t)((newsize + p_chunk_size - 1) / p_chunk_size);
+		t_success = MCMemoryNewArray(chunkcount, chunks);
+	}
 
-			if((scan+lastoffset<oldsize) &&
-				(old[scan+lastoffset] == newp[scan]))
-				oldscore--;
+	if (t_success)
+	{
+		for(i=0;i<chunkcount;i++) {
+			chunks[i].start=i*(off_t)p_chunk_size;
+			chunks[i].end=MIN(newsize,(i+1)*(off_t)p_chunk_size);
 		};
 
-		if((len!=oldscore) || (scan==newsize)) {
-			s=0;Sf=0;lenf=0;
-			for(i=0;(lastscan+i<scan)&&(lastpos+i<oldsize);) {
-				if(old[lastpos+i]==newp[lastscan+i]) s++;
-				i++;
-				if(s*2-i>Sf*2-lenf) { Sf=s; lenf=i; };
-			};
-
-			lenb=0;
-			if(scan<newsize) {
-				s=0;Sb=0;
-				for(i=1;(scan>=lastscan+i)&&(pos>=i);i++) {
-					if(old[pos-i]==newp[scan-i]) s++;
-					if(s*2-i>Sb*2-lenb) { Sb=s; lenb=i; };
-				};
-			};
-
-			if(lastscan+lenf>scan-lenb) {
-				overlap=(lastscan+lenf)-(scan-lenb);
-				s=0;Ss=0;lens=0;
-				for(i=0;i<overlap;i++) {
-					if(newp[lastscan+lenf-overlap+i]==
-					   old[lastpos+lenf-overlap+i]) s++;
-					if(newp[scan-lenb+i]==
-					   old[pos-lenb+i]) s--;
-					if(s>Ss) { Ss=s; lens=i+1; };
-				};
-
-				lenf+=lens-overlap;
-				lenb-=lens;
-			};
-
-			for(i=0;i<lenf;i++)
-				db[dblen+i]=newp[lastscan+i]-old[lastpos+i];
-			for(i=0;i<(scan-lenb)-(lastscan+lenf);i++)
-				eb[eblen+i]=newp[lastscan+lenf+i];
-
-			dblen+=lenf;
-			eblen+=(scan-lenb)-(lastscan+lenf);
-
-			/*offtout(lenf,buf);
-			BZ2_bzWrite(&bz2err, pfbz2, buf, 8);
-			if (bz2err != BZ_OK)
-				errx(1, "BZ2_bzWrite, bz2err = %d", bz2err);
-
-			offtout((scan-lenb)-(lastscan+lenf),buf);
-			BZ2_bzWrite(&bz2err, pfbz2, buf, 8);
-			if (bz2err != BZ_OK)
-				errx(1, "BZ2_bzWrite, bz2err = %d", bz2err);
-
-			offtout((pos-lenb)-(lastpos+lenf),buf);
-			BZ2_bzWrite(&bz2err, pfbz2, buf, 8);
-			if (bz2err != BZ_OK)
-				errx(1, "BZ2_bzWrite, bz2err = %d", bz2err);*/
+		MCBsDiffScan t_scan;
+		t_scan.I=I;
+		t_scan.old=old;
+		t_scan.newp=newp;
+		t_scan.oldsize=oldsize;
+		t_scan.db=db;
+		t_scan.eb=eb;
+		t_scan.chunks=chunks;
+		MCGParallelFor(chunkcount,bsdiffscan,&t_scan);
+	}
 
-			if (t_success)
-				t_success =
-					p_patch_file -> WriteInt32(lenf) &&
-					p_patch_file -> WriteInt32((scan-lenb)-(lastscan+lenf)) &&
-					p_patch_file -> WriteInt32((pos-lenb)-(lastpos+lenf));
+	/* Each chunk ends with the old position wherever its last match left
+		it, so the seek of its last control entry is changed to go to where
+		the next chunk starts from instead. The diff and extra bytes of the
+		chunks are then packed together. */
+	for(i=0;t_success && i<chunkcount;i++) {
+		MCBsDiffChunk *c=&chunks[i];
+		t_success=c->success;
+
+		if(t_success && i+1<chunkcount)
+			c->ctrl[c->ctrl_count-1]=(int32_t)(chunks[i+1].old_start-c->old_end);
+
+		if(t_success) {
+			MCMemoryMove(db+dblen,db+c->start,c->dblen);
+			MCMemoryMove(eb+eblen,eb+c->start,c->eblen);
+			dblen+=c->dblen;
+			eblen+=c->eblen;
+		};
 
-			if (t_success)
-				t_control_size += 12;
+		for(uindex_t j=0;t_success && j<c->ctrl_count;j++)
+			t_success=p_patch_file -> WriteInt32(c->ctrl[j]);
 
-			lastscan=scan-lenb;
-			lastpos=pos-lenb;
-			lastoffset=pos-scan;
-		};
+		if (t_success)
+			t_control_size += c->ctrl_count*4;
 	};
+
 	/*BZ2_bzWriteClose(&bz2err, pfbz2, 0, NULL, NULL);
 	if (bz2err != BZ_OK)
 		errx(1, "BZ2_bzWriteClose, bz2err = %d", bz2err);*/
@@ -480,6 +717,9 @@ static bool bsdiffmain(MCBsDiffInputStream *p_old_file, MCBsDiffInputStream *p_n
 	free(I);
 	free(old);
 	free(new);*/
+	for(i=0;i<chunkcount;i++)
+		MCMemoryDeleteArray(chunks[i].ctrl);
+	MCMemoryDeleteArray(chunks);
 	MCMemoryDeleteArray(db);
 	MCMemoryDeleteArray(eb);
 	MCMemoryDeleteArray(I);
@@ -852,3 +852,82 @@ bool MCCapsuleProcess(MCCapsuleRef self)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+
+bool MCCapsuleDeferredStackSectionRead(IO_handle p_stream, uint32_t p_length, MCCapsuleDeferredStackSection& r_section, MCNameRef& r_name, MCDataRef& r_data)
+{
+	if (p_length < sizeof(MCCapsuleDeferredStackSection))
+		return false;
+
+	MCAutoByteArray t_payload;
+	if (!t_payload . New(p_length - sizeof(MCCapsuleDeferredStackSection)))
+		return false;
+
+	MCCapsuleDeferredStackSection t_section;
+	if (IO_read(&t_section, sizeof(MCCapsuleDeferredStackSection), p_stream) != IO_NORMAL ||
+		IO_read(t_payload . Bytes(), t_payload . ByteCount(), p_stream) != IO_NORMAL)
+		return false;
+
+	// The name is nul-terminated and padded, and the data follows it.
+	uindex_t t_name_length;
+	t_name_length = 0;
+	while(t_name_length < t_payload . ByteCount() && t_payload . Bytes()[t_name_length] != '\0')
+		t_name_length += 1;
+
+	uindex_t t_data_offset;
+	t_data_offset = (t_name_length + 1 + 3) & ~3;
+	if (t_data_offset > t_payload . ByteCount())
+		return false;
+
+	MCAutoStringRef t_name_string;
+	MCNewAutoNameRef t_name;
+	MCAutoDataRef t_data;
+	if (!MCStringCreateWithBytes(t_payload . Bytes(), t_name_length, kMCStringEncodingUTF8, false, &t_name_string) ||
+		!MCNameCreate(*t_name_string, &t_name) ||
+		!MCDataCreateWithBytes(t_payload . Bytes() + t_data_offset, t_payload . ByteCount() - t_data_offset, &t_data))
+		return false;
+
+	r_section . flags = MCSwapInt32NetworkToHost(t_section . flags);
+	r_section . length = MCSwapInt32NetworkToHost(t_section . length);
+	memcpy(r_section . digest, t_section . digest, 16);
+	r_name = t_name . Take();
+	r_data = t_data . Take();
+
+	return true;
+}
+
+bool MCCapsuleInflateDeferredStack(const void *p_data, uint32_t p_data_length, uint32_t p_length, const uint8_t p_digest[16], MCDataRef& r_stackfile)
+{
+	MCAutoByteArray t_stackfile;
+	if (!t_stackfile . New(p_length))
+		return false;
+
+	z_stream t_stream;
+	memset(&t_stream, 0, sizeof(z_stream));
+	if (inflateInit2(&t_stream, -15) != Z_OK)
+		return false;
+
+	t_stream . next_in = (Bytef *)p_data;
+	t_stream . avail_in = p_data_length;
+	t_stream . next_out = (Bytef *)t_stackfile . Bytes();
+	t_stream . avail_out = p_length;
+
+	int t_result;
+	t_result = inflate(&t_stream, Z_FINISH);
+	inflateEnd(&t_stream);
+
+	// The data must be a single complete stream of exactly the expected size.
+	if (t_result != Z_STREAM_END || t_stream . avail_in != 0 || t_stream . avail_out != 0)
+		return false;
+
+	md5_state_t t_md5;
+	md5_byte_t t_digest[16];
+	md5_init(&t_md5);
+	md5_append(&t_md5, (md5_byte_t *)t_stackfile . Bytes(), p_length);
+	md5_finish(&t_md5, t_digest);
+	if (memcmp(t_digest, p_digest, 16) != 0)
+		return false;
+
+	return t_stackfile . CreateDataAndRelease(r_stackfile);
+}
+
+////////////////////////////////////////////////////////////////////////////////
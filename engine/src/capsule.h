@@ -117,6 +117,11 @@ enum MCCapsuleSectionType
 	// MW-2016-02-17: [[ Trial ]] If a banner is present, it is serialized as a
 	//   stackfile in this section.
 	kMCCapsuleSectionTypeBanner,
+
+	// Deferred auxiliary stack sections contain other mainstacks which are
+	// kept compressed when the capsule is loaded, and are only inflated and
+	// loaded the first time they are looked up by name.
+	kMCCapsuleSectionTypeDeferredAuxiliaryStack,
 };
 
 // Each section begins with a header that defines its type and length. This is
@@ -179,6 +184,35 @@ struct MCCapsuleExternalSection
 	// char name[];
 };
 
+// The Deferred Auxiliary Stack section contains the stackfile data for an
+// auxiliary stack, deflated on its own so that it can be inflated later. The
+// name lets the stack be found without inflating it, and the digest is used to
+// check the data when it is.
+struct MCCapsuleDeferredStackSection
+{
+	uint32_t flags;
+	uint32_t length;
+	uint8_t digest[16];
+	// char name[]; (UTF-8, nul-terminated and padded to a 32-bit boundary)
+	// uint8_t data[]; (a complete raw deflate stream)
+};
+
+// The flags of a Deferred Auxiliary Stack section.
+enum
+{
+	// The stackfile is a script-only stack.
+	kMCCapsuleDeferredStackFlagScriptOnly = 1 << 0,
+};
+
+// This method reads a Deferred Auxiliary Stack section of the given length,
+// returning its record (in host byte order), name and deflated data.
+bool MCCapsuleDeferredStackSectionRead(IO_handle stream, uint32_t length, MCCapsuleDeferredStackSection& r_section, MCNameRef& r_name, MCDataRef& r_data);
+
+// This method inflates the data of a Deferred Auxiliary Stack section. It
+// fails if the data doesn't inflate to exactly length bytes that match the
+// digest.
+bool MCCapsuleInflateDeferredStack(const void *data, uint32_t data_length, uint32_t length, const uint8_t digest[16], MCDataRef& r_stackfile);
+
 ////////////////////////////////////////////////////////////////////////////////
 
 // The MCCapsuleRef opaque type represents a capsule while it is being loaded/
@@ -260,6 +294,11 @@ bool MCDeployCapsuleDefineString(MCDeployCapsuleRef self, MCCapsuleSectionType t
 // of the file.
 bool MCDeployCapsuleDefineFromFile(MCDeployCapsuleRef self, MCCapsuleSectionType type, MCDeployFileRef file);
 
+// This method appends a deferred auxiliary stack section for the mainstack
+// with the given name, whose stackfile is held in the given file. The data is
+// read and deflated at this point, so the file need not be kept open.
+bool MCDeployCapsuleDefineDeferredStack(MCDeployCapsuleRef self, MCNameRef name, bool script_only, MCDeployFileRef file);
+
 // This method appends a digest section to the given capsule.
 bool MCDeployCapsuleChecksum(MCDeployCapsuleRef self);
 
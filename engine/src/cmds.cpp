@@ -1020,6 +1020,9 @@ void MCReset::exec_ctxt(MCExecContext& ctxt)
 		case RT_PRINTING:
 			MCPrintingExecResetPrinting(ctxt);
 			break;
+		case RT_DNS_CACHE:
+			MCNetworkExecResetDnsCache(ctxt);
+			break;
 		default:
 			MCInterfaceExecResetTemplate(ctxt, which);
 		break;
@@ -1309,6 +1309,40 @@ public:
     virtual void exec_ctxt(MCExecContext &ctxt);
 };
 
+class MCCompressFileOp : public MCStatement
+{
+	MCExpression *source;
+	MCExpression *dest;
+protected:
+	Boolean isdecompress;
+public:
+	MCCompressFileOp()
+	{
+		source = dest = NULL;
+	}
+	virtual ~MCCompressFileOp();
+	virtual Parse_stat parse(MCScriptPoint &);
+	virtual void exec_ctxt(MCExecContext &);
+};
+
+class MCCompressFile : public MCCompressFileOp
+{
+public:
+	MCCompressFile()
+	{
+		isdecompress = False;
+	}
+};
+
+class MCDecompressFile : public MCCompressFileOp
+{
+public:
+	MCDecompressFile()
+	{
+		isdecompress = True;
+	}
+};
+
 // MW-2004-11-26: Initialise format and sformat (VG)
 class MCExport : public MCStatement
 {
@@ -1567,6 +1601,8 @@ class MCWrite : public MCStatement
 	MCExpression *fname;
 	File_unit unit;
 	MCExpression *at;
+	// Whether source is the path of a file whose contents are written.
+	Boolean isfile;
 public:
 	MCWrite()
 	{
@@ -1574,6 +1610,7 @@ public:
 		fname = NULL;
 		unit = FU_CHARACTER;
 		at = NULL;
+		isfile = False;
 	}
 	virtual ~MCWrite();
 	virtual Parse_stat parse(MCScriptPoint &);
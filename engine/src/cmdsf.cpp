@@ -163,6 +163,64 @@ void MCClose::exec_ctxt(MCExecContext &ctxt)
     }
 }
 
+MCCompressFileOp::~MCCompressFileOp()
+{
+	delete source;
+	delete dest;
+}
+
+Parse_stat MCCompressFileOp::parse(MCScriptPoint &sp)
+{
+	initpoint(sp);
+	if (sp.skip_token(SP_THERE, TT_UNDEFINED, TM_FILE) != PS_NORMAL)
+	{
+		MCperror->add
+		(PE_COMPRESSFILE_NOFILE, sp);
+		return PS_ERROR;
+	}
+	if (sp.parseexp(False, True, &source) != PS_NORMAL)
+	{
+		MCperror->add
+		(PE_COMPRESSFILE_BADEXP, sp);
+		return PS_ERROR;
+	}
+	if (sp.skip_token(SP_EXIT, TT_UNDEFINED, ET_TO) != PS_NORMAL)
+	{
+		MCperror->add
+		(PE_COMPRESSFILE_NOTO, sp);
+		return PS_ERROR;
+	}
+	if (sp.skip_token(SP_THERE, TT_UNDEFINED, TM_FILE) != PS_NORMAL)
+	{
+		MCperror->add
+		(PE_COMPRESSFILE_NOFILE, sp);
+		return PS_ERROR;
+	}
+	if (sp.parseexp(False, True, &dest) != PS_NORMAL)
+	{
+		MCperror->add
+		(PE_COMPRESSFILE_BADEXP, sp);
+		return PS_ERROR;
+	}
+	return PS_NORMAL;
+}
+
+void MCCompressFileOp::exec_ctxt(MCExecContext &ctxt)
+{
+	MCAutoStringRef t_source;
+	if (!ctxt . EvalExprAsStringRef(source, EE_COMPRESSFILE_BADSOURCE, &t_source))
+		return;
+
+	MCAutoStringRef t_dest;
+	if (!ctxt . EvalExprAsStringRef(dest, EE_COMPRESSFILE_BADDEST, &t_dest))
+		return;
+
+	if (isdecompress)
+		MCFiltersExecDecompressFile(ctxt, *t_source, *t_dest);
+	else
+		MCFiltersExecCompressFile(ctxt, *t_source, *t_dest);
+}
+
 MCEncryptionOp::~MCEncryptionOp()
 {
 	delete ciphername;
@@ -2152,6 +2210,8 @@ Parse_stat MCWrite::parse(MCScriptPoint &sp)
 	const LT *te;
 
 	initpoint(sp);
+	if (sp.skip_token(SP_OPEN, TT_UNDEFINED, OA_FILE) == PS_NORMAL)
+		isfile = True;
 	if (sp.parseexp(False, True, &source) != PS_NORMAL)
 	{
 		MCperror->add
@@ -2177,6 +2237,13 @@ Parse_stat MCWrite::parse(MCScriptPoint &sp)
 		return PS_ERROR;
 	}
 	arg = (Open_argument)te->which;
+	// Files can only be written to sockets.
+	if (isfile && arg != OA_SOCKET)
+	{
+		MCperror->add
+		(PE_WRITE_BADTYPE, sp);
+		return PS_ERROR;
+	}
 	if (te->which != OA_STDERR && te->which != OA_STDOUT)
 	{
 		if (sp.parseexp(False, True, &fname) != PS_NORMAL)
@@ -2213,10 +2280,59 @@ Parse_stat MCWrite::parse(MCScriptPoint &sp)
 void MCWrite::exec_ctxt(MCExecContext& ctxt)
 {
     ctxt . SetTheResultToEmpty();
-	MCAutoStringRef t_data;
-    if (!ctxt . EvalExprAsStringRef(source, EE_WRITE_BADEXP, &t_data))
+	if (isfile)
+	{
+		MCAutoStringRef t_path;
+		MCNewAutoNameRef t_target, t_message;
+		if (!ctxt . EvalExprAsStringRef(source, EE_WRITE_BADEXP, &t_path) ||
+			!ctxt . EvalExprAsNameRef(fname, EE_WRITE_BADEXP, &t_target) ||
+			!ctxt . EvalOptionalExprAsNullableNameRef(at, EE_WRITE_BADEXP, &t_message))
+			return;
+		MCNetworkExecWriteFileToSocket(ctxt, *t_target, *t_path, *t_message);
+		return;
+	}
+	
+	MCAutoValueRef t_value;
+    if (!ctxt . EvalExprAsValueRef(source, EE_WRITE_BADEXP, &t_value))
         return;
 	
+	// Writing an array to a socket sends each of its elements as a separate
+	// datagram.
+	if (arg == OA_SOCKET && MCValueGetTypeCode(*t_value) == kMCValueTypeCodeArray)
+	{
+		MCNewAutoNameRef t_target, t_message;
+		if (!ctxt . EvalExprAsNameRef(fname, EE_WRITE_BADEXP, &t_target) ||
+			!ctxt . EvalOptionalExprAsNullableNameRef(at, EE_WRITE_BADEXP, &t_message))
+			return;
+		MCNetworkExecWriteDatagramsToSocket(ctxt, *t_target, (MCArrayRef)*t_value, *t_message);
+		return;
+	}
+	
+	// Data written to a socket is queued by reference, so binary data is
+	// passed on without being copied.
+	if (arg == OA_SOCKET)
+	{
+		MCAutoDataRef t_bytes;
+		MCNewAutoNameRef t_target, t_message;
+		if (!ctxt . ConvertToData(*t_value, &t_bytes))
+		{
+			ctxt . LegacyThrow(EE_WRITE_BADEXP);
+			return;
+		}
+		if (!ctxt . EvalExprAsNameRef(fname, EE_WRITE_BADEXP, &t_target) ||
+			!ctxt . EvalOptionalExprAsNullableNameRef(at, EE_WRITE_BADEXP, &t_message))
+			return;
+		MCNetworkExecWriteToSocket(ctxt, *t_target, *t_bytes, *t_message);
+		return;
+	}
+	
+	MCAutoStringRef t_data;
+	if (!ctxt . ConvertToString(*t_value, &t_data))
+	{
+		ctxt . LegacyThrow(EE_WRITE_BADEXP);
+		return;
+	}
+	
     if (arg == OA_STDERR)
 		MCFilesExecWriteToStderr(ctxt, *t_data, unit);
 	else
@@ -2255,14 +2371,6 @@ void MCWrite::exec_ctxt(MCExecContext& ctxt)
                 case OA_PROCESS:
                     MCFilesExecWriteToProcess(ctxt, *t_target, *t_data, unit);
                     break;
-                case OA_SOCKET:
-				{
-                    MCNewAutoNameRef t_message;
-                    if (!ctxt . EvalOptionalExprAsNullableNameRef(at, EE_WRITE_BADEXP, &t_message))
-                        return;
-                    MCNetworkExecWriteToSocket(ctxt, *t_target, *t_data, *t_message);
-				}
-                    break;
                 default:
                     break;
 			}
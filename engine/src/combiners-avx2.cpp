@@ -0,0 +1,72 @@
+/* Copyright (C) 2003-2015 LiveCode Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+#include "prefix.h"
+
+#include "globdefs.h"
+
+#include "combiners.h"
+
+#if defined(MC_SURFACE_COMBINERS_AVX2)
+
+#include <immintrin.h>
+
+// The engine isn't built for AVX2, so the code in this file is compiled for it
+// explicitly and only used when the CPU supports it (see combiners.cpp).
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct MCSurfaceCombinersAVX2
+{
+	typedef __m256i vec;
+	enum { kWidth = 8 };
+
+	static inline vec load(const uint32_t *p) { return _mm256_loadu_si256((const __m256i *)p); }
+	static inline void store(uint32_t *p, vec x) { _mm256_storeu_si256((__m256i *)p, x); }
+	static inline vec set1(uint32_t x) { return _mm256_set1_epi32((int)x); }
+
+	static inline vec and_(vec x, vec y) { return _mm256_and_si256(x, y); }
+	static inline vec or_(vec x, vec y) { return _mm256_or_si256(x, y); }
+	static inline vec xor_(vec x, vec y) { return _mm256_xor_si256(x, y); }
+	static inline vec add(vec x, vec y) { return _mm256_add_epi32(x, y); }
+	static inline vec sub(vec x, vec y) { return _mm256_sub_epi32(x, y); }
+	template<int N> static inline vec srl(vec x) { return _mm256_srli_epi32(x, N); }
+	template<int N> static inline vec sll(vec x) { return _mm256_slli_epi32(x, N); }
+	static inline vec mul16(vec x, vec y) { return _mm256_mullo_epi16(x, y); }
+};
+
+#include "combiners-simd.h"
+
+void MCSurfaceCombinersInstallAVX2(surface_combiner_t *x_combiners, surface_combiner_t *x_combiners_nda)
+{
+	simd_surface_combiners_install<MCSurfaceCombinersAVX2>(x_combiners, x_combiners_nda);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
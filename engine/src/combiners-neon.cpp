@@ -0,0 +1,57 @@
+/* Copyright (C) 2003-2015 LiveCode Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+#include "prefix.h"
+
+#include "globdefs.h"
+
+#include "combiners.h"
+
+#if defined(MC_SURFACE_COMBINERS_NEON)
+
+#include <arm_neon.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct MCSurfaceCombinersNEON
+{
+	typedef uint32x4_t vec;
+	enum { kWidth = 4 };
+
+	static inline vec load(const uint32_t *p) { return vld1q_u32(p); }
+	static inline void store(uint32_t *p, vec x) { vst1q_u32(p, x); }
+	static inline vec set1(uint32_t x) { return vdupq_n_u32(x); }
+
+	static inline vec and_(vec x, vec y) { return vandq_u32(x, y); }
+	static inline vec or_(vec x, vec y) { return vorrq_u32(x, y); }
+	static inline vec xor_(vec x, vec y) { return veorq_u32(x, y); }
+	static inline vec add(vec x, vec y) { return vaddq_u32(x, y); }
+	static inline vec sub(vec x, vec y) { return vsubq_u32(x, y); }
+	template<int N> static inline vec srl(vec x) { return vshrq_n_u32(x, N); }
+	template<int N> static inline vec sll(vec x) { return vshlq_n_u32(x, N); }
+	static inline vec mul16(vec x, vec y) { return vreinterpretq_u32_u16(vmulq_u16(vreinterpretq_u16_u32(x), vreinterpretq_u16_u32(y))); }
+};
+
+#include "combiners-simd.h"
+
+void MCSurfaceCombinersInstallNEON(surface_combiner_t *x_combiners, surface_combiner_t *x_combiners_nda)
+{
+	simd_surface_combiners_install<MCSurfaceCombinersNEON>(x_combiners, x_combiners_nda);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
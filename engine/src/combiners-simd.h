@@ -0,0 +1,307 @@
+/* Copyright (C) 2003-2015 LiveCode Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+// This file is included by each of the combiners-<isa>.cpp files, after they
+// have defined a traits class describing a vector of 32-bit pixels:
+//
+//   vec                  - the vector type
+//   kWidth               - the number of pixels in a vector
+//   load / store         - unaligned load / store of kWidth pixels
+//   set1(x)              - x in every 32-bit lane
+//   and_ / or_ / xor_    - bitwise operations
+//   add / sub            - 32-bit lane arithmetic
+//   srl<N> / sll<N>      - 32-bit lane shifts
+//   mul16(x, y)          - low 16 bits of the product of each 16-bit lane
+//
+// The kernels perform exactly the same 32-bit packed arithmetic as the scalar
+// combiners in combiners.cpp (two channels per 32-bit value, each in its own
+// 16-bit half), so that their results are identical.
+
+#ifndef COMBINERS_SIMD_H
+#define COMBINERS_SIMD_H
+
+#include "combiners.h"
+
+#ifdef __VISUALC__
+#define SIMD_INLINE __forceinline
+#else
+#define SIMD_INLINE inline
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Returns a scale factor for the packed functions - a in both 16-bit halves of
+// each lane.
+template<class V> static SIMD_INLINE typename V::vec simd_factor(typename V::vec a)
+{
+	return V::or_(a, V::template sll<16>(a));
+}
+
+template<class V> static SIMD_INLINE typename V::vec simd_alpha(typename V::vec x)
+{
+	return simd_factor<V>(V::template srl<24>(x));
+}
+
+template<class V> static SIMD_INLINE typename V::vec simd_inverse_alpha(typename V::vec x)
+{
+	return simd_factor<V>(V::template srl<24>(V::xor_(x, V::set1(0xffffffff))));
+}
+
+template<class V> static SIMD_INLINE typename V::vec simd_inverse(typename V::vec x)
+{
+	return V::xor_(x, V::set1(0xffffffff));
+}
+
+// r_i = (x_i * a) / 255
+template<class V> static SIMD_INLINE typename V::vec simd_scale_bounded(typename V::vec x, typename V::vec a)
+{
+	typename V::vec t_mask, t_round, u, v;
+	t_mask = V::set1(0xff00ff);
+	t_round = V::set1(0x800080);
+
+	u = V::add(V::mul16(V::and_(x, t_mask), a), t_round);
+	u = V::and_(V::template srl<8>(V::add(u, V::and_(V::template srl<8>(u), t_mask))), t_mask);
+
+	v = V::add(V::mul16(V::and_(V::template srl<8>(x), t_mask), a), t_round);
+	v = V::and_(V::add(v, V::and_(V::template srl<8>(v), t_mask)), V::set1(0xff00ff00));
+
+	return V::add(u, v);
+}
+
+// r_i = (x_i * a) / 255 + y_i
+template<class V> static SIMD_INLINE typename V::vec simd_scale_add_bounded(typename V::vec x, typename V::vec a, typename V::vec y)
+{
+	return V::add(simd_scale_bounded<V>(x, a), y);
+}
+
+// r_i = (x_i * a + y_i * b) / 255
+template<class V> static SIMD_INLINE typename V::vec simd_bilinear_bounded(typename V::vec x, typename V::vec a, typename V::vec y, typename V::vec b)
+{
+	typename V::vec t_mask, t_round, u, v;
+	t_mask = V::set1(0xff00ff);
+	t_round = V::set1(0x800080);
+
+	u = V::add(V::add(V::mul16(V::and_(x, t_mask), a), V::mul16(V::and_(y, t_mask), b)), t_round);
+	u = V::and_(V::template srl<8>(V::add(u, V::and_(V::template srl<8>(u), t_mask))), t_mask);
+
+	v = V::add(V::add(V::mul16(V::and_(V::template srl<8>(x), t_mask), a), V::mul16(V::and_(V::template srl<8>(y), t_mask), b)), t_round);
+	v = V::and_(V::add(v, V::and_(V::template srl<8>(v), t_mask)), V::set1(0xff00ff00));
+
+	return V::or_(u, v);
+}
+
+// r_i = x_i * y_i / 255
+template<class V> static SIMD_INLINE typename V::vec simd_multiply_bounded(typename V::vec x, typename V::vec y)
+{
+	typename V::vec t_mask, t_round, u, v;
+	t_mask = V::set1(0xff00ff);
+	t_round = V::set1(0x800080);
+
+	u = V::add(V::mul16(V::and_(x, t_mask), V::and_(y, t_mask)), t_round);
+	v = V::add(V::mul16(V::and_(V::template srl<8>(x), t_mask), V::and_(V::template srl<8>(y), t_mask)), t_round);
+
+	u = V::and_(V::template srl<8>(V::add(u, V::and_(V::template srl<8>(u), t_mask))), t_mask);
+	v = V::and_(V::add(v, V::and_(V::template srl<8>(v), t_mask)), V::set1(0xff00ff00));
+
+	return V::add(u, v);
+}
+
+// r_i = min(x_i + y_i, 255)
+template<class V> static SIMD_INLINE typename V::vec simd_add_saturated(typename V::vec x, typename V::vec y)
+{
+	typename V::vec t_mask, t_limit, u, v;
+	t_mask = V::set1(0xff00ff);
+	t_limit = V::set1(0x10000100);
+
+	u = V::add(V::and_(x, t_mask), V::and_(y, t_mask));
+	u = V::and_(V::or_(u, V::sub(t_limit, V::and_(V::template srl<8>(u), t_mask))), t_mask);
+
+	v = V::add(V::and_(V::template srl<8>(x), t_mask), V::and_(V::template srl<8>(y), t_mask));
+	v = V::and_(V::or_(v, V::sub(t_limit, V::and_(V::template srl<8>(v), t_mask))), t_mask);
+
+	return V::or_(u, V::template sll<8>(v));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The vector form of basic_imaging_combiner in combiners.cpp, the source
+// always having alpha.
+template<class V, int x_combiner, bool x_dst_alpha> static SIMD_INLINE typename V::vec simd_basic_imaging_combiner(typename V::vec dst, typename V::vec src)
+{
+	switch(x_combiner)
+	{
+	case GXblendClear:
+		return V::set1(0);
+	case GXblendSrc:
+		return src;
+	case GXblendDst:
+		return dst;
+	case GXblendSrcOver:
+		return simd_scale_add_bounded<V>(dst, simd_inverse_alpha<V>(src), src);
+	case GXblendDstOver:
+		if (x_dst_alpha)
+			return simd_scale_add_bounded<V>(src, simd_inverse_alpha<V>(dst), dst);
+		return dst;
+	case GXblendSrcIn:
+		if (x_dst_alpha)
+			return simd_scale_bounded<V>(src, simd_alpha<V>(dst));
+		return src;
+	case GXblendDstIn:
+		return simd_scale_bounded<V>(dst, simd_alpha<V>(src));
+	case GXblendSrcOut:
+		if (x_dst_alpha)
+			return simd_scale_bounded<V>(src, simd_inverse_alpha<V>(dst));
+		return V::set1(0);
+	case GXblendDstOut:
+		return simd_scale_bounded<V>(dst, simd_inverse_alpha<V>(src));
+	case GXblendSrcAtop:
+		if (x_dst_alpha)
+			return simd_bilinear_bounded<V>(src, simd_alpha<V>(dst), dst, simd_inverse_alpha<V>(src));
+		return simd_scale_add_bounded<V>(dst, simd_inverse_alpha<V>(src), src);
+	case GXblendDstAtop:
+		if (x_dst_alpha)
+			return simd_bilinear_bounded<V>(dst, simd_alpha<V>(src), src, simd_inverse_alpha<V>(dst));
+		return simd_scale_bounded<V>(dst, simd_alpha<V>(src));
+	case GXblendXor:
+		if (x_dst_alpha)
+			return simd_bilinear_bounded<V>(src, simd_inverse_alpha<V>(dst), dst, simd_inverse_alpha<V>(src));
+		return simd_scale_bounded<V>(dst, simd_inverse_alpha<V>(src));
+	case GXblendPlus:
+		return simd_add_saturated<V>(src, dst);
+	case GXblendMultiply:
+		if (x_dst_alpha)
+			return V::add(simd_multiply_bounded<V>(src, dst), simd_bilinear_bounded<V>(src, simd_inverse_alpha<V>(dst), dst, simd_inverse_alpha<V>(src)));
+		return V::add(simd_multiply_bounded<V>(src, dst), simd_scale_bounded<V>(dst, simd_inverse_alpha<V>(src)));
+	case GXblendScreen:
+		return V::add(simd_multiply_bounded<V>(src, simd_inverse<V>(dst)), dst);
+	default:
+		MCUnreachableReturn(dst);
+	}
+}
+
+// Combines kWidth pixels in place. The source is scaled by the opacity first
+// for srcOver (as in surface_combine_blendSrcOver), and the result is blended
+// with the destination by the opacity for all the others (as in
+// surface_combine).
+template<class V, int x_combiner, bool x_dst_alpha> static SIMD_INLINE void simd_combine_pixels(uint32_t *x_dst, const uint32_t *p_src, bool p_translucent, typename V::vec p_opacity, typename V::vec p_inverse_opacity)
+{
+	typename V::vec t_src, t_dst, t_pixel;
+	t_src = V::load(p_src);
+	t_dst = V::load(x_dst);
+
+	if (x_combiner == GXblendSrcOver)
+	{
+		if (p_translucent)
+			t_src = simd_scale_bounded<V>(t_src, p_opacity);
+		t_pixel = simd_basic_imaging_combiner<V, x_combiner, x_dst_alpha>(t_dst, t_src);
+	}
+	else
+	{
+		t_pixel = simd_basic_imaging_combiner<V, x_combiner, x_dst_alpha>(t_dst, t_src);
+		if (p_translucent)
+			t_pixel = simd_bilinear_bounded<V>(t_pixel, p_opacity, t_dst, p_inverse_opacity);
+	}
+
+	V::store(x_dst, t_pixel);
+}
+
+template<class V, int x_combiner, bool x_dst_alpha>
+static void simd_surface_combine(void *p_dst, int32_t p_dst_stride, const void *p_src, uint32_t p_src_stride, uint32_t p_width, uint32_t p_height, uint8_t p_opacity)
+{
+	if (p_opacity == 0)
+		return;
+
+	bool t_translucent;
+	t_translucent = p_opacity != 255;
+
+	typename V::vec t_opacity, t_inverse_opacity;
+	t_opacity = simd_factor<V>(V::set1(p_opacity));
+	t_inverse_opacity = simd_factor<V>(V::set1(255 - p_opacity));
+
+	uint32_t t_tail;
+	t_tail = p_width % V::kWidth;
+
+	uint8_t *t_dst_row;
+	t_dst_row = (uint8_t *)p_dst;
+
+	const uint8_t *t_src_row;
+	t_src_row = (const uint8_t *)p_src;
+
+	for(; p_height > 0; --p_height, t_dst_row += p_dst_stride, t_src_row += p_src_stride)
+	{
+		uint32_t *t_dst_ptr;
+		t_dst_ptr = (uint32_t *)t_dst_row;
+
+		const uint32_t *t_src_ptr;
+		t_src_ptr = (const uint32_t *)t_src_row;
+
+		for(uint32_t t_width = p_width - t_tail; t_width > 0; t_width -= V::kWidth, t_dst_ptr += V::kWidth, t_src_ptr += V::kWidth)
+			simd_combine_pixels<V, x_combiner, x_dst_alpha>(t_dst_ptr, t_src_ptr, t_translucent, t_opacity, t_inverse_opacity);
+
+		// The last few pixels of each row are combined in a vector's worth of
+		// padding, rather than with separate scalar code.
+		if (t_tail != 0)
+		{
+			uint32_t t_dst_pixels[V::kWidth], t_src_pixels[V::kWidth];
+			memset(t_dst_pixels, 0, sizeof(t_dst_pixels));
+			memset(t_src_pixels, 0, sizeof(t_src_pixels));
+			memcpy(t_dst_pixels, t_dst_ptr, t_tail * sizeof(uint32_t));
+			memcpy(t_src_pixels, t_src_ptr, t_tail * sizeof(uint32_t));
+
+			simd_combine_pixels<V, x_combiner, x_dst_alpha>(t_dst_pixels, t_src_pixels, t_translucent, t_opacity, t_inverse_opacity);
+
+			memcpy(t_dst_ptr, t_dst_pixels, t_tail * sizeof(uint32_t));
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<class V> static void simd_surface_combiners_install(surface_combiner_t *x_combiners, surface_combiner_t *x_combiners_nda)
+{
+	// The legacy copy ink is srcOver (see combiners.cpp), which is the same
+	// whether the destination has alpha or not.
+	x_combiners[GXcopy] = simd_surface_combine<V, GXblendSrcOver, true>;
+	x_combiners_nda[GXcopy] = simd_surface_combine<V, GXblendSrcOver, true>;
+
+#define SIMD_INSTALL_COMBINER(ink) \
+	x_combiners[ink] = simd_surface_combine<V, ink, true>; \
+	x_combiners_nda[ink] = simd_surface_combine<V, ink, false>;
+
+	SIMD_INSTALL_COMBINER(GXblendClear)
+	SIMD_INSTALL_COMBINER(GXblendSrc)
+	SIMD_INSTALL_COMBINER(GXblendDst)
+	SIMD_INSTALL_COMBINER(GXblendDstOver)
+	SIMD_INSTALL_COMBINER(GXblendSrcIn)
+	SIMD_INSTALL_COMBINER(GXblendDstIn)
+	SIMD_INSTALL_COMBINER(GXblendSrcOut)
+	SIMD_INSTALL_COMBINER(GXblendDstOut)
+	SIMD_INSTALL_COMBINER(GXblendSrcAtop)
+	SIMD_INSTALL_COMBINER(GXblendDstAtop)
+	SIMD_INSTALL_COMBINER(GXblendXor)
+	SIMD_INSTALL_COMBINER(GXblendPlus)
+	SIMD_INSTALL_COMBINER(GXblendMultiply)
+	SIMD_INSTALL_COMBINER(GXblendScreen)
+
+#undef SIMD_INSTALL_COMBINER
+
+	x_combiners[GXblendSrcOver] = simd_surface_combine<V, GXblendSrcOver, true>;
+	x_combiners_nda[GXblendSrcOver] = simd_surface_combine<V, GXblendSrcOver, true>;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,57 @@
+/* Copyright (C) 2003-2015 LiveCode Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+#include "prefix.h"
+
+#include "globdefs.h"
+
+#include "combiners.h"
+
+#if defined(MC_SURFACE_COMBINERS_SSE2)
+
+#include <emmintrin.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct MCSurfaceCombinersSSE2
+{
+	typedef __m128i vec;
+	enum { kWidth = 4 };
+
+	static inline vec load(const uint32_t *p) { return _mm_loadu_si128((const __m128i *)p); }
+	static inline void store(uint32_t *p, vec x) { _mm_storeu_si128((__m128i *)p, x); }
+	static inline vec set1(uint32_t x) { return _mm_set1_epi32((int)x); }
+
+	static inline vec and_(vec x, vec y) { return _mm_and_si128(x, y); }
+	static inline vec or_(vec x, vec y) { return _mm_or_si128(x, y); }
+	static inline vec xor_(vec x, vec y) { return _mm_xor_si128(x, y); }
+	static inline vec add(vec x, vec y) { return _mm_add_epi32(x, y); }
+	static inline vec sub(vec x, vec y) { return _mm_sub_epi32(x, y); }
+	template<int N> static inline vec srl(vec x) { return _mm_srli_epi32(x, N); }
+	template<int N> static inline vec sll(vec x) { return _mm_slli_epi32(x, N); }
+	static inline vec mul16(vec x, vec y) { return _mm_mullo_epi16(x, y); }
+};
+
+#include "combiners-simd.h"
+
+void MCSurfaceCombinersInstallSSE2(surface_combiner_t *x_combiners, surface_combiner_t *x_combiners_nda)
+{
+	simd_surface_combiners_install<MCSurfaceCombinersSSE2>(x_combiners, x_combiners_nda);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -16,6 +16,14 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #include "prefix.h"
 
+#include "globdefs.h"
+
+#include "combiners.h"
+
+#if defined(MC_SURFACE_COMBINERS_AVX2) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 #ifdef __VISUALC__
 #pragma optimize("agt", on)
 #pragma optimize("y", off)
@@ -106,8 +114,6 @@ enum AdvancedImagingOperation
 #define OPERATION_SRC_BIC OPERATION_AND_REVERSE
 #define OPERATION_NOT_SRC_BIC OPERATION_AND
 
-typedef void (*surface_combiner_t)(void *p_dst, int32_t p_dst_stride, const void *p_src, uint32_t p_src_stride, uint32_t p_width, uint32_t p_height, uint8_t p_opacity);
-
 #ifdef __VISUALC__
 #define INLINE __forceinline
 #else
@@ -1388,3 +1394,116 @@ surface_combiner_t s_surface_combiners_nda[] =
 	surface_combine<OPERATION_BLEND_DIFFERENCE, false, true>,
 	surface_combine<OPERATION_BLEND_EXCLUSION, false, true>,
 };
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The scalar combiners, saved before any vector combiners are installed over
+// them.
+static surface_combiner_t s_scalar_surface_combiners[NUM_INKS];
+static surface_combiner_t s_scalar_surface_combiners_nda[NUM_INKS];
+static bool s_scalar_surface_combiners_saved = false;
+
+#if defined(MC_SURFACE_COMBINERS_AVX2)
+static bool MCSurfaceCombinersCPUHasAVX2(void)
+{
+#if defined(_MSC_VER)
+	// AVX2 needs the instructions, and the OS to save the YMM registers.
+	int t_info[4];
+	__cpuid(t_info, 0);
+	if (t_info[0] < 7)
+		return false;
+
+	__cpuid(t_info, 1);
+	if ((t_info[2] & (1 << 27)) == 0 || (t_info[2] & (1 << 28)) == 0)
+		return false;
+	if ((_xgetbv(0) & 6) != 6)
+		return false;
+
+	__cpuidex(t_info, 7, 0);
+	return (t_info[1] & (1 << 5)) != 0;
+#else
+	// This checks that the OS supports the YMM registers too.
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+bool MCSurfaceCombinersIsAvailable(MCSurfaceCombinersVariant p_variant)
+{
+	switch(p_variant)
+	{
+	case kMCSurfaceCombinersScalar:
+		return true;
+#if defined(MC_SURFACE_COMBINERS_SSE2)
+	case kMCSurfaceCombinersSSE2:
+		return true;
+#endif
+#if defined(MC_SURFACE_COMBINERS_AVX2)
+	case kMCSurfaceCombinersAVX2:
+		return MCSurfaceCombinersCPUHasAVX2();
+#endif
+#if defined(MC_SURFACE_COMBINERS_NEON)
+	case kMCSurfaceCombinersNEON:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+void MCSurfaceCombinersSelect(MCSurfaceCombinersVariant p_variant)
+{
+	if (!s_scalar_surface_combiners_saved)
+	{
+		MCMemoryCopy(s_scalar_surface_combiners, s_surface_combiners, sizeof(s_scalar_surface_combiners));
+		MCMemoryCopy(s_scalar_surface_combiners_nda, s_surface_combiners_nda, sizeof(s_scalar_surface_combiners_nda));
+		s_scalar_surface_combiners_saved = true;
+	}
+
+	MCMemoryCopy(s_surface_combiners, s_scalar_surface_combiners, sizeof(s_scalar_surface_combiners));
+	MCMemoryCopy(s_surface_combiners_nda, s_scalar_surface_combiners_nda, sizeof(s_scalar_surface_combiners_nda));
+
+	if (!MCSurfaceCombinersIsAvailable(p_variant))
+		return;
+
+	switch(p_variant)
+	{
+#if defined(MC_SURFACE_COMBINERS_SSE2)
+	case kMCSurfaceCombinersSSE2:
+		MCSurfaceCombinersInstallSSE2(s_surface_combiners, s_surface_combiners_nda);
+		break;
+#endif
+#if defined(MC_SURFACE_COMBINERS_AVX2)
+	case kMCSurfaceCombinersAVX2:
+		MCSurfaceCombinersInstallAVX2(s_surface_combiners, s_surface_combiners_nda);
+		break;
+#endif
+#if defined(MC_SURFACE_COMBINERS_NEON)
+	case kMCSurfaceCombinersNEON:
+		MCSurfaceCombinersInstallNEON(s_surface_combiners, s_surface_combiners_nda);
+		break;
+#endif
+	default:
+		break;
+	}
+}
+
+void MCSurfaceCombinersInitialize(void)
+{
+	static const MCSurfaceCombinersVariant kPreferred[] =
+	{
+		kMCSurfaceCombinersAVX2,
+		kMCSurfaceCombinersSSE2,
+		kMCSurfaceCombinersNEON,
+	};
+
+	for(uindex_t i = 0; i < sizeof(kPreferred) / sizeof(kPreferred[0]); i++)
+		if (MCSurfaceCombinersIsAvailable(kPreferred[i]))
+		{
+			MCSurfaceCombinersSelect(kPreferred[i]);
+			return;
+		}
+
+	MCSurfaceCombinersSelect(kMCSurfaceCombinersScalar);
+}
@@ -0,0 +1,72 @@
+/* Copyright (C) 2003-2015 LiveCode Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+#ifndef COMBINERS_H
+#define COMBINERS_H
+
+////////////////////////////////////////////////////////////////////////////////
+
+// A surface combiner composites a p_width x p_height block of premultiplied
+// pixels from p_src onto p_dst, with the given opacity. There is one combiner
+// for each ink in s_surface_combiners (for destinations with alpha) and
+// s_surface_combiners_nda (for destinations without alpha).
+typedef void (*surface_combiner_t)(void *p_dst, int32_t p_dst_stride, const void *p_src, uint32_t p_src_stride, uint32_t p_width, uint32_t p_height, uint8_t p_opacity);
+
+extern surface_combiner_t s_surface_combiners[];
+extern surface_combiner_t s_surface_combiners_nda[];
+
+// The vector instruction sets which the combiners can be built for. Only the
+// Porter-Duff style blend inks (and the legacy copy ink) have vector versions
+// - the others need per-channel division, so always use the scalar code.
+enum MCSurfaceCombinersVariant
+{
+	kMCSurfaceCombinersScalar,
+	kMCSurfaceCombinersSSE2,
+	kMCSurfaceCombinersAVX2,
+	kMCSurfaceCombinersNEON,
+};
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MC_SURFACE_COMBINERS_SSE2
+#endif
+
+#if (defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))) || defined(_M_X64)
+#define MC_SURFACE_COMBINERS_AVX2
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MC_SURFACE_COMBINERS_NEON
+#endif
+
+// Returns true if the combiners for the given variant have been built, and the
+// CPU supports them.
+bool MCSurfaceCombinersIsAvailable(MCSurfaceCombinersVariant p_variant);
+
+// Makes the combiner tables use the given variant (which must be available).
+void MCSurfaceCombinersSelect(MCSurfaceCombinersVariant p_variant);
+
+// Selects the fastest variant the CPU supports.
+void MCSurfaceCombinersInitialize(void);
+
+// Replace the entries in the combiner tables which have vector versions with
+// those for the given instruction set.
+void MCSurfaceCombinersInstallSSE2(surface_combiner_t *x_combiners, surface_combiner_t *x_combiners_nda);
+void MCSurfaceCombinersInstallAVX2(surface_combiner_t *x_combiners, surface_combiner_t *x_combiners_nda);
+void MCSurfaceCombinersInstallNEON(surface_combiner_t *x_combiners, surface_combiner_t *x_combiners_nda);
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -104,6 +104,8 @@ MCControl::MCControl()
 	m_layer_mode_hint = kMCLayerModeHintStatic;
     m_layer_has_clip_rect = false;
     m_layer_clip_rect = kMCEmptyRectangle;
+	m_layer_display_list = nil;
+	layer_resetdisplaylist();
 }
 
 MCControl::MCControl(const MCControl &cref) : MCObject(cref)
@@ -128,6 +130,8 @@ MCControl::MCControl(const MCControl &cref) : MCObject(cref)
 	m_layer_mode_hint = cref . m_layer_mode_hint;
     m_layer_has_clip_rect = cref.m_layer_has_clip_rect;
     m_layer_clip_rect = cref.m_layer_clip_rect;
+	m_layer_display_list = nil;
+	layer_resetdisplaylist();
 }
 
 MCControl::~MCControl()
@@ -139,6 +143,8 @@ MCControl::~MCControl()
 
 	// MW-2009-06-11: [[ Bitmap Effects ]] Destroy the bitmap effects
 	MCBitmapEffectsFinalize(m_bitmap_effects);
+
+	layer_resetdisplaylist();
 }
 
 void MCControl::open()
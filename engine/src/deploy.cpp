@@ -75,6 +75,8 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "globals.h"
 #include "param.h"
 #include "dispatch.h"
+#include "stack.h"
+#include "font.h"
 #include "osspec.h"
 
 #include "ide.h"
@@ -208,6 +210,11 @@ bool MCDeployParameters::InitWithArray(MCExecContext &ctxt, MCArrayRef p_array)
     MCValueAssign(auxiliary_stackfiles, t_temp_array);
 	MCValueRelease(t_temp_array);
 	
+	MCAutoBooleanRef t_defer_auxiliary_stackfiles;
+	if (!ctxt.CopyOptElementAsBoolean(p_array, MCNAME("defer_auxiliary_stackfiles"), false, &t_defer_auxiliary_stackfiles))
+		return false;
+	defer_auxiliary_stackfiles = *t_defer_auxiliary_stackfiles == kMCTrue;
+	
     // The externals listed by the IDE are LF separated
 	if (!ctxt.CopyOptElementAsString(p_array, MCNAME("externals"), false, t_temp_string))
 		return false;
@@ -466,7 +473,40 @@ static bool MCDeployWriteCapsuleDefineStandaloneSections(const MCDeployParameter
 	return t_success;
 }
 
-static bool MCDeployCapsuleDefineFromStackFile(MCDeployCapsuleRef p_self, MCStringRef p_filename, MCDeployFileRef p_file, bool p_mainstack)
+// This method loads the given stackfile just far enough to find the name of
+// its mainstack, which is how a deferred auxiliary stack is found by the
+// standalone. The stack is discarded straight away.
+static bool MCDeployGetStackFileName(MCDataRef p_contents, bool p_script_only, MCNameRef& r_name)
+{
+    IO_handle t_stream = nil;
+    t_stream = MCS_fakeopen(MCDataGetBytePtr(p_contents), MCDataGetLength(p_contents));
+    
+    if (t_stream == nil)
+        return false;
+    
+    MCStack *t_stack = nullptr;
+    const char *t_result = nullptr;
+    IO_stat t_stat;
+    if (p_script_only)
+        t_stat = MCdispatcher -> trytoreadscriptonlystackofsize(kMCEmptyString, t_stream, MCDataGetLength(p_contents), MCdispatcher, t_stack, t_result);
+    else
+        t_stat = MCdispatcher -> trytoreadbinarystack(kMCEmptyString, kMCEmptyString, t_stream, MCdispatcher, t_stack, t_result);
+    MCS_close(t_stream);
+    
+    // MW-2012-02-17: [[ LogFonts ]] As with readfile, make sure any font table
+    //   built while loading is cleared up.
+    MCLogicalFontTableFinish();
+    
+    if (t_stat != IO_NORMAL || t_stack == nullptr)
+        return false;
+    
+    r_name = MCValueRetain(t_stack -> getname());
+    MCdispatcher -> destroystack(t_stack, False);
+    
+    return true;
+}
+
+static bool MCDeployCapsuleDefineFromStackFile(MCDeployCapsuleRef p_self, MCStringRef p_filename, MCDeployFileRef p_file, bool p_mainstack, bool p_deferred)
 {
     MCAutoDataRef t_contents;
     if (!MCS_loadbinaryfile(p_filename, &t_contents))
@@ -481,6 +521,13 @@ static bool MCDeployCapsuleDefineFromStackFile(MCDeployCapsuleRef p_self, MCStri
     bool t_script_only = MCdispatcher -> streamstackisscriptonly(t_stream);
     MCS_close(t_stream);
     
+    // Deferred stacks are looked up by name, so if the stackfile can't be
+    // loaded to find it, the stack is included as a normal auxiliary stack.
+    MCNewAutoNameRef t_name;
+    if (!p_mainstack && p_deferred &&
+        MCDeployGetStackFileName(*t_contents, t_script_only, &t_name))
+        return MCDeployCapsuleDefineDeferredStack(p_self, *t_name, t_script_only, p_file);
+    
     MCCapsuleSectionType t_type;
     if (p_mainstack)
     {
@@ -590,7 +637,7 @@ bool MCDeployWriteCapsule(const MCDeployParameters& p_params, MCDeployFileRef p_
 
 	// Now we add the main stack
 	if (t_success)
-		t_success = MCDeployCapsuleDefineFromStackFile(t_capsule, p_params . stackfile, t_stackfile, true);
+		t_success = MCDeployCapsuleDefineFromStackFile(t_capsule, p_params . stackfile, t_stackfile, true, false);
 
 	// Now we add the auxillary stackfiles, if any
 	MCAutoArray<MCDeployFileRef> t_aux_stackfiles;
@@ -604,7 +651,7 @@ bool MCDeployWriteCapsule(const MCDeployParameters& p_params, MCDeployFileRef p_
 			if (t_success && !MCDeployFileOpen((MCStringRef)t_val, kMCOpenFileModeRead, t_aux_stackfiles[i]))
 				t_success = MCDeployThrow(kMCDeployErrorNoAuxStackfile);
 			if (t_success)
-                t_success = MCDeployCapsuleDefineFromStackFile(t_capsule, (MCStringRef)t_val, t_aux_stackfiles[i], false);
+                t_success = MCDeployCapsuleDefineFromStackFile(t_capsule, (MCStringRef)t_val, t_aux_stackfiles[i], false, p_params . defer_auxiliary_stackfiles);
 		}
 
 	// Now add the externals, if any
@@ -67,6 +67,10 @@ struct MCDeployParameters
     // The array of auxiliary stackfiles to be included in the standalone.
     MCArrayRef auxiliary_stackfiles;
 
+    // If true, the auxiliary stackfiles are kept compressed by the standalone
+    // until they are first needed.
+    bool defer_auxiliary_stackfiles;
+
 	// The array of externals to be loaded on startup by the standalone.
 	MCArrayRef externals;
 
@@ -130,6 +134,7 @@ struct MCDeployParameters
 		version_info	= MCValueRetain(kMCEmptyArray);
 		stackfile		= MCValueRetain(kMCEmptyString);
         auxiliary_stackfiles = MCValueRetain(kMCEmptyArray);
+        defer_auxiliary_stackfiles = false;
 		externals		= MCValueRetain(kMCEmptyArray);
 		startup_script	= MCValueRetain(kMCEmptyString);
 		timeout			= 0;
@@ -36,6 +36,7 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "license.h"
 
 #include "deploysecurity.h"
+#include "graphics.h"
 
 #include <zlib.h>
 
@@ -224,6 +225,103 @@ bool MCDeployCapsuleDefineFromFile(MCDeployCapsuleRef self, MCCapsuleSectionType
 	return t_success;
 }
 
+bool MCDeployCapsuleDefineDeferredStack(MCDeployCapsuleRef self, MCNameRef p_name, bool p_script_only, MCDeployFileRef p_file)
+{
+	MCAssert(self != nil);
+	MCAssert(p_name != nil);
+	MCAssert(p_file != nil);
+
+	bool t_success;
+	t_success = true;
+
+	// Read in the stackfile
+	uint32_t t_length;
+	t_length = 0;
+	if (t_success)
+		t_success = MCDeployFileMeasure(p_file, t_length);
+
+	MCAutoByteArray t_stackfile;
+	if (t_success && !t_stackfile . New(t_length))
+		t_success = MCDeployThrow(kMCDeployErrorNoMemory);
+
+	if (t_success)
+		t_success = MCDeployFileReadAt(p_file, t_stackfile . Bytes(), t_length, 0);
+
+	// The name is stored nul-terminated and padded, so that the data which
+	// follows starts on a word boundary.
+	MCAutoStringRefAsUTF8String t_name;
+	if (t_success && !t_name . Lock(MCNameGetString(p_name)))
+		t_success = MCDeployThrow(kMCDeployErrorNoMemory);
+
+	uint32_t t_record_size;
+	t_record_size = 0;
+	if (t_success)
+		t_record_size = sizeof(MCCapsuleDeferredStackSection) + ((t_name . Size() + 1 + 3) & ~3);
+
+	z_stream t_stream;
+	memset(&t_stream, 0, sizeof(z_stream));
+	if (t_success && deflateInit2(&t_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		t_success = MCDeployThrow(kMCDeployErrorBadCompress);
+
+	// Allocate a new section, with room for the record followed by the
+	// deflated stackfile (the bound guarantees a single call will finish).
+	MCDeployCapsuleSection *t_section;
+	t_section = nil;
+	if (t_success)
+		t_success = MCDeployCapsuleSectionCreate(kMCCapsuleSectionTypeDeferredAuxiliaryStack, t_section);
+
+	uint32_t t_capacity;
+	t_capacity = 0;
+	if (t_success)
+	{
+		t_capacity = t_record_size + deflateBound(&t_stream, t_length);
+		if (!MCMemoryAllocate(t_capacity, t_section -> buffer))
+			t_success = MCDeployThrow(kMCDeployErrorNoMemory);
+	}
+
+	if (t_success)
+	{
+		t_stream . next_in = (Bytef *)t_stackfile . Bytes();
+		t_stream . avail_in = t_length;
+		t_stream . next_out = (Bytef *)t_section -> buffer + t_record_size;
+		t_stream . avail_out = t_capacity - t_record_size;
+		if (deflate(&t_stream, Z_FINISH) != Z_STREAM_END)
+			t_success = MCDeployThrow(kMCDeployErrorBadCompress);
+	}
+
+	// Fill in the record, which is followed by the name and its padding
+	if (t_success)
+	{
+		MCCapsuleDeferredStackSection *t_record;
+		t_record = static_cast<MCCapsuleDeferredStackSection *>(t_section -> buffer);
+		t_record -> flags = p_script_only ? kMCCapsuleDeferredStackFlagScriptOnly : 0;
+		t_record -> length = t_length;
+		MCDeployByteSwapRecord(true, "ll", t_record, sizeof(uint32_t) * 2);
+
+		md5_state_t t_md5;
+		md5_init(&t_md5);
+		md5_append(&t_md5, (md5_byte_t *)t_stackfile . Bytes(), t_length);
+		md5_finish(&t_md5, t_record -> digest);
+
+		char *t_name_buffer;
+		t_name_buffer = (char *)(t_record + 1);
+		memset(t_name_buffer, 0, t_record_size - sizeof(MCCapsuleDeferredStackSection));
+		memcpy(t_name_buffer, *t_name, t_name . Size());
+
+		t_section -> length = t_record_size + t_stream . total_out;
+	}
+
+	deflateEnd(&t_stream);
+
+	// Link into chain at end if successful, otherwise destroy
+	if (t_success)
+		MCListPushBack(self -> sections, t_section);
+	else
+		MCDeployCapsuleSectionDestroy(t_section);
+
+	return t_success;
+}
+
 bool MCDeployCapsuleChecksum(MCDeployCapsuleRef self)
 {
 	MCAssert(self != nil);
@@ -248,6 +346,176 @@ bool MCDeployCapsuleChecksum(MCDeployCapsuleRef self)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Capsule data is compressed in pieces of at most this size. Each piece is
+// deflated independently, ending with a sync flush, so that the pieces can be
+// compressed in parallel and their output concatenated into a single raw
+// deflate stream. A piece never spans two sections, so unchanged sections
+// give identical pieces from one build to the next.
+#define kMCDeployCapsulePieceSize (1024 * 1024)
+
+// The number of pieces gathered before they are compressed together.
+#define kMCDeployCapsuleBatchSize 16
+
+// The most compressed data which is kept in the piece cache between builds.
+#define kMCDeployCapsuleCacheLimit (64 * 1024 * 1024)
+
+struct MCDeployCapsulePiece
+{
+	// The uncompressed data, and its digest which identifies it in the cache.
+	uint8_t *input;
+	uint32_t input_length;
+	md5_byte_t key[16];
+
+	// The zlib compression level to use.
+	int level;
+
+	// The compressed data, and whether it came from the cache.
+	uint8_t *output;
+	uint32_t output_length;
+	bool cached;
+
+	// Set if compression failed.
+	bool failed;
+};
+
+// Compressed pieces are cached by the digest of their data so that building
+// several standalones from the same stacks, or rebuilding after only some have
+// changed, doesn't compress the same data again. The least recently used
+// entries are discarded once the cache exceeds its limit.
+struct MCDeployCapsuleCacheEntry
+{
+	MCDeployCapsuleCacheEntry *next;
+
+	md5_byte_t key[16];
+	uint32_t input_length;
+	int level;
+
+	uint8_t *output;
+	uint32_t output_length;
+
+	uint32_t last_used;
+};
+
+static MCDeployCapsuleCacheEntry *s_capsule_cache = nil;
+static uint32_t s_capsule_cache_size = 0;
+static uint32_t s_capsule_cache_clock = 0;
+
+static bool MCDeployCapsuleCacheLookup(MCDeployCapsulePiece& x_piece)
+{
+	for(MCDeployCapsuleCacheEntry *t_entry = s_capsule_cache; t_entry != nil; t_entry = t_entry -> next)
+	{
+		if (t_entry -> input_length != x_piece . input_length ||
+			t_entry -> level != x_piece . level ||
+			memcmp(t_entry -> key, x_piece . key, 16) != 0)
+			continue;
+
+		if (!MCMemoryAllocateCopy(t_entry -> output, t_entry -> output_length, x_piece . output))
+			return false;
+
+		x_piece . output_length = t_entry -> output_length;
+		x_piece . cached = true;
+		t_entry -> last_used = ++s_capsule_cache_clock;
+
+		return true;
+	}
+
+	return false;
+}
+
+static void MCDeployCapsuleCacheInsert(const MCDeployCapsulePiece& p_piece)
+{
+	if (p_piece . output_length > kMCDeployCapsuleCacheLimit)
+		return;
+
+	MCDeployCapsuleCacheEntry *t_entry;
+	if (!MCMemoryNew(t_entry))
+		return;
+
+	if (!MCMemoryAllocateCopy(p_piece . output, p_piece . output_length, t_entry -> output))
+	{
+		MCMemoryDelete(t_entry);
+		return;
+	}
+
+	memcpy(t_entry -> key, p_piece . key, 16);
+	t_entry -> input_length = p_piece . input_length;
+	t_entry -> level = p_piece . level;
+	t_entry -> output_length = p_piece . output_length;
+	t_entry -> last_used = ++s_capsule_cache_clock;
+	t_entry -> next = s_capsule_cache;
+	s_capsule_cache = t_entry;
+	s_capsule_cache_size += t_entry -> output_length;
+
+	// Make room by discarding the least recently used entries.
+	while(s_capsule_cache_size > kMCDeployCapsuleCacheLimit)
+	{
+		MCDeployCapsuleCacheEntry **t_oldest;
+		t_oldest = &s_capsule_cache;
+		for(MCDeployCapsuleCacheEntry **t_link = &s_capsule_cache; *t_link != nil; t_link = &(*t_link) -> next)
+			if ((*t_link) -> last_used < (*t_oldest) -> last_used)
+				t_oldest = t_link;
+
+		MCDeployCapsuleCacheEntry *t_evicted;
+		t_evicted = *t_oldest;
+		*t_oldest = t_evicted -> next;
+		s_capsule_cache_size -= t_evicted -> output_length;
+		MCMemoryDeallocate(t_evicted -> output);
+		MCMemoryDelete(t_evicted);
+	}
+}
+
+// Deflates a piece which wasn't found in the cache. This runs on worker
+// threads, so failure is only recorded in the piece.
+static void MCDeployCapsuleCompressPiece(void *p_context, uint32_t p_index)
+{
+	MCDeployCapsulePiece& t_piece = static_cast<MCDeployCapsulePiece *>(p_context)[p_index];
+	if (t_piece . output != nil)
+		return;
+
+	z_stream t_stream;
+	memset(&t_stream, 0, sizeof(z_stream));
+	if (deflateInit2(&t_stream, t_piece . level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		t_piece . failed = true;
+		return;
+	}
+
+	// The bound is for a finished stream, so allow for the sync flush marker
+	// too; should that still not be enough the buffer is grown.
+	uint32_t t_capacity;
+	t_capacity = deflateBound(&t_stream, t_piece . input_length) + 16;
+
+	bool t_success;
+	t_success = MCMemoryAllocate(t_capacity, t_piece . output);
+
+	t_stream . next_in = t_piece . input;
+	t_stream . avail_in = t_piece . input_length;
+	while(t_success)
+	{
+		t_stream . next_out = t_piece . output + t_stream . total_out;
+		t_stream . avail_out = t_capacity - t_stream . total_out;
+
+		int t_result;
+		t_result = deflate(&t_stream, Z_SYNC_FLUSH);
+		if (t_result != Z_OK && t_result != Z_BUF_ERROR)
+			t_success = false;
+		else if (t_stream . avail_out != 0)
+			break;
+		else
+		{
+			t_capacity *= 2;
+			t_success = MCMemoryReallocate(t_piece . output, t_capacity, t_piece . output);
+		}
+	}
+
+	deflateEnd(&t_stream);
+
+	if (t_success)
+		t_piece . output_length = t_stream . total_out;
+	else
+		t_piece . failed = true;
+}
+
 // This holds state for a simple compressed data writing filter. The filter
 // uses the zlib library to perform raw deflate. There is no need for anything
 // beyong the raw level of compression since we know precisely what data we
@@ -276,15 +544,13 @@ struct MCDeployCapsuleFilterState
 	// The md5 state for computing the digest as we go along
 	md5_state_t md5_stream;
 
-	// The input/output buffers in use by zlib
-	uint8_t *input;
-	uint32_t input_capacity;
-
-	uint8_t *output;
-	uint32_t output_capacity;
+	// The compression level of the section being written
+	int level;
 
-	// The zlib state
-	z_stream stream;
+	// The pieces gathered for the next batch. The first piece_count are
+	// complete, and the one after (if it has an input buffer) is being filled.
+	MCDeployCapsulePiece pieces[kMCDeployCapsuleBatchSize];
+	uint32_t piece_count;
 };
 
 static void MCDeployCapsuleFilterInitialize(MCDeployCapsuleFilterState& self)
@@ -294,9 +560,11 @@ static void MCDeployCapsuleFilterInitialize(MCDeployCapsuleFilterState& self)
 
 static void MCDeployCapsuleFilterFinalize(MCDeployCapsuleFilterState& self)
 {
-	MCMemoryDeallocate(self . input);
-	MCMemoryDeallocate(self . output);
-	deflateEnd(&self . stream);
+	for(uint32_t i = 0; i < kMCDeployCapsuleBatchSize; i++)
+	{
+		MCMemoryDeallocate(self . pieces[i] . input);
+		MCMemoryDeallocate(self . pieces[i] . output);
+	}
 }
 
 static bool MCDeployCapsuleFilterStart(MCDeployCapsuleFilterState& self, MCDeployFileRef p_output, MCDeployFileRef p_spill_output, uint32_t p_offset)
@@ -307,118 +575,137 @@ static bool MCDeployCapsuleFilterStart(MCDeployCapsuleFilterState& self, MCDeplo
 	self . spill_file = p_spill_output;
 	self . offset = p_offset;
 	self . start_offset = p_offset;
-
-	self . input_capacity = 65536;
-	if (!MCMemoryAllocate(65536, self . input))
-		return false;
-
-	self . output_capacity = 65536;
-	if (!MCMemoryAllocate(65536, self . output))
-		return false;
+	self . level = Z_DEFAULT_COMPRESSION;
 
 	// Initialize the md5 stream
 	md5_init(&self . md5_stream);
 
-	// Initialize the deflate stream
-	int t_result;
-	self . stream . next_in = self . input;
-	self . stream . avail_in = 0;
-	self . stream . next_out = self . output;
-	self . stream . avail_out = self . output_capacity;
-	t_result = deflateInit2(&self . stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8,Z_DEFAULT_STRATEGY);
-	if (t_result != Z_OK)
-		return MCDeployThrow(kMCDeployErrorBadCompress);
-
 	return true;
 }
 
-// This method outputs the current buffer into the output file/split output file.
+// This method outputs compressed data into the output file/split output file.
 // If we are splitting output, then the following happens:
 //   1) We fill up to the first 4K - header size in the output file
 //   2) If we overflow this, we move the last 2K into the split file and continue
 //      output there.
 //   3) When we are done, we shift the last 2K of data back into the exe.
-// If this is the last block of data to output, p_last will be true.
 //
-static bool MCDeployCapsuleFilterOutput(MCDeployCapsuleFilterState& self, bool p_last)
+static bool MCDeployCapsuleFilterOutput(MCDeployCapsuleFilterState& self, const void *p_data, uint32_t p_amount)
 {
-	// Compute the amount of data we have
-	uint32_t t_amount;
-	t_amount = self . stream . next_out - self . output;
-
 	// If we aren't splitting, this is easy
 	if (self . spill_file == nil)
 	{
-		if (!MCDeployFileWriteAt(self . file, self . output, t_amount, self . offset))
+		if (!MCDeployFileWriteAt(self . file, p_data, p_amount, self . offset))
 			return false;
 	
 		// Update the offset
-		self . offset += t_amount;
+		self . offset += p_amount;
 
 		// Update the amount written
-		self . amount += t_amount;
+		self . amount += p_amount;
 	}
 	else
 	{
-		if (!MCDeployFileWriteAt(self . spill_file, self . output, t_amount, self . spill_offset))
+		if (!MCDeployFileWriteAt(self . spill_file, p_data, p_amount, self . spill_offset))
 			return false;
-		self . spill_offset += t_amount;
-		self . amount += t_amount;
+		self . spill_offset += p_amount;
+		self . amount += p_amount;
 	}
 
-
-	// Reset the stream
-	self . stream . next_out = self . output;
-	self . stream . avail_out = self . output_capacity;
-
 	return true;
 }
 
+// Compresses the complete pieces, taking those it can from the cache and the
+// rest in parallel, and then writes them out in order.
 static bool MCDeployCapsuleFilterFlush(MCDeployCapsuleFilterState& self)
 {
-	// Now attempt to do the deflate
-	int t_result;
-	t_result = deflate(&self . stream, Z_NO_FLUSH);
-	if (t_result == Z_STREAM_ERROR)
-		return MCDeployThrow(kMCDeployErrorBadCompress);
-
-	// First ensure we maximum space in the input buffer
-	if (self . stream . next_in != self . input)
-	{
-		memmove(self . input, self . stream . next_in, self . stream . avail_in);
-		self . stream . next_in = self . input;
-	}
+	if (self . piece_count == 0)
+		return true;
 
-	// If a buf error occurred, we either need more space, or more input
-	if (t_result == Z_BUF_ERROR)
+	for(uint32_t i = 0; i < self . piece_count; i++)
 	{
-		// If the input buffer is not maxed out, return as we need more input
-		if (self . stream . avail_in != self . input_capacity)
-			return true;
+		MCDeployCapsulePiece& t_piece = self . pieces[i];
 
-		// Otherwise, we must need a bigger input buffer, so extend it.
-		uint8_t *t_new_input;
-		t_new_input = (uint8_t *)realloc(self . input, self . input_capacity * 2);
-		if (t_new_input == NULL)
-			return MCDeployThrow(kMCDeployErrorNoMemory);
+		md5_state_t t_md5;
+		md5_init(&t_md5);
+		md5_append(&t_md5, t_piece . input, t_piece . input_length);
+		md5_finish(&t_md5, t_piece . key);
 
-		// Update the stream input pointer
-		self . stream . next_in = t_new_input + (self . stream . next_in - self . input);
+		MCDeployCapsuleCacheLookup(t_piece);
+	}
 
-		// Set the new input buffer and size
-		self . input = t_new_input;
-		self . input_capacity *= 2;
+	MCGParallelFor(self . piece_count, MCDeployCapsuleCompressPiece, self . pieces);
 
-		return true;
+	bool t_success;
+	t_success = true;
+	for(uint32_t i = 0; i < self . piece_count && t_success; i++)
+	{
+		MCDeployCapsulePiece& t_piece = self . pieces[i];
+		if (t_piece . failed)
+			t_success = MCDeployThrow(kMCDeployErrorBadCompress);
+
+		if (t_success && !t_piece . cached)
+			MCDeployCapsuleCacheInsert(t_piece);
+
+		if (t_success)
+			t_success = MCDeployCapsuleFilterOutput(self, t_piece . output, t_piece . output_length);
 	}
 
-	// Otherwise, first write out any produced output
-	if (self . stream . avail_out != self . output_capacity)
+	for(uint32_t i = 0; i < self . piece_count; i++)
 	{
-		// Write out the data.
-		if (!MCDeployCapsuleFilterOutput(self, false))
-			return false;
+		MCMemoryDeallocate(self . pieces[i] . input);
+		MCMemoryDeallocate(self . pieces[i] . output);
+		memset(&self . pieces[i], 0, sizeof(MCDeployCapsulePiece));
 	}
+	self . piece_count = 0;
+
+	return t_success;
+}
+
+// Completes the piece being filled, compressing the batch if it is now full.
+// This is called at the end of each section, so that pieces never span
+// sections.
+static bool MCDeployCapsuleFilterEndPiece(MCDeployCapsuleFilterState& self)
+{
+	MCDeployCapsulePiece& t_piece = self . pieces[self . piece_count];
+	if (t_piece . input_length == 0)
+		return true;
+
+	self . piece_count += 1;
+	if (self . piece_count < kMCDeployCapsuleBatchSize)
+		return true;
+
+	return MCDeployCapsuleFilterFlush(self);
+}
+
+// Returns the space left in the piece being filled, starting a new one if
+// needed.
+static bool MCDeployCapsuleFilterReserve(MCDeployCapsuleFilterState& self, uint32_t& r_available)
+{
+	MCDeployCapsulePiece& t_piece = self . pieces[self . piece_count];
+	if (t_piece . input == nil &&
+		!MCMemoryAllocate(kMCDeployCapsulePieceSize, t_piece . input))
+		return MCDeployThrow(kMCDeployErrorNoMemory);
+
+	if (t_piece . input_length == 0)
+		t_piece . level = self . level;
+
+	r_available = kMCDeployCapsulePieceSize - t_piece . input_length;
+
+	return true;
+}
+
+// Accounts for p_amount bytes having been added to the piece being filled.
+static bool MCDeployCapsuleFilterAppended(MCDeployCapsuleFilterState& self, uint32_t p_amount)
+{
+	MCDeployCapsulePiece& t_piece = self . pieces[self . piece_count];
+
+	// Mix in the new data into the MD5 stream.
+	md5_append(&self . md5_stream, t_piece . input + t_piece . input_length, p_amount);
+
+	t_piece . input_length += p_amount;
+	if (t_piece . input_length == kMCDeployCapsulePieceSize)
+		return MCDeployCapsuleFilterEndPiece(self);
 
 	return true;
 }
@@ -428,23 +715,22 @@ static bool MCDeployCapsuleFilterWrite(MCDeployCapsuleFilterState& self, void *p
 	// Loop until we have no more input to write
 	while(p_size > 0)
 	{
-		// Fill the input buffer as much as we can
-		uint32_t t_amount;
-		t_amount = MCU_min((unsigned)((self . input + self . input_capacity) - (self . stream . next_in + self . stream . avail_in)), p_size);
-		memcpy(self . stream . next_in + self . stream . avail_in, p_buffer, t_amount);
+		uint32_t t_available;
+		if (!MCDeployCapsuleFilterReserve(self, t_available))
+			return false;
 
-		// Mix in the new data into the MD5 stream.
-		md5_append(&self . md5_stream, self . stream . next_in + self . stream . avail_in, t_amount);
+		// Fill the piece as much as we can
+		uint32_t t_amount;
+		t_amount = MCU_min(t_available, p_size);
 
-		// Update the amount that is available
-		self . stream . avail_in += t_amount;
+		MCDeployCapsulePiece& t_piece = self . pieces[self . piece_count];
+		memcpy(t_piece . input + t_piece . input_length, p_buffer, t_amount);
 
 		// Adjust the input buffer/size
 		p_size -= t_amount;
 		p_buffer = (uint8_t *)p_buffer + t_amount;
 
-		// Attempt to flush the data
-		if (!MCDeployCapsuleFilterFlush(self))
+		if (!MCDeployCapsuleFilterAppended(self, t_amount))
 			return false;
 	}
 
@@ -455,20 +741,21 @@ static bool MCDeployCapsuleFilterWriteFile(MCDeployCapsuleFilterState& self, MCD
 {
 	while(p_size > 0)
 	{
-		uint32_t t_amount;
-		t_amount = MCU_min((unsigned)((self . input + self . input_capacity) - (self . stream . next_in + self . stream . avail_in)), p_size);
-		if (!MCDeployFileReadAt(p_file, self . stream . next_in + self . stream . avail_in, t_amount, p_from))
+		uint32_t t_available;
+		if (!MCDeployCapsuleFilterReserve(self, t_available))
 			return false;
 
-		// Mix in the new data into the MD5 stream.
-		md5_append(&self . md5_stream, self . stream . next_in + self . stream . avail_in, t_amount);
+		uint32_t t_amount;
+		t_amount = MCU_min(t_available, p_size);
 
-		self . stream . avail_in += t_amount;
+		MCDeployCapsulePiece& t_piece = self . pieces[self . piece_count];
+		if (!MCDeployFileReadAt(p_file, t_piece . input + t_piece . input_length, t_amount, p_from))
+			return false;
 
 		p_size -= t_amount;
 		p_from += t_amount;
 
-		if (!MCDeployCapsuleFilterFlush(self))
+		if (!MCDeployCapsuleFilterAppended(self, t_amount))
 			return false;
 	}
 
@@ -477,11 +764,15 @@ static bool MCDeployCapsuleFilterWriteFile(MCDeployCapsuleFilterState& self, MCD
 
 static bool MCDeployCapsuleFilterFinish(MCDeployCapsuleFilterState& self, uint32_t& r_offset, md5_byte_t r_digest[16])
 {
-	if (deflate(&self . stream, Z_FINISH) != Z_STREAM_END)
-		return MCDeployThrow(kMCDeployErrorBadCompress);
+	// Compress and write out any remaining data
+	if (!MCDeployCapsuleFilterEndPiece(self) ||
+		!MCDeployCapsuleFilterFlush(self))
+		return false;
 
-	// Write out any remaining data
-	if (!MCDeployCapsuleFilterOutput(self, true))
+	// Every piece ends with a sync flush, so the stream is terminated by an
+	// empty final block.
+	static const uint8_t kFinalBlock[2] = { 0x03, 0x00 };
+	if (!MCDeployCapsuleFilterOutput(self, kFinalBlock, sizeof(kFinalBlock)))
 		return false;
 
 	// Finish off the md5
@@ -516,6 +807,13 @@ bool MCDeployCapsuleGenerate(MCDeployCapsuleRef self, MCDeployFileRef p_file, MC
 	if (t_success)
 		for(MCDeployCapsuleSection *t_section = self -> sections; t_section != nil && t_success; t_section = t_section -> next)
 		{
+			// Deferred stacks are already deflated, so their sections are
+			// stored rather than compressed a second time.
+			if (t_section -> type == kMCCapsuleSectionTypeDeferredAuxiliaryStack)
+				t_filter . level = Z_NO_COMPRESSION;
+			else
+				t_filter . level = Z_DEFAULT_COMPRESSION;
+
 			// If this is a digest section we generate the data and write
 			if (t_section -> type == kMCCapsuleSectionTypeDigest)
 			{
@@ -534,6 +832,8 @@ bool MCDeployCapsuleGenerate(MCDeployCapsuleRef self, MCDeployFileRef p_file, MC
 					t_success = MCDeployCapsuleFilterWrite(t_filter, t_digest, 16);
 				if (t_success)
 					t_generated += sizeof(uint32_t) + 16;
+				if (t_success)
+					t_success = MCDeployCapsuleFilterEndPiece(t_filter);
 
 				continue;
 			}
@@ -583,6 +883,10 @@ bool MCDeployCapsuleGenerate(MCDeployCapsuleRef self, MCDeployFileRef p_file, MC
 				if (t_success)
 					t_generated = (t_generated + 3) & ~3;
 			}
+
+			// Start a new piece for the next section
+			if (t_success)
+				t_success = MCDeployCapsuleFilterEndPiece(t_filter);
 		}
 
 	// Now we've written out all the principal data, finish the filter
@@ -63,6 +63,8 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "graphics_util.h"
 
 #include "stackfileformat.h"
+#include "deploy.h"
+#include "capsule.h"
 
 #define UNLICENSED_TIME 6.0
 #ifdef _DEBUG_MALLOC_INC
@@ -150,6 +152,8 @@ MCDispatch::MCDispatch()
     //  any universal name / relative path pairs included in a standalone executable for locating included
     //  resources.
     /* UNCHECKED */ MCArrayCreateMutable(m_library_mapping);
+
+    m_deferred_stacks = nil;
 }
 
 MCDispatch::~MCDispatch()
@@ -173,6 +177,9 @@ MCDispatch::~MCDispatch()
 	delete m_externals;
     // AL-2015-02-10: [[ Standalone Inclusions ]] Delete library mapping
     MCValueRelease(m_library_mapping);
+
+    while(m_deferred_stacks != nil)
+        freedeferredstack(MCListPopFront(m_deferred_stacks));
 }
 
 bool MCDispatch::visit_self(MCObjectVisitor* p_visitor)
@@ -1856,6 +1863,10 @@ MCStack *MCDispatch::findstackname(MCNameRef p_name)
 		while (tstk != stacks);
 	}
 
+	tstk = loaddeferredstack(p_name);
+	if (tstk != NULL)
+		return tstk;
+
 	if (loadfile(MCNameGetString(p_name), tstk) != IO_NORMAL)
 	{
 		MCAutoStringRef t_name;
@@ -1887,6 +1898,84 @@ MCStack *MCDispatch::findstackname(MCNameRef p_name)
 	return tstk;
 }
 
+bool MCDispatch::adddeferredstack(MCNameRef p_name, bool p_script_only, uint32_t p_length, const uint8_t p_digest[16], MCDataRef p_data)
+{
+	MCDeferredStack *t_deferred;
+	if (!MCMemoryNew(t_deferred))
+		return false;
+
+	t_deferred -> name = MCValueRetain(p_name);
+	t_deferred -> script_only = p_script_only;
+	t_deferred -> length = p_length;
+	memcpy(t_deferred -> digest, p_digest, 16);
+	t_deferred -> data = MCValueRetain(p_data);
+
+	MCListPushBack(m_deferred_stacks, t_deferred);
+
+	return true;
+}
+
+// Inflates and loads the deferred stack with the given name, if there is one.
+// The stack is removed from the deferred list first, so that the attempt is
+// only ever made once.
+MCStack *MCDispatch::loaddeferredstack(MCNameRef p_name)
+{
+	MCDeferredStack **t_link;
+	t_link = &m_deferred_stacks;
+	while(*t_link != nil && !MCNameIsEqualToCaseless((*t_link) -> name, p_name))
+		t_link = &(*t_link) -> next;
+
+	MCDeferredStack *t_deferred;
+	t_deferred = *t_link;
+	if (t_deferred == nil)
+		return NULL;
+	*t_link = t_deferred -> next;
+
+	MCAutoDataRef t_stackfile;
+	IO_handle t_stream;
+	t_stream = nil;
+	if (MCCapsuleInflateDeferredStack(MCDataGetBytePtr(t_deferred -> data), MCDataGetLength(t_deferred -> data), t_deferred -> length, t_deferred -> digest, &t_stackfile))
+		t_stream = MCS_fakeopen(MCDataGetBytePtr(*t_stackfile), MCDataGetLength(*t_stackfile));
+
+	MCStack *t_stack;
+	t_stack = nullptr;
+	if (t_stream != nil)
+	{
+		const char *t_result;
+		t_result = nullptr;
+
+		IO_stat t_stat;
+		if (t_deferred -> script_only)
+			t_stat = trytoreadscriptonlystackofsize(kMCEmptyString, t_stream, t_deferred -> length, nullptr, t_stack, t_result);
+		else
+			t_stat = trytoreadbinarystack(kMCEmptyString, kMCEmptyString, t_stream, nullptr, t_stack, t_result);
+		MCS_close(t_stream);
+
+		// MW-2012-02-17: [[ LogFonts ]] As with readfile, make sure any font
+		//   table built while loading is cleared up.
+		MCLogicalFontTableFinish();
+
+		if (t_stat != IO_NORMAL)
+			t_stack = nullptr;
+	}
+
+	freedeferredstack(t_deferred);
+
+	if (t_stack == nullptr)
+		return NULL;
+
+	processstack(kMCEmptyString, t_stack);
+
+	return t_stack;
+}
+
+void MCDispatch::freedeferredstack(MCDeferredStack *p_deferred)
+{
+	MCValueRelease(p_deferred -> name);
+	MCValueRelease(p_deferred -> data);
+	MCMemoryDelete(p_deferred);
+}
+
 MCStack *MCDispatch::findstackid(uint4 fid)
 {
 	if (fid == 0)
@@ -63,6 +63,22 @@ class MCDispatch : public MCObject
 
     // AL-2015-02-10: [[ Standalone Inclusions ]] Add resource mapping array to MCDispatch object.
     MCArrayRef m_library_mapping;
+
+    // A mainstack which was deployed as a deferred auxiliary stack. Its
+    // stackfile is kept compressed until the stack is first looked up.
+    struct MCDeferredStack
+    {
+        MCDeferredStack *next;
+        MCNameRef name;
+        bool script_only;
+        uint32_t length;
+        uint8_t digest[16];
+        MCDataRef data;
+    };
+    MCDeferredStack *m_deferred_stacks;
+
+    MCStack *loaddeferredstack(MCNameRef p_name);
+    void freedeferredstack(MCDeferredStack *p_deferred);
 public:
 	MCDispatch();
 	// virtual functions from MCObject
@@ -201,6 +217,12 @@ public:
 #endif
 	
 	MCStack *findstackname(MCNameRef);
+
+	// Registers a mainstack whose (deflated) stackfile is only inflated,
+	// checked against its digest and loaded when findstackname first fails
+	// to find a loaded stack with its name.
+	bool adddeferredstack(MCNameRef p_name, bool p_script_only, uint32_t p_length, const uint8_t p_digest[16], MCDataRef p_data);
+
 	MCStack *findstackid(uint4 fid);
 	// IM-2014-07-09: [[ Bug 12225 ]] Find the stack by window ID
 	MCStack *findstackwindowid(uintptr_t p_win_id);
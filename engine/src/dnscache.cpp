@@ -0,0 +1,342 @@
+/* Copyright (C) 2003-2015 LiveCode Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+#include "prefix.h"
+
+#include "globdefs.h"
+#include "osspec.h"
+
+#include "dnscache.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct MCDnsCacheEntry
+{
+	MCNameRef key;
+	bool resolved;
+	MCDnsAddressList addresses;
+	real64_t expires;
+};
+
+struct MCDnsLookupWaiter
+{
+	MCDnsLookupWaiterCallback callback;
+	void *context;
+};
+
+struct MCDnsPendingLookup
+{
+	MCDnsPendingLookup *next;
+	MCNameRef key;
+	MCDnsLookupWaiter *waiters;
+	uindex_t waiter_count;
+};
+
+static MCDnsCacheEntry s_dns_cache[DNS_CACHE_SIZE];
+static MCDnsPendingLookup *s_dns_pending_lookups = nil;
+static MCDnsCacheClockCallback s_dns_cache_clock = nil;
+
+static uint32_t s_dns_cache_hits = 0;
+static uint32_t s_dns_cache_negative_hits = 0;
+static uint32_t s_dns_cache_misses = 0;
+static uint32_t s_dns_cache_coalesced = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool MCDnsAddressListAppend(MCDnsAddressList& x_list, const struct sockaddr *p_addr, int p_addrlen)
+{
+	struct sockaddr *t_addr;
+	if (!MCMemoryAllocateCopy(p_addr, p_addrlen, t_addr))
+		return false;
+
+	uindex_t t_count;
+	t_count = x_list . count;
+	if (!MCMemoryResizeArray(t_count + 1, x_list . addresses, t_count))
+	{
+		MCMemoryDeallocate(t_addr);
+		return false;
+	}
+
+	x_list . addresses[x_list . count] . addr = t_addr;
+	x_list . addresses[x_list . count] . addrlen = p_addrlen;
+	x_list . count = t_count;
+	return true;
+}
+
+bool MCDnsAddressListCopy(const MCDnsAddressList& p_list, MCDnsAddressList& r_copy)
+{
+	MCDnsAddressList t_copy;
+	t_copy . addresses = nil;
+	t_copy . count = 0;
+	for(uindex_t i = 0; i < p_list . count; i++)
+		if (!MCDnsAddressListAppend(t_copy, p_list . addresses[i] . addr, p_list . addresses[i] . addrlen))
+		{
+			MCDnsAddressListClear(t_copy);
+			return false;
+		}
+
+	r_copy = t_copy;
+	return true;
+}
+
+void MCDnsAddressListClear(MCDnsAddressList& x_list)
+{
+	for(uindex_t i = 0; i < x_list . count; i++)
+		MCMemoryDeallocate(x_list . addresses[i] . addr);
+	MCMemoryDeleteArray(x_list . addresses);
+	x_list . addresses = nil;
+	x_list . count = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static real64_t MCDnsCacheNow(void)
+{
+	if (s_dns_cache_clock != nil)
+		return s_dns_cache_clock();
+	return MCS_time();
+}
+
+static void MCDnsCacheClearEntry(MCDnsCacheEntry& x_entry)
+{
+	MCValueRelease(x_entry . key);
+	x_entry . key = nil;
+	MCDnsAddressListClear(x_entry . addresses);
+	x_entry . resolved = false;
+	x_entry . expires = 0;
+}
+
+// Returns the index of the live entry for the given key, expiring it instead
+// if its time is up.
+static bool MCDnsCacheFind(MCNameRef p_key, real64_t p_now, uindex_t& r_index)
+{
+	for(uindex_t i = 0; i < DNS_CACHE_SIZE; i++)
+	{
+		if (s_dns_cache[i] . key == nil ||
+			!MCNameIsEqualToCaseless(s_dns_cache[i] . key, p_key))
+			continue;
+
+		if (s_dns_cache[i] . expires <= p_now)
+		{
+			MCDnsCacheClearEntry(s_dns_cache[i]);
+			return false;
+		}
+
+		r_index = i;
+		return true;
+	}
+
+	return false;
+}
+
+static void MCDnsCacheStore(MCNameRef p_key, bool p_resolved, const MCDnsAddressList& p_addresses, real64_t p_now)
+{
+	MCDnsAddressList t_addresses;
+	if (!MCDnsAddressListCopy(p_addresses, t_addresses))
+		return;
+
+	// Reuse the entry for the key if there is one, otherwise take a free slot
+	// or evict whichever entry is closest to expiring.
+	uindex_t t_slot;
+	t_slot = 0;
+	for(uindex_t i = 0; i < DNS_CACHE_SIZE; i++)
+	{
+		if (s_dns_cache[i] . key != nil &&
+			MCNameIsEqualToCaseless(s_dns_cache[i] . key, p_key))
+		{
+			t_slot = i;
+			break;
+		}
+
+		if (s_dns_cache[t_slot] . key == nil)
+			continue;
+
+		if (s_dns_cache[i] . key == nil ||
+			s_dns_cache[i] . expires < s_dns_cache[t_slot] . expires)
+			t_slot = i;
+	}
+
+	MCDnsCacheClearEntry(s_dns_cache[t_slot]);
+	s_dns_cache[t_slot] . key = MCValueRetain(p_key);
+	s_dns_cache[t_slot] . resolved = p_resolved;
+	s_dns_cache[t_slot] . addresses = t_addresses;
+	s_dns_cache[t_slot] . expires = p_now + (p_resolved ? DNS_CACHE_POSITIVE_TTL : DNS_CACHE_NEGATIVE_TTL);
+}
+
+static MCDnsPendingLookup *MCDnsCacheFindPending(MCNameRef p_key)
+{
+	for(MCDnsPendingLookup *t_lookup = s_dns_pending_lookups; t_lookup != nil; t_lookup = t_lookup -> next)
+		if (MCNameIsEqualToCaseless(t_lookup -> key, p_key))
+			return t_lookup;
+	return nil;
+}
+
+static bool MCDnsPendingLookupAddWaiter(MCDnsPendingLookup *p_lookup, MCDnsLookupWaiterCallback p_callback, void *p_context)
+{
+	uindex_t t_count;
+	t_count = p_lookup -> waiter_count;
+	if (!MCMemoryResizeArray(t_count + 1, p_lookup -> waiters, t_count))
+		return false;
+
+	p_lookup -> waiters[p_lookup -> waiter_count] . callback = p_callback;
+	p_lookup -> waiters[p_lookup -> waiter_count] . context = p_context;
+	p_lookup -> waiter_count = t_count;
+	return true;
+}
+
+static void MCDnsPendingLookupDestroy(MCDnsPendingLookup *p_lookup)
+{
+	MCValueRelease(p_lookup -> key);
+	MCMemoryDeleteArray(p_lookup -> waiters);
+	MCMemoryDelete(p_lookup);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool MCDnsCacheBeginLookup(MCNameRef p_key, MCDnsLookupWaiterCallback p_callback, void *p_context, MCDnsLookupStatus& r_status, bool& r_resolved, MCDnsAddressList& r_addresses)
+{
+	uindex_t t_index;
+	if (MCDnsCacheFind(p_key, MCDnsCacheNow(), t_index))
+	{
+		if (!MCDnsAddressListCopy(s_dns_cache[t_index] . addresses, r_addresses))
+			return false;
+
+		if (s_dns_cache[t_index] . resolved)
+			s_dns_cache_hits++;
+		else
+			s_dns_cache_negative_hits++;
+
+		r_resolved = s_dns_cache[t_index] . resolved;
+		r_status = kMCDnsLookupHit;
+		return true;
+	}
+
+	MCDnsPendingLookup *t_lookup;
+	t_lookup = MCDnsCacheFindPending(p_key);
+	if (t_lookup != nil)
+	{
+		if (!MCDnsPendingLookupAddWaiter(t_lookup, p_callback, p_context))
+			return false;
+
+		s_dns_cache_coalesced++;
+		r_status = kMCDnsLookupCoalesced;
+		return true;
+	}
+
+	if (!MCMemoryNew(t_lookup))
+		return false;
+
+	t_lookup -> key = MCValueRetain(p_key);
+	if (!MCDnsPendingLookupAddWaiter(t_lookup, p_callback, p_context))
+	{
+		MCDnsPendingLookupDestroy(t_lookup);
+		return false;
+	}
+
+	t_lookup -> next = s_dns_pending_lookups;
+	s_dns_pending_lookups = t_lookup;
+
+	s_dns_cache_misses++;
+	r_status = kMCDnsLookupStarted;
+	return true;
+}
+
+static MCDnsPendingLookup *MCDnsCacheRemovePending(MCNameRef p_key)
+{
+	for(MCDnsPendingLookup **t_link = &s_dns_pending_lookups; *t_link != nil; t_link = &(*t_link) -> next)
+		if (MCNameIsEqualToCaseless((*t_link) -> key, p_key))
+		{
+			MCDnsPendingLookup *t_lookup;
+			t_lookup = *t_link;
+			*t_link = t_lookup -> next;
+			return t_lookup;
+		}
+	return nil;
+}
+
+void MCDnsCacheEndLookup(MCNameRef p_key, bool p_resolved, const MCDnsAddressList& p_addresses)
+{
+	MCDnsCacheStore(p_key, p_resolved, p_addresses, MCDnsCacheNow());
+
+	// Unlink the pending lookup before notifying any of its waiters, so that a
+	// waiter which looks the key up again sees the cached outcome.
+	MCDnsPendingLookup *t_lookup;
+	t_lookup = MCDnsCacheRemovePending(p_key);
+	if (t_lookup == nil)
+		return;
+
+	for(uindex_t i = 0; i < t_lookup -> waiter_count; i++)
+		t_lookup -> waiters[i] . callback(t_lookup -> waiters[i] . context, p_resolved, p_addresses);
+
+	MCDnsPendingLookupDestroy(t_lookup);
+}
+
+void MCDnsCacheCancelLookup(MCNameRef p_key)
+{
+	MCDnsPendingLookup *t_lookup;
+	t_lookup = MCDnsCacheRemovePending(p_key);
+	if (t_lookup != nil)
+		MCDnsPendingLookupDestroy(t_lookup);
+}
+
+void MCDnsCacheFlush(void)
+{
+	for(uindex_t i = 0; i < DNS_CACHE_SIZE; i++)
+		if (s_dns_cache[i] . key != nil)
+			MCDnsCacheClearEntry(s_dns_cache[i]);
+}
+
+void MCDnsCacheFinalize(void)
+{
+	MCDnsCacheFlush();
+
+	while(s_dns_pending_lookups != nil)
+	{
+		MCDnsPendingLookup *t_lookup;
+		t_lookup = s_dns_pending_lookups;
+		s_dns_pending_lookups = t_lookup -> next;
+		MCDnsPendingLookupDestroy(t_lookup);
+	}
+
+	s_dns_cache_hits = 0;
+	s_dns_cache_negative_hits = 0;
+	s_dns_cache_misses = 0;
+	s_dns_cache_coalesced = 0;
+}
+
+void MCDnsCacheGetStatistics(MCDnsCacheStatistics& r_statistics)
+{
+	r_statistics . hits = s_dns_cache_hits;
+	r_statistics . negative_hits = s_dns_cache_negative_hits;
+	r_statistics . misses = s_dns_cache_misses;
+	r_statistics . coalesced = s_dns_cache_coalesced;
+
+	r_statistics . entries = 0;
+	real64_t t_now;
+	t_now = MCDnsCacheNow();
+	for(uindex_t i = 0; i < DNS_CACHE_SIZE; i++)
+		if (s_dns_cache[i] . key != nil && s_dns_cache[i] . expires > t_now)
+			r_statistics . entries++;
+
+	r_statistics . pending = 0;
+	for(MCDnsPendingLookup *t_lookup = s_dns_pending_lookups; t_lookup != nil; t_lookup = t_lookup -> next)
+		r_statistics . pending++;
+}
+
+void MCDnsCacheSetClock(MCDnsCacheClockCallback p_clock)
+{
+	s_dns_cache_clock = p_clock;
+}
@@ -0,0 +1,105 @@
+/* Copyright (C) 2003-2015 LiveCode Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+#ifndef DNSCACHE_H
+#define DNSCACHE_H
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The DNS cache remembers the outcome of host name lookups for a short time,
+// and coalesces concurrent lookups of the same key so that only one of them
+// is actually performed. It does not resolve anything itself - the caller
+// performs the lookup for any key for which MCDnsCacheBeginLookup reports
+// kMCDnsLookupStarted, and hands the outcome back via MCDnsCacheEndLookup.
+//
+// All of these functions must be called on the main thread.
+
+// How long (in seconds) successful and failed lookups are remembered for.
+#define DNS_CACHE_POSITIVE_TTL 60.0
+#define DNS_CACHE_NEGATIVE_TTL 10.0
+
+// The maximum number of lookups which are remembered.
+#define DNS_CACHE_SIZE 128
+
+struct MCDnsAddress
+{
+	struct sockaddr *addr;
+	int addrlen;
+};
+
+struct MCDnsAddressList
+{
+	MCDnsAddress *addresses;
+	uindex_t count;
+};
+
+bool MCDnsAddressListAppend(MCDnsAddressList& x_list, const struct sockaddr *p_addr, int p_addrlen);
+bool MCDnsAddressListCopy(const MCDnsAddressList& p_list, MCDnsAddressList& r_copy);
+void MCDnsAddressListClear(MCDnsAddressList& x_list);
+
+enum MCDnsLookupStatus
+{
+	// The outcome was cached, and has been returned directly.
+	kMCDnsLookupHit,
+	// A lookup for the key is already in progress and the waiter has been
+	// added to it.
+	kMCDnsLookupCoalesced,
+	// A new lookup for the key has been registered with the waiter, and the
+	// caller must now perform it.
+	kMCDnsLookupStarted,
+};
+
+// Called for each waiter on a lookup when it completes.
+typedef void (*MCDnsLookupWaiterCallback)(void *p_context, bool p_resolved, const MCDnsAddressList& p_addresses);
+
+// Looks up p_key in the cache. On a hit, r_resolved and r_addresses are set
+// from the cached outcome (r_addresses must be cleared by the caller).
+// Otherwise, the waiter is attached to the in-progress lookup for the key.
+bool MCDnsCacheBeginLookup(MCNameRef p_key, MCDnsLookupWaiterCallback p_callback, void *p_context, MCDnsLookupStatus& r_status, bool& r_resolved, MCDnsAddressList& r_addresses);
+
+// Records the outcome of the lookup for p_key and notifies all its waiters.
+void MCDnsCacheEndLookup(MCNameRef p_key, bool p_resolved, const MCDnsAddressList& p_addresses);
+
+// Abandons the lookup for p_key without notifying its waiters, for use when
+// it could not be started.
+void MCDnsCacheCancelLookup(MCNameRef p_key);
+
+// Forgets all cached outcomes. Lookups which are in progress are unaffected.
+void MCDnsCacheFlush(void);
+
+// Releases all resources held by the cache.
+void MCDnsCacheFinalize(void);
+
+struct MCDnsCacheStatistics
+{
+	uint32_t hits;
+	uint32_t negative_hits;
+	uint32_t misses;
+	uint32_t coalesced;
+	uint32_t entries;
+	uint32_t pending;
+};
+
+void MCDnsCacheGetStatistics(MCDnsCacheStatistics& r_statistics);
+
+// The cache uses MCS_time by default to expire entries - this allows another
+// clock to be used instead (passing NULL restores the default).
+typedef real64_t (*MCDnsCacheClockCallback)(void);
+void MCDnsCacheSetClock(MCDnsCacheClockCallback p_clock);
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
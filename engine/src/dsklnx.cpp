@@ -36,6 +36,7 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "globals.h"
 //#include "ports.cpp"
 #include "socket.h"
+#include "srveventloop.h"
 //#include "mcssl.h"
 //#include "securemode.h"
 #include "mode.h"
@@ -1949,6 +1950,90 @@ public:
         }
     }
 
+#if defined(_LINUX_SERVER)
+    // The server has no UI connection or GLib sources to wait on, so waits on
+    // its sockets, URL loads and pipes with the event loop. The sockets stay
+    // registered with the loop, so only the other descriptors are watched
+    // here. Notifications from other threads wake the event loop directly.
+    //
+    // Pipes to processes opened with 'open process' are not watched - reads
+    // from them still wait for a fixed interval between attempts.
+    virtual Boolean Poll(real8 p_delay, int p_fd)
+    {
+        Boolean readinput = False;
+        Boolean wasalarm = alarmpending;
+        if (alarmpending)
+            MCS_alarm(0.0);
+
+        if (MCshellfd != -1)
+            MCServerEventLoopWatch(MCshellfd, kMCServerEventLoopRead);
+        if (MCinputfd != -1)
+            MCServerEventLoopWatch(MCinputfd, kMCServerEventLoopRead);
+
+        // The mode hooks describe the descriptors they are interested in with
+        // fd_sets, and can close them between waits.
+        fd_set rmaskfd, wmaskfd, emaskfd;
+        FD_ZERO(&rmaskfd);
+        FD_ZERO(&wmaskfd);
+        FD_ZERO(&emaskfd);
+        int4 maxfd = -1;
+        MCModePreSelectHook(maxfd, rmaskfd, wmaskfd, emaskfd);
+        for (int4 fd = 0; fd <= maxfd; fd++)
+        {
+            uint32_t t_events;
+            t_events = 0;
+            if (FD_ISSET(fd, &rmaskfd) || FD_ISSET(fd, &emaskfd))
+                t_events |= kMCServerEventLoopRead;
+            if (FD_ISSET(fd, &wmaskfd))
+                t_events |= kMCServerEventLoopWrite;
+            if (t_events != 0)
+                MCServerEventLoopWatch(fd, t_events);
+        }
+
+        int n;
+        n = MCServerEventLoopWait(p_delay);
+
+        if (n <= 0)
+            return False;
+        if (MCshellfd != -1 && (MCServerEventLoopGetReadyEvents(MCshellfd) & kMCServerEventLoopRead) != 0)
+            return True;
+        if (MCinputfd != -1 && (MCServerEventLoopGetReadyEvents(MCinputfd) & kMCServerEventLoopRead) != 0)
+            readinput = True;
+
+        MCSocketsHandleEventLoop();
+
+        for (int4 fd = 0; fd <= maxfd; fd++)
+        {
+            uint32_t t_events;
+            t_events = MCServerEventLoopGetReadyEvents(fd);
+            if ((t_events & kMCServerEventLoopRead) == 0)
+            {
+                FD_CLR(fd, &rmaskfd);
+                FD_CLR(fd, &emaskfd);
+            }
+            if ((t_events & kMCServerEventLoopWrite) == 0)
+                FD_CLR(fd, &wmaskfd);
+        }
+        MCModePostSelectHook(rmaskfd, wmaskfd, emaskfd);
+
+        if (readinput)
+        {
+            int commandsize;
+            ioctl(MCinputfd, FIONREAD, (char *)&commandsize);
+            MCAutoArray<char> t_commands;
+            MCAutoStringRef t_cmd_string;
+
+            t_commands.New(commandsize + 1);
+            read(MCinputfd, t_commands.Ptr(), commandsize);
+            t_commands.Ptr()[commandsize] = '\0';
+            /* UNCHECKED */ MCStringCreateWithSysString(t_commands.Ptr(), &t_cmd_string);
+            MCdefaultstackptr->getcurcard()->domess(*t_cmd_string);
+        }
+        if (wasalarm)
+            Alarm(CHECK_INTERVAL);
+        return True;
+    }
+#else
     virtual Boolean Poll(real8 p_delay, int p_fd)
     {
         Boolean readinput = False;
@@ -2078,6 +2163,7 @@ public:
             Alarm(CHECK_INTERVAL);
         return True;
     }
+#endif
 
     virtual Boolean IsInteractiveConsole(int p_fd)
     {
@@ -3453,7 +3453,7 @@ cleanup:
 	{
 		Boolean handled = False;
 		int4 n;
-		uint2 i;
+		uint4 i;
 		fd_set rmaskfd, wmaskfd, emaskfd;
 		FD_ZERO(&rmaskfd);
 		FD_ZERO(&wmaskfd);
@@ -21,6 +21,7 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "objdefs.h"
 #include "parsedef.h"
 #include "mcio.h"
+#include "osspec.h"
 
 #include "globals.h"
 #include "util.h"
@@ -243,6 +244,14 @@ void MCFiltersEvalCompress(MCExecContext& ctxt, MCDataRef p_source, MCDataRef& r
 		ctxt.LegacyThrow(EE_COMPRESS_ERROR);
 }
 
+void MCFiltersEvalCompressWithLevel(MCExecContext& ctxt, MCDataRef p_source, integer_t p_level, MCDataRef& r_result)
+{
+	if (p_level < 0 || p_level > 9)
+		ctxt.LegacyThrow(EE_COMPRESS_BADLEVEL);
+	else if (!MCFiltersCompressWithLevel(p_source, p_level, r_result))
+		ctxt.LegacyThrow(EE_COMPRESS_ERROR);
+}
+
 void MCFiltersEvalDecompress(MCExecContext& ctxt, MCDataRef p_source, MCDataRef& r_result)
 {
 	if (!MCFiltersIsCompressed(p_source))
@@ -251,6 +260,75 @@ void MCFiltersEvalDecompress(MCExecContext& ctxt, MCDataRef p_source, MCDataRef&
 		ctxt.LegacyThrow(EE_DECOMPRESS_ERROR);
 }
 
+static bool MCFiltersReadFile(void *p_context, void *r_buffer, size_t p_max_size, size_t& r_size)
+{
+	uint32_t t_read;
+	t_read = 0;
+	if (MCS_readall(r_buffer, uint32_t(MCMin(p_max_size, size_t(UINT32_MAX))), static_cast<IO_handle>(p_context), t_read) == IO_ERROR)
+		return false;
+	r_size = t_read;
+	return true;
+}
+
+static bool MCFiltersWriteFile(void *p_context, const void *p_buffer, size_t p_size)
+{
+	return MCS_write(p_buffer, 1, uint4(p_size), static_cast<IO_handle>(p_context)) == IO_NORMAL;
+}
+
+// The file forms stream through the compressor, so only a few blocks of the
+// file are held in memory at once.
+static void MCFiltersExecCompressOrDecompressFile(MCExecContext& ctxt, MCStringRef p_source, MCStringRef p_dest, bool p_decompress)
+{
+	if (!ctxt . EnsureDiskAccessIsAllowed())
+		return;
+
+	IO_handle t_source;
+	t_source = MCS_open(p_source, kMCOpenFileModeRead, False, False, 0);
+	if (t_source == NULL)
+	{
+		ctxt . SetTheResultToStaticCString("can't open file");
+		return;
+	}
+
+	IO_handle t_dest;
+	t_dest = MCS_open(p_dest, kMCOpenFileModeWrite, False, False, 0);
+	if (t_dest == NULL)
+	{
+		MCS_close(t_source);
+		ctxt . SetTheResultToStaticCString("can't open file");
+		return;
+	}
+
+	bool t_success;
+	if (p_decompress)
+		t_success = MCFiltersDecompressStream(MCFiltersReadFile, t_source, MCFiltersWriteFile, t_dest);
+	else
+		t_success = MCFiltersCompressStream(MCFiltersReadFile, t_source, MCFiltersWriteFile, t_dest, -1);
+
+	MCS_close(t_source);
+	MCS_close(t_dest);
+
+	if (!t_success)
+	{
+		// Don't leave a truncated file behind.
+		MCS_unlink(p_dest);
+		ctxt . SetTheResultToStaticCString(p_decompress ? "can't decompress file" : "can't compress file");
+		return;
+	}
+
+	ctxt . SetTheResultToEmpty();
+}
+
+void MCFiltersExecCompressFile(MCExecContext& ctxt, MCStringRef p_source, MCStringRef p_dest)
+{
+	MCFiltersExecCompressOrDecompressFile(ctxt, p_source, p_dest, false);
+}
+
+void MCFiltersExecDecompressFile(MCExecContext& ctxt, MCStringRef p_source, MCStringRef p_dest)
+{
+	MCFiltersExecCompressOrDecompressFile(ctxt, p_source, p_dest, true);
+}
+
 //////////
 
 void MCFiltersEvalBase64Decode(MCExecContext& ctxt, MCStringRef p_source, MCDataRef& r_result)
@@ -357,6 +435,363 @@ static bool MCU_gettemplate(MCStringRef format, uindex_t &x_offset, unichar_t &c
     return true;
 }
 
+//////////
+
+// Binary formats are compiled into a list of templates the first time they are
+// used. The most recently used formats are kept, as scripts which decode a file
+// record by record use the same few formats over and over.
+#define kMCBinaryFormatCacheSize 16
+
+struct MCBinaryTemplate
+{
+	unichar_t cmd;
+	uindex_t count;
+	MCStringEncoding encoding;
+};
+
+struct MCBinaryFormat
+{
+	MCStringRef source;
+	MCBinaryTemplate *templates;
+	uindex_t template_count;
+	// The format has a bad template after the last one. It is only an error
+	// if the data reaches it.
+	bool bad_template;
+	uint32_t last_used;
+};
+
+static MCBinaryFormat s_binary_formats[kMCBinaryFormatCacheSize];
+static uint32_t s_binary_format_clock = 0;
+
+static void MCBinaryFormatClear(MCBinaryFormat& x_format)
+{
+	MCValueRelease(x_format . source);
+	MCMemoryDeleteArray(x_format . templates);
+	x_format . source = nil;
+	x_format . templates = nil;
+	x_format . template_count = 0;
+	x_format . bad_template = false;
+	x_format . last_used = 0;
+}
+
+static bool MCBinaryFormatCompile(MCStringRef p_source, MCBinaryFormat& r_format)
+{
+	MCAutoArray<MCBinaryTemplate> t_templates;
+	bool t_bad_template = false;
+
+	uindex_t t_length = MCStringGetLength(p_source);
+	uindex_t t_offset = 0;
+	while (t_offset < t_length)
+	{
+		MCBinaryTemplate t_template;
+		t_template . encoding = kMCStringEncodingNative;
+		if (!MCU_gettemplate(p_source, t_offset, t_template . cmd, t_template . count, t_template . encoding))
+		{
+			t_bad_template = true;
+			break;
+		}
+
+		if (!t_templates . Push(t_template))
+			return false;
+	}
+
+	r_format . source = MCValueRetain(p_source);
+	t_templates . Take(r_format . templates, r_format . template_count);
+	r_format . bad_template = t_bad_template;
+	return true;
+}
+
+// Returns the compiled form of p_source, which stays valid until the next
+// lookup.
+static const MCBinaryFormat *MCBinaryFormatLookup(MCStringRef p_source)
+{
+	MCBinaryFormat *t_oldest = &s_binary_formats[0];
+	for(uindex_t i = 0; i < kMCBinaryFormatCacheSize; i++)
+	{
+		MCBinaryFormat& t_format = s_binary_formats[i];
+		if (t_format . source != nil &&
+			(t_format . source == p_source || MCStringIsEqualTo(t_format . source, p_source, kMCStringOptionCompareExact)))
+		{
+			t_format . last_used = ++s_binary_format_clock;
+			return &t_format;
+		}
+
+		if (t_format . last_used < t_oldest -> last_used)
+			t_oldest = &t_format;
+	}
+
+	MCBinaryFormat t_new;
+	if (!MCBinaryFormatCompile(p_source, t_new))
+		return nil;
+
+	MCBinaryFormatClear(*t_oldest);
+	*t_oldest = t_new;
+	t_oldest -> last_used = ++s_binary_format_clock;
+	return t_oldest;
+}
+
+void MCFiltersBinaryFormatsFinalize(void)
+{
+	for(uindex_t i = 0; i < kMCBinaryFormatCacheSize; i++)
+		MCBinaryFormatClear(s_binary_formats[i]);
+}
+
+//////////
+
+// Returns the number of bytes a value of a numeric template takes, or 0 if the
+// template is not numeric.
+static uindex_t MCBinaryNumberSize(unichar_t p_cmd)
+{
+	switch (p_cmd)
+	{
+	case 'c':
+	case 'C':
+		return sizeof(int1);
+	case 's':
+	case 'S':
+	case 'm':
+	case 'n':
+		return sizeof(int2);
+	case 'i':
+	case 'I':
+	case 'M':
+	case 'N':
+		return sizeof(int4);
+	case 'f':
+		return sizeof(float);
+	case 'd':
+		return sizeof(double);
+	default:
+		return 0;
+	}
+}
+
+static real64_t MCBinaryReadNumber(unichar_t p_cmd, const byte_t *p_src)
+{
+	switch (p_cmd)
+	{
+	case 'c':
+		return (int1)p_src[0];
+	case 'C':
+		return p_src[0];
+	case 's':
+		{
+			int2 c;
+			memcpy(&c, p_src, sizeof(int2));
+			return c;
+		}
+	case 'S':
+		{
+			uint2 c;
+			memcpy(&c, p_src, sizeof(uint2));
+			return c;
+		}
+	case 'i':
+		{
+			int4 c;
+			memcpy(&c, p_src, sizeof(int4));
+			return c;
+		}
+	case 'I':
+		{
+			uint4 c;
+			memcpy(&c, p_src, sizeof(uint4));
+			return c;
+		}
+	case 'm':
+		{
+			uint2 c;
+			memcpy(&c, p_src, sizeof(uint2));
+			return MCSwapInt16HostToNetwork(c);
+		}
+	case 'M':
+		{
+			uint4 c;
+			memcpy(&c, p_src, sizeof(uint4));
+			return MCSwapInt32HostToNetwork(c);
+		}
+
+	// MW-2007-09-11: [[ Bug 5315 ]] Make sure we coerce to signed integers
+	//   before we convert to doubles - failing to do this results in getting
+	//   unsigned results on little endian machines.
+	case 'n':
+		{
+			int2 c;
+			memcpy(&c, p_src, sizeof(int2));
+			return (int2)MCSwapInt16HostToNetwork(c);
+		}
+	case 'N':
+		{
+			int4 c;
+			memcpy(&c, p_src, sizeof(int4));
+			return (int4)MCSwapInt32HostToNetwork(c);
+		}
+
+	case 'f':
+		{
+			float f;
+			memcpy(&f, p_src, sizeof(float));
+			return f;
+		}
+	case 'd':
+		{
+			double d;
+			memcpy(&d, p_src, sizeof(double));
+			return d;
+		}
+	default:
+		return 0;
+	}
+}
+
+// Decodes the a, A, b, B, h, H, u and U templates. The count is the number of
+// bytes, bits or nibbles as appropriate, all of which must be present.
+static bool MCBinaryDecodeString(unichar_t p_cmd, const byte_t *p_src, uindex_t p_count, MCStringEncoding p_encoding, MCStringRef& r_string)
+{
+	switch (p_cmd)
+	{
+	case 'a':
+	case 'A':
+		{
+			uint4 size = p_count;
+			if (p_cmd == 'A')
+			{
+				while (size > 0)
+				{
+					if (p_src[size - 1] != '\0' && p_src[size - 1] != ' ')
+						break;
+					size--;
+				}
+			}
+
+			return MCStringCreateWithBytes(p_src, size, kMCStringEncodingNative, false, r_string);
+		}
+	case 'b':
+	case 'B':
+		{
+			const uint1 *src = p_src;
+			uint1 value = 0;
+
+			MCAutoNativeCharArray t_buffer;
+			if (!t_buffer.New(p_count))
+				return false;
+
+			char_t *dest = t_buffer.Chars();
+			if (p_cmd == 'b')
+			{
+				for (uindex_t i = 0 ; i < p_count ; i++)
+				{
+					if (i % 8)
+						value >>= 1;
+					else
+						value = *src++;
+					*dest++ = (value & 1) ? '1' : '0';
+				}
+			}
+			else
+			{
+				for (uindex_t i = 0 ; i < p_count ; i++)
+				{
+					if (i % 8)
+						value <<= 1;
+					else
+						value = *src++;
+					*dest++ = (value & 0x80) ? '1' : '0';
+				}
+			}
+			return t_buffer.CreateStringAndRelease(r_string);
+		}
+	case 'h':
+	case 'H':
+		{
+			const uint1 *src = p_src;
+			uint1 value = 0;
+			MCAutoNativeCharArray t_buffer;
+			if (!t_buffer.New(p_count))
+				return false;
+
+			char_t *dest;
+			dest = t_buffer.Chars();
+			static char hexdigit[] = "0123456789abcdef";
+			if (p_cmd == 'h')
+				for (uindex_t i = 0 ; i < p_count ; i++)
+				{
+					if (i % 2)
+						value >>= 4;
+					else
+						value = *src++;
+					*dest++ = hexdigit[value & 0xf];
+				}
+			else
+				for (uindex_t i = 0 ; i < p_count ; i++)
+				{
+					if (i % 2)
+						value <<= 4;
+					else
+						value = *src++;
+					*dest++ = hexdigit[(value >> 4) & 0xf];
+				}
+
+			return t_buffer.CreateStringAndRelease(r_string);
+		}
+	case 'u':
+	case 'U':
+		{
+			uindex_t t_size = p_count;
+
+			if (p_cmd == 'U')
+			{
+				// We need to skip all the spaces
+				MCAutoDataRef t_encoded_space;
+				MCStringEncode(MCSTR(" "), p_encoding, false, &t_encoded_space);
+
+				const byte_t* t_space_ptr = MCDataGetBytePtr(*t_encoded_space);
+				uindex_t t_space_length = MCDataGetLength(*t_encoded_space);
+
+				bool t_space_skipped = false;
+				uindex_t t_temp_size = t_size;
+
+				while (!t_space_skipped)
+				{
+					// stop looking for spaces when an encoded space char won't fit within the remaining data
+					if (t_space_length > t_temp_size)
+					{
+						// No char remaining
+						t_space_skipped = true;
+					}
+					else
+					{
+						bool t_is_space = true;
+
+						// Compare the encoded spaces
+						for (uindex_t i = 0; i < t_space_length && t_is_space; ++i)
+							t_is_space = p_src[t_temp_size - 1 - (t_space_length - 1) + i] == t_space_ptr[i];
+
+						if (t_is_space)
+						{
+							t_size = t_temp_size - t_space_length;
+							t_temp_size = t_size;
+						}
+						else
+						{
+							// The byte might be offset, we need to try to offset at most the size of the encoded space
+							if (t_size - t_temp_size == t_space_length)
+								t_space_skipped = true;
+							else
+								--t_temp_size;
+						}
+
+					}
+				}
+			}
+
+			return MCStringCreateWithBytes(p_src, t_size, p_encoding, false, r_string);
+		}
+	default:
+		return false;
+	}
+}
+
 void MCFiltersEvalBinaryDecode(MCExecContext& ctxt, MCStringRef p_format, MCDataRef p_data, MCValueRef *r_results, uindex_t p_result_count, integer_t& r_done)
 {
 	if (p_data == nil)
@@ -365,10 +800,13 @@ void MCFiltersEvalBinaryDecode(MCExecContext& ctxt, MCStringRef p_format, MCData
 		return;
 	}
 
-    uindex_t t_format_length;
-    uindex_t t_format_index;
-    t_format_length = MCStringGetLength(p_format);
-    t_format_index = 0;
+	const MCBinaryFormat *t_format;
+	t_format = MCBinaryFormatLookup(p_format);
+	if (t_format == nil)
+	{
+		ctxt . Throw();
+		return;
+	}
 
 	const byte_t *t_data_ptr = MCDataGetBytePtr(p_data);
 	uindex_t length = MCDataGetLength(p_data);
@@ -379,19 +817,23 @@ void MCFiltersEvalBinaryDecode(MCExecContext& ctxt, MCStringRef p_format, MCData
 
 	bool t_success = true;
 
-	while (t_success && t_format_index < t_format_length && offset < length)
+	for (uindex_t t_template = 0; t_success && offset < length; t_template++)
 	{
-		unichar_t cmd;
-		uindex_t count;
-        MCStringEncoding t_encoding = kMCStringEncodingNative;
+		if (t_template == t_format -> template_count)
+		{
+			if (t_format -> bad_template)
+			{
+				// Invalid format specified
+				ctxt . Throw();
+				return;
+			}
+			break;
+		}
+
+		unichar_t cmd = t_format -> templates[t_template] . cmd;
+		uindex_t count = t_format -> templates[t_template] . count;
+		MCStringEncoding t_encoding = t_format -> templates[t_template] . encoding;
 
-		if (!MCU_gettemplate(p_format, t_format_index, cmd, count, t_encoding))
-        {
-            // Invalid format specified
-            ctxt . Throw();
-            return;
-        }
-            
 		if (count == 0 && cmd != '@')
 			continue;
 
@@ -413,19 +855,8 @@ void MCFiltersEvalBinaryDecode(MCExecContext& ctxt, MCStringRef p_format, MCData
 						count = 1;
 				if (count > length - offset)
 					break;
-				const byte_t *src = t_data_ptr + offset;
-				uint4 size = count;
-				if (cmd == 'A')
-				{
-					while (size > 0)
-					{
-						if (src[size - 1] != '\0' && src[size - 1] != ' ')
-							break;
-						size--;
-					}
-				}
 
-				t_success = MCStringCreateWithBytes(t_data_ptr + offset, size, kMCStringEncodingNative, false, (MCStringRef&)r_results[t_index]);
+				t_success = MCBinaryDecodeString(cmd, t_data_ptr + offset, count, t_encoding, (MCStringRef&)r_results[t_index]);
 
 				done++;
 				offset += count;
@@ -441,38 +872,8 @@ void MCFiltersEvalBinaryDecode(MCExecContext& ctxt, MCStringRef p_format, MCData
 						count = 1;
 				if (count > (length - offset) * 8)
 					break;
-				uint1 *src = (uint1 *)t_data_ptr + offset;
-				uint1 value = 0;
 
-				MCAutoNativeCharArray t_buffer;
-				t_success = t_buffer.New(count);
-				if (!t_success)
-					break;
-
-				char_t *dest = t_buffer.Chars();
-				if (cmd == 'b')
-				{
-					for (uindex_t i = 0 ; i < count ; i++)
-					{
-						if (i % 8)
-							value >>= 1;
-						else
-							value = *src++;
-						*dest++ = (value & 1) ? '1' : '0';
-					}
-				}
-				else
-				{
-					for (uindex_t i = 0 ; i < count ; i++)
-					{
-						if (i % 8)
-							value <<= 1;
-						else
-							value = *src++;
-						*dest++ = (value & 0x80) ? '1' : '0';
-					}
-				}
-				t_success = t_buffer.CreateStringAndRelease((MCStringRef&)r_results[t_index]);
+				t_success = MCBinaryDecodeString(cmd, t_data_ptr + offset, count, t_encoding, (MCStringRef&)r_results[t_index]);
 				
 				done++;
 				offset += (count + 7 ) / 8;
@@ -488,36 +889,8 @@ void MCFiltersEvalBinaryDecode(MCExecContext& ctxt, MCStringRef p_format, MCData
 						count = 1;
 				if (count > (length - offset) * 2)
 					break;
-				uint1 *src = (uint1 *)t_data_ptr + offset;
-				uint1 value = 0;
-				MCAutoNativeCharArray t_buffer;
-				t_success = t_buffer.New(count);
-				if (!t_success)
-					break;
 
-				char_t *dest;
-				dest = t_buffer.Chars();
-				static char hexdigit[] = "0123456789abcdef";
-				if (cmd == 'h')
-					for (uindex_t i = 0 ; i < count ; i++)
-					{
-						if (i % 2)
-							value >>= 4;
-						else
-							value = *src++;
-						*dest++ = hexdigit[value & 0xf];
-					}
-				else
-					for (uindex_t i = 0 ; i < count ; i++)
-					{
-						if (i % 2)
-							value <<= 4;
-						else
-							value = *src++;
-						*dest++ = hexdigit[(value >> 4) & 0xf];
-					}
-				
-				t_success = t_buffer.CreateStringAndRelease((MCStringRef&)r_results[t_index]);
+				t_success = MCBinaryDecodeString(cmd, t_data_ptr + offset, count, t_encoding, (MCStringRef&)r_results[t_index]);
 
 				done++;
 				offset += (count + 1) / 2;
@@ -535,205 +908,44 @@ void MCFiltersEvalBinaryDecode(MCExecContext& ctxt, MCStringRef p_format, MCData
 		case 'N':
 		case 'f':
 		case 'd':
-			if (count == BINARY_ALL || count == BINARY_NOCOUNT)
-				count = 1;
-			while (t_success && count--)
 			{
-				uindex_t oldoffset = offset;
-				real64_t t_number;
-				switch (cmd)
-				{
-				case 'c':
-					if (offset + (int4)sizeof(int1) <= length)
-					{
-						int1 c;
-						memcpy(&c, t_data_ptr + offset, sizeof(int1));
-						t_number = c;
-						offset += sizeof(int1);
-					}
-					break;
-				case 'C':
-					if (offset + (int4)sizeof(uint1) <= length)
-					{
-						uint1 c;
-						memcpy(&c, t_data_ptr + offset, sizeof(uint1));
-						t_number = c;
-						offset += sizeof(uint1);
-					}
-					break;
-				case 's':
-					if (offset + (int4)sizeof(int2) <= length)
-					{
-						int2 c;
-						memcpy(&c, t_data_ptr + offset, sizeof(int2));
-						t_number = c;
-						offset += sizeof(int2);
-					}
-					break;
-				case 'S':
-					if (offset + (int4)sizeof(uint2) <= length)
-					{
-						uint2 c;
-						memcpy(&c, t_data_ptr + offset, sizeof(uint2));
-						t_number = c;
-						offset += sizeof(uint2);
-					}
-					break;
-				case 'i':
-					if (offset + (int4)sizeof(int4) <= length)
-					{
-						int4 c;
-						memcpy(&c, t_data_ptr + offset, sizeof(int4));
-						t_number = c;
-						offset += sizeof(int4);
-					}
-					break;
-				case 'I':
-					if (offset + (int4)sizeof(uint4) <= length)
-					{
-						uint4 c;
-						memcpy(&c, t_data_ptr + offset, sizeof(uint4));
-						t_number = c;
-						offset += sizeof(uint4);
-					}
-					break;
-				case 'm':
-					if (offset + (int4)sizeof(uint2) <= length)
-					{
-						uint2 c;
-						memcpy(&c, t_data_ptr + offset, sizeof(uint2));
-						t_number = MCSwapInt16HostToNetwork(c);
-						offset += sizeof(int2);
-					}
-					break;
-				case 'M':
-					if (offset + (int4)sizeof(uint4) <= length)
-					{
-						uint4 c;
-						memcpy(&c, t_data_ptr + offset, sizeof(uint4));
-						t_number = MCSwapInt32HostToNetwork(c);
-						offset += sizeof(uint4);
-					}
-					break;
+				if (count == BINARY_ALL || count == BINARY_NOCOUNT)
+					count = 1;
 
-				// MW-2007-09-11: [[ Bug 5315 ]] Make sure we coerce to signed integers
-				//   before we convert to doubles - failing to do this results in getting
-				//   unsigned results on little endian machines.
-				case 'n':
-					if (offset + (int4)sizeof(int2) <= length)
-					{
-						int2 c;
-						memcpy(&c, t_data_ptr + offset, sizeof(int2));
-						t_number = (int2)MCSwapInt16HostToNetwork(c);
-						offset += sizeof(int2);
-					}
-					break;
-				case 'N':
-					if (offset + (int4)sizeof(int4) <= length)
+				uindex_t t_size = MCBinaryNumberSize(cmd);
+				while (t_success && count--)
+				{
+					if (length - offset < t_size)
 					{
-						int4 c;
-						memcpy(&c, t_data_ptr + offset, sizeof(int4));
-						t_number = (int4)MCSwapInt32HostToNetwork(c);
-						offset += sizeof(int4);
+						offset = length;
+						break;
 					}
-					break;
 
-				case 'f':
-					if (offset + (int4)sizeof(float) <= length)
-					{
-						float f;
-						memcpy(&f, t_data_ptr + offset, sizeof(float));
-						t_number = f;
-						offset += sizeof(float);
-					}
-					break;
-				case 'd':
-					if (offset + (int4)sizeof(double) <= length)
-					{
-						double d;
-						memcpy(&d, t_data_ptr + offset, sizeof(double));
-						t_number = d;
-						offset += sizeof(double);
-					}
-					break;
-				}
-				if (offset == oldoffset)
-				{
-					offset = length;
-					break;
-				}
-				t_success = MCNumberCreateWithReal(t_number, (MCNumberRef&)r_results[t_index]);
-				if (!t_success)
-					break;
+					t_success = MCNumberCreateWithReal(MCBinaryReadNumber(cmd, t_data_ptr + offset), (MCNumberRef&)r_results[t_index]);
+					if (!t_success)
+						break;
 
-				done++;
-				if (count)
-				{
-					t_index++;
-					if (t_index >= p_result_count)
+					offset += t_size;
+					done++;
+					if (count)
 					{
-						ctxt.LegacyThrow(EE_BINARYD_BADPARAM);
-						return;
+						t_index++;
+						if (t_index >= p_result_count)
+						{
+							ctxt.LegacyThrow(EE_BINARYD_BADPARAM);
+							return;
+						}
 					}
 				}
+				break;
 			}
-			break;
         case 'u':
         case 'U':
             {
-                
                 if (count == BINARY_ALL)
                     count = length - offset;
                 
-                uindex_t t_size = count;
-                
-                if (cmd == 'U')
-                {
-                    // We need to skip all the spaces
-                    MCAutoDataRef t_encoded_space;
-                    MCStringEncode(MCSTR(" "), t_encoding, false, &t_encoded_space);
-                    
-                    const byte_t* t_space_ptr = MCDataGetBytePtr(*t_encoded_space);
-                    uindex_t t_space_length = MCDataGetLength(*t_encoded_space);
-                    
-                    bool t_space_skipped = false;
-                    uindex_t t_temp_size = t_size;
-                    
-                    while (!t_space_skipped)
-                    {
-                        // stop looking for spaces when an encoded space char won't fit within the remaining data
-                        if (t_space_length > t_temp_size)
-                        {
-                            // No char remaining
-                            t_space_skipped = true;
-                        }
-                        else
-                        {
-                            bool t_is_space = true;
-                            
-                            // Compare the encoded spaces
-                            for (uindex_t i = 0; i < t_space_length && t_is_space; ++i)
-                                t_is_space = t_data_ptr[offset + t_temp_size - 1 - (t_space_length - 1) + i] == t_space_ptr[i];
-                            
-                            if (t_is_space)
-                            {
-                                t_size = t_temp_size - t_space_length;
-                                t_temp_size = t_size;
-                            }
-                            else
-                            {
-                                // The byte might be offset, we need to try to offset at most the size of the encoded space
-                                if (t_size - t_temp_size == t_space_length)
-                                    t_space_skipped = true;
-                                else
-                                    --t_temp_size;
-                            }
-                            
-                        }
-                    }
-                }
-                
-                MCStringCreateWithBytes(t_data_ptr + offset, t_size, t_encoding, false, (MCStringRef&)r_results[t_index]);
+                MCBinaryDecodeString(cmd, t_data_ptr + offset, count, t_encoding, (MCStringRef&)r_results[t_index]);
                                 
                 done++;
                 offset += count;
@@ -766,6 +978,215 @@ void MCFiltersEvalBinaryDecode(MCExecContext& ctxt, MCStringRef p_format, MCData
 	ctxt.Throw();
 }
 
+// Decodes up to p_record_count records laid out one after the other, each of
+// which matches the format. The values of each template go into an array of
+// results, keyed by record number. Every template must have a fixed size, so
+// that the position of each value is known in advance.
+void MCFiltersEvalBinaryDecodeRecords(MCExecContext& ctxt, MCStringRef p_format, MCDataRef p_data, uindex_t p_record_count, MCArrayRef *r_results, uindex_t p_result_count, integer_t& r_done)
+{
+	const MCBinaryFormat *t_format;
+	t_format = MCBinaryFormatLookup(p_format);
+	if (t_format == nil || t_format -> bad_template)
+	{
+		ctxt . Throw();
+		return;
+	}
+
+	// Work out the offset of each result in the record, and the size of the
+	// record. Numeric templates have a result for each value.
+	MCAutoArray<MCBinaryTemplate> t_fields;
+	MCAutoArray<uindex_t> t_offsets;
+	uindex_t t_length = MCDataGetLength(p_data);
+	uindex_t t_record_size = 0;
+	for (uindex_t i = 0; i < t_format -> template_count; i++)
+	{
+		MCBinaryTemplate t_template = t_format -> templates[i];
+		if (t_template . count == 0)
+			continue;
+
+		if (t_template . count == BINARY_ALL)
+		{
+			ctxt . LegacyThrow(EE_BINARYDR_BADFORMAT);
+			return;
+		}
+
+		uindex_t t_size, t_values;
+		t_values = 1;
+		switch (t_template . cmd)
+		{
+		case 'a':
+		case 'A':
+		case 'u':
+		case 'U':
+		case 'x':
+			t_size = t_template . count;
+			break;
+		case 'b':
+		case 'B':
+			t_size = (t_template . count + 7) / 8;
+			break;
+		case 'h':
+		case 'H':
+			t_size = (t_template . count + 1) / 2;
+			break;
+		default:
+			t_size = MCBinaryNumberSize(t_template . cmd);
+			if (t_size == 0)
+			{
+				ctxt . LegacyThrow(EE_BINARYD_BADFORMAT);
+				return;
+			}
+			t_values = t_template . count;
+			t_template . count = 1;
+			break;
+		}
+
+		// There must be a variable for every result, and the record must fit
+		// in the data. Checking before pushing means huge counts can neither
+		// exhaust memory nor wrap the record size.
+		if (t_values > p_result_count - t_fields . Size())
+		{
+			ctxt . LegacyThrow(EE_BINARYDR_BADFORMAT);
+			return;
+		}
+
+		for (uindex_t j = 0; j < t_values; j++)
+		{
+			if (t_size > t_length - t_record_size)
+			{
+				ctxt . LegacyThrow(EE_BINARYDR_BADFORMAT);
+				return;
+			}
+
+			if (!t_fields . Push(t_template) || !t_offsets . Push(t_record_size))
+			{
+				ctxt . Throw();
+				return;
+			}
+			t_record_size += t_size;
+		}
+	}
+
+	uindex_t t_count = 0;
+	if (t_record_size != 0)
+		t_count = MCMin(p_record_count, t_length / t_record_size);
+
+	const byte_t *t_record = MCDataGetBytePtr(p_data);
+
+	bool t_success = true;
+	for (uindex_t i = 0; t_success && i < t_fields . Size(); i++)
+		if (t_fields[i] . cmd != 'x')
+			t_success = MCArrayCreateMutable(r_results[i]);
+
+	for (uindex_t t_index = 1; t_success && t_index <= t_count; t_index++)
+	{
+		for (uindex_t i = 0; t_success && i < t_fields . Size(); i++)
+		{
+			unichar_t t_cmd = t_fields[i] . cmd;
+			const byte_t *t_src = t_record + t_offsets[i];
+
+			MCAutoValueRef t_value;
+			if (t_cmd == 'x')
+				continue;
+			else if (MCBinaryNumberSize(t_cmd) != 0)
+				t_success = MCNumberCreateWithReal(MCBinaryReadNumber(t_cmd, t_src), (MCNumberRef&)&t_value);
+			else
+				t_success = MCBinaryDecodeString(t_cmd, t_src, t_fields[i] . count, t_fields[i] . encoding, (MCStringRef&)&t_value);
+
+			if (t_success)
+				t_success = MCArrayStoreValueAtIndex(r_results[i], t_index, *t_value);
+		}
+		t_record += t_record_size;
+	}
+
+	if (t_success)
+	{
+		r_done = t_count;
+		return;
+	}
+
+	ctxt . Throw();
+}
+
+static void MCBinaryWriteNumber(unichar_t p_cmd, real64_t p_number, byte_t *p_dst)
+{
+	switch (p_cmd)
+	{
+	case 'c':
+		{
+			int1 c = (int1)p_number;
+			memcpy(p_dst, &c, sizeof(int1));
+			break;
+		}
+	case 'C':
+		{
+			uint1 c = (uint1)p_number;
+			memcpy(p_dst, &c, sizeof(uint1));
+			break;
+		}
+	case 's':
+		{
+			int2 c = (int2)p_number;
+			memcpy(p_dst, &c, sizeof(int2));
+			break;
+		}
+	case 'S':
+		{
+			uint2 c = (uint2)p_number;
+			memcpy(p_dst, &c, sizeof(uint2));
+			break;
+		}
+	case 'i':
+		{
+			int4 c = (int4)p_number;
+			memcpy(p_dst, &c, sizeof(int4));
+			break;
+		}
+	case 'I':
+		{
+			uint4 c = (uint4)p_number;
+			memcpy(p_dst, &c, sizeof(uint4));
+			break;
+		}
+	case 'm':
+		{
+			int2 c = MCSwapInt16HostToNetwork((uint2)p_number);
+			memcpy(p_dst, &c, sizeof(int2));
+			break;
+		}
+	case 'M':
+		{
+			uint4 c = MCSwapInt32HostToNetwork((uint4)p_number);
+			memcpy(p_dst, &c, sizeof(uint4));
+			break;
+		}
+	case 'n':
+		{
+			int2 c = MCSwapInt16HostToNetwork((int2)p_number);
+			memcpy(p_dst, &c, sizeof(int2));
+			break;
+		}
+	case 'N':
+		{
+			int4 c = MCSwapInt32HostToNetwork((int4)p_number);
+			memcpy(p_dst, &c, sizeof(int4));
+			break;
+		}
+	case 'f':
+		{
+			float f = (float)p_number;
+			memcpy(p_dst, &f, sizeof(float));
+			break;
+		}
+	case 'd':
+		{
+			double d = p_number;
+			memcpy(p_dst, &d, sizeof(double));
+			break;
+		}
+	}
+}
+
 bool append_to_array(MCAutoByteArray& p_chars, const void* p_bytes, size_t p_byte_count)
 {
 	size_t t_size = p_chars.ByteCount();
@@ -793,24 +1214,31 @@ void MCFiltersEvalBinaryEncode(MCExecContext& ctxt, MCStringRef p_format, MCValu
 	MCAutoByteArray t_buffer;
 	uindex_t t_index = 0;
     
-    uindex_t t_format_index;
-    uindex_t t_format_length;
-    t_format_length = MCStringGetLength(p_format);
-    t_format_index = 0;
+	const MCBinaryFormat *t_format;
+	t_format = MCBinaryFormatLookup(p_format);
+	if (t_format == nil)
+	{
+		ctxt . Throw();
+		return;
+	}
 
 	bool t_success = true;
 
-	while (t_success && t_format_index < t_format_length)
+	for (uindex_t t_template = 0; t_success; t_template++)
 	{
-		unichar_t cmd;
-		uindex_t count;
-        MCStringEncoding t_encoding;
-        
-		if (!MCU_gettemplate(p_format, t_format_index, cmd, count, t_encoding))
-        {
-            ctxt . Throw();
-            return;
-        }
+		if (t_template == t_format -> template_count)
+		{
+			if (t_format -> bad_template)
+			{
+				ctxt . Throw();
+				return;
+			}
+			break;
+		}
+
+		unichar_t cmd = t_format -> templates[t_template] . cmd;
+		uindex_t count = t_format -> templates[t_template] . count;
+		MCStringEncoding t_encoding = t_format -> templates[t_template] . encoding;
         
 		if (count == 0 && cmd != '@')
 		{
@@ -996,6 +1424,15 @@ void MCFiltersEvalBinaryEncode(MCExecContext& ctxt, MCStringRef p_format, MCValu
 			{
 				if (count == BINARY_ALL || count == BINARY_NOCOUNT)
 					count = 1;
+
+				// Make space for all the values there are parameters for up
+				// front.
+				uindex_t t_size = MCBinaryNumberSize(cmd);
+				uindex_t t_start = t_buffer.ByteCount();
+				t_success = t_buffer.Extend(t_start + t_size * MCMin(count, p_param_count - t_index + 1));
+				if (!t_success)
+					break;
+
 				while (count--)
 				{
 					real64_t t_number;
@@ -1004,81 +1441,8 @@ void MCFiltersEvalBinaryEncode(MCExecContext& ctxt, MCStringRef p_format, MCValu
 						ctxt.LegacyThrow(EE_BINARYE_BADFORMAT, t_value);
 						return;
 					}
-					switch (cmd)
-					{
-					case 'c':
-						{
-							int1 c = (int1)t_number;
-							t_success = append_to_array(t_buffer, &c, sizeof(int1));
-							break;
-						}
-					case 'C':
-						{
-							uint1 c = (uint1)t_number;
-							t_success = append_to_array(t_buffer, &c, sizeof(uint1));
-							break;
-						}
-					case 's':
-						{
-							int2 c = (int2)t_number;
-							t_success = append_to_array(t_buffer, &c, sizeof(int2));
-							break;
-						}
-					case 'S':
-						{
-							uint2 c = (uint2)t_number;
-							t_success = append_to_array(t_buffer, &c, sizeof(uint2));
-							break;
-						}
-					case 'i':
-						{
-							int4 c = (int4)t_number;
-							t_success = append_to_array(t_buffer, &c, sizeof(int4));
-							break;
-						}
-					case 'I':
-						{
-							uint4 c = (uint4)t_number;
-							t_success = append_to_array(t_buffer, &c, sizeof(uint4));
-							break;
-						}
-					case 'm':
-						{
-							int2 c = MCSwapInt16HostToNetwork((uint2)t_number);
-							t_success = append_to_array(t_buffer, &c, sizeof(int2));
-							break;
-						}
-					case 'M':
-						{
-							uint4 c = MCSwapInt32HostToNetwork((uint4)t_number);
-							t_success = append_to_array(t_buffer, &c, sizeof(uint4));
-							break;
-						}
-					case 'n':
-						{
-							int2 c = MCSwapInt16HostToNetwork((int2)t_number);
-							t_success = append_to_array(t_buffer, &c, sizeof(int2));
-							break;
-						}
-					case 'N':
-						{
-							int4 c = MCSwapInt32HostToNetwork((int4)t_number);
-							t_success = append_to_array(t_buffer, &c, sizeof(int4));
-							break;
-						}
-					case 'f':
-						{
-							float f = (float)t_number;
-							t_success = append_to_array(t_buffer, &f, sizeof(float));
-							break;
-						}
-					case 'd':
-						{
-							double d = t_number;
-							t_success = append_to_array(t_buffer, &d, sizeof(double));
-							break;
-						}
-					}
+					MCBinaryWriteNumber(cmd, t_number, t_buffer.Bytes() + t_start);
+					t_start += t_size;
 					if (count)
 					{
 						if (t_index >= p_param_count)
@@ -482,16 +482,8 @@ void MCImage::GetImageData(MCExecContext& ctxt, MCDataRef& r_data)
             
             if (t_success)
             {
-                MCMemoryCopy(t_data_ptr, t_bitmap->data, t_data_size);
                 // IM-2013-09-16: [[ RefactorGraphics ]] [[ Bug 11185 ]] Use correct pixel format (xrgb) for imagedata
-#if (kMCGPixelFormatNative != kMCGPixelFormatARGB)
-                while (t_pixel_count--)
-                {
-                    uint8_t t_r, t_g, t_b, t_a;
-                    MCGPixelUnpackNative(*t_data_ptr, t_r, t_g, t_b, t_a);
-                    *t_data_ptr++ = MCGPixelPack(kMCGPixelFormatARGB, t_r, t_g, t_b, t_a);
-                }
-#endif
+                MCImageConvertPixels(t_bitmap->data, kMCGPixelFormatNative, t_data_ptr, kMCGPixelFormatARGB, t_pixel_count);
             }
             
             if (m_rep->GetType() == kMCImageRepMutable)
@@ -547,26 +539,31 @@ void MCImage::SetImageData(MCExecContext& ctxt, MCDataRef p_data)
 			uint32_t t_stride = MCMin(t_length / t_copy->height, t_copy->width * 4);
 			uint32_t t_width = t_stride / 4;
 			
-			uint8_t *t_src_ptr = (uint8_t*)MCDataGetBytePtr(p_data);
-			uint8_t *t_dst_ptr = (uint8_t*)t_copy->data;
-			for (uindex_t y = 0; y < t_copy->height; y++)
+			MCAutoArray<uint32_t> t_row;
+			t_success = t_row.New(t_width);
+			
+			if (t_success)
 			{
-                uint32_t *t_src_row = (uint32_t*)t_src_ptr;
-                uint32_t *t_dst_row = (uint32_t*)t_dst_ptr;
-				for (uindex_t x = 0; x < t_width; x++)
+				// IM-2013-10-25: [[ Bug 11314 ]] Preserve current alpha values when setting the imagedata
+				uint32_t t_alpha_mask;
+				t_alpha_mask = MCGPixelPackNative(0, 0, 0, 255);
+				
+				uint8_t *t_src_ptr = (uint8_t*)MCDataGetBytePtr(p_data);
+				uint8_t *t_dst_ptr = (uint8_t*)t_copy->data;
+				for (uindex_t y = 0; y < t_copy->height; y++)
 				{
-					uint8_t a, r, g, b;
-                    MCGPixelUnpack(kMCGPixelFormatARGB, *t_src_row++, r, g, b, a);
-                    
-                    // IM-2013-10-25: [[ Bug 11314 ]] Preserve current alpha values when setting the imagedata
-                    *t_dst_row = MCGPixelPackNative(r, g, b, MCGPixelGetNativeAlpha(*t_dst_row));
-                    t_dst_row++;
+					MCImageConvertPixels((const uint32_t*)t_src_ptr, kMCGPixelFormatARGB, t_row.Ptr(), kMCGPixelFormatNative, t_width);
+					
+					uint32_t *t_dst_row = (uint32_t*)t_dst_ptr;
+					for (uindex_t x = 0; x < t_width; x++)
+						t_dst_row[x] = (t_row[x] & ~t_alpha_mask) | (t_dst_row[x] & t_alpha_mask);
+					
+					t_src_ptr += t_stride;
+					t_dst_ptr += t_copy->stride;
 				}
-				t_src_ptr += t_stride;
-				t_dst_ptr += t_copy->stride;
+				
+				setbitmap(t_copy, 1.0);
 			}
-			
-			setbitmap(t_copy, 1.0);
 		}
 		
 		MCImageFreeBitmap(t_copy);
@@ -153,6 +153,18 @@ void MCNetworkEvalPeerAddress(MCExecContext& ctxt, MCNameRef p_socket, MCStringR
 #endif
 }
 
+void MCNetworkEvalSocketPendingBytes(MCExecContext& ctxt, MCNameRef p_socket, double& r_bytes)
+{
+	uindex_t t_socket_index;
+	if (IO_findsocket(p_socket, t_socket_index))
+		r_bytes = (double)MCsockets[t_socket_index] -> pendingwrites();
+	else
+	{
+		r_bytes = 0;
+		ctxt . SetTheResultToStaticCString("not an open socket");
+	}
+}
+
 //////////
 
 void MCNetworkEvalHostAddressToName(MCExecContext& ctxt, MCStringRef p_address, MCStringRef &r_name)
@@ -658,7 +670,7 @@ void MCNetworkExecReadFromSocketUntil(MCExecContext& ctxt, MCNameRef p_socket, M
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void MCNetworkExecWriteToSocket(MCExecContext& ctxt, MCNameRef p_socket, MCStringRef p_data, MCNameRef p_message)
+void MCNetworkExecWriteToSocket(MCExecContext& ctxt, MCNameRef p_socket, MCDataRef p_data, MCNameRef p_message)
 {
 	uindex_t t_index;
 	if (IO_findsocket(p_socket, t_index))
@@ -670,6 +682,62 @@ void MCNetworkExecWriteToSocket(MCExecContext& ctxt, MCNameRef p_socket, MCStrin
 		ctxt . SetTheResultToStaticCString("socket is not open");
 }
 
+void MCNetworkExecWriteFileToSocket(MCExecContext& ctxt, MCNameRef p_socket, MCStringRef p_path, MCNameRef p_message)
+{
+	uindex_t t_index;
+	if (IO_findsocket(p_socket, t_index))
+	{
+		ctxt . SetTheResultToEmpty();
+		MCS_write_file_socket(p_path, MCsockets[t_index], ctxt . GetObject(), p_message);
+	}
+	else
+		ctxt . SetTheResultToStaticCString("socket is not open");
+}
+
+void MCNetworkExecWriteDatagramsToSocket(MCExecContext& ctxt, MCNameRef p_socket, MCArrayRef p_datagrams, MCNameRef p_message)
+{
+	uindex_t t_index;
+	if (!IO_findsocket(p_socket, t_index))
+	{
+		ctxt . SetTheResultToStaticCString("socket is not open");
+		return;
+	}
+
+	if (!MCsockets[t_index] -> datagram)
+	{
+		ctxt . SetTheResultToStaticCString("not a datagram socket");
+		return;
+	}
+
+	// The datagrams are the elements of the array in key order, 1 to n.
+	MCAutoDataRefArray t_datagrams;
+	uindex_t t_count;
+	t_count = MCArrayGetCount(p_datagrams);
+	if (!t_datagrams . New(t_count))
+	{
+		ctxt . Throw();
+		return;
+	}
+
+	for (uindex_t i = 0; i < t_count; i++)
+	{
+		MCValueRef t_element;
+		if (!MCArrayFetchValueAtIndex(p_datagrams, i + 1, t_element))
+		{
+			ctxt . LegacyThrow(EE_WRITE_BADEXP);
+			return;
+		}
+		if (!ctxt . ConvertToData(t_element, t_datagrams[i]))
+		{
+			ctxt . LegacyThrow(EE_WRITE_BADEXP);
+			return;
+		}
+	}
+
+	ctxt . SetTheResultToEmpty();
+	MCS_write_datagrams(t_datagrams . Ptr(), t_count, MCsockets[t_index], ctxt . GetObject(), p_message);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 void MCNetworkExecPutIntoUrl(MCExecContext& ctxt, MCValueRef p_value, int p_where, MCUrlChunkPtr p_chunk)
@@ -876,6 +944,39 @@ void MCNetworkSetAllowDatagramBroadcasts(MCExecContext& ctxt, bool p_value)
 	MCallowdatagrambroadcasts = p_value;
 }
 
+void MCNetworkGetBatchDatagramMessages(MCExecContext& ctxt, bool& r_value)
+{
+	r_value = MCbatchdatagrammessages == True;
+}
+
+void MCNetworkSetBatchDatagramMessages(MCExecContext& ctxt, bool p_value)
+{
+	MCbatchdatagrammessages = p_value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MCNetworkGetSslSessionStatistics(MCExecContext& ctxt, MCArrayRef& r_value)
+{
+	if (MCS_ssl_session_statistics(r_value))
+		return;
+	
+	ctxt . Throw();
+}
+
+void MCNetworkGetDnsCacheStatistics(MCExecContext& ctxt, MCArrayRef& r_value)
+{
+	if (MCS_dns_cache_statistics(r_value))
+		return;
+	
+	ctxt . Throw();
+}
+
+void MCNetworkExecResetDnsCache(MCExecContext& ctxt)
+{
+	MCS_dns_cache_flush();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 void MCNetworkExecSetUrl(MCExecContext& ctxt, MCValueRef p_value, MCStringRef p_url)
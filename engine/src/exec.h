@@ -1962,8 +1962,13 @@ void MCFiltersEvalBase64Encode(MCExecContext& ctxt, MCDataRef p_source, MCString
 void MCFiltersEvalBase64Decode(MCExecContext& ctxt, MCStringRef p_source, MCDataRef& r_result);
 void MCFiltersEvalBinaryEncode(MCExecContext& ctxt, MCStringRef p_format, MCValueRef *p_params, uindex_t p_param_count, MCDataRef& r_string);
 void MCFiltersEvalBinaryDecode(MCExecContext& ctxt, MCStringRef p_format, MCDataRef p_data, MCValueRef *r_results, uindex_t p_result_count, integer_t& r_done);
+void MCFiltersEvalBinaryDecodeRecords(MCExecContext& ctxt, MCStringRef p_format, MCDataRef p_data, uindex_t p_record_count, MCArrayRef *r_results, uindex_t p_result_count, integer_t& r_done);
+void MCFiltersBinaryFormatsFinalize(void);
 void MCFiltersEvalCompress(MCExecContext& ctxt, MCDataRef p_source, MCDataRef& r_result);
+void MCFiltersEvalCompressWithLevel(MCExecContext& ctxt, MCDataRef p_source, integer_t p_level, MCDataRef& r_result);
 void MCFiltersEvalDecompress(MCExecContext& ctxt, MCDataRef p_source, MCDataRef& r_result);
+void MCFiltersExecCompressFile(MCExecContext& ctxt, MCStringRef p_source, MCStringRef p_dest);
+void MCFiltersExecDecompressFile(MCExecContext& ctxt, MCStringRef p_source, MCStringRef p_dest);
 void MCFiltersEvalIsoToMac(MCExecContext& ctxt, MCDataRef p_source, MCDataRef& r_result);
 void MCFiltersEvalMacToIso(MCExecContext& ctxt, MCDataRef p_source, MCDataRef& r_result);
 void MCFiltersEvalUrlEncode(MCExecContext& ctxt, MCStringRef p_source, MCStringRef& r_result);
@@ -3355,6 +3360,7 @@ void MCNetworkEvalCachedUrls(MCExecContext& ctxt, MCStringRef& r_string);
 void MCNetworkEvalUrlStatus(MCExecContext& ctxt, MCStringRef p_url, MCStringRef& r_status);
 void MCNetworkEvalHostAddress(MCExecContext& ctxt, MCNameRef p_socket, MCStringRef& r_address);
 void MCNetworkEvalPeerAddress(MCExecContext& ctxt, MCNameRef p_socket, MCStringRef& r_address);
+void MCNetworkEvalSocketPendingBytes(MCExecContext& ctxt, MCNameRef p_socket, double& r_bytes);
 void MCNetworkEvalHostAddressToName(MCExecContext& ctxt, MCStringRef p_address, MCStringRef &r_name);
 void MCNetworkEvalHostNameToAddress(MCExecContext& ctxt, MCStringRef p_hostname, MCNameRef p_message, MCStringRef& r_string);
 void MCNetworkEvalHostName(MCExecContext& ctxt, MCStringRef& r_string);
@@ -3383,7 +3389,9 @@ void MCNetworkExecAcceptSecureConnectionsOnPort(MCExecContext& ctxt, uint2 p_por
 void MCNetworkExecReadFromSocketFor(MCExecContext& ctxt, MCNameRef p_socket, uint4 p_count, int p_unit_type, MCNameRef p_message);
 void MCNetworkExecReadFromSocketUntil(MCExecContext& ctxt, MCNameRef p_socket, MCStringRef p_sentinel, MCNameRef p_message);
 
-void MCNetworkExecWriteToSocket(MCExecContext& ctxt, MCNameRef p_socket, MCStringRef p_data, MCNameRef p_message);
+void MCNetworkExecWriteToSocket(MCExecContext& ctxt, MCNameRef p_socket, MCDataRef p_data, MCNameRef p_message);
+void MCNetworkExecWriteFileToSocket(MCExecContext& ctxt, MCNameRef p_socket, MCStringRef p_path, MCNameRef p_message);
+void MCNetworkExecWriteDatagramsToSocket(MCExecContext& ctxt, MCNameRef p_socket, MCArrayRef p_datagrams, MCNameRef p_message);
 
 void MCNetworkExecPutIntoUrl(MCExecContext& ctxt, MCValueRef value, int prep, MCUrlChunkPtr url);
 
@@ -3406,6 +3414,11 @@ void MCNetworkGetNetworkInterfaces(MCExecContext& ctxt, MCStringRef& r_value);
 
 void MCNetworkGetAllowDatagramBroadcasts(MCExecContext& ctxt, bool& r_value);
 void MCNetworkSetAllowDatagramBroadcasts(MCExecContext& ctxt, bool p_value);
+void MCNetworkGetBatchDatagramMessages(MCExecContext& ctxt, bool& r_value);
+void MCNetworkSetBatchDatagramMessages(MCExecContext& ctxt, bool p_value);
+void MCNetworkGetSslSessionStatistics(MCExecContext& ctxt, MCArrayRef& r_value);
+void MCNetworkGetDnsCacheStatistics(MCExecContext& ctxt, MCArrayRef& r_value);
+void MCNetworkExecResetDnsCache(MCExecContext& ctxt);
 
 void MCNetworkExecSetUrl(MCExecContext& ctxt, MCValueRef p_value, MCStringRef p_url);
 void MCNetworkExecPutIntoUrl(MCExecContext& ctxt, MCStringRef p_value, int p_where, MCStringRef p_url);
@@ -2778,7 +2778,25 @@ enum Exec_errors
     EE_BAD_PERMISSION_NAME,
     
     // {EE-0910} Property: value is not a data
-    EE_PROPERTY_NOTADATA
+    EE_PROPERTY_NOTADATA,
+    
+    // {EE-0911} socketPendingBytes: error in socket expression
+    EE_SOCKETPENDINGBYTES_BADSOCKET,
+    
+    // {EE-0912} compress: level is not an integer between 0 and 9
+    EE_COMPRESS_BADLEVEL,
+    
+    // {EE-0913} binaryDecodeRecords: record count is not a non-negative integer
+    EE_BINARYDR_BADCOUNT,
+    
+    // {EE-0914} binaryDecodeRecords: every template must have a fixed size that fits in the data and a variable
+    EE_BINARYDR_BADFORMAT,
+
+    // {EE-0915} compress file: can't evaluate source file
+    EE_COMPRESSFILE_BADSOURCE,
+
+    // {EE-0916} compress file: can't evaluate destination file
+    EE_COMPRESSFILE_BADDEST,
     
 };
 
@@ -283,6 +283,90 @@ void MCBinaryDecode::eval_ctxt(MCExecContext &ctxt, MCExecValue &r_value)
     }
 }
 
+MCBinaryDecodeRecords::~MCBinaryDecodeRecords()
+{
+	while (params != NULL)
+	{
+		MCParameter *tparams = params;
+		params = params->getnext();
+		delete tparams;
+	}
+}
+
+Parse_stat MCBinaryDecodeRecords::parse(MCScriptPoint &sp, Boolean the)
+{
+	if (getparams(sp, &params) != PS_NORMAL || params == NULL ||
+		params -> getnext() == NULL || params -> getnext() -> getnext() == NULL)
+	{
+		MCperror->add(PE_BINARYDR_BADPARAM, line, pos);
+		return PS_ERROR;
+	}
+	return PS_NORMAL;
+}
+
+void MCBinaryDecodeRecords::eval_ctxt(MCExecContext &ctxt, MCExecValue &r_value)
+{
+    MCAutoStringRef t_format;
+    MCAutoValueRef t_format_valueref;
+    if (!params->eval(ctxt, &t_format_valueref) || !ctxt . ConvertToString(*t_format_valueref, &t_format))
+	{
+		ctxt . LegacyThrow(EE_BINARYD_BADSOURCE);
+		return;
+	}
+    
+    MCAutoValueRef t_data_valueref;
+    MCAutoDataRef t_data;
+    if (!params->getnext()->eval(ctxt, &t_data_valueref) || !ctxt . ConvertToData(*t_data_valueref, &t_data))
+    {
+        ctxt . LegacyThrow(EE_BINARYD_BADPARAM);
+        return;
+    }
+    
+    MCAutoValueRef t_count_valueref;
+    integer_t t_record_count;
+    if (!params->getnext()->getnext()->eval(ctxt, &t_count_valueref) ||
+        !ctxt . ConvertToInteger(*t_count_valueref, t_record_count) || t_record_count < 0)
+    {
+        ctxt . LegacyThrow(EE_BINARYDR_BADCOUNT);
+        return;
+    }
+    
+	MCParameter *t_params = params->getnext()->getnext()->getnext();
+    uinteger_t t_result_count = 0;
+	for (MCParameter *p = t_params; p != nil; p = p->getnext())
+		t_result_count++;
+    
+	MCAutoArray<MCArrayRef> t_results;
+	if (!t_results.New(t_result_count))
+    {
+        ctxt . Throw();
+        return;
+    }
+    
+    MCFiltersEvalBinaryDecodeRecords(ctxt, *t_format, *t_data, t_record_count, t_results.Ptr(), t_result_count, r_value . int_value);
+    r_value . type = kMCExecValueTypeInt;
+    
+    // Each array is put into its variable, and 'x' templates leave theirs
+    // unchanged.
+    for (uindex_t i = 0; i < t_result_count; i++)
+    {
+        if (t_results[i] != nil)
+        {
+            if (!ctxt . HasError())
+            {
+                MCContainer t_container;
+                if (!t_params->evalcontainer(ctxt, t_container))
+                    ctxt . LegacyThrow(EE_BINARYD_BADDEST);
+                else
+                    /* UNCHECKED */ t_container.set_valueref(t_results[i]);
+            }
+            
+            MCValueRelease(t_results[i]);
+        }
+        t_params = t_params->getnext();
+    }
+}
+
 MCBinaryEncode::~MCBinaryEncode()
 {
 	while (params != NULL)
@@ -451,6 +535,38 @@ void MCCommandArguments::eval_ctxt(MCExecContext& ctxt, MCExecValue& r_value)
     }
 }
 
+Parse_stat MCCompress::parse(MCScriptPoint &sp, Boolean the)
+{
+    if (get1or2params(sp, &(&m_source), &(&m_level), the) != PS_NORMAL)
+    {
+        MCperror -> add(PE_COMPRESS_BADPARAM, sp);
+        return PS_ERROR;
+    }
+
+    return PS_NORMAL;
+}
+
+void MCCompress::eval_ctxt(MCExecContext& ctxt, MCExecValue& r_value)
+{
+    MCAutoDataRef t_source;
+    if (!ctxt . EvalExprAsDataRef(*m_source, EE_COMPRESS_BADSOURCE, &t_source))
+        return;
+
+    if (*m_level == nullptr)
+        MCFiltersEvalCompress(ctxt, *t_source, r_value . dataref_value);
+    else
+    {
+        integer_t t_level;
+        if (!ctxt . EvalExprAsInt(*m_level, EE_COMPRESS_BADLEVEL, t_level))
+            return;
+
+        MCFiltersEvalCompressWithLevel(ctxt, *t_source, t_level, r_value . dataref_value);
+    }
+
+    if (!ctxt . HasError())
+        r_value . type = kMCExecValueTypeDataRef;
+}
+
 void MCCommandName::eval_ctxt(MCExecContext& ctxt, MCExecValue& r_value)
 {
     MCEngineEvalCommandName(ctxt, r_value.stringref_value);
@@ -270,6 +270,19 @@ public:
 	virtual void eval_ctxt(MCExecContext &, MCExecValue &);
 };
 
+class MCBinaryDecodeRecords : public MCFunction
+{
+	MCParameter *params;
+public:
+	MCBinaryDecodeRecords()
+	{
+		params = NULL;
+	}
+	virtual ~MCBinaryDecodeRecords();
+	virtual Parse_stat parse(MCScriptPoint &, Boolean the);
+	virtual void eval_ctxt(MCExecContext &, MCExecValue &);
+};
+
 class MCBuildNumber : public MCConstantFunctionCtxt<integer_t, MCEngineEvalBuildNumber>
 {
 public:
@@ -321,11 +334,14 @@ class MCClipboardFunc : public MCConstantFunctionCtxt<MCNameRef, MCPasteboardEva
 public:
 };
 
-class MCCompress : public MCUnaryFunctionCtxt<MCDataRef, MCDataRef, MCFiltersEvalCompress, EE_COMPRESS_BADSOURCE, PE_COMPRESS_BADPARAM>
+// The compress function takes an optional compression level.
+class MCCompress : public MCFunction
 {
+    MCAutoPointer<MCExpression> m_source;
+    MCAutoPointer<MCExpression> m_level;
 public:
-    MCCompress(){}
-    virtual ~MCCompress(){}
+    virtual Parse_stat parse(MCScriptPoint &sp, Boolean the);
+    virtual void eval_ctxt(MCExecContext& ctxt, MCExecValue& r_value);
 };
 
 class MCConstantNames : public MCConstantFunctionCtxt<MCStringRef, MCEngineEvalConstantNames>
@@ -1424,6 +1440,13 @@ class MCShiftKey : public MCConstantFunctionCtxt<MCNameRef, MCInterfaceEvalShift
 public:
 };
 
+class MCSocketPendingBytes : public MCUnaryFunctionCtxt<MCNameRef, double, MCNetworkEvalSocketPendingBytes, EE_SOCKETPENDINGBYTES_BADSOCKET, PE_SOCKETPENDINGBYTES_BADSOCKET>
+{
+public:
+    MCSocketPendingBytes(){}
+    virtual ~MCSocketPendingBytes(){}
+};
+
 class MCSound : public MCConstantFunctionCtxt<MCStringRef, MCMultimediaEvalSound>
 {
 public:
@@ -69,6 +69,7 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "stacksecurity.h"
 #include "resolution.h"
 #include "redraw.h"
+#include "combiners.h"
 
 #include "date.h"
 #include "stacktile.h"
@@ -77,6 +78,8 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #include "stackfileformat.h"
 
+#include "foundation-filters.h"
+
 #define HOLD_SIZE1 65535
 #define HOLD_SIZE2 16384
 
@@ -243,7 +246,7 @@ real8 MCsockettimeout = 10.0;
 real8 MCmaxwait = 60.0;
 uint2 MCnfiles;
 uint2 MCnprocesses;
-uint2 MCnsockets;
+uint4 MCnsockets;
 MCStack **MCusing;
 uint2 MCnusing;
 uint2 MCiconicstacks;
@@ -497,6 +500,10 @@ Boolean MCmainstackschanged = False;
 //   UDP sockets.
 Boolean MCallowdatagrambroadcasts = False;
 
+// Whether datagram sockets opened after it is set deliver all the datagrams
+// received at once in a single message.
+Boolean MCbatchdatagrammessages = False;
+
 char *MCsysencoding = nil;
 
 MCLocaleRef kMCBasicLocale = nil;
@@ -1082,6 +1089,12 @@ bool X_open(int argc, MCStringRef argv[], MCStringRef envp[])
     
 	// MM-2013-09-03: [[ RefactorGraphics ]] Initialize graphics library.
 	MCGraphicsInitialize();
+
+	// Compress large data on the graphics library's worker threads.
+	MCFiltersSetParallelFor(MCGParallelFor);
+
+	// Use the fastest ink combiners the CPU supports.
+	MCSurfaceCombinersInitialize();
 	
 	// MM-2014-02-14: [[ LibOpenSSL 1.0.1e ]] Initialise the openlSSL module.
 #ifdef MCSSL
@@ -1338,11 +1351,9 @@ int X_close(void)
 		delete[] MCfiles; /* Allocated with new[] */
 	if (MCprocesses != NULL)
 		delete[] MCprocesses; /* Allocated with new[] */
-	if (MCnsockets)
-		while (MCnsockets)
-			delete MCsockets[--MCnsockets];
-	if (MCsockets != NULL)
-		delete MCsockets;
+#if defined(MCSSL)
+	MCSocketsDeleteSocketList();
+#endif
 
 	while (MCsavegroupptr != NULL)
 	{
@@ -1438,6 +1449,10 @@ int X_close(void)
 	delete MCsslcertificates;
 	delete MCdefaultnetworkinterface;
 	
+#if defined(MCSSL)
+	MCSSLContextPoolFinalize();
+#endif
+
 #if defined(MCSSL) && !defined(_MOBILE)
 	ShutdownSSL();
 #endif
@@ -1512,6 +1527,13 @@ int X_close(void)
 	// MW-2012-02-23: [[ LogFonts ]] Finalize the font table module.
 	MCLogicalFontTableFinalize();
 	
+	// Free the compiled binaryEncode and binaryDecode formats.
+	MCFiltersBinaryFormatsFinalize();
+	
+	// Stop compressing on the graphics library's worker threads before they
+	// are shut down.
+	MCFiltersSetParallelFor(nil);
+
 	// MM-2013-09-03: [[ RefactorGraphics ]] Initialize graphics library.
 	MCGraphicsFinalize();
 
@@ -174,7 +174,7 @@ extern real8 MCsockettimeout;
 extern real8 MCmaxwait;
 extern uint2 MCnfiles;
 extern uint2 MCnprocesses;
-extern uint2 MCnsockets;
+extern uint4 MCnsockets;
 extern MCStack **MCusing;
 extern uint2 MCnusing;
 extern uint2 MCiconicstacks;
@@ -431,6 +431,7 @@ extern MCPoint MCgroupedobjectoffset;
 // MW-2012-11-14: [[ Bug 10516 ]] When true, sending packets to broadcast
 //   addresses will work.
 extern Boolean MCallowdatagrambroadcasts;
+extern Boolean MCbatchdatagrammessages;
 
 // Character encoding used by the system
 extern char *MCsysencoding;
@@ -306,6 +306,8 @@ bool MCGraphicsContext::begin_with_effects(MCBitmapEffectsRef p_effects, const M
 	else
 		t_effects . has_drop_shadow = false;
 	
+	MCBitmapEffectsGetCache(p_effects, t_effects . cache, t_effects . generation);
+	
 	MCGContextBeginWithEffects(m_gcontext, MCGRectangleMake(p_shape . x, p_shape . y, p_shape . width, p_shape . height), t_effects);
 	return true;
 }
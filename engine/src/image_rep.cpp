@@ -678,14 +678,13 @@ bool MCPixelDataImageRep::LoadImageFrames(MCBitmapFrame *&r_frames, uindex_t &r_
 			uint32_t *t_dst_pixel;
 			t_dst_pixel = (uint32_t*)t_dst_ptr;
 			
-			for (uint32_t x = 0; x < m_pixel_width; x++)
-			{
-//				if (x < t_pixel_width && i < t_pixel_count)
-				if (i < t_pixel_count)
-					*t_dst_pixel++ = MCGPixelToNative(m_pixel_format, t_src_ptr[i++]);
-				else
-					*t_dst_pixel++ = MCGPixelPackNative(0, 0, 0, 1);
-			}
+			uint32_t t_available;
+			t_available = MCMin(m_pixel_width, t_pixel_count - i);
+			MCImageConvertPixels(t_src_ptr + i, m_pixel_format, t_dst_pixel, kMCGPixelFormatNative, t_available);
+			i += t_available;
+			
+			for (uint32_t x = t_available; x < m_pixel_width; x++)
+				t_dst_pixel[x] = MCGPixelPackNative(0, 0, 0, 1);
 			
 			t_dst_ptr += t_frames->image->stride;
 		}
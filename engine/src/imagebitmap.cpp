@@ -26,6 +26,14 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #include "imagebitmap.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MC_IMAGE_BITMAP_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MC_IMAGE_BITMAP_NEON
+#include <arm_neon.h>
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 
 static bool check_point(MCImageBitmap *p_bitmap, int32_t x, int32_t y)
@@ -345,6 +353,76 @@ void MCImageBitmapSetPixel(MCImageBitmap *p_bitmap, uindex_t x, uindex_t y, uint
 
 //////////
 
+// Premultiplies a pixel, rounding each channel to the nearest value. A
+// transparent pixel becomes 0, and an opaque one is unchanged.
+static inline uint32_t premultiply_pixel(uint32_t p_pixel)
+{
+	uint32_t t_alpha;
+	t_alpha = p_pixel >> 24;
+	
+	uint32_t u, v;
+	u = ((p_pixel & 0xff00ff) * t_alpha) + 0x800080;
+	u = ((u + ((u >> 8) & 0xff00ff)) >> 8) & 0xff00ff;
+	v = ((p_pixel & 0x00ff00) * t_alpha) + 0x8000;
+	v = ((v + ((v >> 8) & 0x00ff00)) >> 8) & 0x00ff00;
+	
+	return u | v | (t_alpha << 24);
+}
+
+// Premultiplies p_count pixels from p_src into p_dst (which may be the same).
+static void premultiply_pixels(uint32_t *p_dst, const uint32_t *p_src, uindex_t p_count)
+{
+	uindex_t i;
+	i = 0;
+	
+#if defined(MC_IMAGE_BITMAP_SSE2)
+	// The same arithmetic as premultiply_pixel, with the green channel worked
+	// out alongside the alpha (which is then replaced by the original).
+	__m128i t_mask, t_round, t_alpha_mask;
+	t_mask = _mm_set1_epi32(0xff00ff);
+	t_round = _mm_set1_epi32(0x800080);
+	t_alpha_mask = _mm_set1_epi32(0xff000000);
+	for(; i + 4 <= p_count; i += 4)
+	{
+		__m128i x, a, u, v;
+		x = _mm_loadu_si128((const __m128i *)(p_src + i));
+		a = _mm_srli_epi32(x, 24);
+		a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+		
+		u = _mm_add_epi32(_mm_mullo_epi16(_mm_and_si128(x, t_mask), a), t_round);
+		u = _mm_and_si128(_mm_srli_epi32(_mm_add_epi32(u, _mm_and_si128(_mm_srli_epi32(u, 8), t_mask)), 8), t_mask);
+		
+		v = _mm_add_epi32(_mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(x, 8), t_mask), a), t_round);
+		v = _mm_and_si128(_mm_add_epi32(v, _mm_and_si128(_mm_srli_epi32(v, 8), t_mask)), _mm_set1_epi32(0x0000ff00));
+		
+		_mm_storeu_si128((__m128i *)(p_dst + i), _mm_or_si128(_mm_or_si128(u, v), _mm_and_si128(x, t_alpha_mask)));
+	}
+#elif defined(MC_IMAGE_BITMAP_NEON)
+	uint32x4_t t_mask, t_round, t_alpha_mask;
+	t_mask = vdupq_n_u32(0xff00ff);
+	t_round = vdupq_n_u32(0x800080);
+	t_alpha_mask = vdupq_n_u32(0xff000000);
+	for(; i + 4 <= p_count; i += 4)
+	{
+		uint32x4_t x, a, u, v;
+		x = vld1q_u32(p_src + i);
+		a = vshrq_n_u32(x, 24);
+		a = vorrq_u32(a, vshlq_n_u32(a, 16));
+		
+		u = vaddq_u32(vreinterpretq_u32_u16(vmulq_u16(vreinterpretq_u16_u32(vandq_u32(x, t_mask)), vreinterpretq_u16_u32(a))), t_round);
+		u = vandq_u32(vshrq_n_u32(vaddq_u32(u, vandq_u32(vshrq_n_u32(u, 8), t_mask)), 8), t_mask);
+		
+		v = vaddq_u32(vreinterpretq_u32_u16(vmulq_u16(vreinterpretq_u16_u32(vandq_u32(vshrq_n_u32(x, 8), t_mask)), vreinterpretq_u16_u32(a))), t_round);
+		v = vandq_u32(vaddq_u32(v, vandq_u32(vshrq_n_u32(v, 8), t_mask)), vdupq_n_u32(0x0000ff00));
+		
+		vst1q_u32(p_dst + i, vorrq_u32(vorrq_u32(u, v), vandq_u32(x, t_alpha_mask)));
+	}
+#endif
+	
+	for(; i < p_count; i++)
+		p_dst[i] = premultiply_pixel(p_src[i]);
+}
+
 void MCImageBitmapPremultiplyRegion(MCImageBitmap *p_bitmap, int32_t p_sx, int32_t p_sy, int32_t p_sw, int32_t p_sh, uint32_t p_pixel_stride, uint32_t *p_pixel_ptr)
 {
 	int32_t t_src_x = MCMax(0, p_sx);
@@ -363,26 +441,7 @@ void MCImageBitmapPremultiplyRegion(MCImageBitmap *p_bitmap, int32_t p_sx, int32
 	uint8_t *t_dst_ptr = (uint8_t*)p_pixel_ptr + t_dst_x * 4 + t_dst_y * p_pixel_stride;
 	for (uindex_t y = 0; y < t_height; y++)
 	{
-		uint32_t *t_src_row = (uint32_t*)t_src_ptr;
-		uint32_t *t_dst_row = (uint32_t *)t_dst_ptr;
-		for (uindex_t x = 0; x < t_width; x++)
-		{
-			uint32_t t_pixel = *t_src_row++;
-			uint8_t t_alpha = t_pixel >> 24;
-
-			if (t_alpha == 0)
-				t_pixel = 0;
-			else if (t_alpha != 0xFF)
-			{
-				uint4 u, v;
-				u = ((t_pixel & 0xff00ff) * t_alpha) + 0x800080;
-				u = ((u + ((u >> 8) & 0xff00ff)) >> 8) & 0xff00ff;
-				v = ((t_pixel & 0x00ff00) * t_alpha) + 0x8000;
-				v = ((v + ((v >> 8) & 0x00ff00)) >> 8) & 0x00ff00;
-				t_pixel = (u + v) | (t_alpha << 24);
-			}
-			*t_dst_row++ = t_pixel;
-		}
+		premultiply_pixels((uint32_t *)t_dst_ptr, (const uint32_t *)t_src_ptr, t_width);
 		t_src_ptr += p_bitmap->stride;
 		t_dst_ptr += p_pixel_stride;
 	}
@@ -396,36 +455,177 @@ void MCImageBitmapPremultiply(MCImageBitmap *p_bitmap)
 	uint8_t *t_src_ptr = (uint8_t*) p_bitmap->data;
 	for (uindex_t y = 0; y < p_bitmap->height; y++)
 	{
-		uint32_t *t_src_row = (uint32_t*)t_src_ptr;
-		for (uindex_t x = 0; x < p_bitmap->width; x++)
-		{
-			uint32_t t_pixel = *t_src_row;
-			uint8_t t_alpha = t_pixel >> 24;
-
-			if (t_alpha == 0)
-				t_pixel = 0;
-			else if (t_alpha != 0xFF)
-			{
-				uint4 u, v;
-				u = ((t_pixel & 0xff00ff) * t_alpha) + 0x800080;
-				u = ((u + ((u >> 8) & 0xff00ff)) >> 8) & 0xff00ff;
-				v = ((t_pixel & 0x00ff00) * t_alpha) + 0x8000;
-				v = ((v + ((v >> 8) & 0x00ff00)) >> 8) & 0x00ff00;
-				t_pixel = (u + v) | (t_alpha << 24);
-			}
-			*t_src_row++ = t_pixel;
-		}
+		premultiply_pixels((uint32_t *)t_src_ptr, (const uint32_t *)t_src_ptr, p_bitmap->width);
 		t_src_ptr += p_bitmap->stride;
 	}
 }
 
-static inline uint32_t packed_divide_bounded(uint32_t x, uint8_t a)
+// The reciprocals and rounding offsets used to unpremultiply each channel -
+// for each alpha a > 0, (c * s_unpremultiply_reciprocals[a] +
+// s_unpremultiply_offsets[a]) >> 16 is exactly (c * 255 + a / 2) / a for every
+// channel value c <= a. So premultiplying an unpremultiplied pixel always gives
+// back the original.
+static const uint32_t s_unpremultiply_reciprocals[256] =
+{
+	0x000000, 0xff0000, 0x7f8000, 0x550000, 0x3fc000, 0x330000, 0x2a8000, 0x246db7,
+	0x1fe000, 0x1c5556, 0x198000, 0x172e8c, 0x154000, 0x139d8a, 0x1236dc, 0x110000,
+	0x0ff000, 0x0f0000, 0x0e2aab, 0x0d6bcb, 0x0cc000, 0x0c2493, 0x0b9746, 0x0b1643,
+	0x0aa000, 0x0a3334, 0x09cec5, 0x0971c8, 0x091b6e, 0x08cb09, 0x088000, 0x0839cf,
+	0x07f800, 0x07ba2f, 0x078000, 0x074925, 0x071556, 0x06e454, 0x06b5e6, 0x0689d9,
+	0x066000, 0x063832, 0x06124a, 0x05ee24, 0x05cba3, 0x05aaab, 0x058b22, 0x056cf0,
+	0x055000, 0x05343f, 0x05199a, 0x050000, 0x04e763, 0x04cfb3, 0x04b8e4, 0x04a2e9,
+	0x048db7, 0x047944, 0x046585, 0x045271, 0x044000, 0x042e2a, 0x041ce8, 0x040c31,
+	0x03fc00, 0x03ec4f, 0x03dd18, 0x03ce55, 0x03c000, 0x03b217, 0x03a493, 0x039770,
+	0x038aab, 0x037e40, 0x03722a, 0x036667, 0x035af3, 0x034fcb, 0x0344ed, 0x033a55,
+	0x033000, 0x0325ee, 0x031c19, 0x031282, 0x030925, 0x030000, 0x02f712, 0x02ee59,
+	0x02e5d2, 0x02dd7c, 0x02d556, 0x02cd5d, 0x02c591, 0x02bdf0, 0x02b678, 0x02af29,
+	0x02a800, 0x02a0fe, 0x029a20, 0x029365, 0x028ccd, 0x028657, 0x028000, 0x0279ca,
+	0x0273b2, 0x026db7, 0x0267da, 0x026218, 0x025c72, 0x0256e7, 0x025175, 0x024c1c,
+	0x0246dc, 0x0241b3, 0x023ca2, 0x0237a7, 0x0232c3, 0x022df3, 0x022939, 0x022493,
+	0x022000, 0x021b82, 0x021715, 0x0212bc, 0x020e74, 0x020a3e, 0x020619, 0x020205,
+	0x01fe00, 0x01fa0c, 0x01f628, 0x01f253, 0x01ee8c, 0x01ead4, 0x01e72b, 0x01e38f,
+	0x01e000, 0x01dc80, 0x01d90c, 0x01d5a4, 0x01d24a, 0x01cefb, 0x01cbb8, 0x01c881,
+	0x01c556, 0x01c235, 0x01bf20, 0x01bc15, 0x01b915, 0x01b61f, 0x01b334, 0x01b052,
+	0x01ad7a, 0x01aaab, 0x01a7e6, 0x01a52a, 0x01a277, 0x019fcc, 0x019d2b, 0x019a91,
+	0x019800, 0x019578, 0x0192f7, 0x01907e, 0x018e0d, 0x018ba3, 0x018941, 0x0186e6,
+	0x018493, 0x018246, 0x018000, 0x017dc2, 0x017b89, 0x017958, 0x01772d, 0x017508,
+	0x0172e9, 0x0170d1, 0x016ebe, 0x016cb2, 0x016aab, 0x0168aa, 0x0166af, 0x0164b9,
+	0x0162c9, 0x0160de, 0x015ef8, 0x015d18, 0x015b3c, 0x015966, 0x015795, 0x0155c8,
+	0x015400, 0x01523e, 0x01507f, 0x014ec5, 0x014d10, 0x014b5f, 0x0149b3, 0x01480b,
+	0x014667, 0x0144c7, 0x01432c, 0x014194, 0x014000, 0x013e71, 0x013ce5, 0x013b5d,
+	0x0139d9, 0x013859, 0x0136dc, 0x013563, 0x0133ed, 0x01327b, 0x01310c, 0x012fa1,
+	0x012e39, 0x012cd5, 0x012b74, 0x012a16, 0x0128bb, 0x012763, 0x01260e, 0x0124bd,
+	0x01236e, 0x012223, 0x0120da, 0x011f94, 0x011e51, 0x011d11, 0x011bd4, 0x011a99,
+	0x011962, 0x01182c, 0x0116fa, 0x0115ca, 0x01149d, 0x011372, 0x01124a, 0x011124,
+	0x011000, 0x010ee0, 0x010dc1, 0x010ca5, 0x010b8b, 0x010a73, 0x01095e, 0x01084b,
+	0x01073a, 0x01062c, 0x01051f, 0x010415, 0x01030d, 0x010207, 0x010103, 0x010000,
+};
+
+static const uint16_t s_unpremultiply_offsets[256] =
 {
-	uint32_t u, v, w;
-	u = ((((x & 0xff0000) << 8) - (x & 0xff0000)) / a) & 0xff0000;
-	v = ((((x & 0x00ff00) << 8) - (x & 0x00ff00)) / a) & 0x00ff00;
-	w = ((((x & 0x0000ff) << 8) - (x & 0x0000ff)) / a) & 0x0000ff;
-	return u | v | w;
+	0x0000, 0x0000, 0x8000, 0x5555, 0x8000, 0x6666, 0x8000, 0x6db6,
+	0x8000, 0x71c7, 0x8000, 0x745d, 0x8000, 0x7627, 0x8000, 0x7777,
+	0x8000, 0x7878, 0x8000, 0x7943, 0x8000, 0x79e7, 0x8000, 0x7a6f,
+	0x8000, 0x7ae1, 0x8000, 0x7b42, 0x8000, 0x7b96, 0x8000, 0x7bde,
+	0x8000, 0x7c1f, 0x8000, 0x7c57, 0x8000, 0x7c8a, 0x8000, 0x7cb7,
+	0x8000, 0x7ce0, 0x8000, 0x7d05, 0x8000, 0x7d27, 0x8000, 0x7d46,
+	0x8000, 0x7d63, 0x8000, 0x7d7d, 0x8000, 0x7d95, 0x8000, 0x7dac,
+	0x8000, 0x7dc1, 0x8000, 0x7dd4, 0x8000, 0x7de6, 0x8000, 0x7df7,
+	0x8000, 0x7e07, 0x8000, 0x7e16, 0x8000, 0x7e25, 0x8000, 0x7e32,
+	0x8000, 0x7e3f, 0x8000, 0x7e4b, 0x8000, 0x7e56, 0x8000, 0x7e61,
+	0x8000, 0x7e6b, 0x8000, 0x7e75, 0x8000, 0x7e7e, 0x8000, 0x7e87,
+	0x8000, 0x7e8f, 0x8000, 0x7e97, 0x8000, 0x7e9f, 0x8000, 0x7ea7,
+	0x8000, 0x7eae, 0x8000, 0x7eb5, 0x8000, 0x7ebb, 0x8000, 0x7ec1,
+	0x8000, 0x7ec7, 0x8000, 0x7ecd, 0x8000, 0x7ed3, 0x8000, 0x7ed8,
+	0x8000, 0x7ede, 0x8000, 0x7ee3, 0x8000, 0x7ee7, 0x8000, 0x7eec,
+	0x8000, 0x7ef1, 0x8000, 0x7ef5, 0x8000, 0x7ef9, 0x8000, 0x7efd,
+	0x8000, 0x7f01, 0x8000, 0x7f05, 0x8000, 0x7f09, 0x8000, 0x7f0d,
+	0x8000, 0x7f10, 0x8000, 0x7f14, 0x8000, 0x7f17, 0x8000, 0x7f1a,
+	0x8000, 0x7f1e, 0x8000, 0x7f21, 0x8000, 0x7f24, 0x8000, 0x7f26,
+	0x8000, 0x7f29, 0x8000, 0x7f2c, 0x8000, 0x7f2f, 0x8000, 0x7f31,
+	0x8000, 0x7f34, 0x8000, 0x7f36, 0x8000, 0x7f39, 0x8000, 0x7f3b,
+	0x8000, 0x7f3e, 0x8000, 0x7f40, 0x8000, 0x7f42, 0x8000, 0x7f44,
+	0x8000, 0x7f46, 0x8000, 0x7f48, 0x8000, 0x7f4a, 0x8000, 0x7f4c,
+	0x8000, 0x7f4e, 0x8000, 0x7f50, 0x8000, 0x7f52, 0x8000, 0x7f54,
+	0x8000, 0x7f56, 0x8000, 0x7f57, 0x8000, 0x7f59, 0x8000, 0x7f5b,
+	0x8000, 0x7f5c, 0x8000, 0x7f5e, 0x8000, 0x7f60, 0x8000, 0x7f61,
+	0x8000, 0x7f63, 0x8000, 0x7f64, 0x8000, 0x7f66, 0x8000, 0x7f67,
+	0x8000, 0x7f68, 0x8000, 0x7f6a, 0x8000, 0x7f6b, 0x8000, 0x7f6d,
+	0x8000, 0x7f6e, 0x8000, 0x7f6f, 0x8000, 0x7f70, 0x8000, 0x7f72,
+	0x8000, 0x7f73, 0x8000, 0x7f74, 0x8000, 0x7f75, 0x8000, 0x7f76,
+	0x8000, 0x7f78, 0x8000, 0x7f79, 0x8000, 0x7f7a, 0x8000, 0x7f7b,
+	0x8000, 0x7f7c, 0x8000, 0x7f7d, 0x8000, 0x7f7e, 0x8000, 0x7f7f,
+};
+
+// Unpremultiplies a pixel which is neither transparent nor opaque, rounding
+// each channel to the nearest value. The result for channels greater than the
+// alpha (which are invalid) wraps, as the division always has.
+static inline uint32_t unpremultiply_pixel(uint32_t p_pixel)
+{
+	uint32_t t_alpha, t_reciprocal, t_offset;
+	t_alpha = p_pixel >> 24;
+	t_reciprocal = s_unpremultiply_reciprocals[t_alpha];
+	t_offset = s_unpremultiply_offsets[t_alpha];
+	
+	uint32_t r, g, b;
+	r = ((((p_pixel >> 16) & 0xff) * t_reciprocal + t_offset) >> 16) & 0xff;
+	g = ((((p_pixel >> 8) & 0xff) * t_reciprocal + t_offset) >> 16) & 0xff;
+	b = (((p_pixel & 0xff) * t_reciprocal + t_offset) >> 16) & 0xff;
+	
+	return (t_alpha << 24) | (r << 16) | (g << 8) | b;
+}
+
+// Unpremultiplies p_count pixels in place. Runs of opaque or transparent
+// pixels, which are by far the most common, are skipped a vector at a time.
+static void unpremultiply_pixels(uint32_t *x_pixels, uindex_t p_count)
+{
+	uindex_t i;
+	i = 0;
+	
+#if defined(MC_IMAGE_BITMAP_SSE2)
+	__m128i t_alpha_mask, t_zero;
+	t_alpha_mask = _mm_set1_epi32(0xff000000);
+	t_zero = _mm_setzero_si128();
+	for(; i + 4 <= p_count; i += 4)
+	{
+		__m128i x, a;
+		x = _mm_loadu_si128((const __m128i *)(x_pixels + i));
+		a = _mm_and_si128(x, t_alpha_mask);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, t_alpha_mask)) == 0xffff)
+			continue;
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, t_zero)) == 0xffff)
+		{
+			_mm_storeu_si128((__m128i *)(x_pixels + i), t_zero);
+			continue;
+		}
+		for(uindex_t j = i; j < i + 4; j++)
+		{
+			uint32_t t_alpha;
+			t_alpha = x_pixels[j] >> 24;
+			if (t_alpha == 0)
+				x_pixels[j] = 0;
+			else if (t_alpha != 255)
+				x_pixels[j] = unpremultiply_pixel(x_pixels[j]);
+		}
+	}
+#elif defined(MC_IMAGE_BITMAP_NEON)
+	for(; i + 4 <= p_count; i += 4)
+	{
+		uint32x4_t a;
+		a = vshrq_n_u32(vld1q_u32(x_pixels + i), 24);
+		uint32x2_t t_min, t_max;
+		t_min = vpmin_u32(vget_low_u32(a), vget_high_u32(a));
+		t_max = vpmax_u32(vget_low_u32(a), vget_high_u32(a));
+		t_min = vpmin_u32(t_min, t_min);
+		t_max = vpmax_u32(t_max, t_max);
+		if (vget_lane_u32(t_min, 0) == 255)
+			continue;
+		if (vget_lane_u32(t_max, 0) == 0)
+		{
+			vst1q_u32(x_pixels + i, vdupq_n_u32(0));
+			continue;
+		}
+		for(uindex_t j = i; j < i + 4; j++)
+		{
+			uint32_t t_alpha;
+			t_alpha = x_pixels[j] >> 24;
+			if (t_alpha == 0)
+				x_pixels[j] = 0;
+			else if (t_alpha != 255)
+				x_pixels[j] = unpremultiply_pixel(x_pixels[j]);
+		}
+	}
+#endif
+	
+	for(; i < p_count; i++)
+	{
+		uint32_t t_alpha;
+		t_alpha = x_pixels[i] >> 24;
+		if (t_alpha == 0)
+			x_pixels[i] = 0;
+		else if (t_alpha != 255)
+			x_pixels[i] = unpremultiply_pixel(x_pixels[i]);
+	}
 }
 
 void MCImageBitmapUnpremultiply(MCImageBitmap *p_bitmap)
@@ -436,19 +636,7 @@ void MCImageBitmapUnpremultiply(MCImageBitmap *p_bitmap)
 	uint8_t *t_src_ptr = (uint8_t*) p_bitmap->data;
 	for (uindex_t y = 0; y < p_bitmap->height; y++)
 	{
-		uint32_t *t_src_row = (uint32_t*)t_src_ptr;
-		for (uindex_t x = 0; x < p_bitmap->width; x++)
-		{
-			uint32_t t_pixel = *t_src_row;
-			uint8_t t_alpha = t_pixel >> 24;
-
-			if (t_alpha == 0)
-				t_pixel = 0;
-			else if (t_alpha != 255)
-				t_pixel = (t_alpha << 24) | packed_divide_bounded(t_pixel, t_alpha);
-
-			*t_src_row++ = t_pixel;
-		}
+		unpremultiply_pixels((uint32_t *)t_src_ptr, p_bitmap->width);
 		t_src_ptr += p_bitmap->stride;
 	}
 }
@@ -507,7 +695,7 @@ void MCImageBitmapUnpremultiplyChecking(MCImageBitmap *p_bitmap)
 					t_brokenbits |= 0xFF00;
 				if (((t_pixel >> 16) & 0xFF) > t_alpha)
 					t_brokenbits |= 0xFF0000;
-				t_pixel = (t_alpha << 24) | packed_divide_bounded(t_pixel, t_alpha) | t_brokenbits;
+				t_pixel = unpremultiply_pixel(t_pixel) | t_brokenbits;
 			}
 
 			*t_src_row++ = t_pixel;
@@ -516,6 +704,128 @@ void MCImageBitmapUnpremultiplyChecking(MCImageBitmap *p_bitmap)
 	}
 }
 
+//////////
+
+// Converting between two pixel formats moves each byte of a pixel by a fixed
+// amount, so can be done with at most four masked shifts, one for each
+// distinct distance a byte moves.
+struct MCImagePixelShuffle
+{
+	uint32_t count;
+	int32_t shifts[4];
+	uint32_t masks[4];
+};
+
+static void compute_pixel_shuffle(MCGPixelFormat p_src_format, MCGPixelFormat p_dst_format, MCImagePixelShuffle &r_shuffle)
+{
+	// Each channel is packed as a distinct byte, so its position in each
+	// format can be found.
+	uint32_t t_src, t_dst;
+	t_src = MCGPixelPack(p_src_format, 1, 2, 3, 4);
+	t_dst = MCGPixelPack(p_dst_format, 1, 2, 3, 4);
+	
+	r_shuffle . count = 0;
+	for(int32_t t_dst_byte = 0; t_dst_byte < 4; t_dst_byte++)
+	{
+		int32_t t_src_byte;
+		for(t_src_byte = 0; t_src_byte < 4; t_src_byte++)
+			if (((t_src >> (t_src_byte * 8)) & 0xff) == ((t_dst >> (t_dst_byte * 8)) & 0xff))
+				break;
+		
+		int32_t t_shift;
+		t_shift = (t_dst_byte - t_src_byte) * 8;
+		
+		uint32_t t_index;
+		for(t_index = 0; t_index < r_shuffle . count; t_index++)
+			if (r_shuffle . shifts[t_index] == t_shift)
+				break;
+		
+		if (t_index == r_shuffle . count)
+		{
+			r_shuffle . shifts[t_index] = t_shift;
+			r_shuffle . masks[t_index] = 0;
+			r_shuffle . count++;
+		}
+		
+		r_shuffle . masks[t_index] |= 0xffU << (t_dst_byte * 8);
+	}
+}
+
+static inline uint32_t shuffle_pixel(const MCImagePixelShuffle &p_shuffle, uint32_t p_pixel)
+{
+	uint32_t t_pixel;
+	t_pixel = 0;
+	for(uint32_t i = 0; i < p_shuffle . count; i++)
+	{
+		int32_t t_shift;
+		t_shift = p_shuffle . shifts[i];
+		t_pixel |= (t_shift >= 0 ? p_pixel << t_shift : p_pixel >> -t_shift) & p_shuffle . masks[i];
+	}
+	return t_pixel;
+}
+
+void MCImageConvertPixels(const uint32_t *p_src, MCGPixelFormat p_src_format, uint32_t *p_dst, MCGPixelFormat p_dst_format, uindex_t p_count)
+{
+	if (p_src_format == p_dst_format)
+	{
+		if (p_src != p_dst)
+			MCMemoryMove(p_dst, p_src, p_count * sizeof(uint32_t));
+		return;
+	}
+	
+	MCImagePixelShuffle t_shuffle;
+	compute_pixel_shuffle(p_src_format, p_dst_format, t_shuffle);
+	
+	uindex_t i;
+	i = 0;
+	
+#if defined(MC_IMAGE_BITMAP_SSE2)
+	__m128i t_shifts[4], t_masks[4];
+	for(uint32_t j = 0; j < t_shuffle . count; j++)
+	{
+		t_shifts[j] = _mm_cvtsi32_si128(t_shuffle . shifts[j] >= 0 ? t_shuffle . shifts[j] : -t_shuffle . shifts[j]);
+		t_masks[j] = _mm_set1_epi32(t_shuffle . masks[j]);
+	}
+	for(; i + 4 <= p_count; i += 4)
+	{
+		__m128i x, t_pixels;
+		x = _mm_loadu_si128((const __m128i *)(p_src + i));
+		t_pixels = _mm_setzero_si128();
+		for(uint32_t j = 0; j < t_shuffle . count; j++)
+		{
+			__m128i t_moved;
+			if (t_shuffle . shifts[j] >= 0)
+				t_moved = _mm_sll_epi32(x, t_shifts[j]);
+			else
+				t_moved = _mm_srl_epi32(x, t_shifts[j]);
+			t_pixels = _mm_or_si128(t_pixels, _mm_and_si128(t_moved, t_masks[j]));
+		}
+		_mm_storeu_si128((__m128i *)(p_dst + i), t_pixels);
+	}
+#elif defined(MC_IMAGE_BITMAP_NEON)
+	// NEON shifts right when given a negative distance.
+	int32x4_t t_shifts[4];
+	uint32x4_t t_masks[4];
+	for(uint32_t j = 0; j < t_shuffle . count; j++)
+	{
+		t_shifts[j] = vdupq_n_s32(t_shuffle . shifts[j]);
+		t_masks[j] = vdupq_n_u32(t_shuffle . masks[j]);
+	}
+	for(; i + 4 <= p_count; i += 4)
+	{
+		uint32x4_t x, t_pixels;
+		x = vld1q_u32(p_src + i);
+		t_pixels = vdupq_n_u32(0);
+		for(uint32_t j = 0; j < t_shuffle . count; j++)
+			t_pixels = vorrq_u32(t_pixels, vandq_u32(vshlq_u32(x, t_shifts[j]), t_masks[j]));
+		vst1q_u32(p_dst + i, t_pixels);
+	}
+#endif
+	
+	for(; i < p_count; i++)
+		p_dst[i] = shuffle_pixel(t_shuffle, p_src[i]);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 bool MCImageCreateIndexedBitmap(uindex_t p_width, uindex_t p_height, MCImageIndexedBitmap *&r_indexed)
@@ -73,6 +73,10 @@ void MCImageBitmapUnpremultiply(MCImageBitmap *p_bitmap);
 void MCImageBitmapUnpremultiplyChecking(MCImageBitmap *p_bitmap);
 void MCImageBitmapFixPremultiplied(MCImageBitmap *p_bitmap);
 
+// Converts p_count pixels from one format to another. The source and destination
+// may be the same.
+void MCImageConvertPixels(const uint32_t *p_src, MCGPixelFormat p_src_format, uint32_t *p_dst, MCGPixelFormat p_dst_format, uindex_t p_count);
+
 //////////
 
 bool MCImageCreateIndexedBitmap(uindex_t p_width, uindex_t p_height, MCImageIndexedBitmap *&r_indexed);
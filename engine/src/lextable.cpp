@@ -319,6 +319,7 @@ const LT command_table[] =
         {"combine", TT_STATEMENT, S_COMBINE},
 		{"command", TT_STATEMENT, S_SCRIPT_ERROR},
         {"compact", TT_STATEMENT, S_COMPACT},
+        {"compress", TT_STATEMENT, S_COMPRESS},
         {"constant", TT_STATEMENT, S_CONSTANT},
         {"convert", TT_STATEMENT, S_CONVERT},
         {"copy", TT_STATEMENT, S_COPY},
@@ -326,6 +327,7 @@ const LT command_table[] =
         {"crop", TT_STATEMENT, S_CROP},
         {"cut", TT_STATEMENT, S_CUT},
         {"debugdo", TT_STATEMENT, S_DEBUGDO},
+        {"decompress", TT_STATEMENT, S_DECOMPRESS},
         {"decrypt", TT_STATEMENT, S_DECRYPT},
         {"default", TT_DEFAULT, S_UNDEFINED},
         {"define", TT_STATEMENT, S_DEFINE},
@@ -646,6 +648,7 @@ const LT factor_table[] =
         {"base64decode", TT_FUNCTION, F_BASE64_DECODE},
         {"base64encode", TT_FUNCTION, F_BASE64_ENCODE},
         {"baseconvert", TT_FUNCTION, F_BASE_CONVERT},
+        {"batchdatagrammessages", TT_PROPERTY, P_BATCH_DATAGRAM_MESSAGES},
         {"beepduration", TT_PROPERTY, P_BEEP_DURATION},
         {"beeploudness", TT_PROPERTY, P_BEEP_LOUDNESS},
         {"beeppitch", TT_PROPERTY, P_BEEP_PITCH},
@@ -659,6 +662,7 @@ const LT factor_table[] =
         // AL-2014-10-17: [[ BiDi ]] Returns the result of applying the bi-directional algorithm to text
         {"bididirection", TT_FUNCTION, F_BIDI_DIRECTION},
         {"binarydecode", TT_FUNCTION, F_BINARY_DECODE},
+        {"binarydecoderecords", TT_FUNCTION, F_BINARY_DECODE_RECORDS},
         {"binaryencode", TT_FUNCTION, F_BINARY_ENCODE},
         {"bitand", TT_BINOP, O_AND_BITS},
         {"bitnot", TT_UNOP, O_NOT_BITS},
@@ -845,6 +849,7 @@ const LT factor_table[] =
         {"disabledicon", TT_PROPERTY, P_DISABLED_ICON},
         {"diskspace", TT_FUNCTION, F_DISK_SPACE},
         {"div", TT_BINOP, O_DIV},
+        {"dnscachestatistics", TT_PROPERTY, P_DNS_CACHE_STATISTICS},
         {"dnsservers", TT_FUNCTION, F_DNS_SERVERS},
 		{"document", TT_CHUNK, CT_DOCUMENT},
         // MERG-2015-10-11: [[ DocumentFilename ]] Property tag for documentFilename
@@ -1646,6 +1651,7 @@ const LT factor_table[] =
         {"sixthpixel", TT_PROPERTY, P_BOTTOM_PIXEL},
         {"size", TT_PROPERTY, P_SIZE},
         {"slices", TT_PROPERTY, P_SLICES},
+        {"socketpendingbytes", TT_FUNCTION, F_SOCKET_PENDING_BYTES},
         {"sockettimeoutinterval", TT_PROPERTY, P_SOCKET_TIMEOUT},
         {"sound", TT_FUNCTION, F_SOUND},
         {"soundchannel", TT_PROPERTY, P_SOUND_CHANNEL},
@@ -1657,6 +1663,7 @@ const LT factor_table[] =
         {"spray", TT_PROPERTY, P_SPRAY},
         {"sqrt", TT_FUNCTION, F_SQRT},
         {"sslcertificates",TT_PROPERTY,P_SSL_CERTIFICATES},
+        {"sslsessionstatistics", TT_PROPERTY, P_SSL_SESSION_STATISTICS},
         {"stack", TT_CHUNK, CT_STACK},
         {"stackfiles", TT_PROPERTY, P_STACK_FILES},
         {"stackfiletype", TT_PROPERTY, P_STACK_FILE_TYPE},
@@ -2048,6 +2055,7 @@ const static LT repeat_table[] =
 const static LT reset_table[] =
     {
         {"cursors", TT_UNDEFINED, RT_CURSORS},
+        {"dnscache", TT_UNDEFINED, RT_DNS_CACHE},
         {"paint", TT_UNDEFINED, RT_PAINT},
         {"printing", TT_UNDEFINED, RT_PRINTING},
         {"templateaudioclip", TT_UNDEFINED, RT_TEMPLATE_AUDIO_CLIP},
@@ -66,6 +66,14 @@ protected:
 	// MW-2011-08-24: [[ Layers ]] The layer id of the control.
 	uint32_t m_layer_id;
     MCRectangle m_layer_clip_rect;
+
+	// The recording of the control's drawing as a scenery layer, along with
+	//   the region, transform and epoch it was last drawn with (see
+	//   layer_getdisplaylist).
+	MCGDisplayListRef m_layer_display_list;
+	MCRectangle32 m_layer_display_list_region;
+	MCGAffineTransform m_layer_display_list_transform;
+	uint32_t m_layer_display_list_epoch;
 	
 	// MW-2011-09-21: [[ Layers ]] Whether something about the control has
 	//   changed requiring a recompute the layer attributes.
@@ -94,6 +102,13 @@ protected:
     
     bool m_layer_has_clip_rect : 1;
 
+	// Whether the control has been drawn as scenery with the current display
+	//   list key (and into opaque tiles), and whether its drawing is too large
+	//   to keep recorded.
+	bool m_layer_display_list_seen : 1;
+	bool m_layer_display_list_opaque : 1;
+	bool m_layer_display_list_unrecordable : 1;
+
 	static int2 defaultmargin;
 	static int2 xoffset;
 	static int2 yoffset;
@@ -242,6 +257,24 @@ public:
 	// MW-2011-09-07: [[ Layers ]] Used internally to apply an update to a scrolling layer. If
 	//   'update_card' is true then the dirty rect of the stack will be updated too.
 	void layer_dirtycontentrect(const MCRectangle& content_rect, bool update_card);
+	// Used internally to note that the content of the control (and so of the groups
+	//   containing it) has changed, so any cached effects must be recomputed. This
+	//   applies even if the control is not drawn now, so the redraw methods call it
+	//   before checking whether the control is open.
+	void layer_contentchanged(void);
+	// Used internally to note that the content of the groups containing the control
+	//   has changed, for example because the control has moved.
+	void layer_parentcontentchanged(void);
+
+	// Returns a recording of the control's drawing as a scenery layer if it has
+	//   been drawn unchanged before, retained for the caller. If false is returned
+	//   the control should be drawn directly.
+	bool layer_getdisplaylist(bool p_opaque, MCGDisplayListRef& r_display_list);
+	// Discards the recording of the control's drawing.
+	void layer_resetdisplaylist(void);
+	// Discards the recordings of all controls' drawing (they are released
+	//   lazily, as each control is next drawn).
+	static void layer_invalidatedisplaylists(void);
 
 	// MW-2011-08-24: [[ TileCache ]] Returns the current layer id.
 	uint32_t layer_getid(void) { return m_layer_id; }
@@ -122,50 +122,57 @@ void IO_cleanprocesses()
 real8 IO_cleansockets(real8 ctime)
 {
 	real8 etime = ctime + MCmaxwait;
-	uint2 i = 0;
-	while (i < MCnsockets)
-		if (!MCsockets[i]->waiting && MCsockets[i]->fd == 0
-			&& MCsockets[i]->nread == 0 && MCsockets[i]->resolve_state != kMCSocketStateResolving)
-            MCSocketsRemoveFromSocketList(i);
-		else
+	MCSocketsRemoveFinishedFromSocketList();
+	for (uint4 i = 0 ; i < MCnsockets ; i++)
+	{
+		MCSocket *s = MCsockets[i];
+		if (!s->waiting && !s->accepting
+		    && ((!s->connected && ctime > s->timeout)
+		        || (s->wevents != NULL && ctime > s->wevents->timeout)
+		        || (s->revents != NULL && ctime > s->revents->timeout)))
 		{
-			MCSocket *s = MCsockets[i++];
-			if (!s->waiting && !s->accepting
-			    && ((!s->connected && ctime > s->timeout)
-			        || (s->wevents != NULL && ctime > s->wevents->timeout)
-			        || (s->revents != NULL && ctime > s->revents->timeout)))
-			{
-				if (!s->connected)
-					s->timeout = ctime  + MCsockettimeout;
-				if (s->revents != NULL)
-					s->revents->timeout = ctime + MCsockettimeout;
-				if (s->wevents != NULL)
-					s->wevents->timeout = ctime + MCsockettimeout;
-                
-                if (s->object.IsValid())
-                    MCscreen->delaymessage(s->object, MCM_socket_timeout, MCNameGetString(s->name));
-			}
-			if (s->wevents != NULL && s->wevents->timeout < etime)
-				etime = s->wevents->timeout;
-			if (s->revents != NULL && s->revents->timeout < etime)
-				etime = s->revents->timeout;
+			if (!s->connected)
+				s->timeout = ctime  + MCsockettimeout;
+			if (s->revents != NULL)
+				s->revents->timeout = ctime + MCsockettimeout;
+			if (s->wevents != NULL)
+				s->wevents->timeout = ctime + MCsockettimeout;
+            
+            if (s->object.IsValid())
+                MCscreen->delaymessage(s->object, MCM_socket_timeout, MCNameGetString(s->name));
 		}
+		if (s->wevents != NULL && s->wevents->timeout < etime)
+			etime = s->wevents->timeout;
+		if (s->revents != NULL && s->revents->timeout < etime)
+			etime = s->revents->timeout;
+	}
 	return etime;
 }
 
 bool IO_findsocket(MCNameRef p_name, uindex_t& r_index)
 {
-	IO_cleansockets(MCS_time());
-	for (r_index = 0 ; r_index < MCnsockets ; r_index++)
-		if (MCNameIsEqualToCaseless(p_name, MCsockets[r_index]->name))
-			return true;
-	return false;
+	MCSocket *t_socket;
+	t_socket = MCSocketsFindSocket(p_name);
+	if (t_socket == NULL)
+		return false;
+	
+	// A socket which has finished would have been removed by cleaning the
+	// sockets, so remove it now rather than sweeping the whole list (it is
+	// deleted by the next sweep).
+	if (t_socket -> isfinished())
+	{
+		MCSocketsRemoveFromSocketList(t_socket -> listindex);
+		return false;
+	}
+	
+	r_index = t_socket -> listindex;
+	return true;
 }
 
 void IO_freeobject(MCObject *o)
 {
 	IO_cleansockets(MCS_time());
-	uint2 i = 0;
+	uint4 i = 0;
 	while (i < MCnsockets)
 #if 1
 	{
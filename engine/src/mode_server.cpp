@@ -427,12 +427,18 @@ void MCRemotePageSetupDialog(MCDataRef p_config_data, MCDataRef &r_reply_data, u
 //
 
 #ifdef _LINUX_SERVER
+extern void MCServerUrlLoadsPreSelect(int& maxfd, fd_set& rfds, fd_set& wfds, fd_set& efds);
+extern void MCServerUrlLoadsPostSelect(void);
+
 void MCModePreSelectHook(int& maxfd, fd_set& rfds, fd_set& wfds, fd_set& efds)
 {
+	// Wake up when there is activity on any URLs which are being loaded.
+	MCServerUrlLoadsPreSelect(maxfd, rfds, wfds, efds);
 }
 
 void MCModePostSelectHook(fd_set& rfds, fd_set& wfds, fd_set& efds)
 {
+	MCServerUrlLoadsPostSelect();
 }
 
 #endif
@@ -374,6 +374,31 @@ bool MCStandaloneCapsuleCallback(void *p_self, const uint8_t *p_digest, MCCapsul
     }
     break;
             
+    case kMCCapsuleSectionTypeDeferredAuxiliaryStack:
+    {
+        // The stackfile is left compressed, and is only inflated and loaded
+        // when the stack is first looked up by name.
+        MCCapsuleDeferredStackSection t_section;
+        MCNewAutoNameRef t_name;
+        MCAutoDataRef t_data;
+        if (!MCCapsuleDeferredStackSectionRead(p_stream, p_length, t_section, &t_name, &t_data))
+        {
+            MCresult -> sets("failed to read auxillary stack");
+            return false;
+        }
+        
+        if (!MCdispatcher -> adddeferredstack(*t_name,
+                                              (t_section . flags & kMCCapsuleDeferredStackFlagScriptOnly) != 0,
+                                              t_section . length,
+                                              t_section . digest,
+                                              *t_data))
+        {
+            MCresult -> sets("out of memory");
+            return false;
+        }
+    }
+    break;
+            
     case kMCCapsuleSectionTypeModule:
     {
 		MCAutoByteArray t_module_data;
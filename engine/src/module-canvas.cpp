@@ -60,6 +60,7 @@ enum MCSVGPathCommand
 typedef bool (*MCSVGParseCallback)(void *p_context, MCSVGPathCommand p_command, float32_t *p_args, uint32_t p_arg_count);
 
 bool MCSVGParse(MCStringRef p_string, MCSVGParseCallback p_callback, void *p_context);
+bool MCSVGParseList(MCProperListRef p_list, MCSVGParseCallback p_callback, void *p_context);
 
 inline bool MCSVGPathCommandIsCubic(MCSVGPathCommand p_command)
 {
@@ -2021,14 +2022,8 @@ void MCCanvasImageGetPixels(MCCanvasImageRef p_image, MCDataRef &r_pixels)
 	
 	for (uint32_t y = 0; y < t_raster->height; y++)
 	{
-		uint32_t *t_pixel_ptr;
-		t_pixel_ptr = (uint32_t*)t_pixel_row;
-		
-		for (uint32_t x = 0; x < t_raster->width; x++)
-		{
-			*t_buffer_ptr++ = MCGPixelFromNative(kMCGPixelFormatARGB, *t_pixel_ptr);
-			t_pixel_ptr++;
-		}
+		MCImageConvertPixels((const uint32_t*)t_pixel_row, kMCGPixelFormatNative, t_buffer_ptr, kMCGPixelFormatARGB, t_raster->width);
+		t_buffer_ptr += t_raster->width;
 		
 		t_pixel_row += t_raster->stride;
 	}
@@ -3370,6 +3365,34 @@ void MCCanvasPathMakeWithInstructionsAsString(MCStringRef p_instructions, MCCanv
 	MCGPathRelease(t_path);
 }
 
+// Building a path one instruction at a time copies (and interns) the whole
+// path for each one, so this builds it from a list of instructions in one go.
+MC_DLLEXPORT_DEF
+void MCCanvasPathMakeWithInstructionsAsList(MCProperListRef p_instructions, MCCanvasPathRef &r_path)
+{
+	bool t_success;
+	t_success = true;
+	
+	MCGPathRef t_path;
+	t_path = nil;
+	
+	if (t_success)
+		t_success = MCGPathCreateMutable(t_path);
+	
+	if (t_success)
+	{
+		MCCanvasPathSVGParseContext t_context;
+		t_context.path = t_path;
+		t_context.first_point = t_context.last_point = MCGPointMake(0, 0);
+		t_success = MCSVGParseList(p_instructions, MCCanvasPathSVGParseCallback, &t_context);
+	}
+	
+	if (t_success)
+		MCCanvasPathMakeWithMCGPath(t_path, r_path);
+	
+	MCGPathRelease(t_path);
+}
+
 MC_DLLEXPORT_DEF
 void MCCanvasPathMakeWithRoundedRectangleWithRadii(MCCanvasRectangleRef p_rect, MCCanvasFloat p_x_radius, MCCanvasFloat p_y_radius, MCCanvasPathRef &r_path)
 {
@@ -6922,12 +6945,9 @@ bool MCSVGConsumeWSPCommaWSP(const char *p_string, MCRange &x_range)
 	return !MCRangeIsEqual(x_range, t_range);
 }
 
-bool MCSVGParseParams(const char *p_string, MCRange &x_range, MCSVGPathCommand p_command, float32_t r_params[7], uindex_t &r_param_count)
+uindex_t MCSVGPathCommandGetParamCount(MCSVGPathCommand p_command)
 {
 	uindex_t t_param_count;
-	MCRange t_range;
-	t_range = x_range;
-	
 	switch (p_command)
 	{
 		case kMCSVGPathMoveTo:
@@ -6984,6 +7004,17 @@ bool MCSVGParseParams(const char *p_string, MCRange &x_range, MCSVGPathCommand p
 			break;
 	}
 	
+	return t_param_count;
+}
+
+bool MCSVGParseParams(const char *p_string, MCRange &x_range, MCSVGPathCommand p_command, float32_t r_params[7], uindex_t &r_param_count)
+{
+	uindex_t t_param_count;
+	t_param_count = MCSVGPathCommandGetParamCount(p_command);
+	
+	MCRange t_range;
+	t_range = x_range;
+	
 	for (uint32_t i = 0; i < t_param_count; i++)
 	{
 		real64_t t_real;
@@ -7002,6 +7033,47 @@ bool MCSVGParseParams(const char *p_string, MCRange &x_range, MCSVGPathCommand p
 	return true;
 }
 
+// Works out the command for the next set of parameters in a path, given
+// whether an explicit command was found for them. If the sequence of commands
+// is invalid, r_error is set to the reason.
+bool MCSVGContinuePathCommand(bool p_have_command, bool &x_first_command, MCSVGPathCommand &x_command, MCStringRef &r_error)
+{
+	if (x_first_command)
+	{
+		// If this is the first command then it must exist and it must be a moveto.
+		if (!p_have_command ||
+			(x_command != kMCSVGPathMoveTo &&
+			 x_command != kMCSVGPathRelativeMoveTo))
+		{
+			r_error = MCSTR("Path must begin with moveto command");
+			return false;
+		}
+		
+		x_first_command = false;
+	}
+	else
+	{
+		// If this is subsequent command and we did not parse a command then we
+		// must map a move to to the corresponding line to. If we previously had
+		// a close, then it is an error (since you can't have multiple closes -
+		// they have no params!).
+		if (!p_have_command)
+		{
+			if (x_command == kMCSVGPathMoveTo)
+				x_command = kMCSVGPathLineTo;
+			else if (x_command == kMCSVGPathRelativeMoveTo)
+				x_command = kMCSVGPathRelativeLineTo;
+			else if (x_command == kMCSVGPathClose)
+			{
+				r_error = MCSTR("Path command character expected");
+				return false;
+			}
+		}
+	}
+	
+	return true;
+}
+
 bool MCSVGParse(MCStringRef p_string, MCSVGParseCallback p_callback, void *p_context)
 {
 	
@@ -7031,32 +7103,9 @@ bool MCSVGParse(MCStringRef p_string, MCSVGParseCallback p_callback, void *p_con
 		bool t_have_command;
 		t_have_command = MCSVGParsePathCommand(*t_native_string, t_range, t_command);
 		
-		if (t_first_command)
-		{
-			// If this is the first command then it must exist and it must be a moveto.
-			if (!t_have_command ||
-				(t_command != kMCSVGPathMoveTo &&
-				 t_command != kMCSVGPathRelativeMoveTo))
-				return MCSVGThrowPathParseError(t_range.offset, MCSTR("Path must begin with moveto command"));
-			
-			t_first_command = false;
-		}
-		else
-		{
-			// If this is subsequent command and we did not parse a command then we
-			// must map a move to to the corresponding line to. If we previously had
-			// a close, then it is an error (since you can't have multiple closes -
-			// they have no params!).
-			if (!t_have_command)
-			{
-				if (t_command == kMCSVGPathMoveTo)
-					t_command = kMCSVGPathLineTo;
-				else if (t_command == kMCSVGPathRelativeMoveTo)
-					t_command = kMCSVGPathRelativeLineTo;
-				else if (t_command == kMCSVGPathClose)
-					return MCSVGThrowPathParseError(t_range.offset, MCSTR("Path command character expected"));
-			}
-		}
+		MCStringRef t_error;
+		if (!MCSVGContinuePathCommand(t_have_command, t_first_command, t_command, t_error))
+			return MCSVGThrowPathParseError(t_range.offset, t_error);
 		
 		// Attempt to parse the parameters.
 		float32_t t_params[7];
@@ -7075,6 +7124,67 @@ bool MCSVGParse(MCStringRef p_string, MCSVGParseCallback p_callback, void *p_con
 	return true;
 }
 
+// Parses path instructions given as a list, rather than as a string. Each
+// element is either a string holding a single SVG path command character, or a
+// number which is a parameter of the current command. The same rules apply as
+// for SVG path data, so commands may be repeated by giving more parameters.
+// The position of any error is the index of the offending element.
+bool MCSVGParseList(MCProperListRef p_list, MCSVGParseCallback p_callback, void *p_context)
+{
+	uindex_t t_length;
+	t_length = MCProperListGetLength(p_list);
+	
+	uindex_t t_index;
+	t_index = 0;
+	
+	bool t_first_command;
+	t_first_command = true;
+	MCSVGPathCommand t_command;
+	while (t_index < t_length)
+	{
+		MCValueRef t_element;
+		t_element = MCProperListFetchElementAtIndex(p_list, t_index);
+		
+		// A string element must be a path command, otherwise it must be a
+		// parameter of the previous command.
+		bool t_have_command;
+		t_have_command = false;
+		if (MCValueGetTypeCode(t_element) == kMCValueTypeCodeString)
+		{
+			MCStringRef t_string;
+			t_string = static_cast<MCStringRef>(t_element);
+			if (MCStringGetLength(t_string) != 1 ||
+				!MCSVGLookupPathCommand(MCStringGetNativeCharAtIndex(t_string, 0), t_command))
+				return MCSVGThrowPathParseError(t_index, MCSTR("Path command character expected"));
+			
+			t_have_command = true;
+			t_index++;
+		}
+		
+		MCStringRef t_error;
+		if (!MCSVGContinuePathCommand(t_have_command, t_first_command, t_command, t_error))
+			return MCSVGThrowPathParseError(t_index, t_error);
+		
+		float32_t t_params[7];
+		uindex_t t_param_count;
+		t_param_count = MCSVGPathCommandGetParamCount(t_command);
+		for (uindex_t i = 0; i < t_param_count; i++)
+		{
+			if (t_index >= t_length ||
+				MCValueGetTypeCode(t_element = MCProperListFetchElementAtIndex(p_list, t_index)) != kMCValueTypeCodeNumber)
+				return MCSVGThrowPathParseError(t_index, MCSTR("Expected number value"));
+			
+			t_params[i] = MCNumberFetchAsReal(static_cast<MCNumberRef>(t_element));
+			t_index++;
+		}
+		
+		if (!p_callback(p_context, t_command, t_params, t_param_count))
+			return false;
+	}
+	
+	return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 bool MCSVGAppendValueToString(MCStringRef p_string, bool p_need_separator, float32_t p_value)
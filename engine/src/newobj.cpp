@@ -71,6 +71,8 @@ MCStatement *MCN_new_statement(int2 which)
 		return new MCCombine;
 	case S_COMPACT:
 		return new MCCompact;
+	case S_COMPRESS:
+		return new MCCompressFile;
 	case S_CONSTANT:
 		return new MCLocalConstant;
 	case S_CONVERT:
@@ -85,6 +87,8 @@ MCStatement *MCN_new_statement(int2 which)
 		return new MCCutCmd;
 	case S_DEBUGDO:
 		return new MCDebugDo;
+	case S_DECOMPRESS:
+		return new MCDecompressFile;
 	case S_DECRYPT:
 		return new MCCipherDecrypt;
 	case S_DEFINE:
@@ -362,6 +366,8 @@ MCExpression *MCN_new_function(int2 which)
 		return new MCBinaryEncode;
 	case F_BINARY_DECODE:
 		return new MCBinaryDecode;
+	case F_BINARY_DECODE_RECORDS:
+		return new MCBinaryDecodeRecords;
 	case F_BUILD_NUMBER:
 		return new MCBuildNumber;
     case F_BYTE_OFFSET:
@@ -767,6 +773,8 @@ MCExpression *MCN_new_function(int2 which)
 	// JS-2013-06-19: [[ StatsFunctions ]] Constructor for 'sampleVariance'
 	case F_SMP_VARIANCE:
 		return new MCSampleVariance;
+	case F_SOCKET_PENDING_BYTES:
+		return new MCSocketPendingBytes;
 	case F_SOUND:
 		return new MCSound;
 	case F_SPECIAL_FOLDER_PATH:
@@ -33,11 +33,16 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include <pthread.h>
 #define USE_PTHREADS
 #define USE_PIPE
-#elif defined(_LINUX_DESKTOP) || defined(_LINUX_SERVER)
+#elif defined(_LINUX_DESKTOP)
 #include <pthread.h>
 #include <unistd.h>
 #define USE_PTHREADS
 #define USE_PIPE
+#elif defined(_LINUX_SERVER)
+#include <pthread.h>
+#define USE_PTHREADS
+#define USE_PING
+#define PING_FUNC MCServerEventLoopWake
 #elif defined(_WINDOWS_DESKTOP) || defined(_WINDOWS_SERVER)
 #define USE_WINTHREADS
 #elif defined(_IOS_MOBILE)
@@ -3068,6 +3068,58 @@ void MCObject::alloccolors()
 	}
 }
 
+// Snapshots are drawn into a display list, which is then replayed into the
+// bitmap in horizontal bands of at least this many pixels, each on its own
+// thread.
+#define SNAPSHOT_MIN_BAND_PIXELS 65536
+
+struct MCObjectSnapshotBands
+{
+	MCGDisplayListRef display_list;
+	MCImageBitmap *bitmap;
+	uint32_t band_height;
+	bool failed;
+};
+
+static void MCObjectSnapshotBand(void *p_context, uint32_t p_index)
+{
+	MCObjectSnapshotBands *t_bands;
+	t_bands = static_cast<MCObjectSnapshotBands *>(p_context);
+	
+	uint32_t t_top, t_height;
+	t_top = p_index * t_bands -> band_height;
+	t_height = MCMin(t_bands -> band_height, t_bands -> bitmap -> height - t_top);
+	
+	MCGContextRef t_context;
+	if (!MCGContextCreateWithPixels(t_bands -> bitmap -> width, t_height, t_bands -> bitmap -> stride, (uint8_t *)t_bands -> bitmap -> data + t_top * t_bands -> bitmap -> stride, true, t_context))
+	{
+		t_bands -> failed = true;
+		return;
+	}
+	
+	MCGContextTranslateCTM(t_context, 0.0f, -(MCGFloat)t_top);
+	MCGContextDrawDisplayList(t_context, t_bands -> display_list);
+	MCGContextRelease(t_context);
+}
+
+static bool MCObjectSnapshotRasterize(MCGDisplayListRef p_display_list, MCImageBitmap *p_bitmap)
+{
+	MCObjectSnapshotBands t_bands;
+	t_bands . display_list = p_display_list;
+	t_bands . bitmap = p_bitmap;
+	t_bands . failed = false;
+	
+	uint32_t t_band_count;
+	t_band_count = MCMin(MCGParallelGetThreadCount(), MCMax(1U, (p_bitmap -> width * p_bitmap -> height) / SNAPSHOT_MIN_BAND_PIXELS));
+	t_band_count = MCMin(t_band_count, p_bitmap -> height);
+	t_bands . band_height = (p_bitmap -> height + t_band_count - 1) / t_band_count;
+	t_band_count = (p_bitmap -> height + t_bands . band_height - 1) / t_bands . band_height;
+	
+	MCGParallelFor(t_band_count, MCObjectSnapshotBand, &t_bands);
+	
+	return !t_bands . failed;
+}
+
 MCImageBitmap *MCObject::snapshot(const MCRectangle *p_clip, const MCPoint *p_size, MCGFloat p_scale_factor, bool p_with_effects)
 {
 	Chunk_term t_type;
@@ -3113,21 +3165,68 @@ MCImageBitmap *MCObject::snapshot(const MCRectangle *p_clip, const MCPoint *p_si
 	/* UNCHECKED */ MCImageBitmapCreate(ceil(t_context_width * p_scale_factor), ceil(t_context_height * p_scale_factor), t_bitmap);
 	MCImageBitmapClear(t_bitmap);
 
+	// The objects can only be drawn on this thread, so record the drawing and
+	// then rasterize it on several threads. If the drawing can't be recorded,
+	// the object is drawn straight into the bitmap instead.
 	MCGContextRef t_gcontext = nil;
-	/* UNCHECKED */ MCGContextCreateWithPixels(t_bitmap->width, t_bitmap->height, t_bitmap->stride, t_bitmap->data, true, t_gcontext);
+	MCGDisplayListRef t_display_list;
+	t_display_list = nil;
+	if (MCGContextCreateForDisplayList(MCGIntegerRectangleMake(0, 0, t_bitmap->width, t_bitmap->height), false, t_gcontext))
+	{
+		snapshotdraw(t_gcontext, r, p_size, p_scale_factor, t_effects);
+		if (!MCGContextCopyDisplayList(t_gcontext, t_display_list))
+			t_display_list = nil;
+		MCGContextRelease(t_gcontext);
+		t_gcontext = nil;
+	}
+	
+	bool t_drawn;
+	t_drawn = false;
+	if (t_display_list != nil)
+	{
+		t_drawn = MCObjectSnapshotRasterize(t_display_list, t_bitmap);
+		if (!t_drawn)
+			MCImageBitmapClear(t_bitmap);
+	}
+	
+	if (!t_drawn && MCGContextCreateWithPixels(t_bitmap->width, t_bitmap->height, t_bitmap->stride, t_bitmap->data, true, t_gcontext))
+	{
+		if (t_display_list != nil)
+			MCGContextDrawDisplayList(t_gcontext, t_display_list);
+		else
+			snapshotdraw(t_gcontext, r, p_size, p_scale_factor, t_effects);
+		t_drawn = true;
+		MCGContextRelease(t_gcontext);
+	}
+	
+	MCGDisplayListRelease(t_display_list);
+	
+	if (!t_drawn)
+	{
+		MCImageFreeBitmap(t_bitmap);
+		return NULL;
+	}
+	
+	return t_bitmap;
+}
 
+void MCObject::snapshotdraw(MCGContextRef p_gcontext, const MCRectangle& r, const MCPoint *p_size, MCGFloat p_scale_factor, MCBitmapEffectsRef p_effects)
+{
+	Chunk_term t_type;
+	t_type = gettype();
+	
 	// IM-2013-07-24: [[ ResIndependence ]] take snapshot at specified scale, rather than device scale
-	MCGContextScaleCTM(t_gcontext, p_scale_factor, p_scale_factor);
+	MCGContextScaleCTM(p_gcontext, p_scale_factor, p_scale_factor);
 	
 	MCGAffineTransform t_transform = MCGAffineTransformMakeTranslation(-r.x, -r.y);
 	if (p_size != nil)
 		t_transform = MCGAffineTransformPreScale(t_transform, p_size->x / (float)r.width, p_size->y / (float)r.height);
 
-	MCGContextConcatCTM(t_gcontext, t_transform);
+	MCGContextConcatCTM(p_gcontext, t_transform);
 	
 	// MW-2014-01-07: [[ bug 11632 ]] Use the offscreen variant of the context so its
 	//   type field is appropriate for use by the player.
-	MCContext *t_context = new (nothrow) MCOffscreenGraphicsContext(t_gcontext);
+	MCContext *t_context = new (nothrow) MCOffscreenGraphicsContext(p_gcontext);
 	t_context -> setclip(r);
 
 	// MW-2011-01-29: [[ Bug 9355 ]] Make sure we only open a control if it needs it!
@@ -3172,11 +3271,11 @@ MCImageBitmap *MCObject::snapshot(const MCRectangle *p_clip, const MCPoint *p_si
 #ifdef FEATURE_PLATFORM_PLAYER
         MCPlatformWaitForEvent(0.0, true);
 #endif
-		if (t_effects != nil)
-			t_context -> begin_with_effects(t_effects, static_cast<MCControl *>(this) -> getrect());
+		if (p_effects != nil)
+			t_context -> begin_with_effects(p_effects, static_cast<MCControl *>(this) -> getrect());
 		// MW-2011-09-06: [[ Redraw ]] Render the control isolated, but not as a sprite.
 		((MCControl *)this) -> draw(t_context, r, true, false);
-		if (t_effects != nil)
+		if (p_effects != nil)
 			t_context -> end();
 	}
 	
@@ -3196,8 +3295,6 @@ MCImageBitmap *MCObject::snapshot(const MCRectangle *p_clip, const MCPoint *p_si
 		}
 	}
 	delete t_context;
-	MCGContextRelease(t_gcontext);
-	return t_bitmap;
 }
 
 bool MCObject::isselectable(bool p_only_object) const
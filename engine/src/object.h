@@ -1077,6 +1077,9 @@ public:
 
 	// IM-2013-07-24: [[ ResIndependence ]] Add scale factor to allow taking high-res snapshots
 	MCImageBitmap *snapshot(const MCRectangle *rect, const MCPoint *size, MCGFloat p_scale_factor, bool with_effects);
+	// Draws the area r of the object into the given context for snapshot, scaled
+	//   to size (if not nil) and then by the scale factor.
+	void snapshotdraw(MCGContextRef p_gcontext, const MCRectangle& r, const MCPoint *size, MCGFloat p_scale_factor, MCBitmapEffectsRef p_effects);
 
 	// MW-2011-09-20: [[ Collision ]] Check to see if the two objects touch (exactly).
 	bool intersects(MCObject *other, uint32_t threshold);
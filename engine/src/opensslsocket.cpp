@@ -39,6 +39,9 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #include "notify.h"
 #include "socket.h"
+#include "dnscache.h"
+#include "securemode.h"
+#include "srveventloop.h"
 #include "system.h"
 
 #if defined(_WINDOWS_DESKTOP) || defined(_WINDOWS_SERVER)
@@ -262,6 +265,9 @@ static bool MCSocketsPollInterrupt(void)
     return t_success;
 }
 
+static void MCSocketsFreeSlabs(void);
+static void MCSocketsFreeDatagramState(void);
+
 bool MCSocketsInitialize(void)
 {
 #if defined(USE_AUX_THREAD)
@@ -273,6 +279,10 @@ bool MCSocketsInitialize(void)
 
 void MCSocketsFinalize(void)
 {
+    MCSocketsFreeSlabs();
+    MCSocketsFreeDatagramState();
+    MCDnsCacheFinalize();
+    
 #if defined(USE_AUX_THREAD)
     if (s_socket_poll_thread)
     {
@@ -287,12 +297,261 @@ void MCSocketsFinalize(void)
 #endif
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//
+// Socket registry
+//
+
+// The open sockets are kept in MCsockets in the order they were opened (which
+// is the order of the openSockets). So that looking up a socket by name does
+// not have to search the list, sockets are also indexed by the caseless key of
+// their name in an open-addressed hash table. Each socket records its position
+// in MCsockets, which is kept up to date as the list is compacted.
+//
+// If more than one socket has the same name, only the first in the list is
+// indexed (as that is the one a linear search would have found).
+//
+// Sockets are only taken out of MCsockets by a single compacting pass over the
+// finished ones, as removing one from the middle would shift (and renumber) all
+// those after it. Removing a single socket just takes it out of the index.
+
+#define SOCKET_INDEX_TOMBSTONE ((MCSocket *)1)
+
+static MCSocket **s_socket_index = NULL;
+static uint32_t s_socket_index_capacity = 0;
+static uint32_t s_socket_index_used = 0;
+static uint32_t s_socket_index_duplicates = 0;
+static uint32_t s_sockets_capacity = 0;
+
+static inline uint32_t MCSocketsIndexHash(MCNameRef p_name)
+{
+    uintptr_t t_key;
+    t_key = MCNameGetCaselessSearchKey(p_name);
+    
+    // The key is a pointer, so mix the bits so the low ones are well distributed.
+    uint64_t t_hash;
+    t_hash = uint64_t(t_key) * 0x9E3779B97F4A7C15ULL;
+    return uint32_t(t_hash >> 32);
+}
+
+static MCSocket **MCSocketsIndexLookup(MCNameRef p_name)
+{
+    if (s_socket_index_capacity == 0)
+        return NULL;
+    
+    uint32_t t_mask, t_slot;
+    t_mask = s_socket_index_capacity - 1;
+    t_slot = MCSocketsIndexHash(p_name) & t_mask;
+    for(;;)
+    {
+        MCSocket *t_socket;
+        t_socket = s_socket_index[t_slot];
+        if (t_socket == NULL)
+            return NULL;
+        if (t_socket != SOCKET_INDEX_TOMBSTONE && MCNameIsEqualToCaseless(t_socket -> name, p_name))
+            return &s_socket_index[t_slot];
+        t_slot = (t_slot + 1) & t_mask;
+    }
+}
+
+static bool MCSocketsIndexRehash(uint32_t p_new_capacity)
+{
+    MCSocket **t_new_index;
+    if (!MCMemoryNewArray(p_new_capacity, t_new_index))
+        return false;
+    
+    uint32_t t_mask;
+    t_mask = p_new_capacity - 1;
+    for(uint32_t i = 0; i < s_socket_index_capacity; i++)
+    {
+        MCSocket *t_socket;
+        t_socket = s_socket_index[i];
+        if (t_socket == NULL || t_socket == SOCKET_INDEX_TOMBSTONE)
+            continue;
+        
+        uint32_t t_slot;
+        t_slot = MCSocketsIndexHash(t_socket -> name) & t_mask;
+        while (t_new_index[t_slot] != NULL)
+            t_slot = (t_slot + 1) & t_mask;
+        t_new_index[t_slot] = t_socket;
+    }
+    
+    MCMemoryDeleteArray(s_socket_index);
+    s_socket_index = t_new_index;
+    s_socket_index_capacity = p_new_capacity;
+    
+    // Tombstones are not carried over, so only live entries are now in use.
+    s_socket_index_used = 0;
+    for(uint32_t i = 0; i < s_socket_index_capacity; i++)
+        if (s_socket_index[i] != NULL)
+            s_socket_index_used++;
+    
+    return true;
+}
+
+static void MCSocketsIndexInsert(MCSocket *p_socket)
+{
+    if (MCSocketsIndexLookup(p_socket -> name) != NULL)
+    {
+        p_socket -> indexstate = kMCSocketIndexStateDuplicate;
+        s_socket_index_duplicates++;
+        return;
+    }
+    
+    // Keep the table (including tombstones) at most half full.
+    if ((s_socket_index_used + 1) * 2 > s_socket_index_capacity)
+    {
+        uint32_t t_capacity;
+        t_capacity = s_socket_index_capacity == 0 ? 16 : s_socket_index_capacity;
+        while ((MCnsockets + 1) * 2 > t_capacity / 2)
+            t_capacity *= 2;
+        if (!MCSocketsIndexRehash(t_capacity))
+            return;
+    }
+    
+    uint32_t t_mask, t_slot;
+    t_mask = s_socket_index_capacity - 1;
+    t_slot = MCSocketsIndexHash(p_socket -> name) & t_mask;
+    while (s_socket_index[t_slot] != NULL && s_socket_index[t_slot] != SOCKET_INDEX_TOMBSTONE)
+        t_slot = (t_slot + 1) & t_mask;
+    
+    if (s_socket_index[t_slot] == NULL)
+        s_socket_index_used++;
+    s_socket_index[t_slot] = p_socket;
+    p_socket -> indexstate = kMCSocketIndexStateIndexed;
+}
+
+// Removes the socket from the index, if it is still there. If another socket
+// has the same name, the first one in MCsockets takes its place.
+static void MCSocketsIndexRemove(MCSocket *p_socket)
+{
+    MCSocketIndexState t_state;
+    t_state = p_socket -> indexstate;
+    p_socket -> indexstate = kMCSocketIndexStateNone;
+    
+    if (t_state == kMCSocketIndexStateDuplicate)
+        s_socket_index_duplicates--;
+    if (t_state != kMCSocketIndexStateIndexed)
+        return;
+    
+    MCSocket **t_entry;
+    t_entry = MCSocketsIndexLookup(p_socket -> name);
+    if (t_entry != NULL)
+        *t_entry = SOCKET_INDEX_TOMBSTONE;
+    
+    if (s_socket_index_duplicates == 0)
+        return;
+    
+    for(uint32_t i = 0; i < MCnsockets; i++)
+        if (MCsockets[i] -> indexstate == kMCSocketIndexStateDuplicate &&
+            MCNameIsEqualToCaseless(MCsockets[i] -> name, p_socket -> name))
+        {
+            s_socket_index_duplicates--;
+            MCSocketsIndexInsert(MCsockets[i]);
+            break;
+        }
+}
+
+MCSocket *MCSocketsFindSocket(MCNameRef p_name)
+{
+    MCSocket **t_entry;
+    t_entry = MCSocketsIndexLookup(p_name);
+    if (t_entry == NULL)
+        return NULL;
+    return *t_entry;
+}
+
+// MCSocket objects are allocated from a slab of fixed-size blocks, with freed
+// blocks kept on a free list for reuse - servers accepting (and closing) many
+// connections would otherwise churn the heap.
+
+#define SOCKET_SLAB_SIZE 64
+
+union MCSocketSlabBlock
+{
+    MCSocketSlabBlock *next;
+    char storage[(sizeof(MCSocket) + 15) & ~15];
+};
+
+struct MCSocketSlab
+{
+    MCSocketSlab *next;
+    MCSocketSlabBlock blocks[SOCKET_SLAB_SIZE];
+};
+
+static MCSocketSlab *s_socket_slabs = NULL;
+static MCSocketSlabBlock *s_socket_free_blocks = NULL;
+
+MCSocket *MCSocketsNew(MCNameRef n, MCNameRef f, MCObject *o, MCNameRef m, Boolean d, MCSocketHandle sock, Boolean a, Boolean s, Boolean issecure)
+{
+    if (s_socket_free_blocks == NULL)
+    {
+        MCSocketSlab *t_slab;
+        if (!MCMemoryNew(t_slab))
+            return NULL;
+        
+        for(uint32_t i = 0; i < SOCKET_SLAB_SIZE; i++)
+        {
+            t_slab -> blocks[i] . next = s_socket_free_blocks;
+            s_socket_free_blocks = &t_slab -> blocks[i];
+        }
+        
+        t_slab -> next = s_socket_slabs;
+        s_socket_slabs = t_slab;
+    }
+    
+    MCSocketSlabBlock *t_block;
+    t_block = s_socket_free_blocks;
+    s_socket_free_blocks = t_block -> next;
+    
+    return new (t_block -> storage) MCSocket(n, f, o, m, d, sock, a, s, issecure);
+}
+
+void MCSocketsDelete(MCSocket *p_socket)
+{
+    if (p_socket == NULL)
+        return;
+    
+    p_socket -> ~MCSocket();
+    
+    MCSocketSlabBlock *t_block;
+    t_block = (MCSocketSlabBlock *)p_socket;
+    t_block -> next = s_socket_free_blocks;
+    s_socket_free_blocks = t_block;
+}
+
+static void MCSocketsFreeSlabs(void)
+{
+    while (s_socket_slabs != NULL)
+    {
+        MCSocketSlab *t_slab;
+        t_slab = s_socket_slabs;
+        s_socket_slabs = t_slab -> next;
+        MCMemoryDelete(t_slab);
+    }
+    s_socket_free_blocks = NULL;
+}
+
 void MCSocketsAppendToSocketList(MCSocket *p_socket)
 {
     MCSocketsLockSocketList();
     
-    MCU_realloc((char **)&MCsockets, MCnsockets, MCnsockets + 1, sizeof(MCSocket *));
+    // Grow the list geometrically rather than by one entry per socket.
+    if (MCnsockets == s_sockets_capacity)
+    {
+        uint32_t t_capacity;
+        t_capacity = s_sockets_capacity == 0 ? 16 : s_sockets_capacity * 2;
+        MCU_realloc((char **)&MCsockets, MCnsockets, t_capacity, sizeof(MCSocket *));
+        s_sockets_capacity = t_capacity;
+    }
+    
+    p_socket -> listindex = MCnsockets;
     MCsockets[MCnsockets++] = p_socket;
+    MCSocketsIndexInsert(p_socket);
+    
+#if defined(_LINUX_SERVER)
+    MCSocketsUpdateEventLoop(p_socket);
+#endif
     
     MCSocketsUnlockSocketList();
     MCSocketsPollInterrupt();
@@ -302,17 +561,82 @@ void MCSocketsRemoveFromSocketList(uint32_t p_socket_no)
 {
     MCSocketsLockSocketList();
     
-    delete MCsockets[p_socket_no];
-    uint32_t i;
-    i = p_socket_no;
-    while (++i < MCnsockets)
-        MCsockets[i - 1] = MCsockets[i];
-    MCnsockets--;
+    // The socket stays in MCsockets until the next sweep, but as it has
+    // finished it is no longer polled, and it can no longer be found by name.
+    MCSocketsIndexRemove(MCsockets[p_socket_no]);
+    
+    MCSocketsUnlockSocketList();
+}
+
+// Removes all the sockets which have finished from the list in a single pass,
+// rather than shifting the rest of the list down once for each of them.
+void MCSocketsRemoveFinishedFromSocketList(void)
+{
+    uint32_t t_finished;
+    t_finished = 0;
+    for(uint32_t i = 0; i < MCnsockets; i++)
+        if (MCsockets[i] -> isfinished())
+            t_finished++;
+    
+    if (t_finished == 0)
+        return;
+    
+    MCSocketsLockSocketList();
+    
+    MCSocket **t_removed;
+    if (!MCMemoryNewArray(t_finished, t_removed))
+    {
+        MCSocketsUnlockSocketList();
+        return;
+    }
+    
+    uint32_t t_kept, t_removed_count;
+    t_kept = 0;
+    t_removed_count = 0;
+    for(uint32_t i = 0; i < MCnsockets; i++)
+    {
+        MCSocket *t_socket;
+        t_socket = MCsockets[i];
+        if (t_socket -> isfinished())
+            t_removed[t_removed_count++] = t_socket;
+        else
+        {
+            t_socket -> listindex = t_kept;
+            MCsockets[t_kept++] = t_socket;
+        }
+    }
+    MCnsockets = t_kept;
+    
+    for(uint32_t i = 0; i < t_removed_count; i++)
+    {
+        MCSocketsIndexRemove(t_removed[i]);
+        MCSocketsDelete(t_removed[i]);
+    }
+    MCMemoryDeleteArray(t_removed);
     
     MCSocketsUnlockSocketList();
     MCSocketsPollInterrupt();
 }
 
+void MCSocketsDeleteSocketList(void)
+{
+    while (MCnsockets)
+        MCSocketsDelete(MCsockets[--MCnsockets]);
+    
+    if (MCsockets != NULL)
+        delete[] (char *)MCsockets;
+    MCsockets = NULL;
+    s_sockets_capacity = 0;
+    
+    MCMemoryDeleteArray(s_socket_index);
+    s_socket_index = NULL;
+    s_socket_index_capacity = 0;
+    s_socket_index_used = 0;
+    s_socket_index_duplicates = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 // MM-2015-07-07: [[ MobileSockets ]] Refactored socket polling code that was common accross all the platforms into 2 function calls.
 // MCSocketsAddToFileDescriptorSets adds the required socket file decriptors to the given sets.
 // MCSocketsHandleFileDescriptorSets deals with any pending sockets in the given file descriptor sets.
@@ -322,7 +646,7 @@ bool MCSocketsAddToFileDescriptorSets(int4 &r_maxfd, fd_set &r_rmaskfd, fd_set &
     bool t_handled;
     t_handled = false;
     
-    uint2 i;
+    uint4 i;
     for (i = 0 ; i < MCnsockets ; i++)
     {
         int fd = MCsockets[i]->fd;
@@ -349,7 +673,7 @@ bool MCSocketsAddToFileDescriptorSets(int4 &r_maxfd, fd_set &r_rmaskfd, fd_set &
 
 void MCSocketsHandleFileDescriptorSets(fd_set &p_rmaskfd, fd_set &p_wmaskfd, fd_set &p_emaskfd)
 {
-    uint2 i;
+    uint4 i;
     for (i = 0 ; i < MCnsockets ; i++)
     {
         if (FD_ISSET(MCsockets[i]->fd, &p_emaskfd))
@@ -374,6 +698,64 @@ void MCSocketsHandleFileDescriptorSets(fd_set &p_rmaskfd, fd_set &p_wmaskfd, fd_
     }
 }
 
+#if defined(_LINUX_SERVER)
+// The Linux server keeps each socket registered with the server event loop for
+// the events it is waiting for. The registration is updated whenever they
+// might have changed - when the socket is added to the list, by setselect(),
+// and after the socket has been serviced - so after each wait only the sockets
+// which are ready are dealt with (directly on the main thread).
+
+// Returns the events the socket is waiting for, as for the select loop.
+static uint32_t MCSocketsGetEventLoopEvents(MCSocket *p_socket)
+{
+    if (!p_socket->fd || p_socket->resolve_state == kMCSocketStateResolving ||
+        p_socket->resolve_state == kMCSocketStateError)
+        return 0;
+    
+    uint32_t t_events;
+    t_events = 0;
+    if ((p_socket->connected && !p_socket->closing
+         && !p_socket->shared) || p_socket->accepting)
+        t_events |= kMCServerEventLoopRead;
+    if (!p_socket->connected || p_socket->wevents != NULL)
+        t_events |= kMCServerEventLoopWrite;
+    return t_events;
+}
+
+static void MCSocketsEventLoopCallback(void *p_context, uint32_t p_events)
+{
+    MCSocket *t_socket;
+    t_socket = (MCSocket *)p_context;
+    
+    // The registration can be out of date if the socket has changed since it
+    // was last updated, so only do what the socket still wants. As with
+    // select, read first so that data which arrives during the ssl handshake
+    // is not consumed by writesome().
+    p_events &= MCSocketsGetEventLoopEvents(t_socket);
+    if ((p_events & kMCServerEventLoopRead) != 0)
+        t_socket->readsome();
+    if ((p_events & kMCServerEventLoopWrite) != 0)
+        t_socket->writesome();
+    
+    MCSocketsUpdateEventLoop(t_socket);
+}
+
+void MCSocketsUpdateEventLoop(MCSocket *p_socket)
+{
+    // Shared sockets send on the descriptor of the socket which accepted them,
+    // which is registered for that socket.
+    if (!p_socket->fd || p_socket->shared)
+        return;
+    
+    MCServerEventLoopSetHandler(p_socket->fd, MCSocketsGetEventLoopEvents(p_socket), MCSocketsEventLoopCallback, p_socket);
+}
+
+void MCSocketsHandleEventLoop(void)
+{
+    MCServerEventLoopDispatch();
+}
+#endif
+
 #if defined(_WINDOWS_DESKTOP) || defined(_WINDOWS_SERVER)
 typedef SOCKADDR_IN mc_sockaddr_in_t;
 
@@ -848,7 +1230,7 @@ MCSocket *MCS_open_socket(MCNameRef name, MCNameRef from, Boolean datagram, MCOb
 	MCS_socket_ioctl(sock, FIONBIO, on);
 
 	MCSocket *s = NULL;
-	s = (MCSocket *)new MCSocket(name, from, o, mess, datagram, sock, False, False,secure);
+	s = MCSocketsNew(name, from, o, mess, datagram, sock, False, False,secure);
 
 	if (s != NULL)
 	{
@@ -874,7 +1256,7 @@ MCSocket *MCS_open_socket(MCNameRef name, MCNameRef from, Boolean datagram, MCOb
 					MCresult->copysvalue(MCString(s->error));
 				else
 					MCresult->sets("can't connect to host");
-				delete s;
+				MCSocketsDelete(s);
 				s = NULL;
 			}
 		}
@@ -888,7 +1270,7 @@ MCSocket *MCS_open_socket(MCNameRef name, MCNameRef from, Boolean datagram, MCOb
 			{
 				MCMemoryDelete(t_info);
 				s->name = nil;
-				delete s;
+				MCSocketsDelete(s);
 				s = nil;
 
 				if (MCresult->isclear())
@@ -935,14 +1317,7 @@ MCDataRef MCS_read_socket(MCSocket *s, MCExecContext &ctxt, uint4 length, const
 			return t_data;
 		}
 		if (until == NULL)
-		{
-			if (length > s->rsize - s->nread)
-			{
-				MCU_realloc((char **)&s->rbuffer, s->nread,
-				            length + s->nread, sizeof(char));
-				s->rsize = length + s->nread;
-			}
-		}
+			/* UNCHECKED */ s->reserveread(length);
 		if (mptr != NULL)
 		{
 #if defined(_WINDOWS_DESKTOP) || defined(_WINDOWS_SERVER)
@@ -996,12 +1371,10 @@ MCDataRef MCS_read_socket(MCSocket *s, MCExecContext &ctxt, uint4 length, const
 				{
 					uint4 size = eptr->size;
 					if (until != NULL && *until == '\n' && !*(until + 1)
-					        && size && s->rbuffer[size - 1] == '\r')
+					        && size && s->readbuffer()[size - 1] == '\r')
 						size--;
-					/* UNCHECKED */ MCDataCreateWithBytes((const byte_t *)s->rbuffer, size, t_data);
-					s->nread -= eptr->size;
-					// MW-2010-11-19: [[ Bug 9182 ]] This should be a memmove (I think)
-					memmove(s->rbuffer, s->rbuffer + eptr->size, s->nread);
+					/* UNCHECKED */ MCDataCreateWithBytes((const byte_t *)s->readbuffer(), size, t_data);
+					s->consumeread(eptr->size);
 					break;
 				}
 				if (s->error != NULL)
@@ -1026,47 +1399,418 @@ MCDataRef MCS_read_socket(MCSocket *s, MCExecContext &ctxt, uint4 length, const
 					break;
 				}
 			}
-			eptr->remove(s->revents);
+			eptr->remove(s->revents);
+			delete eptr;
+			s->waiting = False;
+            return t_data;
+		}
+	}
+    MCSocketsPollInterrupt();
+    
+    // SN-2015-01-29: [[ Bug 14409 ]] The function must return something
+    return t_data;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Datagram sockets receive (and, when given an array of datagrams, send) in
+// batches of up to DATAGRAM_BATCH_SIZE datagrams - using a single recvmmsg or
+// sendmmsg call where the platform has them.
+
+#if defined(_LINUX_DESKTOP) || defined(_LINUX_SERVER)
+#define USE_MMSG
+#endif
+
+#define DATAGRAM_BATCH_SIZE 16
+#define DATAGRAM_MAX_SIZE 65536
+
+struct MCDatagramSlot
+{
+	struct sockaddr_in addr;
+	int length;
+};
+
+// The buffers datagrams are received into, shared by all sockets.
+static char *s_datagram_buffers = NULL;
+
+static char *MCSocketsDatagramBuffer(uint32_t p_slot)
+{
+	return s_datagram_buffers + p_slot * DATAGRAM_MAX_SIZE;
+}
+
+// Receives the datagrams waiting on the socket, up to DATAGRAM_BATCH_SIZE of
+// them. Returns the number received, or -1 if none could be.
+static int MCSocketsReceiveDatagrams(MCSocketHandle p_fd, MCDatagramSlot *r_slots)
+{
+	if (s_datagram_buffers == NULL &&
+		!MCMemoryNewArray(DATAGRAM_BATCH_SIZE * DATAGRAM_MAX_SIZE, s_datagram_buffers))
+		return -1;
+
+#if defined(USE_MMSG)
+	struct mmsghdr t_headers[DATAGRAM_BATCH_SIZE];
+	struct iovec t_vectors[DATAGRAM_BATCH_SIZE];
+	memset(t_headers, 0, sizeof(t_headers));
+	for (uint32_t i = 0; i < DATAGRAM_BATCH_SIZE; i++)
+	{
+		t_vectors[i] . iov_base = MCSocketsDatagramBuffer(i);
+		t_vectors[i] . iov_len = DATAGRAM_MAX_SIZE;
+		t_headers[i] . msg_hdr . msg_iov = &t_vectors[i];
+		t_headers[i] . msg_hdr . msg_iovlen = 1;
+		t_headers[i] . msg_hdr . msg_name = &r_slots[i] . addr;
+		t_headers[i] . msg_hdr . msg_namelen = sizeof(r_slots[i] . addr);
+	}
+
+	int t_count;
+	t_count = recvmmsg(p_fd, t_headers, DATAGRAM_BATCH_SIZE, MSG_DONTWAIT, NULL);
+	for (int i = 0; i < t_count; i++)
+		r_slots[i] . length = t_headers[i] . msg_len;
+
+	return t_count;
+#else
+	int t_count;
+	t_count = 0;
+	while (t_count < DATAGRAM_BATCH_SIZE)
+	{
+		socklen_t t_addrsize = sizeof(r_slots[t_count] . addr);
+		int t_length;
+		t_length = recvfrom(p_fd, MCSocketsDatagramBuffer(t_count), DATAGRAM_MAX_SIZE, 0,
+							(struct sockaddr *)&r_slots[t_count] . addr, &t_addrsize);
+		if (t_length < 0)
+			break;
+
+		r_slots[t_count++] . length = t_length;
+	}
+
+	return t_count != 0 ? t_count : -1;
+#endif
+}
+
+// Sends up to DATAGRAM_BATCH_SIZE datagrams, to the given address or (if it
+// is NULL) the address the socket is connected to. Returns the number sent,
+// or -1 if none could be.
+static int MCSocketsSendDatagrams(MCSocketHandle p_fd, struct sockaddr_in *p_to, MCDataRef *p_datagrams, uindex_t p_count)
+{
+#if defined(USE_MMSG)
+	struct mmsghdr t_headers[DATAGRAM_BATCH_SIZE];
+	struct iovec t_vectors[DATAGRAM_BATCH_SIZE];
+	memset(t_headers, 0, sizeof(t_headers));
+	for (uindex_t i = 0; i < p_count; i++)
+	{
+		t_vectors[i] . iov_base = (void *)MCDataGetBytePtr(p_datagrams[i]);
+		t_vectors[i] . iov_len = MCDataGetLength(p_datagrams[i]);
+		t_headers[i] . msg_hdr . msg_iov = &t_vectors[i];
+		t_headers[i] . msg_hdr . msg_iovlen = 1;
+		t_headers[i] . msg_hdr . msg_name = p_to;
+		t_headers[i] . msg_hdr . msg_namelen = p_to != NULL ? sizeof(*p_to) : 0;
+	}
+
+	return sendmmsg(p_fd, t_headers, p_count, 0);
+#else
+	for (uindex_t i = 0; i < p_count; i++)
+	{
+		const char *t_bytes = (const char *)MCDataGetBytePtr(p_datagrams[i]);
+		int t_length = MCDataGetLength(p_datagrams[i]);
+		int t_result;
+		if (p_to != NULL)
+			t_result = sendto(p_fd, t_bytes, t_length, 0, (sockaddr *)p_to, sizeof(*p_to));
+		else
+			t_result = send(p_fd, t_bytes, t_length, 0);
+
+		if (t_result < 0)
+			return i != 0 ? i : -1;
+	}
+
+	return p_count;
+#endif
+}
+
+// The names of the peers datagrams were most recently received from, so that
+// a steady stream of datagrams from the same peers doesn't have to format a
+// new name for each one.
+
+#define DATAGRAM_PEER_NAME_CACHE_BITS 6
+#define DATAGRAM_PEER_NAME_CACHE_SIZE (1 << DATAGRAM_PEER_NAME_CACHE_BITS)
+
+struct MCDatagramPeerName
+{
+	uint32_t address;
+	uint16_t port;
+	MCNameRef name;
+};
+
+static MCDatagramPeerName s_datagram_peer_names[DATAGRAM_PEER_NAME_CACHE_SIZE];
+
+// Returns the "address:port" name of the given peer. The name is owned by the
+// cache, so must be retained if it is kept.
+static MCNameRef MCSocketsDatagramPeerName(const struct sockaddr_in& p_addr)
+{
+	uint32_t t_address = p_addr . sin_addr . s_addr;
+	uint16_t t_port = p_addr . sin_port;
+
+	uint32_t t_slot;
+	t_slot = ((t_address ^ t_port) * 0x9e3779b9U) >> (32 - DATAGRAM_PEER_NAME_CACHE_BITS);
+
+	MCDatagramPeerName& t_entry = s_datagram_peer_names[t_slot];
+	if (t_entry . name != NULL && t_entry . address == t_address && t_entry . port == t_port)
+		return t_entry . name;
+
+	MCAutoStringRef t_string;
+	MCNameRef t_name;
+	if (!MCStringFormat(&t_string, "%s:%d", inet_ntoa(p_addr . sin_addr), MCSwapInt16NetworkToHost(t_port)) ||
+		!MCNameCreate(*t_string, t_name))
+		return NULL;
+
+	MCValueRelease(t_entry . name);
+	t_entry . address = t_address;
+	t_entry . port = t_port;
+	t_entry . name = t_name;
+	return t_name;
+}
+
+// Parses the "address:port" name of a peer into a socket address.
+static bool MCSocketsDatagramPeerAddress(MCNameRef p_name, struct sockaddr_in& r_addr)
+{
+	MCAutoCustomPointer<char,MCMemoryDeleteArray> t_name_copy;
+	if (!MCStringConvertToCString(MCNameGetString(p_name), &t_name_copy))
+		return false;
+
+	char *portptr = strchr(*t_name_copy, ':');
+	if (portptr == NULL)
+		return false;
+	*portptr = '\0';
+
+	memset((char *)&r_addr, 0, sizeof(r_addr));
+	r_addr.sin_family = AF_INET;
+	uint2 port = atoi(portptr + 1);
+	r_addr.sin_port = MCSwapInt16HostToNetwork(port);
+	return inet_aton(*t_name_copy, (in_addr *)&r_addr.sin_addr.s_addr) != 0;
+}
+
+// Adds a datagram to a batch being delivered in one message, as an element
+// with "peer" and "data" keys.
+static bool MCSocketsAppendDatagram(MCArrayRef x_batch, MCNameRef p_peer, MCDataRef p_data)
+{
+	MCAutoArrayRef t_datagram;
+	return MCArrayCreateMutable(&t_datagram) &&
+		MCArrayStoreValue(*t_datagram, false, MCNAME("peer"), MCNameGetString(p_peer)) &&
+		MCArrayStoreValue(*t_datagram, false, MCNAME("data"), p_data) &&
+		t_datagram . MakeImmutable() &&
+		MCArrayStoreValueAtIndex(x_batch, MCArrayGetCount(x_batch) + 1, *t_datagram);
+}
+
+static void MCSocketsFreeDatagramState(void)
+{
+	for (uint32_t i = 0; i < DATAGRAM_PEER_NAME_CACHE_SIZE; i++)
+	{
+		MCValueRelease(s_datagram_peer_names[i] . name);
+		s_datagram_peer_names[i] . name = NULL;
+	}
+
+	MCMemoryDeleteArray(s_datagram_buffers);
+	s_datagram_buffers = NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Stream sockets send the data of consecutive queued writes together with a
+// single writev call where the platform has it, and send files straight from
+// their descriptor with sendfile (unless the socket is secure) rather than
+// copying them through a buffer.
+
+#if !defined(_WINDOWS_DESKTOP) && !defined(_WINDOWS_SERVER)
+#define USE_WRITEV
+#endif
+
+#if defined(_LINUX_DESKTOP) || defined(_LINUX_SERVER) || defined(TARGET_SUBPLATFORM_ANDROID)
+#include <sys/sendfile.h>
+#define USE_SENDFILE
+#elif defined(_MAC_DESKTOP) || defined(_MAC_SERVER)
+#define USE_SENDFILE
+#endif
+
+// The maximum number of queued writes which are sent together.
+#define SOCKET_WRITE_BATCH_SIZE 64
+
+// The maximum number of bytes sent by any one call.
+#define SOCKET_WRITE_MAX_SIZE (1 << 30)
+
+// The size of the chunks files are read in when they can't be sent directly.
+#define SOCKET_FILE_CHUNK_SIZE 65536
+
+// Makes one attempt to send the writes at the front of the socket's queue,
+// returning the number of bytes sent (which may complete several writes), or
+// -1 on failure. The number of bytes which were offered is returned in
+// r_requested.
+static int4 MCSocketsWriteQueued(MCSocket *s, uint64_t& r_requested)
+{
+	MCSocketwrite *t_head;
+	t_head = s->wevents;
+
+	uint4 t_count;
+	t_count = (uint4)MCMin(t_head->size - t_head->done, (uint64_t)SOCKET_WRITE_MAX_SIZE);
+
+#if !defined(_WINDOWS_DESKTOP) && !defined(_WINDOWS_SERVER)
+	if (t_head->file != -1)
+	{
+#if defined(USE_SENDFILE)
+		if (!t_head->secure)
+		{
+			r_requested = t_count;
+#if defined(_MAC_DESKTOP) || defined(_MAC_SERVER)
+			// The number of bytes sent is returned even if the call would
+			// otherwise have blocked.
+			off_t t_sent;
+			t_sent = t_count;
+			if (sendfile(t_head->file, s->fd, t_head->done, &t_sent, NULL, 0) == -1 &&
+				(errno != EAGAIN || t_sent == 0))
+				return -1;
+			return (int4)t_sent;
+#else
+			off_t t_offset;
+			t_offset = t_head->done;
+			return (int4)sendfile(s->fd, t_head->file, &t_offset, t_count);
+#endif
+		}
+#endif
+
+		// Read the next chunk of the file once all of the last one has been
+		// sent. A write which must be retried is retried from the same chunk.
+		if (t_head->done == t_head->chunkstart + t_head->chunksize)
+		{
+			if (t_head->chunk == NULL &&
+				!MCMemoryNewArray(SOCKET_FILE_CHUNK_SIZE, t_head->chunk))
+			{
+				errno = EPIPE;
+				return -1;
+			}
+
+			ssize_t t_read;
+			t_read = pread(t_head->file, t_head->chunk, MCMin(t_count, (uint4)SOCKET_FILE_CHUNK_SIZE), t_head->done);
+			if (t_read <= 0)
+			{
+				errno = EPIPE;
+				return -1;
+			}
+
+			t_head->chunkstart = t_head->done;
+			t_head->chunksize = (uint4)t_read;
+		}
+
+		r_requested = t_head->chunkstart + t_head->chunksize - t_head->done;
+		return s->write(t_head->chunk + (t_head->done - t_head->chunkstart), (uint4)r_requested, t_head->secure);
+	}
+#endif
+
+#if defined(USE_WRITEV)
+	if (!t_head->secure)
+	{
+		struct iovec t_vectors[SOCKET_WRITE_BATCH_SIZE];
+		int t_vector_count;
+		t_vector_count = 0;
+		r_requested = 0;
+
+		MCSocketwrite *t_write;
+		t_write = t_head;
+		do
+		{
+			if (t_write->secure || t_write->data == nil)
+				break;
+
+			uint64_t t_length;
+			t_length = MCMin(t_write->size - t_write->done, SOCKET_WRITE_MAX_SIZE - r_requested);
+			t_vectors[t_vector_count] . iov_base = (void *)t_write->pending();
+			t_vectors[t_vector_count] . iov_len = t_length;
+			t_vector_count++;
+			r_requested += t_length;
+
+			// A write without a message stays at the front of the queue until
+			// its writer has seen that it is done, so it ends the batch.
+			if (t_write->message == NULL || r_requested == SOCKET_WRITE_MAX_SIZE)
+				break;
+
+			t_write = t_write->next();
+		}
+		while (t_write != t_head && t_vector_count < SOCKET_WRITE_BATCH_SIZE);
+
+		return (int4)writev(s->fd, t_vectors, t_vector_count);
+	}
+#endif
+
+	r_requested = t_count;
+	return s->write(t_head->pending(), t_count, t_head->secure);
+}
+
+// Appends the write to the socket's queue. If there is no message to send
+// when it is done, this waits until it has been sent.
+static void MCSocketsQueueWrite(MCSocket *s, MCSocketwrite *eptr, MCNameRef mptr)
+{
+	eptr->appendto(s->wevents);
+	s->setselect();
+	if (mptr == NULL)
+	{
+		s->waiting = True;
+		if (s->connected)
+			s->writesome();
+		while (True)
+		{
+			if (s->error != NULL)
+			{
+				MCresult->sets(s->error);
+				break;
+			}
+			if (s->fd == 0)
+			{
+				MCresult->sets("socket closed");
+				break;
+			}
+			if (curtime > eptr->timeout)
+			{
+				MCresult->sets("timeout");
+				break;
+			}
+			if (s->wevents != NULL && eptr == s->wevents
+			        && eptr->done == eptr->size)
+				break;
+			MCU_play();
+			if (MCscreen->wait(READ_INTERVAL, False, True))
+			{
+				MCresult->sets("interrupted");
+				break;
+			}
+		}
+		if (s->wevents != NULL)
+		{
+			eptr->remove
+			(s->wevents);
 			delete eptr;
-			s->waiting = False;
-            return t_data;
 		}
+		s->waiting = False;
 	}
-    MCSocketsPollInterrupt();
+	else
+		if (s->connected)
+			s->writesome();
     
-    // SN-2015-01-29: [[ Bug 14409 ]] The function must return something
-    return t_data;
+    MCSocketsPollInterrupt();
 }
 
-void MCS_write_socket(const MCStringRef d, MCSocket *s, MCObject *optr, MCNameRef mptr)
+void MCS_write_socket(MCDataRef d, MCSocket *s, MCObject *optr, MCNameRef mptr)
 {
 	if (s->datagram)
 	{
-        MCAutoStringRefAsCString temp_d;
-        /* UNCHECKED */ temp_d.Lock(d);
-
         if (s->shared)
 		{
-            MCAutoCustomPointer<char,MCMemoryDeleteArray> t_name_copy;
-            /* UNCHECKED */ MCStringConvertToCString(MCNameGetString(s->name),
-                                                     &t_name_copy);
-
-			char *portptr = strchr(*t_name_copy, ':');
-			*portptr = '\0';
 			struct sockaddr_in to;
-			memset((char *)&to, 0, sizeof(to));
-			to.sin_family = AF_INET;
-			uint2 port = atoi(portptr + 1);
-			to.sin_port = MCSwapInt16HostToNetwork(port);
-			if (!inet_aton(*t_name_copy, (in_addr *)&to.sin_addr.s_addr)
-				|| sendto(s->fd, *temp_d, MCStringGetLength(d), 0,
+			if (!MCSocketsDatagramPeerAddress(s->name, to)
+				|| sendto(s->fd, (const char *)MCDataGetBytePtr(d), MCDataGetLength(d), 0,
 						  (sockaddr *)&to, sizeof(to)) < 0)
 			{
 				mptr = NULL;
 				MCresult->sets("error sending datagram");
 			}
 		}
-		else if (send(s->fd, *temp_d, MCStringGetLength(d), 0) < 0)
+		else if (send(s->fd, (const char *)MCDataGetBytePtr(d), MCDataGetLength(d), 0) < 0)
 		{
 			mptr = NULL;
 			MCresult->sets("error sending datagram");
@@ -1076,60 +1820,97 @@ void MCS_write_socket(const MCStringRef d, MCSocket *s, MCObject *optr, MCNameRe
 			MCscreen->delaymessage(optr, mptr, MCNameGetString(s->name));
 			s->added = True;
 		}
+
+		MCSocketsPollInterrupt();
 	}
 	else
 	{
 		// MM-2014-02-12: [[ SecureSocket ]] Store against the write if it should be encrypted.
 		//  This way, upon securing a socket, all pending writes will remain unencrypted whilst all new writes will be encrypted.
 		MCSocketwrite *eptr = new (nothrow) MCSocketwrite(d, optr, mptr, s->secure);
-		eptr->appendto(s->wevents);
-		s->setselect();
-		if (mptr == NULL)
+		MCSocketsQueueWrite(s, eptr, mptr);
+	}
+}
+
+void MCS_write_file_socket(MCStringRef p_path, MCSocket *s, MCObject *optr, MCNameRef mptr)
+{
+	if (!MCSecureModeCanAccessDisk())
+	{
+		MCresult->sets("can't open file");
+		return;
+	}
+
+#if !defined(_WINDOWS_DESKTOP) && !defined(_WINDOWS_SERVER)
+	// Files written to stream sockets are sent from their descriptor as the
+	// socket becomes writable, rather than being loaded first.
+	if (!s->datagram)
+	{
+		MCAutoStringRef t_resolved_path, t_native_path;
+		MCAutoStringRefAsSysString t_sys_path;
+		int t_file;
+		t_file = -1;
+		if (MCS_resolvepath(p_path, &t_resolved_path) &&
+			MCS_pathtonative(*t_resolved_path, &t_native_path) &&
+			t_sys_path . Lock(*t_native_path))
+			t_file = open(*t_sys_path, O_RDONLY);
+
+		struct stat t_stat;
+		if (t_file != -1 && (fstat(t_file, &t_stat) != 0 || !S_ISREG(t_stat . st_mode)))
 		{
-			s->waiting = True;
-			if (s->connected)
-				s->writesome();
-			while (True)
-			{
-				if (s->error != NULL)
-				{
-					MCresult->sets(s->error);
-					break;
-				}
-				if (s->fd == 0)
-				{
-					MCresult->sets("socket closed");
-					break;
-				}
-				if (curtime > eptr->timeout)
-				{
-					MCresult->sets("timeout");
-					break;
-				}
-				if (s->wevents != NULL && eptr == s->wevents
-				        && eptr->done == eptr->size)
-					break;
-				MCU_play();
-				if (MCscreen->wait(READ_INTERVAL, False, True))
-				{
-					MCresult->sets("interrupted");
-					break;
-				}
-			}
-			if (s->wevents != NULL)
-			{
-				eptr->remove
-				(s->wevents);
-				delete eptr;
-			}
-			s->waiting = False;
+			::close(t_file);
+			t_file = -1;
+		}
+
+		if (t_file == -1)
+		{
+			MCresult->sets("can't open file");
+			return;
 		}
+
+		MCSocketwrite *eptr = new (nothrow) MCSocketwrite(t_file, t_stat . st_size, optr, mptr, s->secure);
+		MCSocketsQueueWrite(s, eptr, mptr);
+		return;
+	}
+#endif
+
+	MCAutoDataRef t_data;
+	if (!MCS_loadbinaryfile(p_path, &t_data))
+	{
+		MCresult->sets("can't open file");
+		return;
+	}
+
+	MCS_write_socket(*t_data, s, optr, mptr);
+}
+
+void MCS_write_datagrams(MCDataRef *p_datagrams, uindex_t p_count, MCSocket *s, MCObject *optr, MCNameRef mptr)
+{
+	struct sockaddr_in to;
+	bool t_success = true;
+	if (s->shared)
+		t_success = MCSocketsDatagramPeerAddress(s->name, to);
+
+	uindex_t t_sent = 0;
+	while (t_success && t_sent < p_count)
+	{
+		int t_count;
+		t_count = MCSocketsSendDatagrams(s->fd, s->shared ? &to : NULL, p_datagrams + t_sent, MCMin(p_count - t_sent, (uindex_t)DATAGRAM_BATCH_SIZE));
+		if (t_count > 0)
+			t_sent += t_count;
 		else
-			if (s->connected)
-				s->writesome();
+			t_success = false;
+	}
+
+	if (!t_success)
+	{
+		mptr = NULL;
+		MCresult->sets("error sending datagram");
+	}
+	if (mptr != NULL)
+	{
+		MCscreen->delaymessage(optr, mptr, MCNameGetString(s->name));
+		s->added = True;
 	}
-    
-    MCSocketsPollInterrupt();
 }
 
 MCSocket *MCS_accept(uint2 port, MCObject *object, MCNameRef message, Boolean datagram,Boolean secure,Boolean sslverify, MCStringRef sslcertfile)
@@ -1246,7 +2027,7 @@ MCSocket *MCS_accept(uint2 port, MCObject *object, MCNameRef message, Boolean da
 	if (!MCNameCreateWithNativeChars(*t_port_chars, t_length, &t_portname))
         return nil;
     
-	return new MCSocket(*t_portname, NULL, object, message, datagram, sock, True, False, secure);
+	return MCSocketsNew(*t_portname, NULL, object, message, datagram, sock, True, False, secure);
 }
 
 // MM-2014-02-12: [[ SecureSocket ]] New secure socket command. If socket is not already secure, flag as secure to ensure future communications are encrypted.
@@ -1404,6 +2185,8 @@ MCSocketread::MCSocketread(uint4 s, char *u, MCObject *o, MCNameRef m)
 {
 	size = s;
 	until = u;
+	untillength = u != nil ? strlen(u) : 0;
+	scanned = 0;
 	timeout = curtime + MCsockettimeout;
 	optr = o;
 	if (m != nil)
@@ -1418,13 +2201,32 @@ MCSocketread::~MCSocketread()
 	delete until;
 }
 
-MCSocketwrite::MCSocketwrite(MCStringRef d, MCObject *o, MCNameRef m, Boolean securewrite)
+MCSocketwrite::MCSocketwrite(MCDataRef d, MCObject *o, MCNameRef m, Boolean securewrite)
 {
-    char *temp_d;
-    /* UNCHECKED */ MCStringConvertToCString(d, temp_d);
-	
-    buffer = temp_d;
-	size = MCStringGetLength(d);
+	data = MCValueRetain(d);
+	file = -1;
+	chunk = NULL;
+	chunkstart = 0;
+	chunksize = 0;
+	size = MCDataGetLength(d);
+	timeout = curtime + MCsockettimeout;
+	secure = securewrite;
+	optr = o;
+	done = 0;
+	if (m != nil)
+        message = MCValueRetain(m);
+	else
+		message = nil;
+}
+
+MCSocketwrite::MCSocketwrite(int f, uint64_t s, MCObject *o, MCNameRef m, Boolean securewrite)
+{
+	data = nil;
+	file = f;
+	chunk = NULL;
+	chunkstart = 0;
+	chunksize = 0;
+	size = s;
 	timeout = curtime + MCsockettimeout;
 	secure = securewrite;
 	optr = o;
@@ -1437,11 +2239,13 @@ MCSocketwrite::MCSocketwrite(MCStringRef d, MCObject *o, MCNameRef m, Boolean se
 
 MCSocketwrite::~MCSocketwrite()
 {
-	if (message != NULL)
-	{
-		MCValueRelease(message);
-		delete buffer;
-	}
+	MCValueRelease(message);
+	MCValueRelease(data);
+	MCMemoryDeleteArray(chunk);
+#if !defined(_WINDOWS_DESKTOP) && !defined(_WINDOWS_SERVER)
+	if (file != -1)
+		::close(file);
+#endif
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1459,13 +2263,15 @@ MCSocket::MCSocket(MCNameRef n, MCNameRef f, MCObject *o, MCNameRef m, Boolean d
 	accepting = a;
 	connected = datagram;
 	shared = s;
+	batchdatagrams = datagram && MCbatchdatagrammessages;
 	fd = sock;
 	closing = doread = added = waiting = False;
+	indexstate = kMCSocketIndexStateNone;
 	revents = NULL;
 	wevents = NULL;
 	rbuffer = NULL;
 	error = NULL;
-	rsize = nread = 0;
+	rstart = rsize = nread = 0;
 	timeout = curtime + MCsockettimeout;
 	_ssl_context = NULL;
 	_ssl_conn = NULL;
@@ -1500,7 +2306,7 @@ void MCSocket::deletereads()
 		MCSocketread *eptr = revents->remove(revents);
 		delete eptr;
 	}
-	nread = 0;
+	rstart = nread = 0;
 }
 
 void MCSocket::deletewrites()
@@ -1531,27 +2337,34 @@ Boolean MCSocket::read_done()
 		}
 		if (*revents->until != '\004')
 		{
-			char *sptr = rbuffer;
-			char *eptr = rbuffer + nread;
-			char *dptr = revents->until;
-			while (sptr < eptr)
+			// Only search the data which has arrived since the last time this
+			// read was checked - backing up far enough to catch a sentinel which
+			// straddles the previous end of the data.
+			const char *t_data = readbuffer();
+			const char *t_until = revents->until;
+			uint4 t_length = revents->untillength;
+			
+			uint4 t_offset = 0;
+			if (revents->scanned >= t_length)
+				t_offset = revents->scanned - t_length + 1;
+			
+			while (t_offset + t_length <= nread)
 			{
-				if (*sptr++ == *dptr)
+				const char *t_match;
+				t_match = (const char *)memchr(t_data + t_offset, t_until[0], nread - t_length - t_offset + 1);
+				if (t_match == NULL)
+					break;
+				
+				if (memcmp(t_match + 1, t_until + 1, t_length - 1) == 0)
 				{
-					char *tsptr = sptr;
-					char *tdptr = dptr + 1;
-					while (tsptr < eptr && *tdptr && *tsptr == *tdptr)
-					{
-						tsptr++;
-						tdptr++;
-					}
-					if (!*tdptr)
-					{
-						revents->size = tsptr - rbuffer;
-						return True;
-					}
+					revents->size = uint4(t_match - t_data) + t_length;
+					return True;
 				}
+				
+				t_offset = uint4(t_match - t_data) + 1;
 			}
+			
+			revents->scanned = nread;
 		}
 	}
 	else
@@ -1581,6 +2394,48 @@ Boolean MCSocket::read_done()
 	return False;
 }
 
+// Ensures there is room for at least p_count bytes after the unconsumed data
+// in the read buffer. Consumed space at the front is reclaimed first, and the
+// buffer grows geometrically so that large reads don't reallocate per chunk.
+bool MCSocket::reserveread(uint4 p_count)
+{
+	if (rsize - rstart - nread >= p_count)
+		return true;
+	
+	if (rstart != 0)
+	{
+		memmove(rbuffer, rbuffer + rstart, nread);
+		rstart = 0;
+		if (rsize - nread >= p_count)
+			return true;
+	}
+	
+	uint4 t_newsize;
+	t_newsize = nread + p_count + READ_SOCKET_SIZE;
+	if (t_newsize < rsize * 2)
+		t_newsize = rsize * 2;
+	
+	MCU_realloc((char **)&rbuffer, nread, t_newsize, sizeof(char));
+	if (rbuffer == NULL)
+	{
+		rsize = nread = 0;
+		return false;
+	}
+	
+	rsize = t_newsize;
+	return true;
+}
+
+// Discards the first p_count bytes of unconsumed data.
+void MCSocket::consumeread(uint4 p_count)
+{
+	nread -= p_count;
+	if (nread == 0)
+		rstart = 0;
+	else
+		rstart += p_count;
+}
+
 #if defined(_WINDOWS_DESKTOP) || defined(_WINDOWS_SERVER)
 void MCSocket::acceptone()
 {
@@ -1595,7 +2450,7 @@ void MCSocket::acceptone()
 		MCNameRef t_name;
 		MCNameCreate(*n, t_name);
         MCSocket *t_socket;
-        t_socket = new (nothrow) MCSocket(t_name, NULL, object, NULL, False, newfd, False, False,False);
+        t_socket = MCSocketsNew(t_name, NULL, object, NULL, False, newfd, False, False,False);
         if (t_socket != NULL)
         {
             MCSocketsAppendToSocketList(t_socket);
@@ -1614,28 +2469,19 @@ void MCSocket::readsome()
 	socklen_t addrsize = sizeof(addr);
 	if (datagram)
 	{
-		int l = 0;
-		unsigned long t_available;
-		MCS_socket_ioctl(fd, FIONREAD, t_available);
-		l = t_available;
-
-		char *dbuffer = new (nothrow) char[l + 1]; // don't allocate 0
+		MCDatagramSlot t_slots[DATAGRAM_BATCH_SIZE];
+		int t_count;
+		t_count = MCSocketsReceiveDatagrams(fd, t_slots);
 #if defined(_WINDOWS_DESKTOP) || defined(_WINDOWS_SERVER)
-
-		l++; // Not on MacOS/UNIX?
-		if ((l = recvfrom(fd, dbuffer, l, 0, (struct sockaddr *)&addr, &addrsize))
-		        == SOCKET_ERROR)
+		if (t_count < 0)
 		{
-			delete[] dbuffer;
 			error = new (nothrow) char[21 + I4L];
 			sprintf(error, "Error %d on socket", WSAGetLastError());
 			doclose();
 		}
 #else
-		if ((l = recvfrom(fd, dbuffer, l, 0,
-						  (struct sockaddr *)&addr, &addrsize)) < 0)
+		if (t_count < 0)
 		{
-			delete[] dbuffer;
 			if (!doread && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
 			{
 				error = new (nothrow) char[21 + I4L];
@@ -1644,30 +2490,38 @@ void MCSocket::readsome()
 			}
 		}
 #endif
-		else
+		else if (message != NULL && object . IsValid())
 		{
-			if (message != NULL && object . IsValid())
+			MCAutoArrayRef t_batch;
+			if (batchdatagrams)
+				/* UNCHECKED */ MCArrayCreateMutable(&t_batch);
+
+			for (int i = 0; i < t_count; i++)
 			{
-				char *t = inet_ntoa(addr.sin_addr);
-				MCAutoStringRef n;
-				MCNewAutoNameRef t_name;
-				/* UNCHECKED */ MCStringCreateMutable(strlen(t) + U2L, &n);
-				/* UNCHECKED */ MCStringAppendFormat(*n, "%s:%d", t, MCSwapInt16NetworkToHost(addr.sin_port));
-				/* UNCHECKED */ MCNameCreate(*n, &t_name);
+				MCNameRef t_name;
+				t_name = MCSocketsDatagramPeerName(t_slots[i] . addr);
+				if (t_name == NULL)
+					continue;
+
 				uindex_t index;
-				if (accepting && !IO_findsocket(*t_name, index))
+				if (accepting && !IO_findsocket(t_name, index))
 				{
                     MCSocket *t_socket;
-                    t_socket = new (nothrow) MCSocket(*t_name, NULL, object, NULL, True, fd, False, True,False);
+                    t_socket = MCSocketsNew(t_name, NULL, object, NULL, True, fd, False, True,False);
                     if (t_socket != NULL)
                         MCSocketsAppendToSocketList(t_socket);
 				}
 				
 				MCAutoDataRef t_data;
-				if (MCDataCreateWithBytes((const byte_t *)dbuffer, l, &t_data))
+				if (!MCDataCreateWithBytes((const byte_t *)MCSocketsDatagramBuffer(i), t_slots[i] . length, &t_data))
+					continue;
+
+				if (batchdatagrams)
+					/* UNCHECKED */ MCSocketsAppendDatagram(*t_batch, t_name, *t_data);
+				else
 				{
 					MCParameter *params = new (nothrow) MCParameter;
-					params->setvalueref_argument(*t_name);
+					params->setvalueref_argument(t_name);
 					params->setnext(new (nothrow) MCParameter);
 					params->getnext()->setvalueref_argument(*t_data);
 					params->getnext()->setnext(new (nothrow) MCParameter);
@@ -1675,7 +2529,15 @@ void MCSocket::readsome()
 					MCscreen->addmessage(object, message, curtime, params);
 				}
 			}
-			delete[] dbuffer;
+
+			if (batchdatagrams && MCArrayGetCount(*t_batch) != 0 && t_batch . MakeImmutable())
+			{
+				MCParameter *params = new (nothrow) MCParameter;
+				params->setvalueref_argument(*t_batch);
+				params->setnext(new (nothrow) MCParameter);
+				params->getnext()->setvalueref_argument(name);
+				MCscreen->addmessage(object, message, curtime, params);
+			}
 		}
 		added = True;
 		doread = False;
@@ -1702,7 +2564,7 @@ void MCSocket::readsome()
 				/* UNCHECKED */ MCStringFormat(&n, "%s:%d", t, MCSwapInt16NetworkToHost(addr.sin_port));
 				/* UNCHECKED */ MCNameCreate(*n, &t_name);
                 MCSocket *t_socket;
-                t_socket = new (nothrow) MCSocket(*t_name, NULL, object, NULL, False, newfd, False, False,secure);
+                t_socket = MCSocketsNew(*t_name, NULL, object, NULL, False, newfd, False, False,secure);
                 if (t_socket != NULL)
                 {
                     MCSocketsAppendToSocketList(t_socket);
@@ -1732,32 +2594,25 @@ void MCSocket::readsome()
 
 					if (l == 0) l++; // don't read 0
 				}
-				uint4 newsize = nread + l;
-				if (newsize > rsize)
+				if (!reserveread(l))
 				{
-					newsize += READ_SOCKET_SIZE;
-					MCU_realloc((char **)&rbuffer, nread, newsize, sizeof(char));
-					if (rbuffer == NULL)
-					{
-						error = strclone("Out of memory");
-						doclose();
+					error = strclone("Out of memory");
+					doclose();
 
-						return;
-					}
-					rsize = newsize;
+					return;
 				}
 				errno = 0;
 #if defined(_WINDOWS_DESKTOP) || defined(_WINDOWS_SERVER)
 
 				// MM-2014-02-12: [[ SecureSocket ]] If a scoket is secured, all data read should be assumed to be encrypted.
-				if ((l = read(rbuffer + nread, l, secure)) <= 0 || l == SOCKET_ERROR )
+				if ((l = read(readbuffer() + nread, l, secure)) <= 0 || l == SOCKET_ERROR )
 				{
 					int wsaerr = WSAGetLastError();
 					if (!doread && errno != EAGAIN && wsaerr != WSAEWOULDBLOCK && wsaerr != WSAENOTCONN && errno != EINTR)
 					{
 #else
 				// MM-2014-02-12: [[ SecureSocket ]] If a scoket is secured, all data read should be assumed to be encrypted.
-				if ((l = read(rbuffer + nread, l, secure)) <= 0)
+				if ((l = read(readbuffer() + nread, l, secure)) <= 0)
 				{
 					if (!doread && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
 					{
@@ -1805,16 +2660,17 @@ void MCSocket::processreadqueue()
 			if (read_done())
 			{
 				uint4 size = revents->size;
+				char *t_buffer = readbuffer();
 				if (size > 1 && revents->until != NULL && *revents->until == '\n'
-				        && !*(revents->until + 1) && rbuffer[size - 1] == '\r')
-					rbuffer[--size] = '\n';
+				        && !*(revents->until + 1) && t_buffer[size - 1] == '\r')
+					t_buffer[--size] = '\n';
 
 				MCAutoDataRef t_data;
-				/* UNCHECKED */ MCDataCreateWithBytes((const byte_t *)rbuffer, size, &t_data);
+				/* UNCHECKED */ MCDataCreateWithBytes((const byte_t *)t_buffer, size, &t_data);
 				
-				nread -= revents->size;
-				// MW-2010-11-19: [[ Bug 9182 ]] This should be a memmove (I think)
-				memmove(rbuffer, rbuffer + revents->size, nread);
+				// The completed read is handed off without shifting the remaining
+				// data down - the buffer is only compacted when it next needs room.
+				consumeread(revents->size);
 				MCSocketread *e = revents->remove
 				                  (revents);
                 if (e -> optr . IsValid())
@@ -1853,11 +2709,10 @@ void MCSocket::writesome()
 	connected = True;
 	while (wevents != NULL)
 	{
-		uint4 towrite = wevents->size - wevents->done;
-
 		// MM-2014-02-12: [[ SecureSocket ]] The write should only be encrypted if the write object has been flagged as secured.
 		//  (Was previously using the secure flag stored against the socket).
-		int4 nwritten = write( wevents->buffer + wevents->done, towrite, wevents->secure);
+		uint64_t t_requested;
+		int4 nwritten = MCSocketsWriteQueued(this, t_requested);
 #if defined(_WINDOWS_DESKTOP) || defined(_WINDOWS_SERVER)
 
 		if (nwritten == SOCKET_ERROR)
@@ -1883,10 +2738,18 @@ void MCSocket::writesome()
 		}
 		else
 		{
-			wevents->done += nwritten;
-			wevents->timeout = curtime + MCsockettimeout;
-			if (wevents->done == wevents->size && wevents->message != NULL)
+			// The bytes sent may complete several of the writes at the front of
+			// the queue, each of which is removed as it completes.
+			uint64_t t_remaining = nwritten;
+			while (wevents != NULL)
 			{
+				uint64_t t_count = MCMin(t_remaining, wevents->size - wevents->done);
+				wevents->done += t_count;
+				t_remaining -= t_count;
+				wevents->timeout = curtime + MCsockettimeout;
+				if (wevents->done != wevents->size || wevents->message == NULL)
+					break;
+
 				MCSocketwrite *e = wevents->remove
 				                   (wevents);
                 if (e -> optr . IsValid())
@@ -1895,7 +2758,11 @@ void MCSocket::writesome()
                 added = True;
 				delete e;
 			}
-			else
+
+			// Stop once the socket can take no more, or when the write at the
+			// front is waiting to be removed by its writer.
+			if (wevents != NULL &&
+				((uint64_t)nwritten < t_requested || wevents->done == wevents->size))
 				break;
 		}
 	}
@@ -1940,6 +2807,10 @@ void MCSocket::doclose()
 
 void MCSocket::setselect()
 {
+#if defined(_LINUX_SERVER)
+	MCSocketsUpdateEventLoop(this);
+#endif
+
 	uint2 bioselectstate = 0;
 	if (fd)
 	{
@@ -1996,6 +2867,9 @@ void MCSocket::close()
 		closesocket(fd);
 #else
 
+#if defined(_LINUX_SERVER)
+		MCServerEventLoopUnwatch(fd);
+#endif
 		::close(fd);
 #endif
 
@@ -2175,32 +3049,283 @@ Boolean MCSocket::sslinit()
 	return sslinited;
 }
 
-Boolean MCSocket::initsslcontext()
+////////////////////////////////////////////////////////////////////////////////
+//
+// Shared TLS contexts and client session cache
+//
+
+// Secure sockets used to create (and load the whole certificate store into)
+// a fresh SSL_CTX each. Contexts are now pooled process-wide, keyed on the
+// settings used to build them: whether the peer is verified and the value of
+// the sslCertificates when the store was loaded. The pool holds a reference to
+// each context and every socket using one takes another.
+//
+// Client sessions are cached against the socket's host:port (and the end host
+// name, if one was given) so that subsequent connections to the same backend
+// can resume the session (or use its ticket) rather than performing a full
+// handshake. All of this state is only touched on the main thread.
+
+#define SSL_SESSION_CACHE_SIZE 64
+
+struct MCSSLContextPoolEntry
 {
-	if (!sslinit())
-		return False;
-	if (_ssl_context)
-		return True;
+	SSL_CTX *context;
+	char *certificates;
+};
+
+struct MCSSLSessionCacheEntry
+{
+	MCNameRef key;
+	SSL_CTX *context;
+	SSL_SESSION *session;
+	uint32_t last_used;
+};
+
+// The pool is indexed by whether the contexts verify the peer.
+static MCSSLContextPoolEntry s_ssl_context_pool[2];
+static MCSSLSessionCacheEntry s_ssl_session_cache[SSL_SESSION_CACHE_SIZE];
+static uint32_t s_ssl_session_cache_clock = 0;
+
+static uint32_t s_ssl_full_handshake_count = 0;
+static uint32_t s_ssl_resumed_handshake_count = 0;
+
+static void MCSSLSessionCacheClearEntry(MCSSLSessionCacheEntry &x_entry)
+{
+	if (x_entry . session != NULL)
+		SSL_SESSION_free(x_entry . session);
+	MCValueRelease(x_entry . key);
+	x_entry . key = NULL;
+	x_entry . context = NULL;
+	x_entry . session = NULL;
+	x_entry . last_used = 0;
+}
+
+// Removes all the cached sessions which were negotiated using the given
+// context. If the context is NULL, all sessions are removed.
+static void MCSSLSessionCachePurge(SSL_CTX *p_context)
+{
+	for(uint32_t i = 0; i < SSL_SESSION_CACHE_SIZE; i++)
+		if (s_ssl_session_cache[i] . key != NULL &&
+			(p_context == NULL || s_ssl_session_cache[i] . context == p_context))
+			MCSSLSessionCacheClearEntry(s_ssl_session_cache[i]);
+}
+
+static MCSSLSessionCacheEntry *MCSSLSessionCacheFind(SSL_CTX *p_context, MCNameRef p_key)
+{
+	for(uint32_t i = 0; i < SSL_SESSION_CACHE_SIZE; i++)
+		if (s_ssl_session_cache[i] . key != NULL &&
+			s_ssl_session_cache[i] . context == p_context &&
+			MCNameIsEqualToCaseless(s_ssl_session_cache[i] . key, p_key))
+			return &s_ssl_session_cache[i];
+	return NULL;
+}
+
+// Stores the session against the given key, taking ownership of the session's
+// reference. If the cache is full the least recently used entry is evicted.
+static void MCSSLSessionCacheStore(SSL_CTX *p_context, MCNameRef p_key, SSL_SESSION *p_session)
+{
+	MCSSLSessionCacheEntry *t_entry;
+	t_entry = MCSSLSessionCacheFind(p_context, p_key);
+	if (t_entry == NULL)
+	{
+		t_entry = &s_ssl_session_cache[0];
+		for(uint32_t i = 0; i < SSL_SESSION_CACHE_SIZE; i++)
+		{
+			if (s_ssl_session_cache[i] . key == NULL)
+			{
+				t_entry = &s_ssl_session_cache[i];
+				break;
+			}
+			if (s_ssl_session_cache[i] . last_used < t_entry -> last_used)
+				t_entry = &s_ssl_session_cache[i];
+		}
+		MCSSLSessionCacheClearEntry(*t_entry);
+		t_entry -> key = MCValueRetain(p_key);
+		t_entry -> context = p_context;
+	}
+	else if (t_entry -> session != NULL)
+		SSL_SESSION_free(t_entry -> session);
 	
-	bool t_success = true;
+	t_entry -> session = p_session;
+	t_entry -> last_used = ++s_ssl_session_cache_clock;
+}
+
+static void MCSSLSessionCacheRemove(SSL_CTX *p_context, MCNameRef p_key)
+{
+	MCSSLSessionCacheEntry *t_entry;
+	t_entry = MCSSLSessionCacheFind(p_context, p_key);
+	if (t_entry != NULL)
+		MCSSLSessionCacheClearEntry(*t_entry);
+}
+
+// Computes the key sessions for the socket are cached against. This is the
+// host:port the socket was opened with (minus any connection id) along with
+// the end host name the certificate is verified against.
+static bool MCSSLSessionKeyForSocket(MCSocket *p_socket, MCNameRef &r_key)
+{
+	MCStringRef t_name;
+	t_name = MCNameGetString(p_socket -> name);
 	
-	t_success = NULL != (_ssl_context = SSL_CTX_new(TLS_method()));
+	uindex_t t_pos;
+	if (!MCStringFirstIndexOfChar(t_name, '|', 0, kMCCompareExact, t_pos))
+		t_pos = MCStringGetLength(t_name);
 	
-	if (t_success)
-		t_success = MCSSLContextLoadCertificates(_ssl_context, &sslerror);
+	MCRange t_range;
+	t_range = MCRangeMake(0, t_pos);
 	
-	if (t_success)
+	MCAutoStringRef t_key;
+	if (!MCStringFormat(&t_key, "%*@|%@", &t_range, t_name, MCNameGetString(p_socket -> endhostname)))
+		return false;
+	
+	return MCNameCreate(*t_key, r_key);
+}
+
+// Called by OpenSSL whenever a new session is established on a client
+// connection. With TLS 1.3 this happens after the handshake, when the server
+// sends its session tickets.
+static int MCSSLNewSessionCallback(SSL *p_ssl, SSL_SESSION *p_session)
+{
+	if (SSL_is_server(p_ssl))
+		return 0;
+	
+	MCSocket *t_socket;
+	t_socket = (MCSocket *)SSL_get_app_data(p_ssl);
+	if (t_socket == NULL)
+		return 0;
+	
+	MCNewAutoNameRef t_key;
+	if (!MCSSLSessionKeyForSocket(t_socket, &t_key))
+		return 0;
+	
+	MCSSLSessionCacheStore(SSL_get_SSL_CTX(p_ssl), *t_key, p_session);
+	
+	// Returning 1 tells OpenSSL that we have taken the reference to the session.
+	return 1;
+}
+
+// Returns a new reference to a shared context with the given verification
+// settings, creating it (and loading the certificate store) if needed.
+static SSL_CTX *MCSSLContextPoolAcquire(bool p_verify, MCStringRef *r_error)
+{
+	MCSSLContextPoolEntry &t_entry = s_ssl_context_pool[p_verify ? 1 : 0];
+	
+	// If the sslCertificates have changed since the context was built, it can
+	// no longer be shared. Sockets already using it keep their reference.
+	if (t_entry . context != NULL &&
+		!MCCStringEqual(t_entry . certificates != NULL ? t_entry . certificates : "",
+						MCsslcertificates != NULL ? MCsslcertificates : ""))
+	{
+		MCSSLSessionCachePurge(t_entry . context);
+		SSL_CTX_free(t_entry . context);
+		MCCStringFree(t_entry . certificates);
+		t_entry . context = NULL;
+		t_entry . certificates = NULL;
+	}
+	
+	if (t_entry . context == NULL)
 	{
+		SSL_CTX *t_context;
+		t_context = SSL_CTX_new(TLS_method());
+		if (t_context == NULL)
+			return NULL;
+		
+		if (!MCSSLContextLoadCertificates(t_context, r_error))
+		{
+			SSL_CTX_free(t_context);
+			return NULL;
+		}
+		
 #if defined(TARGET_SUBPLATFORM_IPHONE) || defined(TARGET_SUBPLATFORM_ANDROID)
-        // MM-2015-06-04: [[ MobileSockets ]] Since iOS and Android don't expose the root certificates directly, we can't use OpenSSL's verification routines.
-        //   Instead we'll do it ourselves using the OS APIs.
-        SSL_CTX_set_verify(_ssl_context, SSL_VERIFY_NONE, NULL);
+		// MM-2015-06-04: [[ MobileSockets ]] Since iOS and Android don't expose the root certificates directly, we can't use OpenSSL's verification routines.
+		//   Instead we'll do it ourselves using the OS APIs.
+		SSL_CTX_set_verify(t_context, SSL_VERIFY_NONE, NULL);
 #else
-        SSL_CTX_set_verify(_ssl_context, sslverify? SSL_VERIFY_PEER: SSL_VERIFY_NONE,verify_callback);
-        SSL_CTX_set_verify_depth(_ssl_context, 9);
+		SSL_CTX_set_verify(t_context, p_verify ? SSL_VERIFY_PEER : SSL_VERIFY_NONE, verify_callback);
+		SSL_CTX_set_verify_depth(t_context, 9);
 #endif
+		
+		// Client sessions are kept in our own cache (keyed on host and port),
+		// server side resumption uses session tickets - which now work across
+		// accepted connections as they share the context's ticket keys.
+		static const unsigned char s_session_id_context[] = "livecode";
+		SSL_CTX_set_session_id_context(t_context, s_session_id_context, sizeof(s_session_id_context) - 1);
+		SSL_CTX_set_session_cache_mode(t_context, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+		SSL_CTX_sess_set_new_cb(t_context, MCSSLNewSessionCallback);
+		
+		if (MCsslcertificates != NULL)
+			/* UNCHECKED */ MCCStringClone(MCsslcertificates, t_entry . certificates);
+		t_entry . context = t_context;
 	}
-	return t_success;
+	
+	SSL_CTX_up_ref(t_entry . context);
+	return t_entry . context;
+}
+
+void MCSSLContextPoolFinalize(void)
+{
+	MCSSLSessionCachePurge(NULL);
+	
+	for(uint32_t i = 0; i < 2; i++)
+	{
+		if (s_ssl_context_pool[i] . context != NULL)
+			SSL_CTX_free(s_ssl_context_pool[i] . context);
+		MCCStringFree(s_ssl_context_pool[i] . certificates);
+		s_ssl_context_pool[i] . context = NULL;
+		s_ssl_context_pool[i] . certificates = NULL;
+	}
+}
+
+bool MCS_ssl_session_statistics(MCArrayRef &r_statistics)
+{
+	uint32_t t_contexts, t_sessions;
+	t_contexts = 0;
+	t_sessions = 0;
+	for(uint32_t i = 0; i < 2; i++)
+		if (s_ssl_context_pool[i] . context != NULL)
+			t_contexts++;
+	for(uint32_t i = 0; i < SSL_SESSION_CACHE_SIZE; i++)
+		if (s_ssl_session_cache[i] . session != NULL)
+			t_sessions++;
+	
+	MCAutoNumberRef t_handshakes, t_resumptions, t_context_count, t_session_count;
+	MCAutoArrayRef t_array;
+	if (!MCNumberCreateWithUnsignedInteger(s_ssl_full_handshake_count, &t_handshakes) ||
+		!MCNumberCreateWithUnsignedInteger(s_ssl_resumed_handshake_count, &t_resumptions) ||
+		!MCNumberCreateWithUnsignedInteger(t_contexts, &t_context_count) ||
+		!MCNumberCreateWithUnsignedInteger(t_sessions, &t_session_count) ||
+		!MCArrayCreateMutable(&t_array) ||
+		!MCArrayStoreValue(*t_array, false, MCNAME("handshakes"), *t_handshakes) ||
+		!MCArrayStoreValue(*t_array, false, MCNAME("resumptions"), *t_resumptions) ||
+		!MCArrayStoreValue(*t_array, false, MCNAME("contexts"), *t_context_count) ||
+		!MCArrayStoreValue(*t_array, false, MCNAME("sessions"), *t_session_count) ||
+		!t_array . MakeImmutable())
+		return false;
+	
+	r_statistics = t_array . Take();
+	return true;
+}
+
+// Records the outcome of a completed handshake on the given connection.
+static void MCSSLRecordHandshake(SSL *p_ssl)
+{
+	if (SSL_session_reused(p_ssl))
+		s_ssl_resumed_handshake_count++;
+	else
+		s_ssl_full_handshake_count++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Boolean MCSocket::initsslcontext()
+{
+	if (!sslinit())
+		return False;
+	if (_ssl_context)
+		return True;
+	
+	_ssl_context = MCSSLContextPoolAcquire(sslverify == True, &sslerror);
+	
+	return _ssl_context != NULL;
 }
 
 Boolean MCSocket::sslconnect()
@@ -2217,6 +3342,26 @@ Boolean MCSocket::sslconnect()
 		_ssl_conn = SSL_new(_ssl_context);
 		SSL_set_connect_state(_ssl_conn);
 		SSL_set_fd(_ssl_conn, fd);
+		SSL_set_app_data(_ssl_conn, this);
+		
+		// Offer the last session negotiated with this host (if any) so that the
+		// server can resume it rather than doing a full handshake.
+		MCNewAutoNameRef t_session_key;
+		if (MCSSLSessionKeyForSocket(this, &t_session_key))
+		{
+			MCSSLSessionCacheEntry *t_entry;
+			t_entry = MCSSLSessionCacheFind(_ssl_context, *t_session_key);
+			if (t_entry != NULL)
+			{
+				if (SSL_SESSION_is_resumable(t_entry -> session))
+				{
+					SSL_set_session(_ssl_conn, t_entry -> session);
+					t_entry -> last_used = ++s_ssl_session_cache_clock;
+				}
+				else
+					MCSSLSessionCacheClearEntry(*t_entry);
+			}
+		}
 	}
 
     MCAutoStringRef t_hostname;
@@ -2262,6 +3407,11 @@ Boolean MCSocket::sslconnect()
             
             if (rc != X509_V_OK)
             {
+                // Make sure a session which failed verification is never offered again.
+                MCNewAutoNameRef t_session_key;
+                if (MCSSLSessionKeyForSocket(this, &t_session_key))
+                    MCSSLSessionCacheRemove(_ssl_context, *t_session_key);
+                
                 MCAutoStringRef t_message;
                 /* UNCHECKED */ MCStringCreateWithCString(X509_verify_cert_error_string(rc), &t_message);
                 sslerror = MCValueRetain(*t_message);
@@ -2271,6 +3421,7 @@ Boolean MCSocket::sslconnect()
 #endif
 		}
 
+		MCSSLRecordHandshake(_ssl_conn);
 		sslstate |= SSTATE_CONNECTED;
 		setselect(BIONB_TESTREAD | BIONB_TESTWRITE);
 		return True;
@@ -2456,6 +3607,7 @@ Boolean MCSocket::sslaccept()
 #endif
 		}
 
+		MCSSLRecordHandshake(_ssl_conn);
 		sslstate |= SSTATE_CONNECTED;
 		setselect(BIONB_TESTREAD|BIONB_TESTWRITE);
 		return True;
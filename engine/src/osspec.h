@@ -189,7 +189,9 @@ extern bool MCS_compare_host_domain(MCStringRef p_host_a, MCStringRef p_host_b);
 extern MCSocket *MCS_open_socket(MCNameRef name, MCNameRef from, Boolean datagram, MCObject *o, MCNameRef m, Boolean secure, Boolean sslverify, MCStringRef sslcertfile, MCNameRef p_end_hostname);
 extern void MCS_close_socket(MCSocket *s);
 extern MCDataRef MCS_read_socket(MCSocket *s, MCExecContext &ctxt, uint4 length, const char *until, MCNameRef m);
-extern void MCS_write_socket(const MCStringRef d, MCSocket *s, MCObject *optr, MCNameRef m);
+extern void MCS_write_socket(MCDataRef d, MCSocket *s, MCObject *optr, MCNameRef m);
+extern void MCS_write_file_socket(MCStringRef p_path, MCSocket *s, MCObject *optr, MCNameRef m);
+extern void MCS_write_datagrams(MCDataRef *p_datagrams, uindex_t p_count, MCSocket *s, MCObject *optr, MCNameRef m);
 extern MCSocket *MCS_accept(uint2 p, MCObject *o, MCNameRef m, Boolean datagram,Boolean secure,Boolean sslverify, MCStringRef sslcertfile);
 extern bool MCS_ha(MCSocket *s, MCStringRef& r_string);
 extern bool MCS_hn(MCStringRef& r_string);
@@ -197,6 +199,9 @@ extern bool MCS_aton(MCStringRef p_address, MCStringRef& r_name);
 extern bool MCS_ntoa(MCStringRef p_hostname, MCObject *p_target, MCNameRef p_message, MCListRef& r_addr);
 extern bool MCS_pa(MCSocket *s, MCStringRef& r_string);
 extern void MCS_secure_socket(MCSocket *s, Boolean sslverify, MCNameRef end_hostname);
+extern bool MCS_ssl_session_statistics(MCArrayRef& r_statistics);
+extern bool MCS_dns_cache_statistics(MCArrayRef& r_statistics);
+extern void MCS_dns_cache_flush(void);
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -607,6 +607,10 @@ enum Functions {
     F_EVENT_CONTROL_KEY,
     F_EVENT_OPTION_KEY,
     F_EVENT_SHIFT_KEY,
+    
+    F_SOCKET_PENDING_BYTES,
+    
+    F_BINARY_DECODE_RECORDS,
 };
 
 /* The HT_MIN and HT_MAX elements of the enum delimit the range of the handler
@@ -1761,6 +1765,12 @@ enum Properties {
 	
 	P_SYSTEM_APPEARANCE,
     
+    P_SSL_SESSION_STATISTICS,
+    
+    P_DNS_CACHE_STATISTICS,
+    
+    P_BATCH_DATAGRAM_MESSAGES,
+    
     __P_LAST,
 };
 
@@ -1815,6 +1825,7 @@ enum Reset_type {
     RT_TEMPLATE_SCROLLBAR,
     RT_TEMPLATE_STACK,
     RT_TEMPLATE_VIDEO_CLIP,
+    RT_DNS_CACHE,
 };
 
 
@@ -2019,6 +2030,7 @@ enum Statements {
     S_CLOSE,
     S_COMBINE,
     S_COMPACT,
+    S_COMPRESS,
     S_CONSTANT,
     S_CONVERT,
     S_COPY,
@@ -2026,6 +2038,7 @@ enum Statements {
     S_CROP,
     S_CUT,
     S_DEBUGDO,
+    S_DECOMPRESS,
     S_DECRYPT,
     S_DEFINE,
     S_DELETE,
@@ -1798,6 +1798,21 @@ enum Parse_errors
     
     // {PE-0584} out of memory
     PE_OUTOFMEMORY,
+    
+    // {PE-0585} socketPendingBytes: error in socket expression
+    PE_SOCKETPENDINGBYTES_BADSOCKET,
+    
+    // {PE-0586} binaryDecodeRecords: bad parameters
+    PE_BINARYDR_BADPARAM,
+
+    // {PE-0587} compress file: expected 'file'
+    PE_COMPRESSFILE_NOFILE,
+
+    // {PE-0588} compress file: error in file expression
+    PE_COMPRESSFILE_BADEXP,
+
+    // {PE-0589} compress file: expected 'to'
+    PE_COMPRESSFILE_NOTO,
 };
 
 extern const char *MCparsingerrors;
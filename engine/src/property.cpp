@@ -172,6 +172,9 @@ static MCPropertyInfo kMCPropertyInfoTable[] =
 	DEFINE_RW_PROPERTY(P_IMAGE_CACHE_LIMIT, UInt32, Graphics, ImageCacheLimit)
 	DEFINE_RO_PROPERTY(P_IMAGE_CACHE_USAGE, UInt32, Graphics, ImageCacheUsage)
 	DEFINE_RW_PROPERTY(P_ALLOW_DATAGRAM_BROADCASTS, Bool, Network, AllowDatagramBroadcasts)
+	DEFINE_RW_PROPERTY(P_BATCH_DATAGRAM_MESSAGES, Bool, Network, BatchDatagramMessages)
+	DEFINE_RO_PROPERTY(P_SSL_SESSION_STATISTICS, Array, Network, SslSessionStatistics)
+	DEFINE_RO_PROPERTY(P_DNS_CACHE_STATISTICS, Array, Network, DnsCacheStatistics)
 	
 	DEFINE_RW_PROPERTY(P_BRUSH_BACK_COLOR, Any, Interface, BrushBackColor)
 	DEFINE_RW_PROPERTY(P_PEN_BACK_COLOR, Any, Interface, PenBackColor)
@@ -897,6 +900,9 @@ Parse_stat MCProperty::parse(MCScriptPoint &sp, Boolean the)
 	case P_PROCESS_TYPE:
 	case P_STACK_LIMIT:
 	case P_ALLOW_DATAGRAM_BROADCASTS:
+	case P_BATCH_DATAGRAM_MESSAGES:
+	case P_SSL_SESSION_STATISTICS:
+	case P_DNS_CACHE_STATISTICS:
 
 	case P_ERROR_MODE:
 	case P_OUTPUT_TEXT_ENCODING:
@@ -267,6 +267,8 @@ MCRectangle MCControl::layer_getcontentrect(void)
 
 void MCControl::layer_redrawall(void)
 {
+	layer_contentchanged();
+
 	if (!opened)
 		return;
 
@@ -289,6 +291,8 @@ void MCControl::layer_redrawall(void)
 
 void MCControl::layer_redrawrect(const MCRectangle& p_dirty_rect)
 {
+	layer_contentchanged();
+
 	if (!opened)
 		return;
 
@@ -442,6 +446,7 @@ void MCControl::layer_effectiverectchangedandredrawall(const MCRectangle& p_old_
 
 void MCControl::layer_effectschanged(const MCRectangle& p_old_effective_rect)
 {
+	layer_contentchanged();
 	layer_effectiverectchangedandredrawall(p_old_effective_rect);
 }
 
@@ -491,6 +496,8 @@ void MCControl::layer_contentoriginchanged(int32_t p_dx, int32_t p_dy)
 
 void MCControl::layer_scrolled(void)
 {
+	layer_contentchanged();
+
 	if (!opened)
 		return;
 		
@@ -521,6 +528,8 @@ void MCControl::layer_dirtycontentrect(const MCRectangle& p_updated_rect, bool p
 	if (MCU_empty_rect(p_updated_rect))
 		return;
 
+	layer_parentcontentchanged();
+
 	MCRectangle t_content_rect;
 	t_content_rect = layer_getcontentrect();
 	
@@ -550,6 +559,10 @@ void MCControl::layer_dirtycontentrect(const MCRectangle& p_updated_rect, bool p
 
 void MCControl::layer_dirtyeffectiverect(const MCRectangle& p_effective_rect, bool p_update_card)
 {
+	// The control might just have moved, so only the groups containing it
+	// have changed content.
+	layer_parentcontentchanged();
+
 	// The dirty rect will be the input effective rect expanded by any effects
 	// applied by the parent groups (if any).
 	MCRectangle t_dirty_rect;
@@ -638,6 +651,54 @@ void MCControl::layer_dirtyeffectiverect(const MCRectangle& p_effective_rect, bo
 		t_control->getcard()->layer_dirtyrect(t_dirty_rect);
 }
 
+// Discards the display lists and cached effects of the control and any
+// controls it contains, as the drawing of the latter can depend on the
+// properties they inherit.
+static void layer_resetcontent(MCControl *p_control)
+{
+	p_control -> layer_resetdisplaylist();
+	MCBitmapEffectsContentChanged(p_control -> getbitmapeffects());
+
+	if (p_control -> gettype() != CT_GROUP)
+		return;
+
+	MCControl *t_controls;
+	t_controls = static_cast<MCGroup *>(p_control) -> getcontrols();
+	if (t_controls == nil)
+		return;
+
+	MCControl *t_child;
+	t_child = t_controls;
+	do
+	{
+		layer_resetcontent(t_child);
+		t_child = t_child -> next();
+	}
+	while(t_child != t_controls);
+}
+
+void MCControl::layer_contentchanged(void)
+{
+	layer_resetcontent(this);
+	layer_parentcontentchanged();
+}
+
+void MCControl::layer_parentcontentchanged(void)
+{
+	// The blurred masks of the effects of any containing groups are computed
+	// from this control's pixels too, so they must also be recomputed, as
+	// must their recorded drawing.
+	MCControl *t_control;
+	t_control = this;
+	while(t_control -> parent . IsValid() &&
+		  t_control -> parent -> gettype() == CT_GROUP)
+	{
+		t_control = t_control -> parent . GetAs<MCControl>();
+		MCBitmapEffectsContentChanged(t_control -> m_bitmap_effects);
+		t_control -> layer_resetdisplaylist();
+	}
+}
+
 void MCControl::layer_changeeffectiverect(const MCRectangle& p_old_effective_rect, bool p_force_update, bool p_update_card)
 {
 	// Compute the 'new' effectiverect based on visibility.
@@ -647,6 +708,14 @@ void MCControl::layer_changeeffectiverect(const MCRectangle& p_old_effective_rec
 	else
 		MCU_set_rect(t_new_effective_rect, 0, 0, 0, 0);
 
+	// If the content has changed, any cached effects are no longer valid.
+	// Otherwise the control is just moving, so only those of the groups
+	// containing it are.
+	if (p_force_update)
+		layer_contentchanged();
+	else
+		layer_parentcontentchanged();
+
 	// If the effective rect has not changed this is at most an update.
 	if (MCU_equal_rect(p_old_effective_rect, t_new_effective_rect))
 	{
@@ -1027,9 +1096,130 @@ static bool testtilecache_scenery_renderer(void *p_context, MCContext *p_target,
 
 static bool testtilecache_device_scenery_renderer(void *p_context, MCGContextRef p_target, const MCRectangle32& p_rectangle)
 {
+	MCControl *t_control;
+	t_control = (MCControl *)p_context;
+
+	// If the control hasn't changed since it was last drawn, replay its drawing
+	// rather than redoing it; the target is already clipped to the tiles being
+	// redrawn.
+	MCGDisplayListRef t_display_list;
+	if (t_control -> layer_getdisplaylist(MCGContextIsLayerOpaque(p_target), t_display_list))
+	{
+		MCGContextDrawDisplayList(p_target, t_display_list);
+		MCGDisplayListRelease(t_display_list);
+		return true;
+	}
+
 	return tilecache_device_renderer(testtilecache_scenery_renderer, p_context, p_target, p_rectangle, false);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+// Recordings larger than this are replayed once and then discarded, as they
+// can take more memory than the tiles they are drawn into.
+#define kMCLayerDisplayListMaxByteSize (1024 * 1024)
+
+// Bumped whenever everything is redrawn, so all recordings are out of date.
+static uint32_t s_layer_display_list_epoch = 0;
+
+void MCControl::layer_invalidatedisplaylists(void)
+{
+	s_layer_display_list_epoch++;
+}
+
+void MCControl::layer_resetdisplaylist(void)
+{
+	MCGDisplayListRelease(m_layer_display_list);
+	m_layer_display_list = nil;
+	m_layer_display_list_seen = false;
+	m_layer_display_list_unrecordable = false;
+}
+
+bool MCControl::layer_getdisplaylist(bool p_opaque, MCGDisplayListRef& r_display_list)
+{
+	MCStack *t_stack;
+	t_stack = getstack();
+
+	MCGAffineTransform t_transform;
+	t_transform = t_stack -> getdevicetransform();
+
+	// The recording covers everything of the control which can be seen, so
+	// that it can be replayed into any of the tiles it touches.
+	MCRectangle t_rect;
+	t_rect = MCU_intersect_rect(geteffectiverect(), t_stack -> getvisiblerect());
+	if (layer_has_clip_rect())
+		t_rect = MCU_intersect_rect(t_rect, layer_get_clip_rect());
+
+	MCRectangle32 t_region;
+	t_region = MCRectangle32GetTransformedBounds(t_rect, t_transform);
+	if (t_region . width <= 0 || t_region . height <= 0)
+		return false;
+
+	// Controls which are only drawn once with a given key, such as those which
+	// are animating, are not worth recording; so the first time a key is seen
+	// the control is just drawn, and it is recorded the second time.
+	if (!m_layer_display_list_seen ||
+		m_layer_display_list_epoch != s_layer_display_list_epoch ||
+		m_layer_display_list_opaque != p_opaque ||
+		t_region . x != m_layer_display_list_region . x ||
+		t_region . y != m_layer_display_list_region . y ||
+		t_region . width != m_layer_display_list_region . width ||
+		t_region . height != m_layer_display_list_region . height ||
+		!MCGAffineTransformIsEqual(t_transform, m_layer_display_list_transform))
+	{
+		layer_resetdisplaylist();
+		m_layer_display_list_seen = true;
+		m_layer_display_list_opaque = p_opaque;
+		m_layer_display_list_epoch = s_layer_display_list_epoch;
+		m_layer_display_list_region = t_region;
+		m_layer_display_list_transform = t_transform;
+		return false;
+	}
+
+	if (m_layer_display_list != nil)
+	{
+		r_display_list = MCGDisplayListRetain(m_layer_display_list);
+		return true;
+	}
+
+	if (m_layer_display_list_unrecordable)
+		return false;
+
+	MCGContextRef t_context;
+	if (!MCGContextCreateForDisplayList(MCRectangle32ToMCGIntegerRectangle(t_region), p_opaque, t_context))
+	{
+		m_layer_display_list_unrecordable = true;
+		return false;
+	}
+
+	bool t_success;
+	t_success = tilecache_device_renderer(testtilecache_scenery_renderer, this, t_context, t_region, false);
+
+	MCGDisplayListRef t_display_list;
+	t_display_list = nil;
+	if (t_success)
+		t_success = MCGContextCopyDisplayList(t_context, t_display_list);
+
+	MCGContextRelease(t_context);
+
+	if (!t_success)
+	{
+		m_layer_display_list_unrecordable = true;
+		return false;
+	}
+
+	// A recording which is too large is still used for this draw, but isn't
+	// kept.
+	if (MCGDisplayListGetByteSize(t_display_list) > kMCLayerDisplayListMaxByteSize)
+		m_layer_display_list_unrecordable = true;
+	else
+		m_layer_display_list = MCGDisplayListRetain(t_display_list);
+
+	r_display_list = t_display_list;
+
+	return true;
+}
+
 bool MCCard::tilecache_render_foreground(void *p_context, MCContext *p_target, const MCRectangle& p_dirty)
 {
 	MCCard *t_card;
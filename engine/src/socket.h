@@ -47,6 +47,11 @@ class MCSocketread : public MCDLlist
 public:
 	uint4 size;
 	char *until;
+	// The length of the until sentinel, and how far into the read buffer it
+	// has already been searched for (so the search resumes from there when
+	// more data arrives).
+	uint4 untillength;
+	uint4 scanned;
 	real8 timeout;
 	MCObjectHandle optr;
 	MCNameRef message;
@@ -78,16 +83,32 @@ public:
 	real8 timeout;
 	MCObjectHandle optr;
 	MCNameRef message;
-	char *buffer;
-	uint4 size;
-	uint4 done;
+	// The data to write, held by reference rather than copied. This is nil
+	// when writing a file, in which case file is its descriptor - the file's
+	// bytes are sent straight from it where the platform allows, and are
+	// otherwise read a chunk at a time into the chunk buffer (which holds
+	// chunksize bytes from offset chunkstart).
+	MCDataRef data;
+	int file;
+	char *chunk;
+	uint64_t chunkstart;
+	uint4 chunksize;
+	uint64_t size;
+	uint64_t done;
 	Boolean writedone;
 
     // MM-2014-02-12: [[ SecureSocket ]] We now store against each individual write if it should be encrypted (rather than checking against socket).
 	Boolean secure;
     
-	MCSocketwrite(MCStringRef d, MCObject *o, MCNameRef m, Boolean secure);
+	MCSocketwrite(MCDataRef d, MCObject *o, MCNameRef m, Boolean secure);
+	MCSocketwrite(int f, uint64_t s, MCObject *o, MCNameRef m, Boolean secure);
 	~MCSocketwrite();
+	
+	// Returns the bytes of the data which are still to be written.
+	const char *pending()
+	{
+		return (const char *)MCDataGetBytePtr(data) + done;
+	}
 	MCSocketwrite *next()
 	{
 		return (MCSocketwrite *)MCDLlist::next();
@@ -117,6 +138,15 @@ typedef enum _mcsocketstate
 	kMCSocketStateError,
 } MCSocketState ;
 
+// Whether a socket can be found by name in the socket index - sockets sharing
+// the name of an earlier one are left out until that one is removed.
+typedef enum _mcsocketindexstate
+{
+	kMCSocketIndexStateNone,
+	kMCSocketIndexStateIndexed,
+	kMCSocketIndexStateDuplicate,
+} MCSocketIndexState ;
+
 class MCSocket
 {
 public:
@@ -129,12 +159,20 @@ public:
 	Boolean added;
 	Boolean connected;
 	Boolean shared;
+	// Whether the datagrams received are delivered in one message per batch,
+	// rather than one message each.
+	Boolean batchdatagrams;
 	MCSocketState resolve_state;
 	MCObjectHandle object;
 	MCNameRef message;
 	MCSocketread *revents;
 	MCSocketwrite *wevents;
+	// The unconsumed data read from the socket is the nread bytes starting
+	// at rstart in rbuffer (which has room for rsize bytes). Completed reads
+	// are consumed by advancing rstart - the data is only moved back to the
+	// start of the buffer when more room is needed.
 	char *rbuffer;
+	uint4 rstart;
 	uint4 rsize;
 	uint4 nread;
 	char *error;
@@ -143,6 +181,9 @@ public:
 	// MM-2014-06-13: [[ Bug 12567 ]] Added support for specifying an end host name to verify against.
 	MCNameRef endhostname;
     MCNewAutoNameRef from;
+	// The position of the socket in MCsockets.
+	uint32_t listindex;
+	MCSocketIndexState indexstate;
     
 	MCSocket(MCNameRef n, MCNameRef f, MCObject *o, MCNameRef m, Boolean d, MCSocketHandle sock, Boolean a, Boolean s, Boolean issecure);
 
@@ -168,7 +209,38 @@ public:
 	void deletereads();
 	void deletewrites();
 
+	// Returns true if the socket has closed and all the data read from it has
+	// been consumed, and so it can be removed from the list of open sockets.
+	bool isfinished() const
+	{
+		return !waiting && fd == 0 && nread == 0 && resolve_state != kMCSocketStateResolving;
+	}
+
+	// Returns the number of bytes which have been written to the socket but
+	// not yet sent.
+	uint64_t pendingwrites() const
+	{
+		uint64_t t_pending;
+		t_pending = 0;
+		MCSocketwrite *t_write;
+		t_write = wevents;
+		if (t_write != NULL)
+			do
+			{
+				t_pending += t_write->size - t_write->done;
+				t_write = t_write->next();
+			}
+			while (t_write != wevents);
+		return t_pending;
+	}
+
 	Boolean read_done();
+	char *readbuffer()
+	{
+		return rbuffer + rstart;
+	}
+	bool reserveread(uint4 p_count);
+	void consumeread(uint4 p_count);
 	void readsome();
 	void writesome();
 	void processreadqueue();
@@ -226,10 +298,34 @@ bool MCS_sockaddr_to_string(struct sockaddr *p_addr, int p_addrlen, bool p_looku
 bool MCSocketsInitialize(void);
 void MCSocketsFinalize(void);
 
+// Releases the shared TLS contexts and cached client sessions. This must be
+// called before the SSL library is unloaded.
+void MCSSLContextPoolFinalize(void);
+
+// MCSocket objects are allocated from a slab, so must be created with
+// MCSocketsNew and destroyed with MCSocketsDelete.
+MCSocket *MCSocketsNew(MCNameRef n, MCNameRef f, MCObject *o, MCNameRef m, Boolean d, MCSocketHandle sock, Boolean a, Boolean s, Boolean issecure);
+void MCSocketsDelete(MCSocket *s);
+
 void MCSocketsAppendToSocketList(MCSocket *s);
+// Removes a finished socket, so that it can no longer be found by name. It is
+// deleted from the list by the next MCSocketsRemoveFinishedFromSocketList().
 void MCSocketsRemoveFromSocketList(uint32_t socket_no);
+void MCSocketsRemoveFinishedFromSocketList(void);
+void MCSocketsDeleteSocketList(void);
+
+// Returns the open socket with the given name (compared caselessly), or NULL.
+MCSocket *MCSocketsFindSocket(MCNameRef p_name);
 
 bool MCSocketsAddToFileDescriptorSets(int4 &r_maxfd, fd_set &r_rmaskfd, fd_set &r_wmaskfd, fd_set &r_emaskfd);
 void MCSocketsHandleFileDescriptorSets(fd_set &p_rmaskfd, fd_set &p_wmaskfd, fd_set &p_emaskfd);
 
+#if defined(_LINUX_SERVER)
+// Updates the events the socket is registered for with the server event loop.
+void MCSocketsUpdateEventLoop(MCSocket *s);
+// Services the sockets which were ready in the last wait of the server event
+// loop.
+void MCSocketsHandleEventLoop(void);
+#endif
+
 #endif // SOCKET_H
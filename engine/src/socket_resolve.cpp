@@ -34,6 +34,7 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #include "socket.h"
 #include "notify.h"
+#include "dnscache.h"
 
 #include "ports.cpp"
 
@@ -190,77 +191,221 @@ bool platform_launch_thread(_thread_function p_thread, void *p_context)
 }
 #endif
 
-struct _thread_notify_info
+////////////////////////////////////////////////////////////////////////////////
+
+// Name resolution is done by a small pool of worker threads which are started
+// on demand and then kept around, rather than by a new thread per lookup.
+// Each job runs its function on a worker and then posts its callback back to
+// the main thread.
+
+#define RESOLVER_THREAD_LIMIT 4
+
+struct _resolver_job
 {
+	_resolver_job *m_next;
 	_thread_function m_function;
 	_notify_callback m_callback;
 	void * m_context;
 };
 
-void notify_thread(void *p_context)
+static _resolver_job *s_resolver_queue_head = NULL;
+static _resolver_job *s_resolver_queue_tail = NULL;
+static uint32_t s_resolver_thread_count = 0;
+static uint32_t s_resolver_idle_count = 0;
+static bool s_resolver_initialized = false;
+
+#if defined(_WIN32)
+static CRITICAL_SECTION s_resolver_lock;
+static HANDLE s_resolver_jobs_available = NULL;
+
+static bool resolver_platform_initialize(void)
+{
+	s_resolver_jobs_available = CreateSemaphore(NULL, 0, LONG_MAX, NULL);
+	if (s_resolver_jobs_available == NULL)
+		return false;
+	InitializeCriticalSection(&s_resolver_lock);
+	return true;
+}
+
+static void resolver_lock(void)
+{
+	EnterCriticalSection(&s_resolver_lock);
+}
+
+static void resolver_unlock(void)
+{
+	LeaveCriticalSection(&s_resolver_lock);
+}
+
+// Wakes a worker to process a newly queued job. Called without the lock held.
+static void resolver_signal(void)
+{
+	ReleaseSemaphore(s_resolver_jobs_available, 1, NULL);
+}
+
+// Waits until there is a job on the queue. Called, and returns, with the lock
+// held.
+static void resolver_wait(void)
+{
+	// The semaphore is released once per queued job, so once it has been
+	// acquired there is a job waiting for this worker.
+	resolver_unlock();
+	WaitForSingleObject(s_resolver_jobs_available, INFINITE);
+	resolver_lock();
+}
+#else
+static pthread_mutex_t s_resolver_lock;
+static pthread_cond_t s_resolver_jobs_available;
+
+static bool resolver_platform_initialize(void)
+{
+	if (pthread_mutex_init(&s_resolver_lock, NULL) != 0)
+		return false;
+	if (pthread_cond_init(&s_resolver_jobs_available, NULL) != 0)
+	{
+		pthread_mutex_destroy(&s_resolver_lock);
+		return false;
+	}
+	return true;
+}
+
+static void resolver_lock(void)
+{
+	pthread_mutex_lock(&s_resolver_lock);
+}
+
+static void resolver_unlock(void)
+{
+	pthread_mutex_unlock(&s_resolver_lock);
+}
+
+static void resolver_signal(void)
+{
+	pthread_cond_signal(&s_resolver_jobs_available);
+}
+
+static void resolver_wait(void)
+{
+	while (s_resolver_queue_head == NULL)
+		pthread_cond_wait(&s_resolver_jobs_available, &s_resolver_lock);
+}
+#endif
+
+static void resolver_worker_thread(void *p_context)
 {
 #ifdef TARGET_SUBPLATFORM_ANDROID
     // MM-2015-08-04: [[ Bug 15679 ]] Pushing the callback notification will call BreakWait which accesses the JNI.
     //   Make sure we attach this thread to the JVM so that we have a JNI interface pointer.
+    //   Workers live for the rest of the session, so stay attached.
     MCJavaAttachCurrentThread();
 #endif
-    
-	_thread_notify_info *t_info;
-	t_info = (_thread_notify_info*)p_context;
-
-	t_info->m_function(t_info->m_context);
 
-	// IM-2011-08-23: call MCNotifyPush() with safe == false, as notification can be dispatched
-	// during unsafe wait.  fixes broken hostnametoaddress call
-	MCNotifyPush(t_info->m_callback, t_info->m_context, false, false);
-	MCMemoryDelete(t_info);
-    
-#ifdef TARGET_SUBPLATFORM_ANDROID
-    MCJavaDetachCurrentThread();
-#endif
+	for(;;)
+	{
+		resolver_lock();
+		s_resolver_idle_count += 1;
+		resolver_wait();
+		s_resolver_idle_count -= 1;
+
+		_resolver_job *t_job;
+		t_job = s_resolver_queue_head;
+		s_resolver_queue_head = t_job->m_next;
+		if (s_resolver_queue_head == NULL)
+			s_resolver_queue_tail = NULL;
+		resolver_unlock();
+
+		t_job->m_function(t_job->m_context);
+
+		// IM-2011-08-23: call MCNotifyPush() with safe == false, as notification can be dispatched
+		// during unsafe wait.  fixes broken hostnametoaddress call
+		MCNotifyPush(t_job->m_callback, t_job->m_context, false, false);
+		MCMemoryDelete(t_job);
+	}
 }
 
 bool launch_thread_with_notify(_thread_function p_thread, _notify_callback p_callback, void *p_context)
 {
-	bool t_success = true;
-	_thread_notify_info *t_info = NULL;
+	if (!s_resolver_initialized)
+	{
+		if (!resolver_platform_initialize())
+			return false;
+		s_resolver_initialized = true;
+	}
 
-	t_success = MCMemoryNew(t_info);
+	_resolver_job *t_job = NULL;
+	if (!MCMemoryNew(t_job))
+		return false;
 
-	if (t_success)
+	t_job->m_function = p_thread;
+	t_job->m_callback = p_callback;
+	t_job->m_context = p_context;
+
+	resolver_lock();
+
+	// Only start another worker if all the existing ones are busy.
+	bool t_success = true;
+	if (s_resolver_idle_count == 0 && s_resolver_thread_count < RESOLVER_THREAD_LIMIT)
 	{
-		t_info->m_function = p_thread;
-		t_info->m_callback = p_callback;
-		t_info->m_context = p_context;
+		if (platform_launch_thread(resolver_worker_thread, NULL))
+			s_resolver_thread_count += 1;
+		else
+			t_success = s_resolver_thread_count != 0;
+	}
 
-		t_success = platform_launch_thread(notify_thread, t_info);
+	if (t_success)
+	{
+		if (s_resolver_queue_tail != NULL)
+			s_resolver_queue_tail->m_next = t_job;
+		else
+			s_resolver_queue_head = t_job;
+		s_resolver_queue_tail = t_job;
 	}
 
+	resolver_unlock();
+
 	if (!t_success)
-		MCMemoryDelete(t_info);
+	{
+		MCMemoryDelete(t_job);
+		return false;
+	}
 
-	return t_success;
+	resolver_signal();
+	return true;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+// A lookup which is being performed on a resolver thread.
 struct _addrinfo_lookup_info
 {
+	MCNameRef m_key;
 	char *m_name;
 	char *m_port;
 	int m_socktype;
 
 	bool m_success;
 	addrinfo *m_addrinfo;
+};
 
+// A caller which is waiting for the outcome of a lookup.
+struct _hostname_resolve_waiter
+{
 	bool m_blocking;
 	bool m_finished;
+	bool m_success;
 	MCHostNameResolveCallback m_callback;
 	void *m_context;
+
+	// The cached outcome, when the lookup was answered from the cache.
+	bool m_resolved;
+	MCDnsAddressList m_addresses;
 };
 
 void free_addrinfo_lookup_info(_addrinfo_lookup_info *t_info)
 {
 	if (t_info)
 	{
+		MCValueRelease(t_info->m_key);
 		if (t_info->m_name)
 			MCCStringFree(t_info->m_name);
 		if (t_info->m_port)
@@ -269,6 +414,15 @@ void free_addrinfo_lookup_info(_addrinfo_lookup_info *t_info)
 	}
 }
 
+void free_hostname_resolve_waiter(_hostname_resolve_waiter *t_waiter)
+{
+	if (t_waiter)
+	{
+		MCDnsAddressListClear(t_waiter->m_addresses);
+		MCMemoryDelete(t_waiter);
+	}
+}
+
 void hostname_resolve_thread(void *p_context)
 {
 	_addrinfo_lookup_info *t_info = (_addrinfo_lookup_info*)p_context;
@@ -282,41 +436,68 @@ void hostname_resolve_thread(void *p_context)
 	t_info->m_success = t_success;
 }
 
-void hostname_resolve_notify_callback(void *p_context)
+// Passes the outcome of a lookup on to a waiter's callback.
+void hostname_resolve_deliver(_hostname_resolve_waiter *t_waiter, bool p_resolved, const MCDnsAddressList& p_addresses)
 {
-	_addrinfo_lookup_info *t_info = (_addrinfo_lookup_info*)p_context;
-
-	g_name_resolution_count -= 1;
-	
-	if (t_info->m_success)
+	if (p_resolved)
 	{
-		addrinfo *t_addrinfo = t_info->m_addrinfo;
-		if (t_info->m_callback != NULL)
+		if (t_waiter->m_callback != NULL)
 		{
 			bool t_continue = true;
-			addrinfo *t_node = t_addrinfo;
-
-			while (t_node != NULL && t_continue)
-			{
-				t_continue = t_info->m_callback(t_info->m_context, true, t_node->ai_next == NULL, t_node->ai_addr, t_node->ai_addrlen);
-				t_node = t_node->ai_next;
-			}
+			for (uindex_t i = 0; i < p_addresses.count && t_continue; i++)
+				t_continue = t_waiter->m_callback(t_waiter->m_context, true, i + 1 == p_addresses.count, p_addresses.addresses[i].addr, p_addresses.addresses[i].addrlen);
 		}
-		freeaddrinfo(t_addrinfo);
 	}
 	else
-		t_info->m_callback(t_info->m_context, false, true, NULL, 0);
+		t_waiter->m_callback(t_waiter->m_context, false, true, NULL, 0);
 
-	if (t_info->m_blocking)
+	t_waiter->m_success = p_resolved;
+
+	if (t_waiter->m_blocking)
 	{
-		t_info->m_finished = true;
+		t_waiter->m_finished = true;
 	}
 	else
-		free_addrinfo_lookup_info(t_info);
+		free_hostname_resolve_waiter(t_waiter);
 }
 
-bool MCSocketHostNameResolve(const char *p_name, const char *p_port, int p_socktype, bool p_blocking,
-							MCHostNameResolveCallback p_callback, void *p_context)
+void hostname_resolve_waiter_callback(void *p_context, bool p_resolved, const MCDnsAddressList& p_addresses)
+{
+	hostname_resolve_deliver((_hostname_resolve_waiter*)p_context, p_resolved, p_addresses);
+}
+
+void hostname_resolve_cached_notify_callback(void *p_context)
+{
+	_hostname_resolve_waiter *t_waiter = (_hostname_resolve_waiter*)p_context;
+	hostname_resolve_deliver(t_waiter, t_waiter->m_resolved, t_waiter->m_addresses);
+}
+
+void hostname_resolve_notify_callback(void *p_context)
+{
+	_addrinfo_lookup_info *t_info = (_addrinfo_lookup_info*)p_context;
+
+	g_name_resolution_count -= 1;
+
+	bool t_resolved = t_info->m_success;
+	MCDnsAddressList t_addresses;
+	t_addresses.addresses = NULL;
+	t_addresses.count = 0;
+	if (t_resolved)
+	{
+		for (addrinfo *t_node = t_info->m_addrinfo; t_node != NULL && t_resolved; t_node = t_node->ai_next)
+			t_resolved = MCDnsAddressListAppend(t_addresses, t_node->ai_addr, t_node->ai_addrlen);
+		freeaddrinfo(t_info->m_addrinfo);
+	}
+
+	// This caches the outcome and passes it on to everything waiting on it.
+	MCDnsCacheEndLookup(t_info->m_key, t_resolved, t_addresses);
+
+	MCDnsAddressListClear(t_addresses);
+	free_addrinfo_lookup_info(t_info);
+}
+
+// Starts the lookup which answers the given key.
+bool hostname_resolve_start(MCNameRef p_key, const char *p_name, const char *p_port, int p_socktype)
 {
 	_addrinfo_lookup_info *t_info = NULL;
 	bool t_success = true;
@@ -325,48 +506,133 @@ bool MCSocketHostNameResolve(const char *p_name, const char *p_port, int p_sockt
 
 	if (t_success)
 	{
+		t_info->m_key = MCValueRetain(p_key);
 		t_info->m_socktype = p_socktype;
 
-		t_info->m_finished = false;
-		t_info->m_blocking = p_blocking;
-
-		t_info->m_callback = p_callback;
-		t_info->m_context = p_context;
-
 		t_success = (MCCStringClone(p_name, t_info->m_name) &&
-			MCCStringClone(p_port, t_info->m_port));
+			(p_port == NULL || MCCStringClone(p_port, t_info->m_port)));
 	}
+
+	if (t_success)
+	{
+		g_name_resolution_count += 1;
     // SN-2014-12-16: [[ Bug 14181 ]] We can't notify on servers as there is no RunLoop.
     //  We do not create a thread to resolve the hostname.
-	if (t_success)
 #ifdef _SERVER
-    {
         hostname_resolve_thread((void*)t_info);
         hostname_resolve_notify_callback((void*)t_info);
-    }
 #else
 		t_success = launch_thread_with_notify(hostname_resolve_thread, hostname_resolve_notify_callback, t_info);
+		if (!t_success)
+			g_name_resolution_count -= 1;
 #endif
+	}
+
+	if (!t_success)
+		free_addrinfo_lookup_info(t_info);
+
+	return t_success;
+}
+
+bool MCSocketHostNameResolve(const char *p_name, const char *p_port, int p_socktype, bool p_blocking,
+							MCHostNameResolveCallback p_callback, void *p_context)
+{
+	bool t_success = true;
+
+	// Lookups are cached, and coalesced, on the name, port and socket type.
+	MCAutoStringRef t_key_string;
+	MCNewAutoNameRef t_key;
+	t_success = (MCStringFormat(&t_key_string, "%s:%s:%d", p_name, p_port != NULL ? p_port : "", p_socktype) &&
+		MCNameCreate(*t_key_string, &t_key));
+
+	_hostname_resolve_waiter *t_waiter = NULL;
+	if (t_success)
+		t_success = MCMemoryNew(t_waiter);
+
+	MCDnsLookupStatus t_status;
+	if (t_success)
+	{
+		t_waiter->m_finished = false;
+		t_waiter->m_blocking = p_blocking;
+
+		t_waiter->m_callback = p_callback;
+		t_waiter->m_context = p_context;
+
+		t_success = MCDnsCacheBeginLookup(*t_key, hostname_resolve_waiter_callback, t_waiter, t_status, t_waiter->m_resolved, t_waiter->m_addresses);
+	}
+
+	if (t_success && t_status == kMCDnsLookupStarted)
+	{
+		t_success = hostname_resolve_start(*t_key, p_name, p_port, p_socktype);
+		if (!t_success)
+			MCDnsCacheCancelLookup(*t_key);
+	}
+
+	if (t_success && t_status == kMCDnsLookupHit)
+	{
+		// Cached outcomes are still delivered asynchronously to non-blocking
+		// callers, as they may not expect the callback to run before we return.
+#ifndef _SERVER
+		if (!p_blocking)
+			t_success = MCNotifyPush(hostname_resolve_cached_notify_callback, t_waiter, false, false);
+		else
+#endif
+			hostname_resolve_cached_notify_callback(t_waiter);
+	}
+
 	if (t_success)
 	{
-		g_name_resolution_count += 1;
 		if (p_blocking)
 		{
-			while (!t_info->m_finished)
+			while (!t_waiter->m_finished)
 			{
 				// MW-2010-09-09: This call shouldn't allow dispatch.
 				MCscreen->wait(MCsockettimeout, false, true);
 			}
-			t_success = t_info->m_success;
-			free_addrinfo_lookup_info(t_info);
+			t_success = t_waiter->m_success;
+			free_hostname_resolve_waiter(t_waiter);
 		}
 	}
 	else
-		free_addrinfo_lookup_info(t_info);
+		free_hostname_resolve_waiter(t_waiter);
 	
 	return t_success;
 }
 
+void MCS_dns_cache_flush(void)
+{
+	MCDnsCacheFlush();
+}
+
+bool MCS_dns_cache_statistics(MCArrayRef& r_statistics)
+{
+	MCDnsCacheStatistics t_statistics;
+	MCDnsCacheGetStatistics(t_statistics);
+
+	MCAutoNumberRef t_hits, t_negative_hits, t_misses, t_coalesced, t_entries, t_pending, t_threads;
+	MCAutoArrayRef t_array;
+	if (!MCNumberCreateWithUnsignedInteger(t_statistics.hits, &t_hits) ||
+		!MCNumberCreateWithUnsignedInteger(t_statistics.negative_hits, &t_negative_hits) ||
+		!MCNumberCreateWithUnsignedInteger(t_statistics.misses, &t_misses) ||
+		!MCNumberCreateWithUnsignedInteger(t_statistics.coalesced, &t_coalesced) ||
+		!MCNumberCreateWithUnsignedInteger(t_statistics.entries, &t_entries) ||
+		!MCNumberCreateWithUnsignedInteger(t_statistics.pending, &t_pending) ||
+		!MCNumberCreateWithUnsignedInteger(s_resolver_thread_count, &t_threads) ||
+		!MCArrayCreateMutable(&t_array) ||
+		!MCArrayStoreValue(*t_array, false, MCNAME("hits"), *t_hits) ||
+		!MCArrayStoreValue(*t_array, false, MCNAME("negativeHits"), *t_negative_hits) ||
+		!MCArrayStoreValue(*t_array, false, MCNAME("misses"), *t_misses) ||
+		!MCArrayStoreValue(*t_array, false, MCNAME("coalesced"), *t_coalesced) ||
+		!MCArrayStoreValue(*t_array, false, MCNAME("entries"), *t_entries) ||
+		!MCArrayStoreValue(*t_array, false, MCNAME("pending"), *t_pending) ||
+		!MCArrayStoreValue(*t_array, false, MCNAME("threads"), *t_threads) ||
+		!t_array.MakeImmutable())
+		return false;
+
+	r_statistics = t_array.Take();
+	return true;
+}
+
 bool hostname_resolve_first_sockaddr_callback(void *p_context, bool p_resolved, bool p_final, struct sockaddr *p_addr, int p_addrlen)
 {
 	if (p_resolved)
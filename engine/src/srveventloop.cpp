@@ -0,0 +1,338 @@
+/* Copyright (C) 2003-2015 LiveCode Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+#include "prefix.h"
+
+#include "srveventloop.h"
+
+#if defined(_LINUX_SERVER)
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The maximum number of ready descriptors which are collected by one wait. Any
+// others are still ready, so are picked up by the next wait.
+#define EVENT_LOOP_MAX_EVENTS 64
+
+#define kMCServerEventLoopEventMask (kMCServerEventLoopRead | kMCServerEventLoopWrite)
+
+struct MCServerEventLoopEntry
+{
+	// The events declared for the next wait only.
+	uint32_t wanted;
+	// The events the handler (if any) is waiting for.
+	uint32_t handled;
+	// The events which are currently registered with epoll.
+	uint32_t registered;
+	// The events which were ready in the last wait.
+	uint32_t ready;
+	// Whether the descriptor is in s_watched_fds.
+	bool listed;
+	MCServerEventLoopCallback callback;
+	void *context;
+};
+
+static int s_epoll_fd = -1;
+static int s_wake_fd = -1;
+
+// The state of each descriptor, indexed by descriptor.
+static MCServerEventLoopEntry *s_entries = nil;
+static uindex_t s_entry_count = 0;
+
+// The descriptors which have been watched since the previous wait.
+static int *s_watched_fds = nil;
+static uindex_t s_watched_count = 0;
+static uindex_t s_watched_capacity = 0;
+
+// The descriptors which were ready in the last wait.
+static int s_ready_fds[EVENT_LOOP_MAX_EVENTS];
+static uindex_t s_ready_count = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool MCServerEventLoopInitialize(void)
+{
+	s_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (s_epoll_fd == -1)
+		return false;
+
+	s_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (s_wake_fd == -1)
+	{
+		MCServerEventLoopFinalize();
+		return false;
+	}
+
+	struct epoll_event t_event;
+	t_event . events = EPOLLIN;
+	t_event . data . u64 = 0;
+	t_event . data . fd = s_wake_fd;
+	if (epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, s_wake_fd, &t_event) != 0)
+	{
+		MCServerEventLoopFinalize();
+		return false;
+	}
+
+	return true;
+}
+
+void MCServerEventLoopFinalize(void)
+{
+	if (s_wake_fd != -1)
+		close(s_wake_fd);
+	s_wake_fd = -1;
+
+	if (s_epoll_fd != -1)
+		close(s_epoll_fd);
+	s_epoll_fd = -1;
+
+	MCMemoryDeleteArray(s_entries);
+	s_entries = nil;
+	s_entry_count = 0;
+
+	MCMemoryDeleteArray(s_watched_fds);
+	s_watched_fds = nil;
+	s_watched_count = 0;
+	s_watched_capacity = 0;
+
+	s_ready_count = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Changes the events registered with epoll for p_fd. If the registration is
+// out of step with epoll (because the descriptor has been closed and the
+// number reused) the other operation is tried instead.
+static void MCServerEventLoopRegister(int p_fd, MCServerEventLoopEntry& x_entry, uint32_t p_events)
+{
+	struct epoll_event t_event;
+	t_event . events = 0;
+	if ((p_events & kMCServerEventLoopRead) != 0)
+		t_event . events |= EPOLLIN;
+	if ((p_events & kMCServerEventLoopWrite) != 0)
+		t_event . events |= EPOLLOUT;
+	t_event . data . u64 = 0;
+	t_event . data . fd = p_fd;
+
+	int t_result;
+	if (p_events == 0)
+		t_result = epoll_ctl(s_epoll_fd, EPOLL_CTL_DEL, p_fd, &t_event);
+	else if (x_entry . registered == 0)
+	{
+		t_result = epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, p_fd, &t_event);
+		if (t_result != 0 && errno == EEXIST)
+			t_result = epoll_ctl(s_epoll_fd, EPOLL_CTL_MOD, p_fd, &t_event);
+	}
+	else
+	{
+		t_result = epoll_ctl(s_epoll_fd, EPOLL_CTL_MOD, p_fd, &t_event);
+		if (t_result != 0 && errno == ENOENT)
+			t_result = epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, p_fd, &t_event);
+	}
+
+	x_entry . registered = t_result == 0 ? p_events : 0;
+}
+
+// Makes sure there is an entry for p_fd.
+static bool MCServerEventLoopEnsureEntry(int p_fd)
+{
+	if (p_fd < 0 || s_epoll_fd == -1)
+		return false;
+
+	if ((uindex_t)p_fd >= s_entry_count)
+	{
+		uindex_t t_count;
+		t_count = s_entry_count == 0 ? 64 : s_entry_count;
+		while(t_count <= (uindex_t)p_fd)
+			t_count *= 2;
+		if (!MCMemoryResizeArray(t_count, s_entries, s_entry_count))
+			return false;
+	}
+
+	return true;
+}
+
+void MCServerEventLoopWatch(int p_fd, uint32_t p_events)
+{
+	if (!MCServerEventLoopEnsureEntry(p_fd))
+		return;
+
+	MCServerEventLoopEntry& t_entry = s_entries[p_fd];
+	if (!t_entry . listed)
+	{
+		if (s_watched_count == s_watched_capacity)
+		{
+			uindex_t t_capacity;
+			t_capacity = s_watched_capacity;
+			if (!MCMemoryResizeArray(t_capacity == 0 ? 16 : t_capacity * 2, s_watched_fds, t_capacity))
+				return;
+			s_watched_capacity = t_capacity;
+		}
+		s_watched_fds[s_watched_count++] = p_fd;
+		t_entry . listed = true;
+	}
+
+	// A descriptor can be watched more than once in a wait, so accumulate
+	// the events.
+	t_entry . wanted |= p_events & kMCServerEventLoopEventMask;
+}
+
+void MCServerEventLoopSetHandler(int p_fd, uint32_t p_events, MCServerEventLoopCallback p_callback, void *p_context)
+{
+	if (!MCServerEventLoopEnsureEntry(p_fd))
+		return;
+
+	MCServerEventLoopEntry& t_entry = s_entries[p_fd];
+	t_entry . handled = p_events & kMCServerEventLoopEventMask;
+	t_entry . callback = p_callback;
+	t_entry . context = p_context;
+
+	uint32_t t_events;
+	t_events = t_entry . handled | t_entry . wanted;
+	if (t_events != t_entry . registered)
+		MCServerEventLoopRegister(p_fd, t_entry, t_events);
+}
+
+void MCServerEventLoopUnwatch(int p_fd)
+{
+	if (p_fd < 0 || (uindex_t)p_fd >= s_entry_count)
+		return;
+
+	MCServerEventLoopEntry& t_entry = s_entries[p_fd];
+	if (t_entry . registered != 0)
+		MCServerEventLoopRegister(p_fd, t_entry, 0);
+	t_entry . wanted = 0;
+	t_entry . handled = 0;
+	t_entry . ready = 0;
+	t_entry . callback = nil;
+	t_entry . context = nil;
+}
+
+int MCServerEventLoopWait(real64_t p_timeout)
+{
+	if (s_epoll_fd == -1)
+		return -1;
+
+	for(uindex_t i = 0; i < s_ready_count; i++)
+		s_entries[s_ready_fds[i]] . ready = 0;
+	s_ready_count = 0;
+
+	// Descriptors with handlers are already registered, so only those
+	// watched for this wait need to be added.
+	for(uindex_t i = 0; i < s_watched_count; i++)
+	{
+		MCServerEventLoopEntry& t_entry = s_entries[s_watched_fds[i]];
+		uint32_t t_events;
+		t_events = t_entry . handled | t_entry . wanted;
+		if (t_events != t_entry . registered)
+			MCServerEventLoopRegister(s_watched_fds[i], t_entry, t_events);
+	}
+
+	int t_timeout;
+	if (p_timeout <= 0.0)
+		t_timeout = 0;
+	else if (p_timeout >= INT_MAX / 1000)
+		t_timeout = INT_MAX;
+	else
+		t_timeout = (int)ceil(p_timeout * 1000.0);
+
+	struct epoll_event t_events[EVENT_LOOP_MAX_EVENTS];
+	int t_ready;
+	t_ready = epoll_wait(s_epoll_fd, t_events, EVENT_LOOP_MAX_EVENTS, t_timeout);
+
+	for(int i = 0; i < t_ready; i++)
+	{
+		int t_fd;
+		t_fd = t_events[i] . data . fd;
+		if (t_fd == s_wake_fd)
+		{
+			uint64_t t_count;
+			read(s_wake_fd, &t_count, sizeof(t_count));
+			continue;
+		}
+
+		if ((uindex_t)t_fd >= s_entry_count)
+			continue;
+
+		MCServerEventLoopEntry& t_entry = s_entries[t_fd];
+		if ((t_events[i] . events & EPOLLIN) != 0)
+			t_entry . ready |= kMCServerEventLoopRead;
+		if ((t_events[i] . events & EPOLLOUT) != 0)
+			t_entry . ready |= kMCServerEventLoopWrite;
+		if ((t_events[i] . events & (EPOLLERR | EPOLLHUP)) != 0)
+			t_entry . ready |= t_entry . registered;
+		s_ready_fds[s_ready_count++] = t_fd;
+	}
+
+	// Descriptors watched for this wait are removed now, as they might be
+	// closed before the next one.
+	for(uindex_t i = 0; i < s_watched_count; i++)
+	{
+		MCServerEventLoopEntry& t_entry = s_entries[s_watched_fds[i]];
+		if (t_entry . handled != t_entry . registered)
+			MCServerEventLoopRegister(s_watched_fds[i], t_entry, t_entry . handled);
+		t_entry . wanted = 0;
+		t_entry . listed = false;
+	}
+	s_watched_count = 0;
+
+	if (t_ready < 0)
+		return -1;
+
+	return t_ready;
+}
+
+uint32_t MCServerEventLoopGetReadyEvents(int p_fd)
+{
+	if (p_fd < 0 || (uindex_t)p_fd >= s_entry_count)
+		return 0;
+
+	return s_entries[p_fd] . ready;
+}
+
+void MCServerEventLoopDispatch(void)
+{
+	// A handler can unwatch any descriptor (clearing its ready events), but
+	// the list of ready descriptors is only changed by the next wait.
+	for(uindex_t i = 0; i < s_ready_count; i++)
+	{
+		MCServerEventLoopEntry& t_entry = s_entries[s_ready_fds[i]];
+		uint32_t t_events;
+		t_events = t_entry . ready & t_entry . handled;
+		if (t_events != 0 && t_entry . callback != nil)
+			t_entry . callback(t_entry . context, t_events);
+	}
+}
+
+void MCServerEventLoopWake(void)
+{
+	if (s_wake_fd == -1)
+		return;
+
+	uint64_t t_count;
+	t_count = 1;
+	write(s_wake_fd, &t_count, sizeof(t_count));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,79 @@
+/* Copyright (C) 2003-2015 LiveCode Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+#ifndef SRVEVENTLOOP_H
+#define SRVEVENTLOOP_H
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The server event loop waits on all the file descriptors the Linux server
+// engine is interested in (sockets, URL loads and pipes) with a single epoll
+// instance, so that it does not need to rebuild and scan fd_sets on every
+// wait and is not limited to FD_SETSIZE descriptors. Notifications from other
+// threads wake the loop through an eventfd.
+//
+// Descriptors which are owned by code that knows about the loop (sockets) are
+// given a handler, and stay registered with epoll until their interest
+// changes - after each wait, only the handlers of the descriptors which are
+// ready are called. Other descriptors (which might be closed by code that
+// doesn't know about the loop) are watched for a single wait at a time.
+//
+// Apart from MCServerEventLoopWake, these functions must be called on the
+// main thread.
+
+enum
+{
+	kMCServerEventLoopRead = 1 << 0,
+	kMCServerEventLoopWrite = 1 << 1,
+};
+
+typedef void (*MCServerEventLoopCallback)(void *p_context, uint32_t p_events);
+
+bool MCServerEventLoopInitialize(void);
+void MCServerEventLoopFinalize(void);
+
+// Adds the given events to those to wait for on p_fd in the next wait only.
+void MCServerEventLoopWatch(int p_fd, uint32_t p_events);
+
+// Sets the events to wait for on p_fd in every wait from now on, and the
+// handler MCServerEventLoopDispatch calls when any of them are ready.
+void MCServerEventLoopSetHandler(int p_fd, uint32_t p_events, MCServerEventLoopCallback p_callback, void *p_context);
+
+// Stops watching p_fd and removes its handler - this must be called before
+// closing a descriptor which has a handler.
+void MCServerEventLoopUnwatch(int p_fd);
+
+// Waits for up to p_timeout seconds for any watched descriptor to become
+// ready, or for the loop to be woken. Returns the number of descriptors which
+// are ready, or -1 if the wait was interrupted by a signal.
+int MCServerEventLoopWait(real64_t p_timeout);
+
+// Returns the events which were ready on p_fd in the last wait. A descriptor
+// which has an error or has hung up is reported as ready for all the events
+// it was watched for.
+uint32_t MCServerEventLoopGetReadyEvents(int p_fd);
+
+// Calls the handler of each descriptor which was ready in the last wait with
+// the events it is ready for.
+void MCServerEventLoopDispatch(void);
+
+// Wakes the loop if it is waiting, or makes the next wait return immediately
+// if not. This can be called on any thread.
+void MCServerEventLoopWake(void);
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -41,6 +41,7 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "font.h"
 #include "libscript/script.h"
 #include "eventqueue.h"
+#include "srveventloop.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -643,6 +644,8 @@ void X_main_loop(void)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+extern void MCServerUrlFinalize(void);
+
 int platform_main(int argc, char *argv[], char *envp[])
 {
 	if (!MCInitialize() ||
@@ -685,13 +688,23 @@ int platform_main(int argc, char *argv[], char *envp[])
     t_options.argv = t_new_argv;
     t_options.envp = t_new_envp;
     t_options.app_code_path = nullptr;
+#if defined(_LINUX_SERVER)
+	if (!MCServerEventLoopInitialize())
+		exit(-1);
+#endif
 	if (!X_init(t_options))
 		exit(-1);
 	
 	X_main_loop();
 	
+	MCServerUrlFinalize();
+	
 	int t_exit_code;
 	t_exit_code = X_close();
+	
+#if defined(_LINUX_SERVER)
+	MCServerEventLoopFinalize();
+#endif
 
 	for (int t_arg = 0; t_arg < argc; t_arg++)
 	{
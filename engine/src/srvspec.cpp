@@ -36,6 +36,8 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "system.h"
 #include "srvdebug.h"
 #include "srvmain.h"
+#include "uidc.h"
+#include "eventqueue.h"
 
 #include "mcssl.h"
 
@@ -126,7 +128,40 @@ static CURLcode _set_ssl_certificates_callback(CURL *p_curl, void *p_ssl_ctx, vo
 	return CURLE_OK;
 }
 
-static void url_execute(MCStringRef p_url, MCUrlExecuteCallback p_callback, void *p_state, MCStringRef& r_error)
+////////////////////////////////////////////////////////////////////////////////
+
+// All transfers share their DNS cache, TLS sessions and - where libcurl
+// supports it - their open connections through a single share handle, so that
+// consecutive requests to the same host do not each pay for a new connection.
+static CURLSH *s_url_share = NULL;
+
+// Synchronous requests are performed with a single easy handle which is reset
+// between requests rather than recreated, so that its own connection cache
+// survives with versions of libcurl which cannot share connections.
+static CURL *s_url_handle = NULL;
+
+static bool url_initialize(void)
+{
+	if (s_url_share != NULL)
+		return true;
+	
+	s_url_share = curl_share_init();
+	if (s_url_share == NULL)
+		return false;
+	
+	curl_share_setopt(s_url_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+	curl_share_setopt(s_url_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+	curl_share_setopt(s_url_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+	
+	return true;
+}
+
+// Applies the options common to all requests to the given handle. Any header
+// list which is built is returned in r_headers, and must be kept until the
+// request has completed.
+static const char *url_configure(CURL *p_url_handle, MCStringRef p_url, char *p_error_buffer, curl_slist*& r_headers)
 {
 	const char *t_error;
 	t_error = NULL;
@@ -143,43 +178,34 @@ static void url_execute(MCStringRef p_url, MCUrlExecuteCallback p_callback, void
 			t_error = "couldn't build header list";
 	}
 	
-	CURL *t_url_handle;
-	t_url_handle = NULL;
 	if (t_error == NULL)
 	{
-		t_url_handle = curl_easy_init();
-		if (t_url_handle == NULL)
-			t_error = "couldn't create handle";
+		if (curl_easy_setopt(p_url_handle, CURLOPT_SHARE, s_url_share) != CURLE_OK)
+			t_error = "couldn't set share";
 	}
 	
 	if (t_error == NULL)
 	{
-		if (curl_easy_setopt(t_url_handle, CURLOPT_URL, MCStringGetCString(p_url)) != CURLE_OK)
+		if (curl_easy_setopt(p_url_handle, CURLOPT_URL, MCStringGetCString(p_url)) != CURLE_OK)
 			t_error = "couldn't set url";
 	}
 	
-	if (t_error == NULL)
-	{
-		if (curl_easy_setopt(t_url_handle, CURLOPT_WRITEFUNCTION, url_write_callback) != CURLE_OK)
-			t_error = "couldn't set callback";
-	}
-	
 	if (t_error == NULL && t_headers != NULL)
 	{
-		if (curl_easy_setopt(t_url_handle, CURLOPT_HTTPHEADER, t_headers) != CURLE_OK)
+		if (curl_easy_setopt(p_url_handle, CURLOPT_HTTPHEADER, t_headers) != CURLE_OK)
 			t_error = "couldn't set headers";
 	}
 	
 	if (t_error == NULL && t_is_https)
 	{
 		// IM-2014-07-28: [[ Bug 12822 ]] Override default ssl certificate loading.
-		if (curl_easy_setopt(t_url_handle, CURLOPT_SSL_VERIFYPEER, 1) != CURLE_OK ||
-			curl_easy_setopt(t_url_handle, CURLOPT_SSL_VERIFYHOST, 2) != CURLE_OK
+		if (curl_easy_setopt(p_url_handle, CURLOPT_SSL_VERIFYPEER, 1) != CURLE_OK ||
+			curl_easy_setopt(p_url_handle, CURLOPT_SSL_VERIFYHOST, 2) != CURLE_OK
 #if defined(_LINUX) || defined(_WIN32)
             // These options are not supported when using the OSX system libcurl
             // as it uses the OS' certificate database and not a cert file.
-			|| curl_easy_setopt(t_url_handle, CURLOPT_CAINFO, nil) != CURLE_OK
-			|| curl_easy_setopt(t_url_handle, CURLOPT_SSL_CTX_FUNCTION, _set_ssl_certificates_callback) != CURLE_OK
+			|| curl_easy_setopt(p_url_handle, CURLOPT_CAINFO, nil) != CURLE_OK
+			|| curl_easy_setopt(p_url_handle, CURLOPT_SSL_CTX_FUNCTION, _set_ssl_certificates_callback) != CURLE_OK
 #endif
             )
 			t_error = "couldn't configure ssl";
@@ -188,8 +214,8 @@ static void url_execute(MCStringRef p_url, MCUrlExecuteCallback p_callback, void
 	if (t_error == NULL)
 	{
 #if LIBCURL_VERSION_MINOR >= 19
-		if (curl_easy_setopt(t_url_handle, CURLOPT_REDIR_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS) != CURLE_OK ||
-			curl_easy_setopt(t_url_handle, CURLOPT_FOLLOWLOCATION, 1) != CURLE_OK)
+		if (curl_easy_setopt(p_url_handle, CURLOPT_REDIR_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS) != CURLE_OK ||
+			curl_easy_setopt(p_url_handle, CURLOPT_FOLLOWLOCATION, 1) != CURLE_OK)
 			t_error = "couldn't configure follow";
 #endif
 	}
@@ -198,18 +224,55 @@ static void url_execute(MCStringRef p_url, MCUrlExecuteCallback p_callback, void
 	if (t_error == NULL)
 	{
 		if (MCdefaultnetworkinterface != NULL)
-			if (curl_easy_setopt(t_url_handle, CURLOPT_INTERFACE, MCdefaultnetworkinterface) != CURLE_OK)
+			if (curl_easy_setopt(p_url_handle, CURLOPT_INTERFACE, MCdefaultnetworkinterface) != CURLE_OK)
 				t_error = "couldn't set network interface";
 	}
 	
+	if (t_error == NULL)
+		curl_easy_setopt(p_url_handle, CURLOPT_ERRORBUFFER, p_error_buffer);
+	
+	r_headers = t_headers;
+	
+	return t_error;
+}
+
+static void url_execute(MCStringRef p_url, MCUrlExecuteCallback p_callback, void *p_state, MCStringRef& r_error)
+{
+	const char *t_error;
+	t_error = NULL;
+	
+	bool t_is_http;
+	t_is_http = MCStringBeginsWithCString(p_url, (const char_t*)"http", kMCCompareExact);
+	
+	CURL *t_url_handle;
+	t_url_handle = NULL;
+	if (t_error == NULL)
+	{
+		if (url_initialize() && s_url_handle == NULL)
+			s_url_handle = curl_easy_init();
+		
+		t_url_handle = s_url_handle;
+		if (s_url_share == NULL || t_url_handle == NULL)
+			t_error = "couldn't create handle";
+	}
+	
+	char t_error_buffer[CURL_ERROR_SIZE];
+	curl_slist *t_headers;
+	t_headers = NULL;
+	if (t_error == NULL)
+		t_error = url_configure(t_url_handle, p_url, t_error_buffer, t_headers);
+	
+	if (t_error == NULL)
+	{
+		if (curl_easy_setopt(t_url_handle, CURLOPT_WRITEFUNCTION, url_write_callback) != CURLE_OK)
+			t_error = "couldn't set callback";
+	}
+	
 	if (t_error == NULL && p_callback != NULL)
 		t_error = p_callback(p_state, t_url_handle);
 	
 	if (t_error == NULL)
 	{
-		char t_error_buffer[CURL_ERROR_SIZE];
-		curl_easy_setopt(t_url_handle, CURLOPT_ERRORBUFFER, t_error_buffer);
-
 		MCurlresult -> clear();
 		MCresult -> clear();
 		if (curl_easy_perform(t_url_handle) == CURLE_OK)
@@ -238,12 +301,10 @@ static void url_execute(MCStringRef p_url, MCUrlExecuteCallback p_callback, void
 		}
 	}
 	
-	if (t_error == NULL && t_is_http)
-	{
-	}
-	
+	// Resetting the handle forgets this request's options (which reference the
+	// headers and error buffer) but keeps its connections open for the next.
 	if (t_url_handle != NULL)
-		curl_easy_cleanup(t_url_handle);
+		curl_easy_reset(t_url_handle);
 	
 	if (t_headers != NULL)
 		curl_slist_free_all(t_headers);
@@ -252,6 +313,337 @@ static void url_execute(MCStringRef p_url, MCUrlExecuteCallback p_callback, void
 	
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+// URLs fetched with 'load url' are transferred concurrently by a single multi
+// handle. The transfers progress whenever the engine waits, and fetching a URL
+// which is still loading drives all the loads until that one completes - so a
+// script can start loading a set of URLs and then collect them together. As
+// with the internet library, loaded URLs are kept until they are unloaded.
+
+struct MCUrlLoad
+{
+	MCUrlLoad *next;
+	MCStringRef url;
+	MCObjectHandle object;
+	MCNameRef message;
+	CURL *handle;
+	curl_slist *headers;
+	MCDataRef data;
+	MCStringRef error;
+	bool is_http;
+	bool finished;
+	char error_buffer[CURL_ERROR_SIZE];
+};
+
+static MCUrlLoad *s_url_loads = NULL;
+static uindex_t s_url_loads_pending = 0;
+static CURLM *s_url_multi = NULL;
+static MCRunloopActionRef s_url_loads_action = NULL;
+
+// The maximum number of connections which loads may open to any one host.
+#define URL_LOAD_HOST_CONNECTION_LIMIT 6
+
+// How long (in milliseconds) to wait for activity on the loads in progress
+// between checks for a URL which is being waited for.
+#define URL_LOAD_WAIT_INTERVAL 100
+
+class MCUrlLoadEvent: public MCCustomEvent
+{
+public:
+	MCUrlLoadEvent(MCUrlLoad *p_load)
+		: m_object(p_load -> object),
+		  m_message(MCValueRetain(p_load -> message)),
+		  m_url(MCValueRetain(p_load -> url)),
+		  m_data(MCValueRetain(p_load -> data)),
+		  m_error(p_load -> error != nil ? MCValueRetain(p_load -> error) : nil)
+	{
+	}
+	
+	void Destroy(void)
+	{
+		MCValueRelease(m_message);
+		MCValueRelease(m_url);
+		MCValueRelease(m_data);
+		MCValueRelease(m_error);
+		delete this;
+	}
+	
+	void Dispatch(void)
+	{
+		if (!m_object . IsValid())
+			return;
+		
+		if (m_error != nil)
+			m_object -> message_with_valueref_args(m_message, m_url, MCSTR("error"), m_error);
+		else
+		{
+			MCAutoNumberRef t_length;
+			/* UNCHECKED */ MCNumberCreateWithUnsignedInteger(MCDataGetLength(m_data), &t_length);
+			m_object -> message_with_valueref_args(m_message, m_url, MCSTR("downloaded"), m_data, *t_length);
+		}
+	}
+	
+private:
+	MCObjectHandle m_object;
+	MCNameRef m_message;
+	MCStringRef m_url;
+	MCDataRef m_data;
+	MCStringRef m_error;
+};
+
+static size_t url_load_write_callback(void *p_buffer, size_t p_size, size_t p_count, void *p_context)
+{
+	MCUrlLoad *t_load;
+	t_load = static_cast<MCUrlLoad *>(p_context);
+	if (!MCDataAppendBytes(t_load -> data, (const byte_t *)p_buffer, p_size * p_count))
+		return 0;
+	return p_size * p_count;
+}
+
+static MCUrlLoad *url_load_find(MCStringRef p_url)
+{
+	for(MCUrlLoad *t_load = s_url_loads; t_load != NULL; t_load = t_load -> next)
+		if (MCStringIsEqualTo(t_load -> url, p_url, kMCStringOptionCompareExact))
+			return t_load;
+	return NULL;
+}
+
+static void url_load_finish(MCUrlLoad *p_load, CURLcode p_result)
+{
+	if (p_result != CURLE_OK)
+		/* UNCHECKED */ MCStringFormat(p_load -> error, "error %s", p_load -> error_buffer);
+	else if (p_load -> is_http)
+	{
+		long t_code;
+		if (curl_easy_getinfo(p_load -> handle, CURLINFO_RESPONSE_CODE, &t_code) != CURLE_OK)
+			/* UNCHECKED */ MCStringCreateWithCString("couldn't fetch response code", p_load -> error);
+		else if (t_code != 200)
+			/* UNCHECKED */ MCStringFormat(p_load -> error, "error %ld", t_code);
+	}
+	
+	curl_multi_remove_handle(s_url_multi, p_load -> handle);
+	curl_easy_cleanup(p_load -> handle);
+	p_load -> handle = NULL;
+	
+	if (p_load -> headers != NULL)
+		curl_slist_free_all(p_load -> headers);
+	p_load -> headers = NULL;
+	
+	p_load -> finished = true;
+	s_url_loads_pending -= 1;
+	
+	if (p_load -> message != nil)
+	{
+		MCUrlLoadEvent *t_event;
+		t_event = new (nothrow) MCUrlLoadEvent(p_load);
+		if (t_event != nil && !MCEventQueuePostCustom(t_event))
+			t_event -> Destroy();
+	}
+}
+
+static void url_load_destroy(MCUrlLoad *p_load)
+{
+	if (p_load -> handle != NULL)
+	{
+		curl_multi_remove_handle(s_url_multi, p_load -> handle);
+		curl_easy_cleanup(p_load -> handle);
+		s_url_loads_pending -= 1;
+	}
+	
+	if (p_load -> headers != NULL)
+		curl_slist_free_all(p_load -> headers);
+	
+	MCValueRelease(p_load -> url);
+	MCValueRelease(p_load -> message);
+	MCValueRelease(p_load -> data);
+	MCValueRelease(p_load -> error);
+	delete p_load;
+}
+
+static void url_loads_runloop_action(void *p_context);
+
+// Waits up to p_timeout milliseconds for activity on any of the loads, then
+// advances them all and finishes any which have completed.
+static void url_loads_perform(int p_timeout)
+{
+	if (s_url_loads_pending != 0)
+	{
+		if (p_timeout > 0)
+			curl_multi_wait(s_url_multi, NULL, 0, p_timeout, NULL);
+		
+		int t_running;
+		curl_multi_perform(s_url_multi, &t_running);
+		
+		CURLMsg *t_message;
+		int t_remaining;
+		while((t_message = curl_multi_info_read(s_url_multi, &t_remaining)) != NULL)
+		{
+			if (t_message -> msg != CURLMSG_DONE)
+				continue;
+			
+			// The message is invalidated when its handle is removed.
+			CURL *t_handle;
+			t_handle = t_message -> easy_handle;
+			CURLcode t_result;
+			t_result = t_message -> data . result;
+			
+			for(MCUrlLoad *t_load = s_url_loads; t_load != NULL; t_load = t_load -> next)
+				if (t_load -> handle == t_handle)
+				{
+					url_load_finish(t_load, t_result);
+					break;
+				}
+		}
+	}
+	
+	// Nothing more needs to be done while the engine waits until another load
+	// is started.
+	if (s_url_loads_pending == 0 && s_url_loads_action != NULL)
+	{
+		MCscreen -> RemoveRunloopAction(s_url_loads_action);
+		s_url_loads_action = NULL;
+	}
+}
+
+static void url_loads_runloop_action(void *p_context)
+{
+	url_loads_perform(0);
+}
+
+static bool url_load_start(MCObject *p_object, MCStringRef p_url, MCNameRef p_message)
+{
+	if (!url_initialize())
+		return false;
+	
+	if (s_url_multi == NULL)
+	{
+		s_url_multi = curl_multi_init();
+		if (s_url_multi == NULL)
+			return false;
+		
+#if LIBCURL_VERSION_NUM >= 0x071e00
+		curl_multi_setopt(s_url_multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)URL_LOAD_HOST_CONNECTION_LIMIT);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x072b00
+		curl_multi_setopt(s_url_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+	}
+	
+	MCUrlLoad *t_load;
+	t_load = new (nothrow) MCUrlLoad();
+	if (t_load == NULL)
+		return false;
+	
+	t_load -> url = MCValueRetain(p_url);
+	t_load -> object = p_object -> GetHandle();
+	if (p_message != nil && !MCNameIsEmpty(p_message))
+		t_load -> message = MCValueRetain(p_message);
+	t_load -> is_http = MCStringBeginsWithCString(p_url, (const char_t*)"http", kMCCompareExact);
+	
+	bool t_success;
+	t_success = MCDataCreateMutable(0, t_load -> data);
+	
+	if (t_success)
+	{
+		t_load -> handle = curl_easy_init();
+		t_success = t_load -> handle != NULL;
+	}
+	
+	if (t_success)
+		t_success = url_configure(t_load -> handle, p_url, t_load -> error_buffer, t_load -> headers) == NULL &&
+					curl_easy_setopt(t_load -> handle, CURLOPT_WRITEFUNCTION, url_load_write_callback) == CURLE_OK &&
+					curl_easy_setopt(t_load -> handle, CURLOPT_WRITEDATA, t_load) == CURLE_OK &&
+					curl_multi_add_handle(s_url_multi, t_load -> handle) == CURLM_OK;
+	
+	if (!t_success)
+	{
+		if (t_load -> handle != NULL)
+			curl_easy_cleanup(t_load -> handle);
+		t_load -> handle = NULL;
+		url_load_destroy(t_load);
+		return false;
+	}
+	
+	t_load -> next = s_url_loads;
+	s_url_loads = t_load;
+	s_url_loads_pending += 1;
+	
+	if (s_url_loads_action == NULL)
+		/* UNCHECKED */ MCscreen -> AddRunloopAction(url_loads_runloop_action, NULL, s_url_loads_action);
+	
+	// Start connecting straight away.
+	url_loads_perform(0);
+	
+	return true;
+}
+
+// Sets the url result to that of the given load, waiting for it to complete if
+// necessary.
+static void url_load_fetch(MCUrlLoad *p_load)
+{
+	while(!p_load -> finished)
+		url_loads_perform(URL_LOAD_WAIT_INTERVAL);
+	
+	MCAutoStringRef t_data;
+	/* UNCHECKED */ MCStringCreateWithNativeChars(MCDataGetBytePtr(p_load -> data), MCDataGetLength(p_load -> data), &t_data);
+	MCExecContext ctxt;
+	MCurlresult -> set(ctxt, *t_data);
+	
+	if (p_load -> error != nil)
+		MCresult -> setvalueref(p_load -> error);
+	else
+		MCresult -> clear();
+}
+
+// Called from the server's select loop to wake it when any of the loads in
+// progress has activity.
+void MCServerUrlLoadsPreSelect(int& x_maxfd, fd_set& x_rfds, fd_set& x_wfds, fd_set& x_efds)
+{
+	if (s_url_loads_pending == 0)
+		return;
+	
+	int t_maxfd;
+	t_maxfd = -1;
+	if (curl_multi_fdset(s_url_multi, &x_rfds, &x_wfds, &x_efds, &t_maxfd) == CURLM_OK &&
+		t_maxfd > x_maxfd)
+		x_maxfd = t_maxfd;
+}
+
+void MCServerUrlLoadsPostSelect(void)
+{
+	url_loads_perform(0);
+}
+
+void MCServerUrlFinalize(void)
+{
+	while(s_url_loads != NULL)
+	{
+		MCUrlLoad *t_load;
+		t_load = s_url_loads;
+		s_url_loads = t_load -> next;
+		url_load_destroy(t_load);
+	}
+	
+	if (s_url_loads_action != NULL)
+		MCscreen -> RemoveRunloopAction(s_url_loads_action);
+	s_url_loads_action = NULL;
+	
+	if (s_url_multi != NULL)
+		curl_multi_cleanup(s_url_multi);
+	s_url_multi = NULL;
+	
+	if (s_url_handle != NULL)
+		curl_easy_cleanup(s_url_handle);
+	s_url_handle = NULL;
+	
+	if (s_url_share != NULL)
+		curl_share_cleanup(s_url_share);
+	s_url_share = NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void MCS_geturl(MCObject *p_target, MCStringRef p_url)
 {
 
@@ -263,7 +655,16 @@ void MCS_geturl(MCObject *p_target, MCStringRef p_url)
 			/* UNCHECKED */ MCStringCreateWithCString("unsupported protocol", &t_error);
 	}
 	
+	// A URL which has been loaded is fetched from the cache, waiting for it
+	// to finish loading if necessary.
+	MCUrlLoad *t_load;
+	t_load = NULL;
 	if (MCStringIsEmpty(*t_error))
+		t_load = url_load_find(p_url);
+	
+	if (t_load != NULL)
+		url_load_fetch(t_load);
+	else if (MCStringIsEmpty(*t_error))
 	{
 		url_execute(p_url, NULL, NULL, &t_error);
 	}
@@ -443,10 +844,41 @@ void MCS_deleteurl(MCObject *p_target, MCStringRef p_url)
 
 void MCS_unloadurl(MCObject *p_object, MCStringRef p_url)
 {
+	MCresult -> clear();
+	
+	for(MCUrlLoad **t_link = &s_url_loads; *t_link != NULL; t_link = &(*t_link) -> next)
+		if (MCStringIsEqualTo((*t_link) -> url, p_url, kMCStringOptionCompareExact))
+		{
+			MCUrlLoad *t_load;
+			t_load = *t_link;
+			*t_link = t_load -> next;
+			url_load_destroy(t_load);
+			return;
+		}
 }
 
 void MCS_loadurl(MCObject *p_object, MCStringRef p_url, MCNameRef p_message)
 {
+	if (!MCStringBeginsWithCString(p_url, (const char_t*)"https:", kMCCompareExact) && !MCStringBeginsWithCString(p_url, (const char_t*)"http:", kMCCompareExact) && !MCStringBeginsWithCString(p_url, (const char_t*)"ftp:", kMCCompareExact))
+	{
+		MCresult -> sets("unsupported protocol");
+		return;
+	}
+	
+	// Loading a URL which is already loaded (or loading) leaves it as it is.
+	if (url_load_find(p_url) != NULL)
+	{
+		MCresult -> clear();
+		return;
+	}
+	
+	if (url_load_start(p_object, p_url, p_message))
+		MCresult -> clear();
+	else
+	{
+		MCurlresult -> clear();
+		MCresult -> sets("error: load URL failed");
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -50,6 +50,7 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "redraw.h"
 #include "region.h"
 #include "tilecache.h"
+#include "bitmapeffect.h"
 #include "stacksecurity.h"
 
 #include "context.h"
@@ -2831,6 +2832,11 @@ void MCStack::dirtyall(void)
 	//   data.
 	view_flushtilecache();
 
+	// Any blurs cached for bitmap effects must be recomputed too, as must
+	//   any recorded drawing of controls.
+	MCBitmapEffectsInvalidateCaches();
+	MCControl::layer_invalidatedisplaylists();
+
 	// MW-2011-09-21: [[ Layers ]] Make sure all the layers on the current card
 	//   recompute their id's and other attrs.
 	MCObjptr *t_objptr;
@@ -42,6 +42,7 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #include "graphics.h"
 #include "resolution.h"
+#include "combiners.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -49,6 +50,10 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #define DISSOLVE_SIZE 16
 #define DISSOLVE_MASK 15
 
+// Dissolves are blended in bands of at least this many pixels, which are
+// shared between the graphics worker threads.
+#define DISSOLVE_MIN_BAND_PIXELS 65536
+
 static uint2 Checkersize = 64;
 static uint2 Venetiansize = 64;
 #if INCLUDE_ZOOM_EFFECT
@@ -415,14 +420,31 @@ void MCStack::effectrect(const MCRectangle& p_area, Boolean& r_abort)
 			double t_start_time;
 			t_start_time = 0.0;
 			
+			// The time it takes to draw a frame, averaged over the recent
+			// frames. Each frame is drawn for the time at which it will appear,
+			// so when drawing is slow frames are skipped and the effect still
+			// finishes on time.
+			double t_frame_time;
+			t_frame_time = 0.0;
+			
 			for(;;)
 			{
 				t_context.delta = t_delta;
 				
+				double t_frame_start;
+				t_frame_start = MCS_time();
+				
 				view_platform_updatewindowwithcallback(t_effect_region, MCStackRenderEffect, &t_context);
 				
                 MCscreen -> sync(getw());
 				
+				double t_frame_end;
+				t_frame_end = MCS_time();
+				if (t_frame_time == 0.0)
+					t_frame_time = t_frame_end - t_frame_start;
+				else
+					t_frame_time = (t_frame_time * 3 + (t_frame_end - t_frame_start)) / 4;
+				
 				// Update the window's blendlevel (if needed)
 				if (old_blendlevel != blendlevel)
 				{
@@ -448,9 +470,10 @@ void MCStack::effectrect(const MCRectangle& p_area, Boolean& r_abort)
 				double t_now;
 				t_now = MCS_time();
 				
-				// Compute the new delta value.
+				// Compute the new delta value, which is the time at which the
+				// next frame will have been drawn.
 				uint32_t t_new_delta;
-				t_new_delta = (uint32_t)ceil((t_now - t_start_time) * 1000.0);
+				t_new_delta = (uint32_t)ceil((t_now + t_frame_time - t_start_time) * 1000.0);
 				
 				// If the new value is same as the old, then advance one step.
 				if (t_new_delta == t_delta)
@@ -462,9 +485,9 @@ void MCStack::effectrect(const MCRectangle& p_area, Boolean& r_abort)
 				if (t_delta > t_duration)
 					t_delta = t_duration;
 				
-				// Wait until the next boundary, making sure we break for no reason
-				// other than abort.
-				if (MCscreen -> wait((t_start_time + (t_delta / 1000.0)) - t_now, False, False))
+				// Wait until the next frame must be started to appear on the next
+				// boundary, making sure we break for no reason other than abort.
+				if (MCscreen -> wait(MCMax(0.0, (t_start_time + (t_delta / 1000.0)) - t_frame_time - t_now), False, False))
 					r_abort = True;
 				
 				// If we aborted, we render the final step and are thus done.
@@ -596,8 +619,95 @@ Boolean checkerboardeffect_step(const MCRectangle &drect, MCStackSurface *p_targ
 	return True;
 }
 
+struct MCStackEffectDissolveBands
+{
+	MCGRaster target;
+	MCGRaster start;
+	MCGRaster end;
+	surface_combiner_t combiner;
+	uint32_t band_height;
+	uint8_t opacity;
+};
+
+static void MCStackEffectDissolveBand(void *p_context, uint32_t p_index)
+{
+	MCStackEffectDissolveBands *t_bands;
+	t_bands = static_cast<MCStackEffectDissolveBands *>(p_context);
+	
+	uint32_t t_top, t_height;
+	t_top = p_index * t_bands -> band_height;
+	t_height = MCMin(t_bands -> band_height, t_bands -> target . height - t_top);
+	
+	uint8_t *t_target_pixels;
+	const uint8_t *t_start_pixels, *t_end_pixels;
+	t_target_pixels = static_cast<uint8_t *>(t_bands -> target . pixels) + t_top * t_bands -> target . stride;
+	t_start_pixels = static_cast<const uint8_t *>(t_bands -> start . pixels) + t_top * t_bands -> start . stride;
+	t_end_pixels = static_cast<const uint8_t *>(t_bands -> end . pixels) + t_top * t_bands -> end . stride;
+	
+	for(uint32_t y = 0; y < t_height; y++)
+		memcpy(t_target_pixels + y * t_bands -> target . stride, t_start_pixels + y * t_bands -> start . stride, t_bands -> target . width * sizeof(uint32_t));
+	
+	t_bands -> combiner(t_target_pixels, t_bands -> target . stride, t_end_pixels, t_bands -> end . stride, t_bands -> target . width, t_height, t_bands -> opacity);
+}
+
+// Blends the start and end images straight into the target's pixels, using the
+// (vectorised) blend combiner. Returns false if the target's pixels or the
+// images can't be accessed directly, in which case nothing has been drawn.
+static bool MCStackEffectDissolvePixels(const MCRectangle &drect, MCStackSurface *p_target, MCGImageRef p_start, MCGImageRef p_end, uint8_t p_opacity)
+{
+	MCStackEffectDissolveBands t_bands;
+	
+	// The start image must be opaque, as it replaces the target's pixels.
+	if (!MCGImageGetRaster(p_start, t_bands . start) ||
+		!MCGImageGetRaster(p_end, t_bands . end) ||
+		t_bands . start . format != kMCGRasterFormat_xRGB ||
+		(t_bands . end . format != kMCGRasterFormat_xRGB && t_bands . end . format != kMCGRasterFormat_ARGB) ||
+		t_bands . start . width < drect . width || t_bands . start . height < drect . height ||
+		t_bands . end . width < drect . width || t_bands . end . height < drect . height)
+		return false;
+	
+	MCGIntegerRectangle t_area, t_locked_area;
+	t_area = MCGIntegerRectangleMake(drect . x, drect . y, drect . width, drect . height);
+	if (!p_target -> LockPixels(t_area, t_bands . target, t_locked_area))
+		return false;
+	
+	// Only draw this way if the whole area is available, and in a format the
+	// combiners understand.
+	if (t_locked_area . origin . x != t_area . origin . x || t_locked_area . origin . y != t_area . origin . y ||
+		t_locked_area . size . width != t_area . size . width || t_locked_area . size . height != t_area . size . height ||
+		(t_bands . target . format != kMCGRasterFormat_xRGB && t_bands . target . format != kMCGRasterFormat_ARGB))
+	{
+		p_target -> UnlockPixels(t_locked_area, t_bands . target);
+		return false;
+	}
+	
+	if (t_bands . target . format == kMCGRasterFormat_xRGB)
+		t_bands . combiner = s_surface_combiners_nda[GXblendSrcOver];
+	else
+		t_bands . combiner = s_surface_combiners[GXblendSrcOver];
+	t_bands . opacity = p_opacity;
+	
+	uint32_t t_band_count;
+	t_band_count = MCMin(MCGParallelGetThreadCount(), MCMax(1U, ((uint32_t)drect . width * drect . height) / DISSOLVE_MIN_BAND_PIXELS));
+	t_band_count = MCMin(t_band_count, (uint32_t)drect . height);
+	t_bands . band_height = (drect . height + t_band_count - 1) / t_band_count;
+	t_band_count = (drect . height + t_bands . band_height - 1) / t_bands . band_height;
+	
+	MCGParallelFor(t_band_count, MCStackEffectDissolveBand, &t_bands);
+	
+	p_target -> UnlockPixels(t_locked_area, t_bands . target);
+	
+	return true;
+}
+
 Boolean dissolveeffect_step(const MCRectangle &drect, MCStackSurface *p_target, MCGImageRef p_start, MCGImageRef p_end, Visual_effects dir, uint4 delta, uint4 duration)
 {
+	if (drect . width == 0 || drect . height == 0)
+		return True;
+	
+	if (MCStackEffectDissolvePixels(drect, p_target, p_start, p_end, uint8_t(delta * 255 / duration)))
+		return True;
+	
 	MCGFloat t_alpha;
 	t_alpha = (MCGFloat)delta / (MCGFloat)duration;
 	
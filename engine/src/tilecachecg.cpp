@@ -25,6 +25,7 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "stack.h"
 #include "region.h"
 #include "tilecache.h"
+#include "combiners.h"
 
 #ifdef _IOS_MOBILE
 #include <CoreGraphics/CoreGraphics.h>
@@ -43,9 +44,6 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 extern CGBitmapInfo MCGPixelFormatToCGBitmapInfo(uint32_t p_pixel_format, bool p_alpha);
 extern bool MCImageGetCGColorSpace(CGColorSpaceRef &r_colorspace);
 
-typedef void (*surface_combiner_t)(void *p_dst, int32_t p_dst_stride, const void *p_src, uint4 p_src_stride, uint4 p_width, uint4 p_height, uint1 p_opacity);
-extern surface_combiner_t s_surface_combiners_nda[];
-
 struct MCTileCacheCoreGraphicsCompositorContext
 {
 	// The tilecache
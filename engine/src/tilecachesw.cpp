@@ -25,14 +25,12 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include "stack.h"
 #include "region.h"
 #include "tilecache.h"
+#include "combiners.h"
 
 #include "graphics_util.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
-typedef void (*surface_combiner_t)(void *p_dst, int32_t p_dst_stride, const void *p_src, uint4 p_src_stride, uint4 p_width, uint4 p_height, uint1 p_opacity);
-extern surface_combiner_t s_surface_combiners_nda[];
-
 struct MCTileCacheSoftwareCompositorContext
 {
 	// The tilecache
@@ -1383,7 +1383,7 @@ LRESULT CALLBACK MCWindowProc(HWND hwnd, UINT msg, WPARAM wParam,
 		break;
 	case WM_USER:
 		{
-			uint2 i;
+			uint4 i;
 			for (i = 0 ; i < MCnsockets ; i++)
 			{
 				if (MCsockets[i]->fd == 0)
@@ -0,0 +1,218 @@
+/* Copyright (C) 2003-2017 LiveCode Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+#include "gtest/gtest.h"
+
+#include "prefix.h"
+#include "bsdiff.h"
+
+#include <vector>
+
+/* Streams over byte vectors, for building and applying patches in memory. */
+
+struct MemoryInputStream: public MCBsDiffInputStream
+{
+	const std::vector<uint8_t> *data;
+	uint32_t position;
+
+	MemoryInputStream(const std::vector<uint8_t>& p_data)
+		: data(&p_data), position(0)
+	{
+	}
+
+	bool Measure(uint32_t& r_size)
+	{
+		r_size = data -> size();
+		return true;
+	}
+
+	bool ReadBytes(void *p_buffer, uint32_t p_count)
+	{
+		if (p_count > data -> size() - position)
+			return false;
+		if (p_count != 0)
+			MCMemoryCopy(p_buffer, &(*data)[position], p_count);
+		position += p_count;
+		return true;
+	}
+
+	bool ReadInt32(int32_t& r_value)
+	{
+		return ReadBytes(&r_value, sizeof(int32_t));
+	}
+};
+
+struct MemoryOutputStream: public MCBsDiffOutputStream
+{
+	std::vector<uint8_t> data;
+	uint32_t position;
+
+	MemoryOutputStream(void)
+		: position(0)
+	{
+	}
+
+	bool Rewind(void)
+	{
+		position = 0;
+		return true;
+	}
+
+	bool WriteBytes(const void *p_buffer, uint32_t p_count)
+	{
+		if (position + p_count > data . size())
+			data . resize(position + p_count);
+		if (p_count != 0)
+			MCMemoryCopy(&data[position], p_buffer, p_count);
+		position += p_count;
+		return true;
+	}
+
+	bool WriteInt32(int32_t p_value)
+	{
+		return WriteBytes(&p_value, sizeof(int32_t));
+	}
+};
+
+static uint32_t s_random = 1;
+
+static uint8_t random_byte(void)
+{
+	s_random = s_random * 1103515245 + 12345;
+	return (s_random >> 16) & 0xff;
+}
+
+/* Returns text-like data, which has plenty of repeated runs for the suffix
+ * sort and the scan to find. */
+static std::vector<uint8_t> random_data(uint32_t p_length)
+{
+	static const char kWords[] = "on mouseUp put the long name of me into field 1 end mouseUp ";
+	std::vector<uint8_t> t_data(p_length);
+	for (uint32_t i = 0; i < p_length; i++)
+		t_data[i] = random_byte() % 16 == 0 ? random_byte() : kWords[i % (sizeof(kWords) - 1)];
+	return t_data;
+}
+
+/* Returns a copy of the data with some bytes changed, and some runs inserted
+ * and removed. */
+static std::vector<uint8_t> edit_data(const std::vector<uint8_t>& p_data)
+{
+	std::vector<uint8_t> t_data(p_data);
+	int t_edits = 1 + random_byte() % 12;
+	for (int i = 0; i < t_edits && !t_data . empty(); i++)
+	{
+		size_t t_offset = ((random_byte() << 8) | random_byte()) % t_data . size();
+		size_t t_length = random_byte() % 100;
+		switch (random_byte() % 3)
+		{
+			case 0:
+				t_data[t_offset] ^= 1 + random_byte() % 255;
+				break;
+			case 1:
+			{
+				std::vector<uint8_t> t_run(random_data(t_length));
+				t_data . insert(t_data . begin() + t_offset, t_run . begin(), t_run . end());
+			}
+				break;
+			case 2:
+				t_data . erase(t_data . begin() + t_offset, t_data . begin() + MCMin(t_data . size(), t_offset + t_length));
+				break;
+		}
+	}
+	return t_data;
+}
+
+/* Builds a patch from p_old to p_new, with the new file diffed in chunks of
+ * the given size (or as MCBsDiffBuild() does if it is 0), applies it to p_old
+ * and checks the result is p_new. */
+static void check_round_trip(const std::vector<uint8_t>& p_old, const std::vector<uint8_t>& p_new, uint32_t p_chunk_size)
+{
+	SCOPED_TRACE(testing::Message() << "old " << p_old . size() << " bytes, new " << p_new . size() << " bytes, chunk size " << p_chunk_size);
+
+	MemoryInputStream t_old_stream(p_old), t_new_stream(p_new);
+	MemoryOutputStream t_patch_stream;
+	bool t_built;
+	if (p_chunk_size == 0)
+		t_built = MCBsDiffBuild(&t_old_stream, &t_new_stream, &t_patch_stream);
+	else
+		t_built = MCBsDiffBuildInChunks(&t_old_stream, &t_new_stream, &t_patch_stream, p_chunk_size);
+	ASSERT_TRUE(t_built);
+
+	MemoryInputStream t_patch_input(t_patch_stream . data), t_input(p_old);
+	MemoryOutputStream t_output;
+	ASSERT_TRUE(MCBsDiffApply(&t_patch_input, &t_input, &t_output));
+	EXPECT_TRUE(t_output . data == p_new);
+}
+
+TEST(bsdiff, empty_files)
+{
+	std::vector<uint8_t> t_empty, t_data(random_data(300));
+
+	check_round_trip(t_empty, t_empty, 0);
+	check_round_trip(t_empty, t_data, 0);
+	check_round_trip(t_data, t_empty, 0);
+	check_round_trip(t_empty, t_data, 64);
+	check_round_trip(t_data, t_empty, 64);
+}
+
+TEST(bsdiff, small_files)
+{
+	for (int i = 0; i < 50; i++)
+	{
+		std::vector<uint8_t> t_old(random_data(1 + random_byte() * 8));
+		check_round_trip(t_old, t_old, 0);
+		check_round_trip(t_old, edit_data(t_old), 0);
+		check_round_trip(t_old, random_data(random_byte() * 8), 0);
+	}
+}
+
+/* With a small chunk size, the files are diffed in many chunks, so the seek
+ * at the end of each chunk has to take the old position to where the next
+ * chunk starts from. This includes new files which end on a chunk boundary,
+ * and chunks of a single byte. */
+TEST(bsdiff, multiple_chunks)
+{
+	static const uint32_t kChunkSizes[] = { 1, 7, 64, 333, 4096 };
+
+	for (int i = 0; i < 20; i++)
+	{
+		std::vector<uint8_t> t_old(random_data(200 + random_byte() * 16));
+		std::vector<uint8_t> t_new(edit_data(t_old));
+		for (size_t j = 0; j < sizeof(kChunkSizes) / sizeof(kChunkSizes[0]); j++)
+			check_round_trip(t_old, t_new, kChunkSizes[j]);
+
+		t_new . resize(t_new . size() / 64 * 64);
+		check_round_trip(t_old, t_new, 64);
+	}
+}
+
+/* A new file which fits in one chunk gives the same patch whatever the chunk
+ * size. */
+TEST(bsdiff, single_chunk_matches_default)
+{
+	std::vector<uint8_t> t_old(random_data(3000));
+	std::vector<uint8_t> t_new(edit_data(t_old));
+
+	MemoryInputStream t_old_stream(t_old), t_new_stream(t_new);
+	MemoryOutputStream t_patch;
+	ASSERT_TRUE(MCBsDiffBuild(&t_old_stream, &t_new_stream, &t_patch));
+
+	MemoryInputStream t_old_chunked_stream(t_old), t_new_chunked_stream(t_new);
+	MemoryOutputStream t_chunked_patch;
+	ASSERT_TRUE(MCBsDiffBuildInChunks(&t_old_chunked_stream, &t_new_chunked_stream, &t_chunked_patch, t_new . size()));
+
+	EXPECT_TRUE(t_patch . data == t_chunked_patch . data);
+}
@@ -0,0 +1,134 @@
+/* Copyright (C) 2003-2017 LiveCode Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+#include "gtest/gtest.h"
+
+#include "prefix.h"
+#include "globdefs.h"
+#include "combiners.h"
+
+/* The surfaces are combined with a few pixels either side of each row, which
+ * must be left untouched. */
+#define kSurfaceWidth 19
+#define kSurfaceHeight 3
+#define kSurfacePadding 2
+#define kSurfaceStride (kSurfaceWidth + kSurfacePadding * 2)
+
+static const uint8_t kOpacities[] = { 0, 1, 127, 128, 254, 255 };
+
+static uint32_t s_random = 1;
+
+static uint8_t random_byte(void)
+{
+	s_random = s_random * 1103515245 + 12345;
+	return (s_random >> 16) & 0xff;
+}
+
+/* Returns a random premultiplied pixel, biased towards the fully transparent
+ * and fully opaque pixels which are most common in practice. */
+static uint32_t random_pixel(void)
+{
+	uint8_t t_alpha;
+	switch(random_byte() % 4)
+	{
+	case 0:
+		t_alpha = 0;
+		break;
+	case 1:
+		t_alpha = 255;
+		break;
+	default:
+		t_alpha = random_byte();
+		break;
+	}
+
+	uint32_t t_pixel;
+	t_pixel = t_alpha << 24;
+	for(int i = 0; i < 3; i++)
+		t_pixel |= (t_alpha == 0 ? 0 : random_byte() % (t_alpha + 1)) << (i * 8);
+	return t_pixel;
+}
+
+static void fill_surface(uint32_t *r_pixels)
+{
+	for(int i = 0; i < kSurfaceStride * kSurfaceHeight; i++)
+		r_pixels[i] = random_pixel();
+}
+
+static void get_combiners(MCSurfaceCombinersVariant p_variant, surface_combiner_t *r_combiners, surface_combiner_t *r_combiners_nda)
+{
+	MCSurfaceCombinersSelect(p_variant);
+	memcpy(r_combiners, s_surface_combiners, sizeof(surface_combiner_t) * NUM_INKS);
+	memcpy(r_combiners_nda, s_surface_combiners_nda, sizeof(surface_combiner_t) * NUM_INKS);
+}
+
+static void test_variant(MCSurfaceCombinersVariant p_variant)
+{
+	surface_combiner_t t_scalar[NUM_INKS], t_scalar_nda[NUM_INKS];
+	get_combiners(kMCSurfaceCombinersScalar, t_scalar, t_scalar_nda);
+
+	surface_combiner_t t_vector[NUM_INKS], t_vector_nda[NUM_INKS];
+	get_combiners(p_variant, t_vector, t_vector_nda);
+
+	MCSurfaceCombinersInitialize();
+
+	for(int t_table = 0; t_table < 2; t_table++)
+		for(int t_ink = 0; t_ink < NUM_INKS; t_ink++)
+			for(uindex_t t_opacity = 0; t_opacity < sizeof(kOpacities); t_opacity++)
+				for(int t_width = 1; t_width <= kSurfaceWidth; t_width++)
+				{
+					uint32_t t_src[kSurfaceStride * kSurfaceHeight];
+					uint32_t t_expected[kSurfaceStride * kSurfaceHeight];
+					uint32_t t_actual[kSurfaceStride * kSurfaceHeight];
+					fill_surface(t_src);
+					fill_surface(t_expected);
+					memcpy(t_actual, t_expected, sizeof(t_actual));
+
+					surface_combiner_t t_expected_combiner, t_actual_combiner;
+					t_expected_combiner = t_table == 0 ? t_scalar[t_ink] : t_scalar_nda[t_ink];
+					t_actual_combiner = t_table == 0 ? t_vector[t_ink] : t_vector_nda[t_ink];
+
+					t_expected_combiner(t_expected + kSurfacePadding, kSurfaceStride * 4, t_src + kSurfacePadding, kSurfaceStride * 4, t_width, kSurfaceHeight, kOpacities[t_opacity]);
+					t_actual_combiner(t_actual + kSurfacePadding, kSurfaceStride * 4, t_src + kSurfacePadding, kSurfaceStride * 4, t_width, kSurfaceHeight, kOpacities[t_opacity]);
+
+					for(int i = 0; i < kSurfaceStride * kSurfaceHeight; i++)
+						ASSERT_EQ(t_expected[i], t_actual[i]) << "table " << t_table << ", ink " << t_ink << ", opacity " << int(kOpacities[t_opacity]) << ", width " << t_width << ", pixel " << i;
+				}
+}
+
+TEST(combiners, sse2)
+{
+	if (!MCSurfaceCombinersIsAvailable(kMCSurfaceCombinersSSE2))
+		return;
+
+	test_variant(kMCSurfaceCombinersSSE2);
+}
+
+TEST(combiners, avx2)
+{
+	if (!MCSurfaceCombinersIsAvailable(kMCSurfaceCombinersAVX2))
+		return;
+
+	test_variant(kMCSurfaceCombinersAVX2);
+}
+
+TEST(combiners, neon)
+{
+	if (!MCSurfaceCombinersIsAvailable(kMCSurfaceCombinersNEON))
+		return;
+
+	test_variant(kMCSurfaceCombinersNEON);
+}
@@ -0,0 +1,259 @@
+/* Copyright (C) 2003-2017 LiveCode Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+#include "gtest/gtest.h"
+
+#include "prefix.h"
+#include "dnscache.h"
+
+/* A stub resolver which knows a fixed set of names, each resolving to a
+ * single 'address' consisting of the name's index. */
+
+static const char *kStubNames[] = { "alpha.test", "beta.test" };
+
+static real64_t s_stub_clock = 0;
+static int s_stub_lookups = 0;
+
+static real64_t stub_clock(void)
+{
+	return s_stub_clock;
+}
+
+static void stub_resolve(MCNameRef p_key)
+{
+	s_stub_lookups++;
+
+	MCDnsAddressList t_addresses;
+	t_addresses . addresses = nil;
+	t_addresses . count = 0;
+
+	bool t_resolved = false;
+	for(uint8_t i = 0; i < sizeof(kStubNames) / sizeof(kStubNames[0]); i++)
+		if (MCStringIsEqualToCString(MCNameGetString(p_key), kStubNames[i], kMCStringOptionCompareCaseless))
+		{
+			ASSERT_TRUE(MCDnsAddressListAppend(t_addresses, reinterpret_cast<const struct sockaddr *>(&i), sizeof(i)));
+			t_resolved = true;
+		}
+
+	MCDnsCacheEndLookup(p_key, t_resolved, t_addresses);
+	MCDnsAddressListClear(t_addresses);
+}
+
+struct StubWaiter
+{
+	int calls;
+	bool resolved;
+	int address;
+};
+
+static void stub_waiter_callback(void *p_context, bool p_resolved, const MCDnsAddressList& p_addresses)
+{
+	StubWaiter *t_waiter = static_cast<StubWaiter *>(p_context);
+	t_waiter -> calls++;
+	t_waiter -> resolved = p_resolved;
+	t_waiter -> address = -1;
+	if (p_addresses . count == 1)
+		t_waiter -> address = *reinterpret_cast<const uint8_t *>(p_addresses . addresses[0] . addr);
+}
+
+/* Looks up the given name as the engine does, resolving it with the stub
+ * straight away if the lookup has to be performed. */
+static MCDnsLookupStatus stub_lookup(const char *p_name, StubWaiter& x_waiter, bool p_defer = false)
+{
+	MCNewAutoNameRef t_key;
+	EXPECT_TRUE(MCNameCreateWithNativeChars((const char_t *)p_name, strlen(p_name), &t_key));
+
+	MCDnsLookupStatus t_status = kMCDnsLookupStarted;
+	bool t_resolved = false;
+	MCDnsAddressList t_addresses;
+	t_addresses . addresses = nil;
+	t_addresses . count = 0;
+	EXPECT_TRUE(MCDnsCacheBeginLookup(*t_key, stub_waiter_callback, &x_waiter, t_status, t_resolved, t_addresses));
+
+	if (t_status == kMCDnsLookupHit)
+		stub_waiter_callback(&x_waiter, t_resolved, t_addresses);
+	else if (t_status == kMCDnsLookupStarted && !p_defer)
+		stub_resolve(*t_key);
+
+	MCDnsAddressListClear(t_addresses);
+	return t_status;
+}
+
+static void stub_reset(void)
+{
+	static bool s_initialized = false;
+	if (!s_initialized)
+		s_initialized = MCInitialize();
+
+	MCDnsCacheSetClock(stub_clock);
+	s_stub_clock = 1000;
+	s_stub_lookups = 0;
+}
+
+static void stub_finish(void)
+{
+	MCDnsCacheFinalize();
+	MCDnsCacheSetClock(nil);
+}
+
+TEST(dnscache, positive)
+{
+	stub_reset();
+
+	StubWaiter t_first = {}, t_second = {};
+	EXPECT_EQ(stub_lookup("beta.test", t_first), kMCDnsLookupStarted);
+	EXPECT_EQ(stub_lookup("BETA.test", t_second), kMCDnsLookupHit);
+
+	EXPECT_EQ(s_stub_lookups, 1);
+	EXPECT_EQ(t_first . calls, 1);
+	EXPECT_TRUE(t_first . resolved);
+	EXPECT_EQ(t_first . address, 1);
+	EXPECT_EQ(t_second . calls, 1);
+	EXPECT_TRUE(t_second . resolved);
+	EXPECT_EQ(t_second . address, 1);
+
+	// Once the entry has expired, the name is looked up again.
+	s_stub_clock += DNS_CACHE_POSITIVE_TTL;
+	StubWaiter t_third = {};
+	EXPECT_EQ(stub_lookup("beta.test", t_third), kMCDnsLookupStarted);
+	EXPECT_EQ(s_stub_lookups, 2);
+	EXPECT_TRUE(t_third . resolved);
+
+	stub_finish();
+}
+
+TEST(dnscache, negative)
+{
+	stub_reset();
+
+	StubWaiter t_first = {}, t_second = {};
+	EXPECT_EQ(stub_lookup("gamma.test", t_first), kMCDnsLookupStarted);
+	EXPECT_FALSE(t_first . resolved);
+
+	s_stub_clock += DNS_CACHE_NEGATIVE_TTL / 2;
+	EXPECT_EQ(stub_lookup("gamma.test", t_second), kMCDnsLookupHit);
+	EXPECT_FALSE(t_second . resolved);
+	EXPECT_EQ(s_stub_lookups, 1);
+
+	// Failures are remembered for less time than successes.
+	s_stub_clock += DNS_CACHE_NEGATIVE_TTL / 2;
+	StubWaiter t_third = {};
+	EXPECT_EQ(stub_lookup("gamma.test", t_third), kMCDnsLookupStarted);
+	EXPECT_EQ(s_stub_lookups, 2);
+
+	MCDnsCacheStatistics t_statistics;
+	MCDnsCacheGetStatistics(t_statistics);
+	EXPECT_EQ(t_statistics . negative_hits, 1U);
+	EXPECT_EQ(t_statistics . entries, 1U);
+
+	stub_finish();
+}
+
+TEST(dnscache, coalesce)
+{
+	stub_reset();
+
+	StubWaiter t_waiters[3] = {};
+	EXPECT_EQ(stub_lookup("alpha.test", t_waiters[0], true), kMCDnsLookupStarted);
+	EXPECT_EQ(stub_lookup("alpha.test", t_waiters[1], true), kMCDnsLookupCoalesced);
+	EXPECT_EQ(stub_lookup("Alpha.Test", t_waiters[2], true), kMCDnsLookupCoalesced);
+
+	MCDnsCacheStatistics t_statistics;
+	MCDnsCacheGetStatistics(t_statistics);
+	EXPECT_EQ(t_statistics . pending, 1U);
+	EXPECT_EQ(t_statistics . coalesced, 2U);
+
+	for(int i = 0; i < 3; i++)
+		EXPECT_EQ(t_waiters[i] . calls, 0);
+
+	// Completing the one lookup notifies every waiter.
+	stub_resolve(MCNAME("alpha.test"));
+	EXPECT_EQ(s_stub_lookups, 1);
+	for(int i = 0; i < 3; i++)
+	{
+		EXPECT_EQ(t_waiters[i] . calls, 1);
+		EXPECT_TRUE(t_waiters[i] . resolved);
+		EXPECT_EQ(t_waiters[i] . address, 0);
+	}
+
+	MCDnsCacheGetStatistics(t_statistics);
+	EXPECT_EQ(t_statistics . pending, 0U);
+	EXPECT_EQ(t_statistics . entries, 1U);
+
+	stub_finish();
+}
+
+TEST(dnscache, flush)
+{
+	stub_reset();
+
+	StubWaiter t_first = {}, t_second = {};
+	EXPECT_EQ(stub_lookup("alpha.test", t_first), kMCDnsLookupStarted);
+	EXPECT_EQ(stub_lookup("beta.test", t_first), kMCDnsLookupStarted);
+
+	MCDnsCacheFlush();
+
+	MCDnsCacheStatistics t_statistics;
+	MCDnsCacheGetStatistics(t_statistics);
+	EXPECT_EQ(t_statistics . entries, 0U);
+
+	EXPECT_EQ(stub_lookup("alpha.test", t_second), kMCDnsLookupStarted);
+	EXPECT_EQ(s_stub_lookups, 3);
+
+	stub_finish();
+}
+
+TEST(dnscache, cancel)
+{
+	stub_reset();
+
+	StubWaiter t_first = {}, t_second = {};
+	EXPECT_EQ(stub_lookup("alpha.test", t_first, true), kMCDnsLookupStarted);
+	MCDnsCacheCancelLookup(MCNAME("alpha.test"));
+	EXPECT_EQ(t_first . calls, 0);
+
+	// A cancelled lookup leaves nothing behind to coalesce with.
+	EXPECT_EQ(stub_lookup("alpha.test", t_second), kMCDnsLookupStarted);
+	EXPECT_EQ(t_first . calls, 0);
+	EXPECT_EQ(t_second . calls, 1);
+
+	stub_finish();
+}
+
+TEST(dnscache, capacity)
+{
+	stub_reset();
+
+	// Filling the cache past its capacity evicts the oldest entries.
+	for(int i = 0; i < DNS_CACHE_SIZE + 8; i++)
+	{
+		char t_name[32];
+		sprintf(t_name, "host%d.test", i);
+		StubWaiter t_waiter = {};
+		EXPECT_EQ(stub_lookup(t_name, t_waiter), kMCDnsLookupStarted);
+		s_stub_clock += 0.01;
+	}
+
+	MCDnsCacheStatistics t_statistics;
+	MCDnsCacheGetStatistics(t_statistics);
+	EXPECT_EQ(t_statistics . entries, (uint32_t)DNS_CACHE_SIZE);
+
+	StubWaiter t_oldest = {}, t_newest = {};
+	EXPECT_EQ(stub_lookup("host0.test", t_oldest), kMCDnsLookupStarted);
+	EXPECT_EQ(stub_lookup("host135.test", t_newest), kMCDnsLookupHit);
+
+	stub_finish();
+}
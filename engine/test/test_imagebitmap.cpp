@@ -0,0 +1,150 @@
+/* Copyright (C) 2003-2017 LiveCode Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+#include "gtest/gtest.h"
+
+#include "prefix.h"
+#include "globdefs.h"
+#include "imagebitmap.h"
+
+/* Each row of the test bitmap has a different alpha, and each pixel in the row
+ * a different value for its first channel. The widths are chosen so that the
+ * rows are not a whole number of vectors. */
+#define kBitmapWidth 257
+#define kBitmapHeight 256
+
+static const MCGPixelFormat kFormats[] =
+{
+	kMCGPixelFormatBGRA,
+	kMCGPixelFormatRGBA,
+	kMCGPixelFormatABGR,
+	kMCGPixelFormatARGB,
+};
+
+static uint32_t s_random = 1;
+
+static uint32_t random_pixel(void)
+{
+	s_random = s_random * 1103515245 + 12345;
+	uint32_t t_high;
+	t_high = s_random >> 16;
+	s_random = s_random * 1103515245 + 12345;
+	return (t_high << 16) | (s_random >> 16);
+}
+
+static uint32_t *get_pixel(MCImageBitmap *p_bitmap, uint32_t x, uint32_t y)
+{
+	return (uint32_t *)((uint8_t *)p_bitmap->data + y * p_bitmap->stride) + x;
+}
+
+/* Premultiplication should round each channel to the nearest value. */
+static uint8_t premultiply_channel(uint32_t p_channel, uint32_t p_alpha)
+{
+	return (p_channel * p_alpha + 127) / 255;
+}
+
+TEST(imagebitmap, premultiply)
+{
+	MCImageBitmap *t_bitmap;
+	ASSERT_TRUE(MCImageBitmapCreate(kBitmapWidth, kBitmapHeight, t_bitmap));
+
+	for(uint32_t y = 0; y < kBitmapHeight; y++)
+		for(uint32_t x = 0; x < kBitmapWidth; x++)
+			*get_pixel(t_bitmap, x, y) = (y << 24) | ((x & 0xff) << 16) | ((255 - (x & 0xff)) << 8) | (x * 7 & 0xff);
+	MCImageBitmapCheckTransparency(t_bitmap);
+
+	MCImageBitmapPremultiply(t_bitmap);
+
+	for(uint32_t y = 0; y < kBitmapHeight; y++)
+		for(uint32_t x = 0; x < kBitmapWidth; x++)
+		{
+			uint32_t t_expected;
+			if (y == 0)
+				t_expected = 0;
+			else
+				t_expected = (y << 24) | (premultiply_channel(x & 0xff, y) << 16) | (premultiply_channel(255 - (x & 0xff), y) << 8) | premultiply_channel(x * 7 & 0xff, y);
+
+			ASSERT_EQ(t_expected, *get_pixel(t_bitmap, x, y)) << "alpha " << y << ", pixel " << x;
+		}
+
+	MCImageFreeBitmap(t_bitmap);
+}
+
+/* Every valid premultiplied pixel should survive being unpremultiplied and then
+ * premultiplied again. */
+TEST(imagebitmap, unpremultiply_round_trip)
+{
+	MCImageBitmap *t_bitmap;
+	ASSERT_TRUE(MCImageBitmapCreate(kBitmapWidth, kBitmapHeight, t_bitmap));
+
+	for(uint32_t y = 0; y < kBitmapHeight; y++)
+		for(uint32_t x = 0; x < kBitmapWidth; x++)
+		{
+			uint32_t t_channel;
+			t_channel = (x & 0xff) % (y + 1);
+			*get_pixel(t_bitmap, x, y) = (y << 24) | (t_channel << 16) | ((y - t_channel) << 8) | (t_channel / 2);
+		}
+	MCImageBitmapCheckTransparency(t_bitmap);
+
+	MCImageBitmap *t_original;
+	ASSERT_TRUE(MCImageCopyBitmap(t_bitmap, t_original));
+
+	MCImageBitmapUnpremultiply(t_bitmap);
+
+	for(uint32_t x = 0; x < kBitmapWidth; x++)
+	{
+		/* Opaque pixels are unchanged, and transparent pixels have no color. */
+		ASSERT_EQ(*get_pixel(t_original, x, 255), *get_pixel(t_bitmap, x, 255)) << "pixel " << x;
+		ASSERT_EQ(0U, *get_pixel(t_bitmap, x, 0)) << "pixel " << x;
+	}
+
+	MCImageBitmapPremultiply(t_bitmap);
+
+	for(uint32_t y = 0; y < kBitmapHeight; y++)
+		for(uint32_t x = 0; x < kBitmapWidth; x++)
+			ASSERT_EQ(*get_pixel(t_original, x, y), *get_pixel(t_bitmap, x, y)) << "alpha " << y << ", pixel " << x;
+
+	MCImageFreeBitmap(t_original);
+	MCImageFreeBitmap(t_bitmap);
+}
+
+TEST(imagebitmap, convert_pixels)
+{
+	uint32_t t_src[kBitmapWidth];
+	for(uint32_t i = 0; i < kBitmapWidth; i++)
+		t_src[i] = random_pixel();
+
+	for(uindex_t t_from = 0; t_from < sizeof(kFormats) / sizeof(kFormats[0]); t_from++)
+		for(uindex_t t_to = 0; t_to < sizeof(kFormats) / sizeof(kFormats[0]); t_to++)
+			for(uint32_t t_count = 0; t_count <= 9; t_count++)
+			{
+				uint32_t t_dst[kBitmapWidth];
+				MCImageConvertPixels(t_src, kFormats[t_from], t_dst, kFormats[t_to], kBitmapWidth - t_count);
+
+				for(uint32_t i = 0; i < kBitmapWidth - t_count; i++)
+				{
+					uint8_t r, g, b, a;
+					MCGPixelUnpack(kFormats[t_from], t_src[i], r, g, b, a);
+					ASSERT_EQ(MCGPixelPack(kFormats[t_to], r, g, b, a), t_dst[i]) << "from " << kFormats[t_from] << ", to " << kFormats[t_to] << ", pixel " << i;
+				}
+
+				/* Converting in place and back again should give the original
+				 * pixels. */
+				MCImageConvertPixels(t_dst, kFormats[t_to], t_dst, kFormats[t_from], kBitmapWidth - t_count);
+				for(uint32_t i = 0; i < kBitmapWidth - t_count; i++)
+					ASSERT_EQ(t_src[i], t_dst[i]) << "from " << kFormats[t_from] << ", to " << kFormats[t_to] << ", pixel " << i;
+			}
+}
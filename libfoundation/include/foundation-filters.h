@@ -35,4 +35,30 @@ bool MCFiltersUrlDecode(MCStringRef p_source, MCStringRef& r_result);
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Compresses p_source as gzip at the given zlib level (-1 for the default,
+// or 0 to 9). Large inputs are split into blocks which are compressed on
+// several threads when a parallel-for function has been set.
+bool MCFiltersCompressWithLevel(MCDataRef p_source, int32_t p_level, MCDataRef& r_result);
+
+// The stream forms compress or decompress from a read callback to a write
+// callback using a fixed amount of memory, so that files can be processed
+// without loading them. The read callback returns at most p_max_size bytes,
+// and zero bytes once the end of the source has been reached.
+typedef bool (*MCFiltersReadCallback)(void *p_context, void *r_buffer, size_t p_max_size, size_t& r_size);
+typedef bool (*MCFiltersWriteCallback)(void *p_context, const void *p_buffer, size_t p_size);
+
+bool MCFiltersCompressStream(MCFiltersReadCallback p_reader, void *p_reader_context, MCFiltersWriteCallback p_writer, void *p_writer_context, int32_t p_level);
+bool MCFiltersDecompressStream(MCFiltersReadCallback p_reader, void *p_reader_context, MCFiltersWriteCallback p_writer, void *p_writer_context);
+
+// Sets the function used to spread the blocks of a compression between
+// threads. By default all blocks are compressed on the calling thread. The
+// function must call p_callback once for each index below p_count, and
+// return when all the calls have finished.
+typedef void (*MCFiltersParallelCallback)(void *p_context, uint32_t p_index);
+typedef void (*MCFiltersParallelForFunction)(uint32_t p_count, MCFiltersParallelCallback p_callback, void *p_context);
+
+void MCFiltersSetParallelFor(MCFiltersParallelForFunction p_parallel_for);
+
+////////////////////////////////////////////////////////////////////////////////
+
 #endif
@@ -14,6 +14,7 @@
 		'module_test_sources':
 		[
 			'test/environment.cpp',
+            'test/test_filters.cpp',
             'test/test_foreign.cpp',
 			'test/test_hash.cpp',
             'test/test_memory.cpp',
@@ -17,22 +17,269 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include <foundation.h>
 
 #include "foundation-auto.h"
+#include "foundation-filters.h"
 #include "foundation-private.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
-inline uint8_t isvalid(uint8_t x)
+// Base64 is encoded and decoded a vector at a time where the CPU allows it.
+// SSSE3 is checked for at runtime, as x86 builds only assume SSE2.
+#if ((defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))) || defined(_M_X64) || defined(_M_IX86)
+#define MC_FILTERS_BASE64_SSSE3
+#include <tmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define MC_FILTERS_TARGET_SSSE3
+#else
+#define MC_FILTERS_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MC_FILTERS_BASE64_NEON
+#include <arm_neon.h>
+#endif
+
+static const char_t kMCFiltersBase64Alphabet[] =
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// The value of each character in the alphabet, and 0xff for all others.
+static const uint8_t kMCFiltersBase64Values[256] =
+{
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3e, 0xff, 0xff, 0xff, 0x3f,
+	0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+	0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+	0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+#if defined(MC_FILTERS_BASE64_SSSE3)
+static bool MCFiltersCPUHasSSSE3(void)
+{
+#if defined(_MSC_VER)
+	int t_info[4];
+	__cpuid(t_info, 1);
+	return (t_info[2] & (1 << 9)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+static bool MCFiltersBase64UseSSSE3(void)
+{
+	static const bool s_has_ssse3 = MCFiltersCPUHasSSSE3();
+	return s_has_ssse3;
+}
+
+// Encodes p_count blocks of 12 bytes as 16 characters each. Each block is
+// loaded as 16 bytes, so 4 bytes after the last block must be readable.
+MC_FILTERS_TARGET_SSSE3
+static void MCFiltersBase64EncodeBlocksSSSE3(const byte_t *p_src, uindex_t p_count, char_t *p_dst)
+{
+	const __m128i t_shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+	const __m128i t_offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+	                                        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+	                                        '/' - 63, 'A', 0, 0);
+	
+	for(uindex_t i = 0; i < p_count; i++)
+	{
+		__m128i t_in;
+		t_in = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(p_src + i * 12)), t_shuffle);
+		
+		// Move each 6-bit index into its own byte.
+		__m128i t_ac, t_bd, t_indices;
+		t_ac = _mm_mulhi_epu16(_mm_and_si128(t_in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+		t_bd = _mm_mullo_epi16(_mm_and_si128(t_in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+		t_indices = _mm_or_si128(t_ac, t_bd);
+		
+		// Pick the offset from index to character for each range of indices.
+		__m128i t_range;
+		t_range = _mm_subs_epu8(t_indices, _mm_set1_epi8(51));
+		t_range = _mm_or_si128(t_range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), t_indices), _mm_set1_epi8(13)));
+		
+		_mm_storeu_si128((__m128i *)(p_dst + i * 16), _mm_add_epi8(t_indices, _mm_shuffle_epi8(t_offsets, t_range)));
+	}
+}
+
+// Decodes blocks of 16 characters as 12 bytes each while every character is
+// in the alphabet, and returns the number of blocks decoded. Each block is
+// stored as 16 bytes, so there must be space for 4 bytes after the last.
+MC_FILTERS_TARGET_SSSE3
+static uindex_t MCFiltersBase64DecodeBlocksSSSE3(const char_t *p_src, uindex_t p_count, byte_t *p_dst)
+{
+	const __m128i t_lo_classes = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+	                                           0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+	const __m128i t_hi_classes = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+	                                           0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m128i t_offsets = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+	                                        0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i t_pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	
+	uindex_t i;
+	for(i = 0; i < p_count; i++)
+	{
+		__m128i t_in, t_hi, t_lo;
+		t_in = _mm_loadu_si128((const __m128i *)(p_src + i * 16));
+		t_hi = _mm_and_si128(_mm_srli_epi32(t_in, 4), _mm_set1_epi8(0x0f));
+		t_lo = _mm_and_si128(t_in, _mm_set1_epi8(0x0f));
+		
+		// A character is in the alphabet if the classes of its nibbles don't
+		// overlap.
+		__m128i t_invalid;
+		t_invalid = _mm_and_si128(_mm_shuffle_epi8(t_lo_classes, t_lo), _mm_shuffle_epi8(t_hi_classes, t_hi));
+		if (_mm_movemask_epi8(_mm_cmpgt_epi8(t_invalid, _mm_setzero_si128())) != 0)
+			break;
+		
+		__m128i t_values;
+		t_values = _mm_add_epi8(t_in, _mm_shuffle_epi8(t_offsets, _mm_add_epi8(_mm_cmpeq_epi8(t_in, _mm_set1_epi8('/')), t_hi)));
+		
+		// Join pairs of 6-bit values, then pairs of 12-bit values, then drop
+		// the top byte of each 32-bit word.
+		__m128i t_words;
+		t_words = _mm_madd_epi16(_mm_maddubs_epi16(t_values, _mm_set1_epi32(0x01400140)), _mm_set1_epi32(0x00011000));
+		_mm_storeu_si128((__m128i *)(p_dst + i * 12), _mm_shuffle_epi8(t_words, t_pack));
+	}
+	
+	return i;
+}
+#endif
+
+#if defined(MC_FILTERS_BASE64_NEON)
+static inline uint8x16_t MCFiltersBase64EncodeNEON(uint8x16_t p_indices)
+{
+	// Start from the offset of 'A', then adjust it for each later range.
+	uint8x16_t t_offsets;
+	t_offsets = vdupq_n_u8('A');
+	t_offsets = vaddq_u8(t_offsets, vandq_u8(vcgeq_u8(p_indices, vdupq_n_u8(26)), vdupq_n_u8(6)));
+	t_offsets = vsubq_u8(t_offsets, vandq_u8(vcgeq_u8(p_indices, vdupq_n_u8(52)), vdupq_n_u8(75)));
+	t_offsets = vsubq_u8(t_offsets, vandq_u8(vcgeq_u8(p_indices, vdupq_n_u8(62)), vdupq_n_u8(15)));
+	t_offsets = vaddq_u8(t_offsets, vandq_u8(vceqq_u8(p_indices, vdupq_n_u8(63)), vdupq_n_u8(3)));
+	return vaddq_u8(p_indices, t_offsets);
+}
+
+// Encodes p_count blocks of 48 bytes as 64 characters each.
+static void MCFiltersBase64EncodeBlocksNEON(const byte_t *p_src, uindex_t p_count, char_t *p_dst)
 {
-	return ((x >= 'A' && x <= 'Z') || (x >= 'a' && x <= 'z') ||
-	        (x >= '0' && x <= '9') || x == '+' || x == '/');
+	for(uindex_t i = 0; i < p_count; i++)
+	{
+		uint8x16x3_t t_in;
+		t_in = vld3q_u8(p_src + i * 48);
+		
+		uint8x16x4_t t_out;
+		t_out . val[0] = vshrq_n_u8(t_in . val[0], 2);
+		t_out . val[1] = vorrq_u8(vshlq_n_u8(vandq_u8(t_in . val[0], vdupq_n_u8(0x03)), 4), vshrq_n_u8(t_in . val[1], 4));
+		t_out . val[2] = vorrq_u8(vshlq_n_u8(vandq_u8(t_in . val[1], vdupq_n_u8(0x0f)), 2), vshrq_n_u8(t_in . val[2], 6));
+		t_out . val[3] = vandq_u8(t_in . val[2], vdupq_n_u8(0x3f));
+		
+		for(int j = 0; j < 4; j++)
+			t_out . val[j] = MCFiltersBase64EncodeNEON(t_out . val[j]);
+		
+		vst4q_u8(p_dst + i * 64, t_out);
+	}
 }
 
-inline uint8_t val(uint8_t x)
+// Returns the values of the characters, and sets the lanes of x_invalid for
+// characters which are not in the alphabet.
+static inline uint8x16_t MCFiltersBase64DecodeNEON(uint8x16_t p_chars, uint8x16_t& x_invalid)
 {
-	return (x >= 'A' && x <= 'Z' ? x - 'A' :
-	        (x >= 'a' && x <= 'z' ? x - 'a' + 26 :
-	         (x >= '0' && x <= '9' ? x - '0' + 52 :
-	          (x == '+' ? 62 : (x == '/' ? 63 : 0)))));
+	uint8x16_t t_upper, t_lower, t_digit, t_plus, t_slash;
+	t_upper = vcltq_u8(vsubq_u8(p_chars, vdupq_n_u8('A')), vdupq_n_u8(26));
+	t_lower = vcltq_u8(vsubq_u8(p_chars, vdupq_n_u8('a')), vdupq_n_u8(26));
+	t_digit = vcltq_u8(vsubq_u8(p_chars, vdupq_n_u8('0')), vdupq_n_u8(10));
+	t_plus = vceqq_u8(p_chars, vdupq_n_u8('+'));
+	t_slash = vceqq_u8(p_chars, vdupq_n_u8('/'));
+	
+	uint8x16_t t_valid;
+	t_valid = vorrq_u8(vorrq_u8(t_upper, t_lower), vorrq_u8(vorrq_u8(t_digit, t_plus), t_slash));
+	x_invalid = vorrq_u8(x_invalid, vmvnq_u8(t_valid));
+	
+	uint8x16_t t_offsets;
+	t_offsets = vandq_u8(t_upper, vdupq_n_u8((uint8_t)-'A'));
+	t_offsets = vorrq_u8(t_offsets, vandq_u8(t_lower, vdupq_n_u8((uint8_t)(26 - 'a'))));
+	t_offsets = vorrq_u8(t_offsets, vandq_u8(t_digit, vdupq_n_u8((uint8_t)(52 - '0'))));
+	t_offsets = vorrq_u8(t_offsets, vandq_u8(t_plus, vdupq_n_u8((uint8_t)(62 - '+'))));
+	t_offsets = vorrq_u8(t_offsets, vandq_u8(t_slash, vdupq_n_u8((uint8_t)(63 - '/'))));
+	return vaddq_u8(p_chars, t_offsets);
+}
+
+// Decodes blocks of 64 characters as 48 bytes each while every character is
+// in the alphabet, and returns the number of blocks decoded.
+static uindex_t MCFiltersBase64DecodeBlocksNEON(const char_t *p_src, uindex_t p_count, byte_t *p_dst)
+{
+	uindex_t i;
+	for(i = 0; i < p_count; i++)
+	{
+		uint8x16x4_t t_in;
+		t_in = vld4q_u8(p_src + i * 64);
+		
+		uint8x16_t t_invalid;
+		t_invalid = vdupq_n_u8(0);
+		for(int j = 0; j < 4; j++)
+			t_in . val[j] = MCFiltersBase64DecodeNEON(t_in . val[j], t_invalid);
+		
+		uint8x8_t t_any;
+		t_any = vorr_u8(vget_low_u8(t_invalid), vget_high_u8(t_invalid));
+		if (vget_lane_u64(vreinterpret_u64_u8(t_any), 0) != 0)
+			break;
+		
+		uint8x16x3_t t_out;
+		t_out . val[0] = vorrq_u8(vshlq_n_u8(t_in . val[0], 2), vshrq_n_u8(t_in . val[1], 4));
+		t_out . val[1] = vorrq_u8(vshlq_n_u8(t_in . val[1], 4), vshrq_n_u8(t_in . val[2], 2));
+		t_out . val[2] = vorrq_u8(vshlq_n_u8(t_in . val[2], 6), t_in . val[3]);
+		vst3q_u8(p_dst + i * 48, t_out);
+	}
+	
+	return i;
+}
+#endif
+
+// Decodes the next four characters in the alphabet, skipping any others. A
+// '=', a NUL or the end of the source pads the rest of the group, and ends
+// the decoding, in which case false is returned.
+static bool MCFiltersBase64DecodeGroup(const char_t*& x_src, const char_t *p_end, byte_t*& x_dst)
+{
+	uint8_t c[4];
+	int16_t i = 0;
+	int16_t pad = -1;
+	
+	while (i < 4)
+	{
+		char_t t_char;
+		t_char = x_src < p_end ? *x_src++ : '=';
+		
+		uint8_t t_value;
+		t_value = kMCFiltersBase64Values[t_char];
+		if (t_value != 0xff)
+			c[i++] = t_value;
+		else if (t_char == 0 || t_char == '=')
+		{
+			pad = 3 - i;
+			while (i < 4)
+				c[i++] = 0;
+		}
+	}
+	
+	uint32_t d;
+	d = (c[0] << 18) | (c[1] << 12) | (c[2] << 6) | c[3];
+	
+	if (pad < 2)
+		*x_dst++ = (d & 0xff0000) >> 16;
+	if (pad < 1)
+		*x_dst++ = (d & 0xff00) >> 8;
+	if (pad < 0)
+		*x_dst++ = d & 0xff;
+	
+	return pad < 0;
 }
 
 bool MCFiltersBase64Decode(MCStringRef p_src, MCDataRef& r_dst)
@@ -52,53 +299,47 @@ bool MCFiltersBase64Decode(MCStringRef p_src, MCDataRef& r_dst)
     
 	p = buffer . Bytes();
     
-	uint8_t c[5];
-	c[4] = '\0';
-    
-	while (l)
+	const char_t *t_end = s + l;
+	while (s < t_end)
 	{
-		uint16_t i = 0;
-		int16_t pad = -1;
-		uint32_t d;
-        
-		while (i < 4)
+		// Runs of characters in the alphabet, such as the lines of encoded
+		// data, are decoded in blocks and then in groups. Anything else is
+		// skipped or treated as padding by the general group decoder.
+		uindex_t t_blocks;
+#if defined(MC_FILTERS_BASE64_SSSE3)
+		if (MCFiltersBase64UseSSSE3())
 		{
-			if (l--)
-				c[i] = *s++;
-			else
-				c[i] = '=';
-			if (c[i] && isvalid(c[i]))
-			{
-				i++;
-				continue;
-			}
-			if (c[i] && c[i] != '=')
-				continue;
-			while ((!c[i] || c[i] == '=') && i < 4)
-			{
-				pad++;
-				c[i++] = 0;
-				c[i] = '=';
-			}
+			t_blocks = MCFiltersBase64DecodeBlocksSSSE3(s, (t_end - s) / 16, p);
+			s += t_blocks * 16;
+			p += t_blocks * 12;
 		}
-        
-		d = (val(c[0]) << 18) | (val(c[1]) << 12) | (val(c[2]) << 6) | val(c[3]);
-        
-		if (pad < 2)
-			*p++ = (d & 0xff0000) >> 16;
-		if (pad < 1)
-			*p++ = (d & 0xff00) >> 8;
-		if (pad < 0)
-			*p++ = d & 0xff;
-        
-		if (c[4] == '=')
+#elif defined(MC_FILTERS_BASE64_NEON)
+		t_blocks = MCFiltersBase64DecodeBlocksNEON(s, (t_end - s) / 64, p);
+		s += t_blocks * 64;
+		p += t_blocks * 48;
+#endif
+		
+		while (t_end - s >= 4)
 		{
-			*p = 0;
-			break;
+			uint32_t t_values;
+			t_values = (kMCFiltersBase64Values[s[0]] << 24) | (kMCFiltersBase64Values[s[1]] << 16) |
+				(kMCFiltersBase64Values[s[2]] << 8) | kMCFiltersBase64Values[s[3]];
+			if ((t_values & 0xc0c0c0c0) != 0)
+				break;
+			
+			uint32_t d;
+			d = ((t_values >> 6) & 0xfc0000) | ((t_values >> 4) & 0x3f000) | ((t_values >> 2) & 0xfc0) | (t_values & 0x3f);
+			p[0] = d >> 16;
+			p[1] = d >> 8;
+			p[2] = d;
+			p += 3;
+			s += 4;
 		}
+		
+		if (s < t_end && !MCFiltersBase64DecodeGroup(s, t_end, p))
+			break;
 	}
     
-    
 	buffer . Shrink(p - buffer . Bytes());
     
 	return buffer . CreateDataAndRelease(r_dst);
@@ -106,86 +347,78 @@ bool MCFiltersBase64Decode(MCStringRef p_src, MCDataRef& r_dst)
 
 //////////
 
-inline uint8_t lav(uint8_t x)
+static inline void MCFiltersBase64EncodeGroup(const byte_t *p_src, char_t *p_dst)
 {
-	return (x <= 25 ? x + 'A' : (x >= 26 && x <= 51 ? x + 'a' - 26 :
-	                             (x >= 52 && x <= 61 ? x + '0' - 52 :
-	                              (x == 62 ? '+' : (x == 63 ? '/' : '?')))));
+	uint32_t d;
+	d = (p_src[0] << 16) | (p_src[1] << 8) | p_src[2];
+	p_dst[0] = kMCFiltersBase64Alphabet[d >> 18];
+	p_dst[1] = kMCFiltersBase64Alphabet[(d >> 12) & 0x3f];
+	p_dst[2] = kMCFiltersBase64Alphabet[(d >> 6) & 0x3f];
+	p_dst[3] = kMCFiltersBase64Alphabet[d & 0x3f];
 }
 
+// Each line holds 18 groups of 3 bytes, encoded as 72 characters and a
+// newline. The last line also ends with a newline if it is full.
+#define kMCFiltersBase64LineBytes 54
+#define kMCFiltersBase64LineGroups 18
+
 bool MCFiltersBase64Encode(MCDataRef p_src, MCStringRef& r_dst)
 {
 	MCAutoNativeCharArray buffer;
 	uint32_t size;
     
-	const char_t *s = nil;
+	const byte_t *s = nil;
 	char_t *p = nil;
     
 	size = MCDataGetLength(p_src);
-	s = (char_t *)MCDataGetBytePtr(p_src);
+	s = MCDataGetBytePtr(p_src);
     
-	uint32_t newsize = size * 4 / 3 + size / 54 + 5;
-	if (!buffer.New(newsize))
+	uint32_t t_groups = size / 3 + (size % 3 != 0 ? 1 : 0);
+	if (!buffer.New(t_groups * 4 + t_groups / kMCFiltersBase64LineGroups))
 		return false;
     
 	p = buffer.Chars();
-	char_t *linestart = p;
     
-	while (size)
+	while (size >= kMCFiltersBase64LineBytes)
 	{
-		uint8_t c[3];
-		uint8_t d;
-		int16_t i = 0;
-		int16_t pad = -1;
-        
-		while (i < 3)
-		{
-			if (size)
-			{
-				c[i++] = *s++;
-				size--;
-			}
-			else
-			{
-				c[i++] = 0;
-				pad++;
-			}
-		}
-        
-		d = c[0] >> 2;
-		*p++ = lav(d);
-        
-		if (pad < 2)
+		uint32_t t_done = 0;
+#if defined(MC_FILTERS_BASE64_SSSE3)
+		// Four blocks of 12 bytes read no further than byte 52 of the line.
+		if (MCFiltersBase64UseSSSE3())
 		{
-			d = ((c[0] & 0x3) << 4) | (c[1] >> 4);
-			*p++ = lav(d);
-		}
-		else
-			*p++ = '=';
-        
-		if (pad < 1)
-		{
-			d = ((c[1] & 0xf) << 2) | (c[2] >> 6);
-			*p++ = lav(d);
-		}
-		else
-			*p++ = '=';
-        
-		if (pad < 0)
-		{
-			d = c[2] & 0x3f;
-			*p++ = lav(d);
-		}
-		else
-			*p++ = '=';
-		if (p - linestart == 72)
-		{
-			*p++ = '\n';
-			linestart = p;
+			MCFiltersBase64EncodeBlocksSSSE3(s, 4, p);
+			t_done = 48;
 		}
+#elif defined(MC_FILTERS_BASE64_NEON)
+		MCFiltersBase64EncodeBlocksNEON(s, 1, p);
+		t_done = 48;
+#endif
+		for(; t_done < kMCFiltersBase64LineBytes; t_done += 3)
+			MCFiltersBase64EncodeGroup(s + t_done, p + t_done / 3 * 4);
+		
+		p[72] = '\n';
+		p += 73;
+		s += kMCFiltersBase64LineBytes;
+		size -= kMCFiltersBase64LineBytes;
+	}
+	
+	uint32_t t_tail_groups = size / 3 + (size % 3 != 0 ? 1 : 0);
+	for(; size >= 3; size -= 3, s += 3, p += 4)
+		MCFiltersBase64EncodeGroup(s, p);
+	
+	if (size != 0)
+	{
+		byte_t c[3] = { s[0], size > 1 ? s[1] : (byte_t)0, 0 };
+		MCFiltersBase64EncodeGroup(c, p);
+		if (size == 1)
+			p[2] = '=';
+		p[3] = '=';
+		p += 4;
 	}
+	
+	if (t_tail_groups == kMCFiltersBase64LineGroups)
+		*p++ = '\n';
     
-	buffer.Shrink(p - buffer.Chars());
 	return buffer.CreateStringAndRelease(r_dst);
 }
 
@@ -202,41 +435,339 @@ bool MCFiltersBase64Encode(MCDataRef p_src, MCStringRef& r_dst)
 static char_t gzip_header[GZIP_HEADER_SIZE] = { (char_t)0x1f, (char_t)0x8b,
     Z_DEFLATED, 0, 0, 0, 0, 0, 0, 3 };
 
+// Sources are compressed as a run of blocks which are each primed with the
+// end of the source before them as a dictionary. This allows the blocks to be
+// compressed at the same time, and their output concatenated to give a single
+// deflate stream. All but the last block end with a sync flush, so that they
+// finish on a byte boundary.
+#define kMCFiltersDeflateBlockSize (128 * 1024)
+#define kMCFiltersDeflateDictionarySize (32 * 1024)
+
+// The number of blocks which are compressed before their output is written.
+#define kMCFiltersDeflateBatchSize 32
+
+// Inflated output is checksummed in chunks of this size, while it is still in
+// the cache.
+#define kMCFiltersInflateChunkSize (64 * 1024)
+
+static MCFiltersParallelForFunction s_parallel_for = nil;
+
+void MCFiltersSetParallelFor(MCFiltersParallelForFunction p_parallel_for)
+{
+	s_parallel_for = p_parallel_for;
+}
+
+struct MCFiltersDeflateBlock
+{
+	const byte_t *input;
+	size_t input_size;
+	const byte_t *dictionary;
+	size_t dictionary_size;
+	bool last;
+	
+	byte_t *output;
+	size_t output_size;
+	uint32_t crc;
+	bool success;
+};
+
+struct MCFiltersDeflateBatch
+{
+	MCFiltersDeflateBlock *blocks;
+	int32_t level;
+};
+
+struct MCFiltersDeflateState
+{
+	int32_t level;
+	uint32_t crc;
+	uint32_t length;
+	MCFiltersWriteCallback writer;
+	void *writer_context;
+};
+
+// Blocks may be compressed on other threads, so their output is allocated
+// with malloc directly rather than through MCMemoryAllocate, which throws an
+// error on failure.
+static bool MCFiltersDeflateBlockCompress(MCFiltersDeflateBlock& x_block, int32_t p_level)
+{
+	z_stream zstrm;
+	memset((char *)&zstrm, 0, sizeof(z_stream));
+	if (deflateInit2(&zstrm, p_level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return false;
+	
+	bool t_success;
+	t_success = true;
+	
+	if (x_block . dictionary_size != 0)
+		t_success = deflateSetDictionary(&zstrm, x_block . dictionary, x_block . dictionary_size) == Z_OK;
+	
+	// The bound does not include the marker written by a sync flush.
+	size_t t_capacity;
+	t_capacity = deflateBound(&zstrm, x_block . input_size) + 16;
+	if (t_success)
+	{
+		x_block . output = (byte_t *)malloc(t_capacity);
+		t_success = x_block . output != nil;
+	}
+	
+	zstrm . next_in = (Bytef *)x_block . input;
+	zstrm . avail_in = x_block . input_size;
+	while (t_success)
+	{
+		zstrm . next_out = x_block . output + zstrm . total_out;
+		zstrm . avail_out = t_capacity - zstrm . total_out;
+		
+		int t_result;
+		t_result = deflate(&zstrm, x_block . last ? Z_FINISH : Z_SYNC_FLUSH);
+		if (t_result == Z_STREAM_END ||
+			(!x_block . last && t_result == Z_OK && zstrm . avail_out != 0))
+			break;
+		
+		if (t_result != Z_OK && t_result != Z_BUF_ERROR)
+		{
+			t_success = false;
+			break;
+		}
+		
+		byte_t *t_new_output;
+		t_new_output = (byte_t *)realloc(x_block . output, t_capacity * 2);
+		if (t_new_output == nil)
+			t_success = false;
+		else
+		{
+			x_block . output = t_new_output;
+			t_capacity *= 2;
+		}
+	}
+	
+	x_block . output_size = zstrm . total_out;
+	x_block . crc = crc32(crc32(0L, Z_NULL, 0), x_block . input, x_block . input_size);
+	
+	deflateEnd(&zstrm);
+	
+	return t_success;
+}
+
+static void MCFiltersDeflateBlockCallback(void *p_context, uint32_t p_index)
+{
+	MCFiltersDeflateBatch *t_batch;
+	t_batch = static_cast<MCFiltersDeflateBatch *>(p_context);
+	
+	MCFiltersDeflateBlock& t_block = t_batch -> blocks[p_index];
+	t_block . success = MCFiltersDeflateBlockCompress(t_block, t_batch -> level);
+}
+
+// Compresses p_size bytes (at most a batch) at p_input and writes them out.
+// The p_dictionary_size bytes before p_input are the end of the source which
+// has already been compressed.
+static bool MCFiltersDeflateWriteBatch(MCFiltersDeflateState& x_state, const byte_t *p_input, size_t p_size, size_t p_dictionary_size, bool p_last)
+{
+	MCFiltersDeflateBlock t_blocks[kMCFiltersDeflateBatchSize];
+	
+	uint32_t t_count;
+	t_count = MCMax((p_size + kMCFiltersDeflateBlockSize - 1) / kMCFiltersDeflateBlockSize, (size_t)1);
+	for(uint32_t i = 0; i < t_count; i++)
+	{
+		MCFiltersDeflateBlock& t_block = t_blocks[i];
+		t_block . input = p_input + i * kMCFiltersDeflateBlockSize;
+		t_block . input_size = MCMin(p_size - i * kMCFiltersDeflateBlockSize, (size_t)kMCFiltersDeflateBlockSize);
+		t_block . dictionary_size = i == 0 ? p_dictionary_size : kMCFiltersDeflateDictionarySize;
+		t_block . dictionary = t_block . input - t_block . dictionary_size;
+		t_block . last = p_last && i == t_count - 1;
+		t_block . output = nil;
+		t_block . output_size = 0;
+		t_block . crc = 0;
+		t_block . success = false;
+	}
+	
+	MCFiltersDeflateBatch t_batch;
+	t_batch . blocks = t_blocks;
+	t_batch . level = x_state . level;
+	
+	if (t_count > 1 && s_parallel_for != nil)
+		s_parallel_for(t_count, MCFiltersDeflateBlockCallback, &t_batch);
+	else
+		for(uint32_t i = 0; i < t_count; i++)
+			MCFiltersDeflateBlockCallback(&t_batch, i);
+	
+	bool t_success;
+	t_success = true;
+	for(uint32_t i = 0; i < t_count; i++)
+	{
+		if (t_success)
+			t_success = t_blocks[i] . success &&
+				x_state . writer(x_state . writer_context, t_blocks[i] . output, t_blocks[i] . output_size);
+		
+		if (t_success)
+			x_state . crc = crc32_combine(x_state . crc, t_blocks[i] . crc, t_blocks[i] . input_size);
+		
+		free(t_blocks[i] . output);
+	}
+	
+	x_state . length += p_size;
+	
+	return t_success;
+}
+
+static bool MCFiltersDeflateWriteTrailer(MCFiltersDeflateState& x_state)
+{
+	uint32_t t_trailer[2];
+	t_trailer[0] = MCSwapInt32HostToLittle(x_state . crc);
+	t_trailer[1] = MCSwapInt32HostToLittle(x_state . length);
+	return x_state . writer(x_state . writer_context, t_trailer, 8);
+}
+
+struct MCFiltersMemoryOutput
+{
+	byte_t *bytes;
+	size_t size;
+	size_t capacity;
+};
+
+static bool MCFiltersMemoryOutputWrite(void *p_context, const void *p_buffer, size_t p_size)
+{
+	MCFiltersMemoryOutput *self;
+	self = static_cast<MCFiltersMemoryOutput *>(p_context);
+	
+	if (p_size > self -> capacity - self -> size)
+	{
+		size_t t_new_capacity;
+		t_new_capacity = MCMax(self -> capacity * 2, self -> size + p_size);
+		if (!MCMemoryReallocate(self -> bytes, t_new_capacity, self -> bytes))
+			return false;
+		self -> capacity = t_new_capacity;
+	}
+	
+	MCMemoryCopy(self -> bytes + self -> size, p_buffer, p_size);
+	self -> size += p_size;
+	return true;
+}
+
 bool MCFiltersCompress(MCDataRef p_source, MCDataRef& r_result)
 {
+	return MCFiltersCompressWithLevel(p_source, Z_DEFAULT_COMPRESSION, r_result);
+}
+
+bool MCFiltersCompressWithLevel(MCDataRef p_source, int32_t p_level, MCDataRef& r_result)
+{
+	if (p_level < Z_DEFAULT_COMPRESSION || p_level > Z_BEST_COMPRESSION)
+		return false;
+	
 	const byte_t *t_src_ptr = MCDataGetBytePtr(p_source);
 	uindex_t t_src_len = MCDataGetLength(p_source);
-    
-	uint32_t size = t_src_len + 12 + GZIP_HEADER_SIZE + 8;
-	size += size / 999;  //dest must be "0.1% larger than (source) plus 12 bytes"
-	MCAutoByteArray t_buffer;
-	if (!t_buffer.New(size))
+	
+	// The output is usually smaller than the source, so start with a
+	// little more space than the source for incompressible data.
+	MCFiltersMemoryOutput t_output;
+	t_output . size = 0;
+	t_output . capacity = t_src_len + t_src_len / 999 + 12 + GZIP_HEADER_SIZE + 8;
+	if (!MCMemoryAllocate(t_output . capacity, t_output . bytes))
 		return false;
-    
-	memcpy(t_buffer.Bytes(), gzip_header, GZIP_HEADER_SIZE);
-	z_stream zstrm;
-	memset((char *)&zstrm, 0, sizeof(z_stream));
-	zstrm.next_in = (unsigned char *)t_src_ptr;
-	zstrm.avail_in = t_src_len;
-	zstrm.next_out = (unsigned char *)t_buffer.Bytes() + GZIP_HEADER_SIZE;
-	zstrm.avail_out = size - GZIP_HEADER_SIZE - 8;
-	if (deflateInit2(&zstrm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, 0) != Z_OK
-        || deflate(&zstrm, Z_FINISH) != Z_STREAM_END
-        || deflateEnd(&zstrm) != Z_OK)
+	
+	MCFiltersDeflateState t_state;
+	t_state . level = p_level;
+	t_state . crc = crc32(0L, Z_NULL, 0);
+	t_state . length = 0;
+	t_state . writer = MCFiltersMemoryOutputWrite;
+	t_state . writer_context = &t_output;
+	
+	bool t_success;
+	t_success = MCFiltersMemoryOutputWrite(&t_output, gzip_header, GZIP_HEADER_SIZE);
+	
+	size_t t_offset = 0;
+	while (t_success)
 	{
+		size_t t_size;
+		t_size = MCMin(t_src_len - t_offset, (size_t)kMCFiltersDeflateBatchSize * kMCFiltersDeflateBlockSize);
+		
+		t_success = MCFiltersDeflateWriteBatch(t_state, t_src_ptr + t_offset, t_size, MCMin(t_offset, (size_t)kMCFiltersDeflateDictionarySize), t_offset + t_size == t_src_len);
+		
+		t_offset += t_size;
+		if (t_offset == t_src_len)
+			break;
+	}
+	
+	if (t_success)
+		t_success = MCFiltersDeflateWriteTrailer(t_state);
+	
+	if (t_success)
+		t_success = MCDataCreateWithBytesAndRelease(t_output . bytes, t_output . size, r_result);
+	
+	if (!t_success)
+		MCMemoryDeallocate(t_output . bytes);
+	
+	return t_success;
+}
+
+// Reads until p_max_size bytes have been read or the source is exhausted.
+static bool MCFiltersReadFully(MCFiltersReadCallback p_reader, void *p_context, byte_t *r_buffer, size_t p_max_size, size_t& r_size)
+{
+	size_t t_size = 0;
+	while (t_size < p_max_size)
+	{
+		size_t t_read;
+		if (!p_reader(p_context, r_buffer + t_size, p_max_size - t_size, t_read))
+			return false;
+		if (t_read == 0)
+			break;
+		t_size += t_read;
+	}
+	
+	r_size = t_size;
+	return true;
+}
+
+bool MCFiltersCompressStream(MCFiltersReadCallback p_reader, void *p_reader_context, MCFiltersWriteCallback p_writer, void *p_writer_context, int32_t p_level)
+{
+	if (p_level < Z_DEFAULT_COMPRESSION || p_level > Z_BEST_COMPRESSION)
+		return false;
+	
+	// The buffer holds a batch of the source, preceded by the end of the
+	// batch before it.
+	const size_t t_batch_size = kMCFiltersDeflateBatchSize * kMCFiltersDeflateBlockSize;
+	MCAutoByteArray t_buffer;
+	if (!t_buffer . New(kMCFiltersDeflateDictionarySize + t_batch_size))
 		return false;
+	
+	byte_t *t_input;
+	t_input = t_buffer . Bytes() + kMCFiltersDeflateDictionarySize;
+	
+	MCFiltersDeflateState t_state;
+	t_state . level = p_level;
+	t_state . crc = crc32(0L, Z_NULL, 0);
+	t_state . length = 0;
+	t_state . writer = p_writer;
+	t_state . writer_context = p_writer_context;
+	
+	bool t_success;
+	t_success = p_writer(p_writer_context, gzip_header, GZIP_HEADER_SIZE);
+	
+	// A source which is a whole number of batches ends with an empty batch,
+	// which is compressed as an empty final block.
+	size_t t_dictionary_size = 0;
+	while (t_success)
+	{
+		size_t t_size;
+		t_success = MCFiltersReadFully(p_reader, p_reader_context, t_input, t_batch_size, t_size);
+		
+		bool t_last;
+		t_last = t_size < t_batch_size;
+		
+		if (t_success)
+			t_success = MCFiltersDeflateWriteBatch(t_state, t_input, t_size, t_dictionary_size, t_last);
+		
+		if (t_last)
+			break;
+		
+		MCMemoryMove(t_buffer . Bytes(), t_input + t_batch_size - kMCFiltersDeflateDictionarySize, kMCFiltersDeflateDictionarySize);
+		t_dictionary_size = kMCFiltersDeflateDictionarySize;
 	}
-	uint32_t osize = zstrm.total_out + GZIP_HEADER_SIZE;
-	uint32_t check = crc32(0L, Z_NULL, 0);
-	check = crc32(check, (unsigned char *)t_src_ptr, t_src_len);
-    check = MCSwapInt32HostToLittle(check);
-	memcpy(t_buffer.Bytes() + osize, &check, 4);
-	check = t_src_len;
-    check = MCSwapInt32HostToLittle(check);
-	memcpy(t_buffer.Bytes() + osize + 4, &check, 4);
-    
-	t_buffer.Shrink(osize + 8);
-	return t_buffer.CreateDataAndRelease(r_result);
+	
+	if (t_success)
+		t_success = MCFiltersDeflateWriteTrailer(t_state);
+	
+	return t_success;
 }
 
 bool MCFiltersIsCompressed(MCDataRef p_source)
@@ -296,18 +827,168 @@ bool MCFiltersDecompress(MCDataRef p_source, MCDataRef& r_result)
 	memset((char *)&zstrm, 0, sizeof(z_stream));
 	zstrm.next_in = (unsigned char *)sptr + startindex;
 	zstrm.avail_in = t_src_len - startindex - 8;
-	zstrm.next_out = (unsigned char *)t_buffer.Bytes();
-	zstrm.avail_out = size;
-	int err;
-	if (inflateInit2(&zstrm, -MAX_WBITS) != Z_OK
-	    || ((err = inflate(&zstrm, Z_FINISH)) != Z_STREAM_END
-	        && err != Z_OK && err != Z_BUF_ERROR) // bug on OS X returns this error
+	if (inflateInit2(&zstrm, -MAX_WBITS) != Z_OK)
+		return false;
+    
+	// Inflate a chunk at a time, so that each chunk can be checksummed while
+	// it is still in the cache. Once the buffer is full, inflate is called
+	// without any space to read the end of the stream.
+	uint32_t t_crc = crc32(0L, Z_NULL, 0);
+	int err = Z_OK;
+	while (err == Z_OK)
+	{
+		byte_t *t_chunk = t_buffer.Bytes() + zstrm.total_out;
+		zstrm.next_out = t_chunk;
+		zstrm.avail_out = MCMin(size - (uint32_t)zstrm.total_out, (uint32_t)kMCFiltersInflateChunkSize);
+		err = inflate(&zstrm, Z_NO_FLUSH);
+		t_crc = crc32(t_crc, t_chunk, zstrm.next_out - t_chunk);
+	}
+    
+	if ((err != Z_STREAM_END && err != Z_OK && err != Z_BUF_ERROR) // bug on OS X returns this error
         || inflateEnd(&zstrm) != Z_OK)
 		return false;
     
+	// A complete stream must match its trailer.
+	if (err == Z_STREAM_END)
+	{
+		uint32_t t_check;
+		memcpy(&t_check, &sptr[t_src_len - 8], 4);
+		if (MCSwapInt32LittleToHost(t_check) != t_crc || zstrm.total_out != size)
+			return false;
+	}
+    
 	return t_buffer.CreateDataAndRelease(r_result);
 }
 
+struct MCFiltersInflateInput
+{
+	MCFiltersReadCallback reader;
+	void *context;
+	byte_t *bytes;
+	size_t size;
+	size_t offset;
+};
+
+// Refills the input once it has all been consumed. The input is empty at the
+// end of the source.
+static bool MCFiltersInflateInputFill(MCFiltersInflateInput& x_input)
+{
+	if (x_input . offset < x_input . size)
+		return true;
+	
+	x_input . offset = 0;
+	return x_input . reader(x_input . context, x_input . bytes, kMCFiltersInflateChunkSize, x_input . size);
+}
+
+static bool MCFiltersInflateInputRead(MCFiltersInflateInput& x_input, byte_t *r_bytes, size_t p_count)
+{
+	for(size_t i = 0; i < p_count; i++)
+	{
+		if (!MCFiltersInflateInputFill(x_input) || x_input . size == 0)
+			return false;
+		if (r_bytes != nil)
+			r_bytes[i] = x_input . bytes[x_input . offset];
+		x_input . offset++;
+	}
+	return true;
+}
+
+static bool MCFiltersInflateInputSkipString(MCFiltersInflateInput& x_input)
+{
+	byte_t t_char;
+	do
+	{
+		if (!MCFiltersInflateInputRead(x_input, &t_char, 1))
+			return false;
+	}
+	while (t_char != 0);
+	return true;
+}
+
+bool MCFiltersDecompressStream(MCFiltersReadCallback p_reader, void *p_reader_context, MCFiltersWriteCallback p_writer, void *p_writer_context)
+{
+	MCAutoByteArray t_input_buffer, t_output_buffer;
+	if (!t_input_buffer . New(kMCFiltersInflateChunkSize) ||
+		!t_output_buffer . New(kMCFiltersInflateChunkSize))
+		return false;
+	
+	MCFiltersInflateInput t_input;
+	t_input . reader = p_reader;
+	t_input . context = p_reader_context;
+	t_input . bytes = t_input_buffer . Bytes();
+	t_input . size = 0;
+	t_input . offset = 0;
+	
+	byte_t t_header[GZIP_HEADER_SIZE];
+	if (!MCFiltersInflateInputRead(t_input, t_header, GZIP_HEADER_SIZE) ||
+		t_header[0] != (byte_t)gzip_header[0] ||
+		t_header[1] != (byte_t)gzip_header[1] ||
+		t_header[2] != (byte_t)gzip_header[2] ||
+		(t_header[3] & GZIP_RESERVED) != 0)
+		return false;
+	
+	bool t_success;
+	t_success = true;
+	if (t_header[3] & GZIP_EXTRA_FIELD)
+	{ /* skip the extra field */
+		byte_t t_length[2];
+		t_success = MCFiltersInflateInputRead(t_input, t_length, 2) &&
+			MCFiltersInflateInputRead(t_input, nil, t_length[0] | (t_length[1] << 8));
+	}
+	if (t_success && (t_header[3] & GZIP_ORIG_NAME)) /* skip the original file name */
+		t_success = MCFiltersInflateInputSkipString(t_input);
+	if (t_success && (t_header[3] & GZIP_COMMENT))   /* skip the .gz file comment */
+		t_success = MCFiltersInflateInputSkipString(t_input);
+	if (t_success && (t_header[3] & GZIP_HEAD_CRC))  /* skip the header crc */
+		t_success = MCFiltersInflateInputRead(t_input, nil, 2);
+	if (!t_success)
+		return false;
+	
+	z_stream zstrm;
+	memset((char *)&zstrm, 0, sizeof(z_stream));
+	if (inflateInit2(&zstrm, -MAX_WBITS) != Z_OK)
+		return false;
+	
+	uint32_t t_crc = crc32(0L, Z_NULL, 0);
+	uint32_t t_length = 0;
+	int err = Z_OK;
+	while (t_success && err != Z_STREAM_END)
+	{
+		// A source which ends before the stream does is truncated.
+		t_success = MCFiltersInflateInputFill(t_input) && t_input . size != 0;
+		if (!t_success)
+			break;
+		
+		zstrm . next_in = t_input . bytes + t_input . offset;
+		zstrm . avail_in = t_input . size - t_input . offset;
+		zstrm . next_out = t_output_buffer . Bytes();
+		zstrm . avail_out = kMCFiltersInflateChunkSize;
+		
+		err = inflate(&zstrm, Z_NO_FLUSH);
+		t_success = err == Z_OK || err == Z_STREAM_END;
+		
+		t_input . offset = t_input . size - zstrm . avail_in;
+		
+		size_t t_size;
+		t_size = kMCFiltersInflateChunkSize - zstrm . avail_out;
+		t_crc = crc32(t_crc, t_output_buffer . Bytes(), t_size);
+		t_length += t_size;
+		
+		if (t_success && t_size != 0)
+			t_success = p_writer(p_writer_context, t_output_buffer . Bytes(), t_size);
+	}
+	
+	inflateEnd(&zstrm);
+	
+	uint32_t t_trailer[2];
+	if (t_success)
+		t_success = MCFiltersInflateInputRead(t_input, (byte_t *)t_trailer, 8);
+	
+	return t_success &&
+		MCSwapInt32LittleToHost(t_trailer[0]) == t_crc &&
+		MCSwapInt32LittleToHost(t_trailer[1]) == t_length;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 static const char * const url_table[256] =
@@ -338,11 +1019,33 @@ static const char * const url_table[256] =
     "%F7", "%F8", "%F9", "%FA", "%FB", "%FC", "%FD", "%FE", "%FF"
 };
 
+// The length of each byte's entry in url_table, or 0 for bytes which are
+// copied unchanged.
+static const uint8_t url_length_table[256] =
+{
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 6, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    1, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 3, 3, 0, 0, 3,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 3, 3, 3, 3, 3,
+    3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 3, 3, 3, 0,
+    3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+};
+
 bool MCFiltersUrlEncode(MCStringRef p_source, MCStringRef& r_result)
 {
 	MCAutoStringRefAsUTF8String t_utf8_string;
-	const char *s;
-	uindex_t l;
+	const uint8_t *s;
+	const uint8_t *e;
 	uindex_t size;
     
     // SN-2014-11-13: [[ Bug 14015 ]] We don't want to nativise the string,
@@ -350,37 +1053,35 @@ bool MCFiltersUrlEncode(MCStringRef p_source, MCStringRef& r_result)
 	if (!t_utf8_string.Lock (p_source))
         return false;
     
-	s = *t_utf8_string;
-	l = t_utf8_string.Size();
-	size = l + 1;
-	size += size / 4;
+	s = (const uint8_t *)*t_utf8_string;
+	e = s + t_utf8_string.Size();
+    
+    // Measure the result first, so that it can be written without resizing.
+	size = 0;
+	for(const uint8_t *t_byte = s; t_byte < e; t_byte++)
+		size += MCMax(url_length_table[*t_byte], (uint8_t)1);
     
     MCAutoNativeCharArray buffer;
     if (!buffer . New(size))
         return false;
     
+    // Runs of unreserved characters are copied in one go.
     char_t *dptr = buffer . Chars();
-    while (l--)
+    while (s < e)
     {
-        if (dptr - buffer . Chars() + 7 > size)
-        {
-            uint32_t newsize = size + size / 4 + 7;
-            uint32_t offset = dptr - buffer . Chars();
-            if (!buffer . Extend(newsize))
-                return false;
-            dptr = buffer . Chars() + offset;
-            size = newsize;
-        }
-        const char_t *sptr = (const char_t *)url_table[(uint8_t)*s++];
-        do
+        const uint8_t *t_run = s;
+        while (s < e && url_length_table[*s] == 0)
+            s++;
+        MCMemoryCopy(dptr, t_run, s - t_run);
+        dptr += s - t_run;
+        
+        if (s < e)
         {
-            *dptr++ = *sptr++;
+            MCMemoryCopy(dptr, url_table[*s], url_length_table[*s]);
+            dptr += url_length_table[*s++];
         }
-        while (*sptr);
     }
     
-    buffer . Shrink(dptr - buffer . Chars());
-    
     return buffer . CreateStringAndRelease(r_result);
 }
 
@@ -406,6 +1107,15 @@ bool MCFiltersUrlDecode(MCStringRef p_source, MCStringRef& r_result)
     uint8_t *dptr = (uint8_t*)t_buffer . Bytes();
     while (sptr < eptr)
     {
+        // Runs of characters which decode to themselves are copied in one go.
+        const uint8_t *t_run = sptr;
+        while (sptr < eptr && *sptr != '%' && *sptr != '+' && *sptr != '\r')
+            sptr++;
+        MCMemoryCopy(dptr, t_run, sptr - t_run);
+        dptr += sptr - t_run;
+        if (sptr == eptr)
+            break;
+        
         if (*sptr == '%')
         {
             uint8_t source = MCNativeCharUppercase(*++sptr);
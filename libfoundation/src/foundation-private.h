@@ -34,6 +34,7 @@ extern const char *__MCSysCharset;
 //
 //   0 : is_real (number)
 //     : is_unicode (string)
+//     : is_pooled (custom)
 //   1 : is_mutable (string)
 //
 
@@ -442,6 +443,13 @@ struct __MCError: public __MCValue
 
 ////////
 
+enum
+{
+    // If set, then the value was allocated at the size of the custom value
+    // pool, and can be returned to it.
+    kMCCustomValueFlagIsPooled = 1 << 0,
+};
+
 struct __MCCustomValue: public __MCValue
 {
     MCTypeInfoRef typeinfo;
@@ -532,18 +532,43 @@ struct MCValuePool
 };
 static MCValuePool *s_value_pools;
 
+// Small custom values (such as the points, rectangles and colors used by
+// canvas) are created and released in large numbers, so those which fit in
+// kMCCustomValuePoolSize bytes are allocated at that size and share a pool
+// after the per-typecode ones.
+#define kMCCustomValuePoolSize 64
+#define kMCCustomValuePool (kMCValueTypeCodeList + 1)
+
 // Stores the number of pools that we have.
-uindex_t kMCValuePoolCount = kMCValueTypeCodeList + 1;
+uindex_t kMCValuePoolCount = kMCCustomValuePool + 1;
+
+// Returns the pool a value with the given typecode and size should come from,
+// or kMCValuePoolCount if it is not pooled.
+static inline uindex_t __MCValueGetPool(MCValueTypeCode p_type_code, size_t p_size)
+{
+    if (p_type_code <= kMCValueTypeCodeList)
+        return p_type_code;
+    if (p_type_code == kMCValueTypeCodeCustom && p_size <= kMCCustomValuePoolSize)
+        return kMCCustomValuePool;
+    return kMCValuePoolCount;
+}
 
 bool __MCValueCreate(MCValueTypeCode p_type_code, size_t p_size, __MCValue*& r_value)
 {
 	void *t_value;
 	
+    uindex_t t_pool;
+    t_pool = __MCValueGetPool(p_type_code, p_size);
+    
+    // All pooled custom values are the same size, whatever they need.
+    if (t_pool == kMCCustomValuePool)
+        p_size = kMCCustomValuePoolSize;
+    
     // MW-2014-03-21: [[ Faster ]] If we are pooling this typecode, and the
     //   pool isn't empty grab the ptr from there.
-    if (p_type_code <= kMCValueTypeCodeList && s_value_pools[p_type_code] . count > 0)
+    if (t_pool < kMCValuePoolCount && s_value_pools[t_pool] . count > 0)
     {
-        t_value = s_value_pools[p_type_code] . values;
+        t_value = s_value_pools[t_pool] . values;
 
 #ifdef HAVE_VALGRIND
 		/* Valgrind support */
@@ -560,8 +585,8 @@ bool __MCValueCreate(MCValueTypeCode p_type_code, size_t p_size, __MCValue*& r_v
         MCAssert(((__MCFreedValue *)t_value) -> references == 0 &&
                  ((__MCFreedValue *)t_value) -> flags == UINT32_MAX);
         
-        s_value_pools[p_type_code] . count -= 1;
-        s_value_pools[p_type_code] . values = ((__MCFreedValue *)t_value) -> next;
+        s_value_pools[t_pool] . count -= 1;
+        s_value_pools[t_pool] . values = ((__MCFreedValue *)t_value) -> next;
         MCMemoryClear(t_value, p_size);
 	}
     else
@@ -580,6 +605,8 @@ bool __MCValueCreate(MCValueTypeCode p_type_code, size_t p_size, __MCValue*& r_v
 
 	self -> references = 1;
 	self -> flags = (p_type_code << 28);
+    if (t_pool == kMCCustomValuePool)
+        self -> flags |= kMCCustomValueFlagIsPooled;
     
 	r_value = self;
 
@@ -658,6 +685,14 @@ void __MCValueDestroy(__MCValue *self)
         MCUnreachableReturn();
 	}
 	
+    uindex_t t_pool;
+    if (t_code <= kMCValueTypeCodeList)
+        t_pool = t_code;
+    else if (t_code == kMCValueTypeCodeCustom && (self -> flags & kMCCustomValueFlagIsPooled) != 0)
+        t_pool = kMCCustomValuePool;
+    else
+        t_pool = kMCValuePoolCount;
+    
 	// Ensure that an immediate abort will be caused in Debug mode if a destroyed MCValueRef pointer is passed to
 	// a libfoundation function
 #ifdef _DEBUG
@@ -667,11 +702,11 @@ void __MCValueDestroy(__MCValue *self)
 
     // MW-2014-03-21: [[ Faster ]] If we are pooling this typecode, and the
     //   pool isn't full, add it to the pool.
-    if (t_code <= kMCValueTypeCodeList && s_value_pools[t_code] . count < 32)
+    if (t_pool < kMCValuePoolCount && s_value_pools[t_pool] . count < 32)
     {
-        s_value_pools[t_code] . count += 1;
-        ((__MCFreedValue *)self) -> next = s_value_pools[t_code] . values;
-        s_value_pools[t_code] . values = (__MCFreedValue *)self;
+        s_value_pools[t_pool] . count += 1;
+        ((__MCFreedValue *)self) -> next = s_value_pools[t_pool] . values;
+        s_value_pools[t_pool] . values = (__MCFreedValue *)self;
 
 #ifdef HAVE_VALGRIND
 		/* Valgrind support */
@@ -688,6 +723,7 @@ void __MCValueDestroy(__MCValue *self)
 		case kMCValueTypeCodeData:    t_size = sizeof(__MCData);    break;
 		case kMCValueTypeCodeArray:   t_size = sizeof(__MCArray);   break;
 		case kMCValueTypeCodeList:    t_size = sizeof(__MCList);    break;
+		case kMCValueTypeCodeCustom:  t_size = kMCCustomValuePoolSize; break;
 		default:                      MCUnreachable();
 		}
 		VALGRIND_MAKE_MEM_NOACCESS(self, t_size);
@@ -0,0 +1,415 @@
+/* Copyright (C) 2003-2017 LiveCode Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+#include "gtest/gtest.h"
+
+#include "foundation.h"
+#include "foundation-auto.h"
+#include "foundation-filters.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/* The sizes straddle the compression block (128kB) and batch (4MB) sizes. */
+static const size_t kSizes[] =
+{
+	0, 1, 1000, 131071, 131072, 131073, 500000, 4194304, 4194305, 9000000,
+};
+
+static uint32_t s_random = 1;
+
+/* Half of each kilobyte is text, and half is noise, so that the data both
+ * compresses and needs the block dictionaries to do so. */
+static void make_source(size_t p_size, std::vector<byte_t>& r_source)
+{
+	static const char kText[] = "the quick brown fox jumps over the lazy dog ";
+
+	r_source . resize(p_size);
+	for(size_t i = 0; i < p_size; i++)
+	{
+		s_random = s_random * 1103515245 + 12345;
+		if (i % 1024 < 512)
+			r_source[i] = kText[i % (sizeof(kText) - 1)];
+		else
+			r_source[i] = s_random >> 16;
+	}
+}
+
+/* Runs the calls in reverse, as another thread might. */
+static void reverse_parallel_for(uint32_t p_count, MCFiltersParallelCallback p_callback, void *p_context)
+{
+	for(uint32_t i = p_count; i > 0; i--)
+		p_callback(p_context, i - 1);
+}
+
+struct memory_stream
+{
+	std::vector<byte_t> bytes;
+	size_t offset;
+	size_t max_read;
+};
+
+static bool memory_stream_read(void *p_context, void *r_buffer, size_t p_max_size, size_t& r_size)
+{
+	memory_stream *t_stream = static_cast<memory_stream *>(p_context);
+	r_size = MCMin(MCMin(p_max_size, t_stream -> max_read), t_stream -> bytes . size() - t_stream -> offset);
+	MCMemoryCopy(r_buffer, t_stream -> bytes . data() + t_stream -> offset, r_size);
+	t_stream -> offset += r_size;
+	return true;
+}
+
+static bool memory_stream_write(void *p_context, const void *p_buffer, size_t p_size)
+{
+	memory_stream *t_stream = static_cast<memory_stream *>(p_context);
+	t_stream -> bytes . insert(t_stream -> bytes . end(), (const byte_t *)p_buffer, (const byte_t *)p_buffer + p_size);
+	return true;
+}
+
+TEST(filters, compress_empty)
+{
+	/* An empty source gives the same gzip as a single deflate call. */
+	static const byte_t kExpected[] =
+	{
+		0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03,
+		0x03, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	};
+
+	MCAutoDataRef t_compressed;
+	ASSERT_TRUE(MCFiltersCompress(kMCEmptyData, &t_compressed));
+	ASSERT_EQ(sizeof(kExpected), MCDataGetLength(*t_compressed));
+	EXPECT_EQ(0, memcmp(kExpected, MCDataGetBytePtr(*t_compressed), sizeof(kExpected)));
+}
+
+TEST(filters, compress_round_trip)
+{
+	MCFiltersSetParallelFor(reverse_parallel_for);
+
+	for(size_t t_size : kSizes)
+	{
+		std::vector<byte_t> t_source;
+		make_source(t_size, t_source);
+
+		MCAutoDataRef t_data;
+		ASSERT_TRUE(MCDataCreateWithBytes(t_source . data(), t_size, &t_data));
+
+		for(int32_t t_level = -1; t_level <= 9; t_level += 5)
+		{
+			MCAutoDataRef t_compressed, t_decompressed;
+			ASSERT_TRUE(MCFiltersCompressWithLevel(*t_data, t_level, &t_compressed)) << "size " << t_size << ", level " << t_level;
+			ASSERT_TRUE(MCFiltersIsCompressed(*t_compressed));
+			ASSERT_TRUE(MCFiltersDecompress(*t_compressed, &t_decompressed)) << "size " << t_size << ", level " << t_level;
+			EXPECT_TRUE(MCDataIsEqualTo(*t_data, *t_decompressed)) << "size " << t_size << ", level " << t_level;
+		}
+	}
+
+	MCFiltersSetParallelFor(nil);
+
+	MCAutoDataRef t_compressed;
+	EXPECT_FALSE(MCFiltersCompressWithLevel(kMCEmptyData, 10, &t_compressed));
+}
+
+TEST(filters, stream_round_trip)
+{
+	for(size_t t_size : kSizes)
+	{
+		memory_stream t_source;
+		make_source(t_size, t_source . bytes);
+		t_source . offset = 0;
+		t_source . max_read = 100000;
+
+		memory_stream t_compressed;
+		t_compressed . offset = 0;
+		t_compressed . max_read = 1000;
+		ASSERT_TRUE(MCFiltersCompressStream(memory_stream_read, &t_source, memory_stream_write, &t_compressed, -1)) << "size " << t_size;
+
+		/* The stream and whole data forms should understand each other. */
+		MCAutoDataRef t_data, t_decompressed;
+		ASSERT_TRUE(MCDataCreateWithBytes(t_compressed . bytes . data(), t_compressed . bytes . size(), &t_data));
+		ASSERT_TRUE(MCFiltersDecompress(*t_data, &t_decompressed)) << "size " << t_size;
+		ASSERT_EQ(t_size, MCDataGetLength(*t_decompressed));
+		EXPECT_EQ(0, memcmp(t_source . bytes . data(), MCDataGetBytePtr(*t_decompressed), t_size)) << "size " << t_size;
+
+		memory_stream t_output;
+		ASSERT_TRUE(MCFiltersDecompressStream(memory_stream_read, &t_compressed, memory_stream_write, &t_output)) << "size " << t_size;
+		EXPECT_TRUE(t_source . bytes == t_output . bytes) << "size " << t_size;
+	}
+}
+
+TEST(filters, decompress_checks_crc)
+{
+	std::vector<byte_t> t_source;
+	make_source(500000, t_source);
+
+	MCAutoDataRef t_data, t_compressed;
+	ASSERT_TRUE(MCDataCreateWithBytes(t_source . data(), t_source . size(), &t_data));
+	ASSERT_TRUE(MCFiltersCompress(*t_data, &t_compressed));
+
+	/* Flip a bit of the stored checksum. */
+	memory_stream t_corrupt;
+	t_corrupt . bytes . assign(MCDataGetBytePtr(*t_compressed), MCDataGetBytePtr(*t_compressed) + MCDataGetLength(*t_compressed));
+	t_corrupt . bytes[t_corrupt . bytes . size() - 8] ^= 1;
+	t_corrupt . offset = 0;
+	t_corrupt . max_read = 4096;
+
+	MCAutoDataRef t_corrupt_data, t_decompressed;
+	ASSERT_TRUE(MCDataCreateWithBytes(t_corrupt . bytes . data(), t_corrupt . bytes . size(), &t_corrupt_data));
+	EXPECT_FALSE(MCFiltersDecompress(*t_corrupt_data, &t_decompressed));
+
+	memory_stream t_output;
+	EXPECT_FALSE(MCFiltersDecompressStream(memory_stream_read, &t_corrupt, memory_stream_write, &t_output));
+}
+
+/* Reference versions of the base64 and URL filters, written a character at a
+ * time, which the filters must agree with exactly. */
+static const char kBase64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static std::string reference_base64_encode(const std::vector<byte_t>& p_source)
+{
+	std::string t_result;
+	for(size_t i = 0; i < p_source . size(); i += 3)
+	{
+		size_t t_count = MCMin(p_source . size() - i, (size_t)3);
+		uint32_t d = p_source[i] << 16;
+		if (t_count > 1)
+			d |= p_source[i + 1] << 8;
+		if (t_count > 2)
+			d |= p_source[i + 2];
+
+		t_result += kBase64Alphabet[d >> 18];
+		t_result += kBase64Alphabet[(d >> 12) & 0x3f];
+		t_result += t_count > 1 ? kBase64Alphabet[(d >> 6) & 0x3f] : '=';
+		t_result += t_count > 2 ? kBase64Alphabet[d & 0x3f] : '=';
+		if (i % 54 == 51)
+			t_result += '\n';
+	}
+	return t_result;
+}
+
+/* Characters outside the alphabet are skipped, and the first '=' or NUL (or
+ * the end) pads the group and stops the decoding. */
+static std::vector<byte_t> reference_base64_decode(const std::string& p_source)
+{
+	std::vector<byte_t> t_result;
+	size_t t_offset = 0;
+	while (t_offset < p_source . size())
+	{
+		uint32_t d = 0;
+		int t_count = 0;
+		bool t_end = false;
+		while (t_count < 4 && !t_end)
+		{
+			char t_char = t_offset < p_source . size() ? p_source[t_offset++] : '=';
+			const char *t_found = t_char != 0 ? strchr(kBase64Alphabet, t_char) : nil;
+			if (t_found != nil)
+				d |= (t_found - kBase64Alphabet) << (18 - 6 * t_count++);
+			else if (t_char == 0 || t_char == '=')
+				t_end = true;
+		}
+
+		for(int i = 0; i < t_count - 1; i++)
+			t_result . push_back(d >> (16 - 8 * i));
+
+		if (t_end)
+			break;
+	}
+	return t_result;
+}
+
+static std::string reference_url_encode(const std::string& p_utf8)
+{
+	std::string t_result;
+	for(unsigned char t_char : p_utf8)
+	{
+		if (isalnum(t_char) || t_char == '*' || t_char == '-' || t_char == '.' || t_char == '_')
+			t_result += t_char;
+		else if (t_char == ' ')
+			t_result += '+';
+		else if (t_char == '\n')
+			t_result += "%0D%0A";
+		else
+		{
+			char t_escape[4];
+			sprintf(t_escape, "%%%02X", t_char);
+			t_result += t_escape;
+		}
+	}
+	return t_result;
+}
+
+/* Escapes are only decoded when complete, so that the reference doesn't
+ * need to copy the filter's handling of a '%' at the end of the source. */
+static std::string reference_url_decode(const std::string& p_source)
+{
+	std::string t_result;
+	for(size_t i = 0; i < p_source . size(); i++)
+	{
+		if (p_source[i] == '%')
+		{
+			int t_value = 0;
+			for(size_t j = i + 1; j < i + 3; j++)
+			{
+				char t_digit = toupper(p_source[j]);
+				t_value <<= 4;
+				if (isdigit(t_digit))
+					t_value += t_digit - '0';
+				else if (t_digit >= 'A' && t_digit <= 'F')
+					t_value += t_digit - 'A' + 10;
+			}
+			if (t_value != 13)
+				t_result += (char)t_value;
+			i += 2;
+		}
+		else if (p_source[i] == '+')
+			t_result += ' ';
+		else if (p_source[i] == '\r')
+		{
+			if (i + 1 < p_source . size() && p_source[i + 1] == '\n')
+				i++;
+			t_result += '\n';
+		}
+		else
+			t_result += p_source[i];
+	}
+	return t_result;
+}
+
+static std::string string_to_std(MCStringRef p_string)
+{
+	MCAutoStringRefAsUTF8String t_utf8;
+	if (!t_utf8 . Lock(p_string))
+		return std::string();
+	return std::string(*t_utf8, t_utf8 . Size());
+}
+
+TEST(filters, base64_encode)
+{
+	/* Every length up to a few lines, so that every position of the vector
+	 * blocks and the line breaks is covered. */
+	for(size_t t_size = 0; t_size < 1000; t_size++)
+	{
+		std::vector<byte_t> t_source;
+		make_source(t_size, t_source);
+		for(size_t i = 0; i < t_size; i++)
+			t_source[i] ^= (byte_t)i;
+
+		MCAutoDataRef t_data;
+		MCAutoStringRef t_encoded;
+		ASSERT_TRUE(MCDataCreateWithBytes(t_source . data(), t_size, &t_data));
+		ASSERT_TRUE(MCFiltersBase64Encode(*t_data, &t_encoded));
+		EXPECT_EQ(reference_base64_encode(t_source), string_to_std(*t_encoded)) << "size " << t_size;
+
+		MCAutoDataRef t_decoded;
+		ASSERT_TRUE(MCFiltersBase64Decode(*t_encoded, &t_decoded));
+		EXPECT_TRUE(MCDataIsEqualTo(*t_data, *t_decoded)) << "size " << t_size;
+	}
+}
+
+TEST(filters, base64_decode)
+{
+	/* Encoded text with padding, line breaks and stray characters dropped
+	 * in at random. */
+	static const char kStray[] = "AZaz09+/=\n\r \t.-%\x7f";
+	for(int t_case = 0; t_case < 20000; t_case++)
+	{
+		std::vector<byte_t> t_source;
+		make_source(s_random % 400, t_source);
+		std::string t_text = reference_base64_encode(t_source);
+
+		for(uint32_t t_edits = s_random % 5; t_edits > 0; t_edits--)
+		{
+			s_random = s_random * 1103515245 + 12345;
+			t_text . insert((s_random >> 8) % (t_text . size() + 1), 1, kStray[(s_random >> 20) % (sizeof(kStray) - 1)]);
+		}
+
+		MCAutoStringRef t_string;
+		MCAutoDataRef t_decoded;
+		ASSERT_TRUE(MCStringCreateWithNativeChars((const char_t *)t_text . data(), t_text . size(), &t_string));
+		ASSERT_TRUE(MCFiltersBase64Decode(*t_string, &t_decoded));
+
+		std::vector<byte_t> t_expected = reference_base64_decode(t_text);
+		ASSERT_EQ(t_expected . size(), MCDataGetLength(*t_decoded)) << t_text;
+		EXPECT_EQ(0, memcmp(t_expected . data(), MCDataGetBytePtr(*t_decoded), t_expected . size())) << t_text;
+	}
+}
+
+TEST(filters, url_encode)
+{
+	/* Runs of unreserved characters between every other ASCII character, and
+	 * two byte UTF-8 sequences. */
+	for(int t_case = 0; t_case < 20000; t_case++)
+	{
+		std::string t_utf8;
+		for(uint32_t i = s_random % 200; i > 0; i--)
+		{
+			s_random = s_random * 1103515245 + 12345;
+			uint32_t t_char = (s_random >> 8) % 0x800;
+			/* A CR is dropped when decoded, so it doesn't round trip. */
+			if (t_char >= 0x400 || t_char == '\r')
+				t_char = 'a' + t_char % 26;
+			if (t_char < 0x80)
+				t_utf8 += (char)t_char;
+			else
+			{
+				t_utf8 += (char)(0xc0 | (t_char >> 6));
+				t_utf8 += (char)(0x80 | (t_char & 0x3f));
+			}
+		}
+
+		MCAutoStringRef t_string, t_encoded;
+		ASSERT_TRUE(MCStringCreateWithBytes((const byte_t *)t_utf8 . data(), t_utf8 . size(), kMCStringEncodingUTF8, false, &t_string));
+		ASSERT_TRUE(MCFiltersUrlEncode(*t_string, &t_encoded));
+		EXPECT_EQ(reference_url_encode(t_utf8), string_to_std(*t_encoded));
+
+		MCAutoStringRef t_decoded;
+		ASSERT_TRUE(MCFiltersUrlDecode(*t_encoded, &t_decoded));
+		EXPECT_TRUE(MCStringIsEqualTo(*t_string, *t_decoded, kMCStringOptionCompareExact));
+	}
+}
+
+TEST(filters, url_decode)
+{
+	static const char kSpecial[] = "%%%+\r\n0aF";
+	for(int t_case = 0; t_case < 20000; t_case++)
+	{
+		std::string t_text;
+		for(uint32_t i = s_random % 200; i > 0; i--)
+		{
+			s_random = s_random * 1103515245 + 12345;
+			if ((s_random >> 8) % 4 == 0)
+				t_text += kSpecial[(s_random >> 12) % (sizeof(kSpecial) - 1)];
+			else
+				t_text += (char)(' ' + (s_random >> 12) % 95);
+		}
+
+		/* Complete any escape at the end. */
+		t_text += "41";
+
+		MCAutoStringRef t_string, t_decoded;
+		ASSERT_TRUE(MCStringCreateWithNativeChars((const char_t *)t_text . data(), t_text . size(), &t_string));
+
+		MCAutoStringRef t_expected;
+		std::string t_expected_utf8 = reference_url_decode(t_text);
+		bool t_expected_valid = MCStringCreateWithBytes((const byte_t *)t_expected_utf8 . data(), t_expected_utf8 . size(), kMCStringEncodingUTF8, false, &t_expected);
+
+		ASSERT_EQ(t_expected_valid, MCFiltersUrlDecode(*t_string, &t_decoded)) << t_text;
+		if (t_expected_valid)
+			EXPECT_TRUE(MCStringIsEqualTo(*t_expected, *t_decoded, kMCStringOptionCompareExact)) << t_text;
+	}
+}
@@ -92,3 +92,31 @@ TEST(memory, sizes)
     EXPECT_EQ(sizeof(__MCProperList), 24);
 #endif
 }
+
+TEST(memory, custom_value_pool)
+{
+    MCValueCustomCallbacks t_callbacks;
+    memset(&t_callbacks, 0, sizeof(t_callbacks));
+    
+    MCAutoTypeInfoRef t_typeinfo;
+    ASSERT_TRUE(MCCustomTypeInfoCreate(kMCAnyTypeInfo, &t_callbacks, &t_typeinfo));
+    
+    /* Small custom values are reused once released, and must always start
+     * out cleared whatever size they were before. */
+    for(size_t t_size = 0; t_size <= 128; t_size += 8)
+    {
+        MCValueRef t_value;
+        ASSERT_TRUE(MCValueCreateCustom(*t_typeinfo, t_size, t_value));
+        
+        uint8_t *t_bytes;
+        t_bytes = (uint8_t *)MCValueGetExtraBytesPtr(t_value);
+        for(size_t i = 0; i < t_size; i++)
+        {
+            ASSERT_EQ(0, t_bytes[i]) << "size " << t_size << ", byte " << i;
+            t_bytes[i] = 0xff;
+        }
+        
+        EXPECT_EQ(*t_typeinfo, MCValueGetTypeInfo(t_value));
+        MCValueRelease(t_value);
+    }
+}
@@ -30,6 +30,9 @@ typedef struct __MCGMask *MCGMaskRef;
 typedef struct __MCGDashes *MCGDashesRef;
 typedef struct __MCGRegion *MCGRegionRef;
 
+typedef struct __MCGBitmapEffectsCache *MCGBitmapEffectsCacheRef;
+typedef struct __MCGDisplayList *MCGDisplayListRef;
+
 typedef class MCGPaint *MCGPaintRef;
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -533,6 +536,12 @@ struct MCGBitmapEffects
 	bool has_drop_shadow = false;
 	
 	bool isolated = false;
+
+	// The blurred masks computed when rendering the effects are kept in the
+	// cache (if any), and reused while the generation of the content, the
+	// blur parameters and the device transform stay the same.
+	MCGBitmapEffectsCacheRef cache = nullptr;
+	uint32_t generation = 0;
 };
 
 struct MCGDeviceMaskInfo
@@ -802,6 +811,16 @@ void MCGraphicsInitialize(void);
 void MCGraphicsFinalize(void);
 void MCGraphicsCompact(void);
 
+// Calls p_callback once for each index below p_count, sharing the calls between
+// the calling thread and the graphics worker threads, and returns when they
+// have all finished. The calls are all made on the calling thread if the
+// workers are already running another request.
+typedef void (*MCGParallelCallback)(void *p_context, uint32_t p_index);
+void MCGParallelFor(uint32_t p_count, MCGParallelCallback p_callback, void *p_context);
+
+// Returns the number of threads MCGParallelFor shares calls between.
+uint32_t MCGParallelGetThreadCount(void);
+
 ////////////////////////////////////////////////////////////////////////////////
 
 bool MCGPaintCreateWithNone(MCGPaintRef& r_paint);
@@ -850,6 +869,22 @@ MCGRectangle MCGMaskGetBounds(MCGMaskRef mask);
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// A bitmap effects cache holds the blurred masks for the effects of one
+// object. It must outlive any context layer which uses it.
+bool MCGBitmapEffectsCacheCreate(MCGBitmapEffectsCacheRef& r_cache);
+void MCGBitmapEffectsCacheRelease(MCGBitmapEffectsCacheRef cache);
+
+////////////////////////////////////////////////////////////////////////////////
+
+// A display list is a recording of drawing operations, which can be replayed
+// into any context.
+MCGDisplayListRef MCGDisplayListRetain(MCGDisplayListRef display_list);
+void MCGDisplayListRelease(MCGDisplayListRef display_list);
+// Returns the approximate amount of memory used by the display list.
+size_t MCGDisplayListGetByteSize(MCGDisplayListRef display_list);
+
+////////////////////////////////////////////////////////////////////////////////
+
 enum MCGPathCommand
 {
 	kMCGPathCommandEnd,
@@ -917,6 +952,11 @@ bool MCGPathIterate(MCGPathRef p_path, MCGPathIterateCallback p_callback, void *
 extern "C" bool MCGContextCreate(uint32_t width, uint32_t height, bool alpha, MCGContextRef& r_context);
 bool MCGContextCreateWithPixels(uint32_t width, uint32_t height, uint32_t stride, void *pixels, bool alpha, MCGContextRef& r_context);
 bool MCGContextCreateWithRaster(const MCGRaster& raster, MCGContextRef& r_context);
+// Creates a context which records the drawing done to it within the given (device)
+// bounds, rather than rendering it. The recording can be fetched as a display list
+// with MCGContextCopyDisplayList. If 'opaque' is true, the list must only be replayed
+// into opaque layers.
+bool MCGContextCreateForDisplayList(const MCGIntegerRectangle& bounds, bool opaque, MCGContextRef& r_context);
 
 MCGContextRef MCGContextRetain(MCGContextRef context);
 void MCGContextRelease(MCGContextRef context);
@@ -1052,6 +1092,14 @@ void MCGContextDrawRectOfImage(MCGContextRef self, MCGImageRef p_image, MCGRecta
 
 bool MCGContextCopyImage(MCGContextRef context, MCGImageRef &r_image);
 
+// Ends the recording of a context created with MCGContextCreateForDisplayList,
+// returning the drawing as a display list. No further drawing can be done to the
+// context.
+bool MCGContextCopyDisplayList(MCGContextRef context, MCGDisplayListRef& r_display_list);
+// Replays the drawing of a display list through the context's current transform
+// and clip.
+void MCGContextDrawDisplayList(MCGContextRef context, MCGDisplayListRef display_list);
+
 void MCGContextDrawPlatformText(MCGContextRef context, const unichar_t *text, uindex_t length, MCGPoint location, const MCGFont &font, bool p_rtl);
 // MM-2014-04-16: [[ Bug 11964 ]] Updated prototype to take transform parameter.
 MCGFloat MCGContextMeasurePlatformText(MCGContextRef context, const unichar_t *text, uindex_t length, const MCGFont &p_font, const MCGAffineTransform &p_transform);
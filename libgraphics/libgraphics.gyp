@@ -1,7 +1,30 @@
 {
+	'variables':
+	{
+		'module_name': 'libGraphics',
+		'module_test_dependencies':
+		[
+			'libGraphics',
+			'../prebuilt/thirdparty.gyp:thirdparty_prebuilt_skia',
+		],
+		'module_test_include_dirs':
+		[
+			'include',
+			'src',
+		],
+		'module_test_sources':
+		[
+			'test/environment.cpp',
+			'test/test_blur.cpp',
+			'test/test_gradients.cpp',
+			'test/test_spread.cpp',
+		],
+	},
+
 	'includes':
 	[
 		'../common.gypi',
+		'../config/cpptest.gypi',
 	],
 	
 	'targets':
@@ -57,6 +80,7 @@
 				'src/lnxtext.cpp',
 				'src/harfbuzztext.cpp',
 				'src/hb-sk.cpp',
+				'src/parallel.cpp',
 				'src/path.cpp',
 				'src/region.cpp',
 				'src/spread.cpp',
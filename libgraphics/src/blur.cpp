@@ -21,168 +21,225 @@
 
 #define kBlurRadiusFudgeFactor SkFloatToScalar( .57735f )
 
-extern void dilateDistanceXY(const uint8_t *src, uint8_t *dst, int xradius, int yradius, int width, int height, int& r_new_width, int& r_new_height);
-
 ////////////////////////////////////////////////////////////////////////////////
 //
 //  Low / Normal quality blurs - box-blur technique.
 //
+//  Each box blur pass runs down the columns of the mask, keeping a running sum
+//  for every column, so that a whole row is processed at once using vector
+//  instructions. The columns are split into bands which are blurred on the
+//  graphics worker threads. Blurring in X is done to a transposed copy of the
+//  mask, which is transposed back before blurring in Y.
+//
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLUR_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BLUR_NEON
+#include <arm_neon.h>
+#endif
 
-#define UNROLL_SEPARABLE_LOOPS
+// Masks with fewer pixels than this are blurred on a single thread.
+#define kBlurMinBandPixels 32768
 
-/**
- * This function performs a box blur in X, of the given radius.  If the
- * "transpose" parameter is true, it will transpose the pixels on write,
- * such that X and Y are swapped. Reads are always performed from contiguous
- * memory in X, for speed. The destination buffer (dst) must be at least
- * (width + leftRadius + rightRadius) * height bytes in size.
- */
-static int boxBlur(const uint8_t* src, int src_y_stride, uint8_t* dst,
-                   int leftRadius, int rightRadius, int width, int height,
-                   bool transpose)
+// The width of each band of columns is rounded up to a multiple of this, so
+// only the last band has columns left over from the vector loops.
+#define kBlurBandAlignment 16
+
+#if defined(BLUR_SSE2)
+// Widens 16 bytes into four vectors of 32-bit values.
+static inline void widenU8(__m128i v, __m128i r[4])
 {
-    int diameter = leftRadius + rightRadius;
-    int kernelSize = diameter + 1;
-    int border = SkMin32(width, diameter);
-    uint32_t scale = (1 << 24) / kernelSize;
-    int new_width = width + SkMax32(leftRadius, rightRadius) * 2;
-    int dst_x_stride = transpose ? height : 1;
-    int dst_y_stride = transpose ? 1 : new_width;
-    for (int y = 0; y < height; ++y) {
-        int sum = 0;
-        uint8_t* dptr = dst + y * dst_y_stride;
-        const uint8_t* right = src + y * src_y_stride;
-        const uint8_t* left = right;
-        for (int x = 0; x < rightRadius - leftRadius; x++) {
-            *dptr = 0;
-            dptr += dst_x_stride;
-        }
-#define LEFT_BORDER_ITER \
-			sum += *right++; \
-			*dptr = (sum * scale) >> 24; \
-			dptr += dst_x_stride;
-		
-        int x = 0;
-#ifdef UNROLL_SEPARABLE_LOOPS
-        for (; x < border - 16; x += 16) {
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-        }
+    __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_unpacklo_epi8(v, zero);
+    __m128i hi = _mm_unpackhi_epi8(v, zero);
+    r[0] = _mm_unpacklo_epi16(lo, zero);
+    r[1] = _mm_unpackhi_epi16(lo, zero);
+    r[2] = _mm_unpacklo_epi16(hi, zero);
+    r[3] = _mm_unpackhi_epi16(hi, zero);
+}
+
+// Multiplies 32-bit values, keeping the low 32 bits of each product as the
+// scalar code does.
+static inline __m128i mulU32(__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// Narrows four vectors of 32-bit values (which must be at most 255) to bytes.
+static inline __m128i narrowU32(const __m128i v[4])
+{
+    return _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3]));
+}
 #endif
-        for (; x < border; ++x) {
-            LEFT_BORDER_ITER
-        }
-#undef LEFT_BORDER_ITER
-#define TRIVIAL_ITER \
-			*dptr = (sum * scale) >> 24; \
-			dptr += dst_x_stride;
-        x = width;
-#ifdef UNROLL_SEPARABLE_LOOPS
-        for (; x < diameter - 16; x += 16) {
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-        }
+
+#if defined(BLUR_NEON)
+static inline void widenU8(uint8x16_t v, uint32x4_t r[4])
+{
+    uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+    uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+    r[0] = vmovl_u16(vget_low_u16(lo));
+    r[1] = vmovl_u16(vget_high_u16(lo));
+    r[2] = vmovl_u16(vget_low_u16(hi));
+    r[3] = vmovl_u16(vget_high_u16(hi));
+}
+
+static inline uint8x16_t narrowU32(const uint32x4_t v[4])
+{
+    uint16x8_t lo = vcombine_u16(vmovn_u32(v[0]), vmovn_u32(v[1]));
+    uint16x8_t hi = vcombine_u16(vmovn_u32(v[2]), vmovn_u32(v[3]));
+    return vcombine_u8(vmovn_u16(lo), vmovn_u16(hi));
+}
 #endif
-        for (; x < diameter; ++x) {
-            TRIVIAL_ITER
+
+/**
+ * Adds the "add" row to the column sums and writes the sums, scaled by the
+ * 8.24 fixed point "scale", to the "dst" row. The "sub" row is then subtracted
+ * from the sums. Passing a row of zeros leaves out the add or subtract.
+ */
+static void boxBlurRow(uint32_t* sums, const uint8_t* add, const uint8_t* sub,
+                       uint8_t* dst, int width, uint32_t scale)
+{
+    int x = 0;
+#if defined(BLUR_SSE2)
+    __m128i vscale = _mm_set1_epi32(scale);
+    for (; x + 16 <= width; x += 16) {
+        __m128i a[4], s[4], d[4];
+        widenU8(_mm_loadu_si128((const __m128i*)(add + x)), a);
+        widenU8(_mm_loadu_si128((const __m128i*)(sub + x)), s);
+        for (int i = 0; i < 4; i++) {
+            __m128i* sptr = (__m128i*)(sums + x + i * 4);
+            __m128i sum = _mm_add_epi32(_mm_loadu_si128(sptr), a[i]);
+            d[i] = _mm_srli_epi32(mulU32(sum, vscale), 24);
+            _mm_storeu_si128(sptr, _mm_sub_epi32(sum, s[i]));
         }
-#undef TRIVIAL_ITER
-#define CENTER_ITER \
-			sum += *right++; \
-			*dptr = (sum * scale) >> 24; \
-			sum -= *left++; \
-			dptr += dst_x_stride;
-		
-        x = diameter;
-#ifdef UNROLL_SEPARABLE_LOOPS
-        for (; x < width - 16; x += 16) {
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
+        _mm_storeu_si128((__m128i*)(dst + x), narrowU32(d));
+    }
+#elif defined(BLUR_NEON)
+    uint32x4_t vscale = vdupq_n_u32(scale);
+    for (; x + 16 <= width; x += 16) {
+        uint32x4_t a[4], s[4], d[4];
+        widenU8(vld1q_u8(add + x), a);
+        widenU8(vld1q_u8(sub + x), s);
+        for (int i = 0; i < 4; i++) {
+            uint32_t* sptr = sums + x + i * 4;
+            uint32x4_t sum = vaddq_u32(vld1q_u32(sptr), a[i]);
+            d[i] = vshrq_n_u32(vmulq_u32(sum, vscale), 24);
+            vst1q_u32(sptr, vsubq_u32(sum, s[i]));
         }
+        vst1q_u8(dst + x, narrowU32(d));
+    }
 #endif
-        for (; x < width; ++x) {
-            CENTER_ITER
+    for (; x < width; x++) {
+        uint32_t sum = sums[x] + add[x];
+        dst[x] = (sum * scale) >> 24;
+        sums[x] = sum - sub[x];
+    }
+}
+
+/**
+ * This variant of boxBlurRow() interpolates between an outer and an inner
+ * sum, for blurring with non-integer radii. The outer sum is the column sum
+ * after adding the "add" row, and the inner sum is the column sum less the
+ * "inner_sub" row. The "sub" row is subtracted from the outer sum to give the
+ * new column sum.
+ */
+static void boxBlurInterpRow(uint32_t* sums, const uint8_t* add,
+                             const uint8_t* inner_sub, const uint8_t* sub,
+                             uint8_t* dst, int width,
+                             uint32_t outer_scale, uint32_t inner_scale)
+{
+    int x = 0;
+#if defined(BLUR_SSE2)
+    __m128i vouter_scale = _mm_set1_epi32(outer_scale);
+    __m128i vinner_scale = _mm_set1_epi32(inner_scale);
+    for (; x + 16 <= width; x += 16) {
+        __m128i a[4], is[4], s[4], d[4];
+        widenU8(_mm_loadu_si128((const __m128i*)(add + x)), a);
+        widenU8(_mm_loadu_si128((const __m128i*)(inner_sub + x)), is);
+        widenU8(_mm_loadu_si128((const __m128i*)(sub + x)), s);
+        for (int i = 0; i < 4; i++) {
+            __m128i* sptr = (__m128i*)(sums + x + i * 4);
+            __m128i sum = _mm_loadu_si128(sptr);
+            __m128i inner_sum = _mm_sub_epi32(sum, is[i]);
+            __m128i outer_sum = _mm_add_epi32(sum, a[i]);
+            d[i] = _mm_srli_epi32(_mm_add_epi32(mulU32(outer_sum, vouter_scale),
+                                                mulU32(inner_sum, vinner_scale)), 24);
+            _mm_storeu_si128(sptr, _mm_sub_epi32(outer_sum, s[i]));
         }
-#undef CENTER_ITER
-#define RIGHT_BORDER_ITER \
-			*dptr = (sum * scale) >> 24; \
-			sum -= *left++; \
-			dptr += dst_x_stride;
-		
-        x = 0;
-#ifdef UNROLL_SEPARABLE_LOOPS
-        for (; x < border - 16; x += 16) {
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
+        _mm_storeu_si128((__m128i*)(dst + x), narrowU32(d));
+    }
+#elif defined(BLUR_NEON)
+    uint32x4_t vouter_scale = vdupq_n_u32(outer_scale);
+    uint32x4_t vinner_scale = vdupq_n_u32(inner_scale);
+    for (; x + 16 <= width; x += 16) {
+        uint32x4_t a[4], is[4], s[4], d[4];
+        widenU8(vld1q_u8(add + x), a);
+        widenU8(vld1q_u8(inner_sub + x), is);
+        widenU8(vld1q_u8(sub + x), s);
+        for (int i = 0; i < 4; i++) {
+            uint32_t* sptr = sums + x + i * 4;
+            uint32x4_t sum = vld1q_u32(sptr);
+            uint32x4_t inner_sum = vsubq_u32(sum, is[i]);
+            uint32x4_t outer_sum = vaddq_u32(sum, a[i]);
+            d[i] = vshrq_n_u32(vmlaq_u32(vmulq_u32(outer_sum, vouter_scale),
+                                         inner_sum, vinner_scale), 24);
+            vst1q_u32(sptr, vsubq_u32(outer_sum, s[i]));
         }
+        vst1q_u8(dst + x, narrowU32(d));
+    }
 #endif
-        for (; x < border; ++x) {
-            RIGHT_BORDER_ITER
-        }
-#undef RIGHT_BORDER_ITER
-        for (int t_x = 0; t_x < leftRadius - rightRadius; t_x++) {
-            *dptr = 0;
-            dptr += dst_x_stride;
-        }
-        SkASSERT(sum == 0);
+    for (; x < width; x++) {
+        uint32_t inner_sum = sums[x] - inner_sub[x];
+        uint32_t outer_sum = sums[x] + add[x];
+        dst[x] = (outer_sum * outer_scale + inner_sum * inner_scale) >> 24;
+        sums[x] = outer_sum - sub[x];
     }
-    return new_width;
+}
+
+/**
+ * This function performs a box blur down each of the "width" columns of src,
+ * of the given radius. The result has height + 2 * radius rows, and the new
+ * height is returned. The "sums" buffer must have room for "width" values,
+ * and "zeros" must point to at least "width" zero bytes.
+ */
+static int boxBlurColumns(const uint8_t* src, int src_stride,
+                          uint8_t* dst, int dst_stride,
+                          uint32_t* sums, const uint8_t* zeros,
+                          int radius, int width, int height)
+{
+    int diameter = radius * 2;
+    int kernelSize = diameter + 1;
+    int border = SkMin32(height, diameter);
+    uint32_t scale = (1 << 24) / kernelSize;
+    const uint8_t* right = src;
+    const uint8_t* left = src;
+    memset(sums, 0, width * sizeof(uint32_t));
+    for (int y = 0; y < border; y++) {
+        boxBlurRow(sums, right, zeros, dst, width, scale);
+        right += src_stride;
+        dst += dst_stride;
+    }
+    for (int y = height; y < diameter; y++) {
+        boxBlurRow(sums, zeros, zeros, dst, width, scale);
+        dst += dst_stride;
+    }
+    for (int y = diameter; y < height; y++) {
+        boxBlurRow(sums, right, left, dst, width, scale);
+        right += src_stride;
+        left += src_stride;
+        dst += dst_stride;
+    }
+    for (int y = 0; y < border; y++) {
+        boxBlurRow(sums, zeros, left, dst, width, scale);
+        left += src_stride;
+        dst += dst_stride;
+    }
+    return height + diameter;
 }
 
 /**
@@ -193,131 +250,200 @@ static int boxBlur(const uint8_t* src, int src_y_stride, uint8_t* dst,
  *  outer_weight * outer_sum / kernelSize +
  *  (1.0 - outer_weight) * innerSum / (kernelSize - 2)
  */
-static int boxBlurInterp(const uint8_t* src, int src_y_stride, uint8_t* dst,
-                         int radius, int width, int height,
-                         bool transpose, uint8_t outer_weight)
+static int boxBlurInterpColumns(const uint8_t* src, int src_stride,
+                                uint8_t* dst, int dst_stride,
+                                uint32_t* sums, const uint8_t* zeros,
+                                int radius, int width, int height,
+                                uint8_t outer_weight)
 {
     int diameter = radius * 2;
     int kernelSize = diameter + 1;
-    int border = SkMin32(width, diameter);
+    int border = SkMin32(height, diameter);
     int inner_weight = 255 - outer_weight;
     outer_weight += outer_weight >> 7;
     inner_weight += inner_weight >> 7;
     uint32_t outer_scale = (outer_weight << 16) / kernelSize;
     uint32_t inner_scale = (inner_weight << 16) / (kernelSize - 2);
-    int new_width = width + diameter;
-    int dst_x_stride = transpose ? height : 1;
-    int dst_y_stride = transpose ? 1 : new_width;
-    for (int y = 0; y < height; ++y) {
-        int outer_sum = 0, inner_sum = 0;
-        uint8_t* dptr = dst + y * dst_y_stride;
-        const uint8_t* right = src + y * src_y_stride;
-        const uint8_t* left = right;
-        int x = 0;
-		
-#define LEFT_BORDER_ITER \
-			inner_sum = outer_sum; \
-			outer_sum += *right++; \
-			*dptr = (outer_sum * outer_scale + inner_sum * inner_scale) >> 24; \
-			dptr += dst_x_stride;
-		
-#ifdef UNROLL_SEPARABLE_LOOPS
-        for (;x < border - 16; x += 16) {
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-        }
-#endif
-		
-        for (;x < border; x++) {
-            LEFT_BORDER_ITER
-        }
-#undef LEFT_BORDER_ITER
-        for (int t_x = width; t_x < diameter; ++t_x) {
-            *dptr = (outer_sum * outer_scale + inner_sum * inner_scale) >> 24;
-            dptr += dst_x_stride;
+    const uint8_t* right = src;
+    const uint8_t* left = src;
+    memset(sums, 0, width * sizeof(uint32_t));
+    for (int y = 0; y < border; y++) {
+        boxBlurInterpRow(sums, right, zeros, zeros, dst, width, outer_scale, inner_scale);
+        right += src_stride;
+        dst += dst_stride;
+    }
+    // If the kernel is taller than the mask, the sums stay the same until the
+    // kernel starts to leave the mask. The inner sum excludes the last row.
+    const uint8_t* last = right != src ? right - src_stride : zeros;
+    for (int y = height; y < diameter; y++) {
+        boxBlurInterpRow(sums, zeros, last, zeros, dst, width, outer_scale, inner_scale);
+        dst += dst_stride;
+    }
+    for (int y = diameter; y < height; y++) {
+        boxBlurInterpRow(sums, right, left, left, dst, width, outer_scale, inner_scale);
+        right += src_stride;
+        left += src_stride;
+        dst += dst_stride;
+    }
+    for (int y = 0; y < border; y++) {
+        boxBlurInterpRow(sums, zeros, left, left, dst, width, outer_scale, inner_scale);
+        left += src_stride;
+        dst += dst_stride;
+    }
+    return height + diameter;
+}
+
+#if defined(BLUR_SSE2) || defined(BLUR_NEON)
+/**
+ * Transposes a 16x16 tile of bytes. Interleaving the top half of the rows with
+ * the bottom half four times moves every byte to its transposed position.
+ */
+static void transposeTile(const uint8_t* src, int src_stride, uint8_t* dst, int dst_stride)
+{
+#if defined(BLUR_SSE2)
+    __m128i rows[16], next[16];
+    for (int i = 0; i < 16; i++)
+        rows[i] = _mm_loadu_si128((const __m128i*)(src + i * src_stride));
+    for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < 8; i++) {
+            next[i * 2] = _mm_unpacklo_epi8(rows[i], rows[i + 8]);
+            next[i * 2 + 1] = _mm_unpackhi_epi8(rows[i], rows[i + 8]);
         }
-        x = diameter;
-		
-#define CENTER_ITER \
-			inner_sum = outer_sum - *left; \
-			outer_sum += *right++; \
-			*dptr = (outer_sum * outer_scale + inner_sum * inner_scale) >> 24; \
-			dptr += dst_x_stride; \
-			outer_sum -= *left++;
-		
-#ifdef UNROLL_SEPARABLE_LOOPS
-        for (; x < width - 16; x += 16) {
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
+        memcpy(rows, next, sizeof(rows));
+    }
+    for (int i = 0; i < 16; i++)
+        _mm_storeu_si128((__m128i*)(dst + i * dst_stride), rows[i]);
+#else
+    uint8x16_t rows[16], next[16];
+    for (int i = 0; i < 16; i++)
+        rows[i] = vld1q_u8(src + i * src_stride);
+    for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < 8; i++) {
+            uint8x16x2_t zipped = vzipq_u8(rows[i], rows[i + 8]);
+            next[i * 2] = zipped.val[0];
+            next[i * 2 + 1] = zipped.val[1];
         }
+        memcpy(rows, next, sizeof(rows));
+    }
+    for (int i = 0; i < 16; i++)
+        vst1q_u8(dst + i * dst_stride, rows[i]);
 #endif
-        for (; x < width; ++x) {
-            CENTER_ITER
-        }
-#undef CENTER_ITER
-		
-#define RIGHT_BORDER_ITER \
-		inner_sum = outer_sum - *left++; \
-		*dptr = (outer_sum * outer_scale + inner_sum * inner_scale) >> 24; \
-		dptr += dst_x_stride; \
-		outer_sum = inner_sum;
-		
-        x = 0;
-#ifdef UNROLL_SEPARABLE_LOOPS
-        for (; x < border - 16; x += 16) {
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-        }
+}
+#endif
+
+/**
+ * Writes the columns from x0 to x1 of the width x height src to the rows x0
+ * to x1 of dst, which has rows "height" bytes long.
+ */
+static void transposeColumns(const uint8_t* src, int src_stride, uint8_t* dst,
+                             int height, int x0, int x1)
+{
+    for (int bx = x0; bx < x1; bx += 16) {
+        int bx1 = SkMin32(bx + 16, x1);
+        for (int by = 0; by < height; by += 16) {
+            int by1 = SkMin32(by + 16, height);
+#if defined(BLUR_SSE2) || defined(BLUR_NEON)
+            if (bx1 - bx == 16 && by1 - by == 16) {
+                transposeTile(src + by * src_stride + bx, src_stride, dst + bx * height + by, height);
+                continue;
+            }
 #endif
-        for (; x < border; x++) {
-            RIGHT_BORDER_ITER
+            for (int x = bx; x < bx1; x++) {
+                const uint8_t* sptr = src + by * src_stride + x;
+                uint8_t* dptr = dst + x * height + by;
+                for (int y = by; y < by1; y++) {
+                    *dptr++ = *sptr;
+                    sptr += src_stride;
+                }
+            }
         }
-#undef RIGHT_BORDER_ITER
-        SkASSERT(outer_sum == 0 && inner_sum == 0);
     }
-    return new_width;
+}
+
+/**
+ * Returns the number of bands the columns of a width x height mask should be
+ * split into, and the width of each.
+ */
+static uint32_t countBands(int width, int height, int& r_band_width)
+{
+    if (width <= 0) {
+        r_band_width = 0;
+        return 0;
+    }
+
+    uint32_t bands = (uint32_t)(((int64_t)width * SkMax32(height, 1)) / kBlurMinBandPixels);
+    bands = SkMin32(bands, MCGParallelGetThreadCount());
+    bands = SkMax32(bands, 1);
+
+    r_band_width = (width + bands - 1) / bands;
+    r_band_width = (r_band_width + kBlurBandAlignment - 1) & ~(kBlurBandAlignment - 1);
+    return (width + r_band_width - 1) / r_band_width;
+}
+
+struct TransposeBands {
+    const uint8_t* src;
+    int src_stride;
+    uint8_t* dst;
+    int width;
+    int height;
+    int band_width;
+};
+
+static void transposeBand(void* context, uint32_t index)
+{
+    TransposeBands* bands = (TransposeBands*)context;
+    int x0 = index * bands->band_width;
+    int x1 = SkMin32(x0 + bands->band_width, bands->width);
+    transposeColumns(bands->src, bands->src_stride, bands->dst, bands->height, x0, x1);
+}
+
+/**
+ * Transposes the width x height src into dst, whose rows are "height" bytes
+ * long.
+ */
+static void transposeMask(const uint8_t* src, int src_stride, uint8_t* dst,
+                          int width, int height)
+{
+    TransposeBands bands;
+    bands.src = src;
+    bands.src_stride = src_stride;
+    bands.dst = dst;
+    bands.width = width;
+    bands.height = height;
+    MCGParallelFor(countBands(width, height, bands.band_width), transposeBand, &bands);
+}
+
+struct BlurBands {
+    uint8_t* buffer;
+    uint8_t* temp;
+    uint32_t* sums;
+    const uint8_t* zeros;
+    int width;
+    int height;
+    int radii[3];
+    uint8_t weight;
+    int band_width;
+};
+
+static void blurBand(void* context, uint32_t index)
+{
+    BlurBands* bands = (BlurBands*)context;
+    int x0 = index * bands->band_width;
+    int width = SkMin32(bands->band_width, bands->width - x0);
+    int stride = bands->width;
+    uint8_t* buffer = bands->buffer + x0;
+    uint8_t* temp = bands->temp + x0;
+    uint32_t* sums = bands->sums + x0;
+    int h = bands->height;
+    if (bands->weight == 255) {
+        h = boxBlurColumns(buffer, stride, temp, stride, sums, bands->zeros, bands->radii[0], width, h);
+        h = boxBlurColumns(temp, stride, buffer, stride, sums, bands->zeros, bands->radii[1], width, h);
+        boxBlurColumns(buffer, stride, temp, stride, sums, bands->zeros, bands->radii[2], width, h);
+    } else {
+        h = boxBlurInterpColumns(buffer, stride, temp, stride, sums, bands->zeros, bands->radii[0], width, h, bands->weight);
+        h = boxBlurInterpColumns(temp, stride, buffer, stride, sums, bands->zeros, bands->radii[1], width, h, bands->weight);
+        boxBlurInterpColumns(buffer, stride, temp, stride, sums, bands->zeros, bands->radii[2], width, h, bands->weight);
+    }
 }
 
 // pass 0 is (radius + (3 - 0 - 1)) / (3 - 0) = (radius + 2) / 3  (4)
@@ -326,11 +452,35 @@ static int boxBlurInterp(const uint8_t* src, int src_y_stride, uint8_t* dst,
 // radius -= p1_radius
 // pass 2 is (radius + (3 - 2 - 1)) / (3 - 2) = (radius + 0) / 1  (3)
 
+/**
+ * Applies three box blur passes, approximating a gaussian of the given radius,
+ * down the columns of the width x height mask in buffer. The passes alternate
+ * between buffer and temp, leaving the result in temp, and the new height is
+ * returned. A weight other than 255 blurs with a non-integer radius.
+ */
+static int boxBlurColumns3(uint8_t* buffer, uint8_t* temp, uint32_t* sums,
+                           const uint8_t* zeros, int width, int height,
+                           int radius, uint8_t weight)
+{
+    BlurBands bands;
+    bands.buffer = buffer;
+    bands.temp = temp;
+    bands.sums = sums;
+    bands.zeros = zeros;
+    bands.width = width;
+    bands.height = height;
+    bands.weight = weight;
+    bands.radii[0] = (radius + 2) / 3;
+    radius -= bands.radii[0];
+    bands.radii[1] = (radius + 1) / 2;
+    radius -= bands.radii[1];
+    bands.radii[2] = radius;
+    MCGParallelFor(countBands(width, height, bands.band_width), blurBand, &bands);
+    return height + (bands.radii[0] + bands.radii[1] + bands.radii[2]) * 2;
+}
+
 bool MCGBlurBox(const SkMask& p_src, SkScalar p_x_radius, SkScalar p_y_radius, SkScalar p_x_spread, SkScalar p_y_spread, SkMask& r_dst)
 {
-	int t_pass_count;
-	t_pass_count = 3;
-	
 	// Maximum amount of spread is 254 pixels.
 	int x_spread, y_spread;
 	x_spread = SkMin32(SkScalarFloor(p_x_radius * p_x_spread), 254);
@@ -389,140 +539,52 @@ bool MCGBlurBox(const SkMask& p_src, SkScalar p_x_radius, SkScalar p_y_radius, S
 		return false;
 	}
 	
+	// The column sums, and the row of zeros, are used by both directions so
+	// must cover the larger of the blurred width and height.
+	uindex_t t_max_columns;
+	t_max_columns = SkMax32(r_dst . fBounds . width(), r_dst . fBounds . height());
+	
+	uint32_t *t_sums;
+	t_sums = nil;
+	uint8_t *t_zeros;
+	t_zeros = nil;
+	if (!MCMemoryNewArray(t_max_columns, t_sums) ||
+		!MCMemoryNewArray(t_max_columns, t_zeros))
+	{
+		MCMemoryDeleteArray(t_sums);
+		SkMask::FreeImage(tp);
+		SkMask::FreeImage(dp);
+		return false;
+	}
+	
 	int w, h;
 	w = sw;
 	h = sh;
-	if (wx == 255)
-	{
-		if (t_pass_count == 3)
-		{
-			int r;
-			r = rx;
-			
-			bool t_has_spread;
-			t_has_spread = false;
-			if (x_spread != 0 || y_spread != 0)
-			{
-				//w = dilateMask(sp, p_src . fRowBytes, tp, x_spread, w, h, true);
-				//h = dilateMask(tp, h, dp, y_spread, h, w, true);
-				dilateDistanceXY(sp, dp, x_spread, y_spread, w, h, w, h);
-				t_has_spread = true;
-			}
-			
-			int trx;
-			trx = (r + 2) / 3; 
-			r -= trx;
-			
-			int rx_lo, rx_hi;
-			rx_lo = rx_hi = trx;
-			
-			w = boxBlur(t_has_spread ? dp : sp, t_has_spread ? w : p_src . fRowBytes, tp, rx_lo, rx_hi, w, h, false);
-			
-			trx = (r + 1) / 2;
-			r -= trx;
-			
-			rx_lo = rx_hi = trx;
-			w = boxBlur(tp, w, dp, rx_hi, rx_lo, w, h, false);
-			
-			trx = r;
-			rx_lo = rx_hi = trx;
-			w = boxBlur(dp, w, tp, rx_hi, rx_hi, w, h, true);
-		}
-		else
-			w = boxBlur(sp, p_src . fRowBytes, tp, rx, rx, w, h, true);
-	}
-	else
-	{
-		if (t_pass_count == 3)
-		{
-			int r;
-			r = rx;
-			
-			bool t_has_spread;
-			t_has_spread = false;
-			if (x_spread != 0 || y_spread != 0)
-			{
-				//w = dilateMask(sp, p_src . fRowBytes, tp, x_spread, w, h, true);
-				//h = dilateMask(tp, h, dp, y_spread, h, w, true);
-				dilateDistanceXY(sp, dp, x_spread, y_spread, w, h, w, h);
-				t_has_spread = true;
-			}
-			
-			int trx;
-			trx = (r + 2) / 3; 
-			r -= trx;
-			
-			w = boxBlurInterp(t_has_spread ? dp : sp, t_has_spread ? w : p_src . fRowBytes, tp, trx, w, h, false, wx);
-			
-			trx = (r + 1) / 2;
-			r -= trx;
-			
-			w = boxBlurInterp(tp, w, dp, trx, w, h, false, wx);
-			
-			trx = r;
-			
-			w = boxBlurInterp(dp, w, tp, trx, w, h, true, wx);
-		}
-		else
-			w = boxBlurInterp(sp, p_src . fRowBytes, tp, rx, w, h, true, wx);
-	}
 	
-	if (wy == 255)
+	// Blur the rows by blurring the columns of the transposed mask, which
+	// leaves the h x w result in dp. Spreading produces the transposed mask
+	// directly, using dp for its working.
+	if (x_spread != 0 || y_spread != 0)
 	{
-		if (t_pass_count == 3)
+		if (!dilateDistanceXY(sp, p_src . fRowBytes, tp, dp, x_spread, y_spread, w, h, w, h))
 		{
-			int r;
-			r = ry;
-			
-			int sry;
-			sry = (r + 2) / 3;
-			r -= sry;
-			
-			int ry_lo, ry_hi;
-			ry_lo = ry_hi = sry;
-			
-			h = boxBlur(tp, h, dp, ry_lo, ry_hi, h, w, false);
-			
-			sry = (r + 1) / 2;
-			r -= sry;
-			ry_lo = ry_hi = sry;
-			
-			h = boxBlur(dp, h, tp, ry_hi, ry_lo, h, w, false);
-			
-			sry = r;
-			ry_lo = ry_hi = sry;
-			
-			h = boxBlur(tp, h, dp, ry_hi, ry_hi, h, w, true);
+			MCMemoryDeleteArray(t_zeros);
+			MCMemoryDeleteArray(t_sums);
+			SkMask::FreeImage(tp);
+			SkMask::FreeImage(dp);
+			return false;
 		}
-		else
-			h = boxBlur(tp, h, dp, ry, ry, h, w, true);
 	}
 	else
-	{
-		if (t_pass_count == 3)
-		{
-			int r;
-			r = ry;
-			
-			int sry;
-			sry = (r + 2) / 3;
-			r -= sry;
-			
-			h = boxBlurInterp(tp, h, dp, sry, h, w, false, wy);
-			
-			sry = (r + 1) / 2;
-			r -= sry;
-			
-			h = boxBlurInterp(dp, h, tp, sry, h, w, false, wy);
-			
-			sry = r;
-			
-			h = boxBlurInterp(tp, h, dp, sry, h, w, true, wy);
-		}
-		else
-			w = boxBlurInterp(tp, h, dp, rx, h, w, true, wy);
-	}
+		transposeMask(sp, p_src . fRowBytes, tp, w, h);
+	w = boxBlurColumns3(tp, dp, t_sums, t_zeros, h, w, rx, wx);
+	
+	// Transpose back, and blur the columns to leave the w x h result in dp.
+	transposeMask(dp, h, tp, h, w);
+	h = boxBlurColumns3(tp, dp, t_sums, t_zeros, w, h, ry, wy);
 	
+	MCMemoryDeleteArray(t_zeros);
+	MCMemoryDeleteArray(t_sums);
 	SkMask::FreeImage(tp);
 	
 	r_dst . fImage = dp;
@@ -32,6 +32,7 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include <SkTypeface.h>
 #include <SkColorPriv.h>
 #include <SkSurface.h>
+#include <SkBBHFactory.h>
 
 #include <time.h>
 
@@ -351,6 +352,9 @@ static void MCGContextDestroy(MCGContextRef self)
 
 		if (self -> path != NULL)
 			MCGPathRelease(self -> path);
+		
+		// The recorder owns the base layer's canvas, so must go after the layers.
+		delete self -> recorder;
 	}
 	
 	MCMemoryDelete(self);
@@ -472,6 +476,39 @@ bool MCGContextCreate(uint32_t p_width, uint32_t p_height, bool p_alpha, MCGCont
 	//return MCGContextCreateWithSurface(t_surface, r_context);
 }
 
+bool MCGContextCreateForDisplayList(const MCGIntegerRectangle& p_bounds, bool p_opaque, MCGContextRef& r_context)
+{
+	MCGContextRef t_context = nullptr;
+	if (!MCGContextCreateUnbound(t_context))
+		return false;
+	
+	bool t_success = true;
+	
+	t_context->recorder = new (nothrow) SkPictureRecorder;
+	t_context->recorder_is_opaque = p_opaque;
+	t_success = t_context->recorder != nil;
+	
+	// Record into an R-tree, so that replaying the list into a small clip only
+	// draws the operations which touch it.
+	SkCanvas *t_canvas = nil;
+	if (t_success)
+	{
+		SkRTreeFactory t_factory;
+		t_canvas = t_context->recorder->beginRecording(SkRect::MakeXYWH(p_bounds.origin.x, p_bounds.origin.y, p_bounds.size.width, p_bounds.size.height), &t_factory);
+		t_success = t_canvas != nil;
+	}
+	
+	if (t_success)
+		t_success = MCGContextLayerCreateWithCanvas(t_canvas, t_context->layer);
+	
+	if (t_success)
+		r_context = t_context;
+	else
+		MCGContextDestroy(t_context);
+	
+	return t_success;
+}
+
 bool MCGContextCreateWithRaster(const MCGRaster& p_raster, MCGContextRef& r_context)
 {
 	SkBitmap t_bitmap;
@@ -561,6 +598,11 @@ bool MCGContextIsValid(MCGContextRef self)
 
 bool MCGContextIsLayerOpaque(MCGContextRef self)
 {
+	// A recording canvas has no pixels, so take the opacity of the layers the
+	// recording is for.
+	if (self->recorder != nil && self->layer->parent == nil)
+		return self->recorder_is_opaque;
+	
 	return SkAlphaTypeIsOpaque(self->layer->canvas->imageInfo().alphaType());
 }
 
@@ -746,8 +788,11 @@ void MCGContextBeginWithEffects(MCGContextRef self, MCGRectangle p_shape, const
 	t_device_clip = MCGRectangleComputeHull(MCGContextGetDeviceClipBounds(self));
 
 	// First transform the shape rect by the total transform to get it's rectangle in device space.
+	MCGRectangle t_device_shape_rect;
+	t_device_shape_rect = MCGRectangleApplyAffineTransform(p_shape, t_device_transform);
+	
 	MCGIRectangle t_device_shape;
-	t_device_shape = MCGRectangleComputeHull(MCGRectangleApplyAffineTransform(p_shape, t_device_transform));
+	t_device_shape = MCGRectangleComputeHull(t_device_shape_rect);
 	
 	// This is the rectangle of pixels not related to bitmap effects which are needed.
 	MCGIRectangle t_layer_clip;
@@ -897,6 +942,7 @@ void MCGContextBeginWithEffects(MCGContextRef self, MCGRectangle p_shape, const
 	t_new_layer -> origin_y = t_layer_clip . top;
 	t_new_layer -> has_effects = true;
 	t_new_layer -> effects = p_effects;
+	t_new_layer -> effects_shape = t_device_shape_rect;
 	self -> layer = t_new_layer;
 }
 
@@ -915,7 +961,172 @@ static void MCGMaskedDeviceFill(SkCanvas& p_canvas, const SkMask& p_mask, const
 	p_canvas.restore();
 }
 
-static void MCGContextRenderEffect(MCGContextRef self, const SkMask& p_mask, MCGSize p_radii, MCGSize p_offset, MCGFloat p_spread, MCGBlurType p_attenuation, MCGColor p_color, MCGBlendMode p_blend)
+////////////////////////////////////////////////////////////////////////////////
+
+// The number of blurred masks kept for each object - enough for all the blur
+// effects when they have different parameters.
+#define kMCGBitmapEffectsCacheSize 4
+
+// The state which determines the pixels of an unblurred effects mask - the
+// generation of the content, the device transform (less any whole pixel
+// translation) and the part of the shape which was rendered.
+struct MCGBitmapEffectsCacheKey
+{
+	uint32_t generation;
+	MCGAffineTransform transform;
+	SkIRect bounds;
+};
+
+struct MCGBitmapEffectsCacheEntry
+{
+	bool valid;
+	uint32_t last_used;
+	MCGBitmapEffectsCacheKey key;
+	MCGSize radii;
+	MCGFloat spread;
+	// The blurred mask, with bounds relative to the top-left of the shape.
+	SkMask mask;
+};
+
+struct __MCGBitmapEffectsCache
+{
+	MCGBitmapEffectsCacheEntry entries[kMCGBitmapEffectsCacheSize];
+	uint32_t clock;
+};
+
+bool MCGBitmapEffectsCacheCreate(MCGBitmapEffectsCacheRef& r_cache)
+{
+	return MCMemoryNew(r_cache);
+}
+
+void MCGBitmapEffectsCacheRelease(MCGBitmapEffectsCacheRef self)
+{
+	if (self == nil)
+		return;
+	
+	for(uint32_t i = 0; i < kMCGBitmapEffectsCacheSize; i++)
+		if (self -> entries[i] . valid)
+			SkMask::FreeImage(self -> entries[i] . mask . fImage);
+	
+	MCMemoryDelete(self);
+}
+
+static bool MCGBitmapEffectsCacheKeyIsEqual(const MCGBitmapEffectsCacheKey& p_left, const MCGBitmapEffectsCacheKey& p_right)
+{
+	return p_left . generation == p_right . generation &&
+			p_left . transform . a == p_right . transform . a &&
+			p_left . transform . b == p_right . transform . b &&
+			p_left . transform . c == p_right . transform . c &&
+			p_left . transform . d == p_right . transform . d &&
+			p_left . transform . tx == p_right . transform . tx &&
+			p_left . transform . ty == p_right . transform . ty &&
+			p_left . bounds == p_right . bounds;
+}
+
+// Computes the key for the mask of the given layer, returning the offset of the
+// shape so that masks can be stored relative to it. The key is such that moving
+// the shape by whole device pixels (for example, when its group is scrolled)
+// doesn't change it.
+static void MCGBitmapEffectsCacheComputeKey(MCGContextRef self, MCGContextLayerRef p_layer, const SkMask& p_mask, MCGBitmapEffectsCacheKey& r_key, int32_t& r_dx, int32_t& r_dy)
+{
+	MCGFloat t_x, t_y;
+	t_x = floorf(p_layer -> effects_shape . origin . x);
+	t_y = floorf(p_layer -> effects_shape . origin . y);
+	
+	r_key . generation = p_layer -> effects . generation;
+	r_key . transform = MCGContextGetDeviceTransform(self);
+	r_key . transform . tx = p_layer -> effects_shape . origin . x - t_x;
+	r_key . transform . ty = p_layer -> effects_shape . origin . y - t_y;
+	r_key . bounds = p_mask . fBounds;
+	r_key . bounds . offset(-(int32_t)t_x, -(int32_t)t_y);
+	
+	r_dx = (int32_t)t_x;
+	r_dy = (int32_t)t_y;
+}
+
+// Blurs the mask as MCGBlurBox does, reusing the blurred mask from a previous
+// render if the cache has one for the same mask and parameters.
+static bool MCGContextBlurEffectMask(MCGBitmapEffectsCacheRef p_cache, const MCGBitmapEffectsCacheKey *p_key, int32_t p_dx, int32_t p_dy, const SkMask& p_mask, MCGSize p_radii, MCGFloat p_spread, SkMask& r_blurred_mask)
+{
+	if (p_cache == nil || p_key == nil)
+		return MCGBlurBox(p_mask, p_radii . width, p_radii . height, p_spread, p_spread, r_blurred_mask);
+	
+	p_cache -> clock += 1;
+	
+	MCGBitmapEffectsCacheEntry *t_entry;
+	t_entry = nil;
+	for(uint32_t i = 0; i < kMCGBitmapEffectsCacheSize; i++)
+	{
+		MCGBitmapEffectsCacheEntry& t_candidate = p_cache -> entries[i];
+		if (t_candidate . valid &&
+			t_candidate . radii . width == p_radii . width &&
+			t_candidate . radii . height == p_radii . height &&
+			t_candidate . spread == p_spread &&
+			MCGBitmapEffectsCacheKeyIsEqual(t_candidate . key, *p_key))
+		{
+			t_entry = &t_candidate;
+			break;
+		}
+	}
+	
+	// The caller modifies the blurred mask, so it always gets its own copy.
+	if (t_entry != nil)
+	{
+		size_t t_size;
+		t_size = t_entry -> mask . computeImageSize();
+		
+		r_blurred_mask = t_entry -> mask;
+		r_blurred_mask . fBounds . offset(p_dx, p_dy);
+		r_blurred_mask . fImage = SkMask::AllocImage(t_size);
+		if (r_blurred_mask . fImage == nil)
+			return false;
+		
+		MCMemoryCopy(r_blurred_mask . fImage, t_entry -> mask . fImage, t_size);
+		t_entry -> last_used = p_cache -> clock;
+		return true;
+	}
+	
+	if (!MCGBlurBox(p_mask, p_radii . width, p_radii . height, p_spread, p_spread, r_blurred_mask))
+		return false;
+	
+	if (r_blurred_mask . fImage == nil)
+		return true;
+	
+	// Replace the least recently used entry with the new mask.
+	t_entry = &p_cache -> entries[0];
+	for(uint32_t i = 1; i < kMCGBitmapEffectsCacheSize && t_entry -> valid; i++)
+		if (!p_cache -> entries[i] . valid || p_cache -> entries[i] . last_used < t_entry -> last_used)
+			t_entry = &p_cache -> entries[i];
+	
+	if (t_entry -> valid)
+		SkMask::FreeImage(t_entry -> mask . fImage);
+	t_entry -> valid = false;
+	
+	size_t t_size;
+	t_size = r_blurred_mask . computeImageSize();
+	
+	uint8_t *t_image;
+	t_image = SkMask::AllocImage(t_size);
+	if (t_image == nil)
+		return true;
+	
+	MCMemoryCopy(t_image, r_blurred_mask . fImage, t_size);
+	
+	t_entry -> valid = true;
+	t_entry -> last_used = p_cache -> clock;
+	t_entry -> key = *p_key;
+	t_entry -> radii = p_radii;
+	t_entry -> spread = p_spread;
+	t_entry -> mask = r_blurred_mask;
+	t_entry -> mask . fBounds . offset(-p_dx, -p_dy);
+	t_entry -> mask . fImage = t_image;
+	
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void MCGContextRenderEffect(MCGContextRef self, MCGBitmapEffectsCacheRef p_cache, const MCGBitmapEffectsCacheKey *p_key, int32_t p_dx, int32_t p_dy, const SkMask& p_mask, MCGSize p_radii, MCGSize p_offset, MCGFloat p_spread, MCGBlurType p_attenuation, MCGColor p_color, MCGBlendMode p_blend)
 {
 	// Get the device transform.
 	MCGAffineTransform t_transform;
@@ -928,7 +1139,7 @@ static void MCGContextRenderEffect(MCGContextRef self, const SkMask& p_mask, MCG
 	
 	// Now blur the mask.
 	SkMask t_blurred_mask;
-	if (!MCGBlurBox(p_mask, t_transformed_radii . width, t_transformed_radii . height, p_spread, p_spread, t_blurred_mask))
+	if (!MCGContextBlurEffectMask(p_cache, p_key, p_dx, p_dy, p_mask, t_transformed_radii, p_spread, t_blurred_mask))
 		return;
 	
 	// Offset the blur mask appropriately.
@@ -1151,8 +1362,25 @@ static void MCGContextRenderEffects(MCGContextRef self, MCGContextLayerRef p_chi
 		for(int x = 0; x < t_child_bitmap . width(); x++)
 			t_child_mask . fImage[y * t_child_mask . fRowBytes + x] = *(((uint32_t *)t_child_bitmap . getPixels()) + y * t_child_bitmap . rowBytes() / 4 + x) >> 24;
 	
+	MCGBitmapEffectsCacheRef t_cache;
+	t_cache = p_effects . cache;
+	
+	MCGBitmapEffectsCacheKey t_key;
+	int32_t t_dx, t_dy;
+	if (t_cache != nil)
+		MCGBitmapEffectsCacheComputeKey(self, p_child, t_child_mask, t_key, t_dx, t_dy);
+	else
+	{
+		t_dx = 0;
+		t_dy = 0;
+	}
+	
 	if (p_effects . has_drop_shadow)
 		MCGContextRenderEffect(self,
+							   t_cache,
+							   &t_key,
+							   t_dx,
+							   t_dy,
 							   t_child_mask,
 							   MCGSizeMake(p_effects . drop_shadow . size, p_effects . drop_shadow . size),
 							   MCGSizeMake(p_effects . drop_shadow . x_offset, p_effects . drop_shadow . y_offset),
@@ -1163,6 +1391,10 @@ static void MCGContextRenderEffects(MCGContextRef self, MCGContextLayerRef p_chi
 	
 	if (p_effects . has_outer_glow)
 		MCGContextRenderEffect(self,
+							   t_cache,
+							   &t_key,
+							   t_dx,
+							   t_dy,
 							   t_child_mask,
 							   MCGSizeMake(p_effects . outer_glow . size, p_effects . outer_glow . size),
 							   MCGSizeMake(0.0, 0.0),
@@ -1182,6 +1414,10 @@ static void MCGContextRenderEffects(MCGContextRef self, MCGContextLayerRef p_chi
 	
 	if (p_effects . has_inner_shadow)
 		MCGContextRenderEffect(self,
+							   t_cache,
+							   &t_key,
+							   t_dx,
+							   t_dy,
 							   t_child_mask,
 							   MCGSizeMake(p_effects . inner_shadow . size, p_effects . inner_shadow . size),
 							   MCGSizeMake(p_effects . inner_shadow . x_offset, p_effects . inner_shadow . y_offset),
@@ -1192,6 +1428,10 @@ static void MCGContextRenderEffects(MCGContextRef self, MCGContextLayerRef p_chi
 	
 	if (p_effects . has_inner_glow)
 		MCGContextRenderEffect(self,
+							   t_cache,
+							   &t_key,
+							   t_dx,
+							   t_dy,
 							   t_child_mask,
 							   MCGSizeMake(p_effects . inner_glow . size, p_effects . inner_glow . size),
 							   MCGSizeMake(0.0, 0.0),
@@ -2540,3 +2780,68 @@ bool MCGContextCopyImage(MCGContextRef self, MCGImageRef &r_image)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+bool MCGContextCopyDisplayList(MCGContextRef self, MCGDisplayListRef& r_display_list)
+{
+	// Only the base layer of a recording context can be copied.
+	if (!MCGContextIsValid(self) || self->recorder == nil || self->layer->parent != nil)
+		return false;
+	
+	__MCGDisplayList *t_display_list;
+	if (!MCMemoryNew(t_display_list))
+		return false;
+	
+	t_display_list->picture = self->recorder->finishRecordingAsPicture();
+	t_display_list->references = 1;
+	
+	// The recording has finished, so nothing more can be drawn.
+	self->is_valid = false;
+	
+	if (t_display_list->picture == nullptr)
+	{
+		MCGDisplayListRelease(t_display_list);
+		return false;
+	}
+	
+	r_display_list = t_display_list;
+	
+	return true;
+}
+
+void MCGContextDrawDisplayList(MCGContextRef self, MCGDisplayListRef p_display_list)
+{
+	if (!MCGContextIsValid(self) || p_display_list == nil)
+		return;
+	
+	self->layer->canvas->drawPicture(p_display_list->picture);
+}
+
+MCGDisplayListRef MCGDisplayListRetain(MCGDisplayListRef self)
+{
+	if (self != nil)
+		self->references++;
+	return self;
+}
+
+void MCGDisplayListRelease(MCGDisplayListRef self)
+{
+	if (self == nil)
+		return;
+	
+	self->references--;
+	if (self->references > 0)
+		return;
+	
+	self->picture.reset();
+	MCMemoryDelete(self);
+}
+
+size_t MCGDisplayListGetByteSize(MCGDisplayListRef self)
+{
+	if (self == nil)
+		return 0;
+	
+	return sizeof(__MCGDisplayList) + self->picture->approximateBytesUsed();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
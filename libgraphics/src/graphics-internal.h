@@ -19,6 +19,8 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #include "graphics.h"
 #include <SkCanvas.h>
+#include <SkPicture.h>
+#include <SkPictureRecorder.h>
 #include <SkDashPathEffect.h>
 #include <SkMask.h>
 #include <SkShader.h>
@@ -315,6 +317,8 @@ struct __MCGContextLayer
 	
 	bool has_effects : 1;
 	MCGBitmapEffects effects;
+	// The device-space rectangle of the shape the effects apply to.
+	MCGRectangle effects_shape;
 	
 	MCGContextLayerRef parent;
 };
@@ -349,12 +353,25 @@ struct __MCGContext
 	MCGContextLayerRef  layer;
 	MCGPathRef			path;
 	
+	// The recorder for contexts created for display lists. It owns the
+	// canvas of the base layer.
+	SkPictureRecorder	*recorder;
+	bool				recorder_is_opaque;
+	
 	bool				is_valid;
 	uint32_t			references;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 
+struct __MCGDisplayList
+{
+	sk_sp<SkPicture> picture;
+	uint32_t references;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 struct __MCGDashes
 {
 	MCGFloat	phase;
@@ -629,6 +646,8 @@ enum MCGBlurType
 
 bool MCGBlurBox(const SkMask& p_src, SkScalar p_x_radius, SkScalar p_y_radius, SkScalar p_x_spread, SkScalar p_y_spread, SkMask& r_dst);
 
+bool dilateDistanceXY(const uint8_t *src, int src_stride, uint8_t *dst, uint8_t *scratch, int xradius, int yradius, int width, int height, int& r_new_width, int& r_new_height);
+
 ////////////////////////////////////////////////////////////////////////////////
 
 typedef struct __MCGCacheTable *MCGCacheTableRef;
@@ -661,6 +680,13 @@ void MCGTextMeasureCacheCompact(void);
 void MCGBlendModesInitialize(void);
 void MCGBlendModesFinalize(void);
 
+void MCGParallelInitialize(void);
+void MCGParallelFinalize(void);
+
+void MCGGradientRampCacheInitialize(void);
+void MCGGradientRampCacheFinalize(void);
+void MCGGradientRampCacheCompact(void);
+
 ////////////////////////////////////////////////////////////////////////////////
 
 struct __MCGRegion
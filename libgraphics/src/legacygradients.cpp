@@ -66,6 +66,14 @@ inline int32 fast_floor(double val) {
 }
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GRADIENT_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#define GRADIENT_NEON
+#include <arm_neon.h>
+#endif
+
 #define STOP_DIFF_PRECISION 24
 #define STOP_DIFF_MULT ((1 << STOP_DIFF_PRECISION) * (uint32_t)255)
 #define STOP_INT_PRECISION 16
@@ -160,16 +168,235 @@ PACKED_INLINE uint32_t packed_avg(uint32_t x, uint32_t y)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Each pair of stops has a table of this many colours, indexed by the weight
+// of the second stop.
+#define GRADIENT_RAMP_WEIGHTS 256
+
+// The number of unused ramp tables which are kept for reuse.
+#define kMCGGradientRampCacheSize 16
+
+// A ramp table holds the fixed point stops of a ramp, along with the colours
+// between each pair of stops (as they are, and premultiplied). Ramps are
+// created afresh whenever a gradient is drawn, so the tables are shared
+// between all ramps with the same stops and colours.
+struct MCGGradientRampTable
+{
+	MCGGradientRampTable *next;
+	uint32_t references;
+	hash_t hash;
+
+	size_t length;
+	SkScalar *stops;
+	SkColor *colors;
+
+	MCGradientFillStop *fill_stops;
+	uint32_t *interpolated;
+	uint32_t *premultiplied;
+	uint32_t first_premultiplied;
+	uint32_t last_premultiplied;
+};
+
+// The tables, most recently used first.
+static MCGGradientRampTable *s_ramp_tables = nil;
+
+static hash_t MCGGradientRampHash(MCGRampRef p_ramp)
+{
+	return MCHashBytesStream(MCHashBytes(p_ramp -> GetStops(), sizeof(SkScalar) * p_ramp -> GetLength()),
+							 p_ramp -> GetColors(), sizeof(SkColor) * p_ramp -> GetLength());
+}
+
+static bool MCGGradientRampTableMatches(MCGGradientRampTable *p_table, hash_t p_hash, MCGRampRef p_ramp)
+{
+	return p_table -> hash == p_hash &&
+		p_table -> length == p_ramp -> GetLength() &&
+		MCMemoryCompare(p_table -> stops, p_ramp -> GetStops(), sizeof(SkScalar) * p_table -> length) == 0 &&
+		MCMemoryCompare(p_table -> colors, p_ramp -> GetColors(), sizeof(SkColor) * p_table -> length) == 0;
+}
+
+static void MCGGradientRampTableDestroy(MCGGradientRampTable *p_table)
+{
+	MCMemoryDeleteArray(p_table -> stops);
+	MCMemoryDeleteArray(p_table -> colors);
+	MCMemoryDeleteArray(p_table -> fill_stops);
+	MCMemoryDeleteArray(p_table -> interpolated);
+	MCMemoryDeleteArray(p_table -> premultiplied);
+	MCMemoryDelete(p_table);
+}
+
+static bool MCGGradientRampTableCreate(MCGRampRef p_ramp, hash_t p_hash, MCGGradientRampTable*& r_table)
+{
+	size_t t_length;
+	t_length = p_ramp -> GetLength();
+	if (t_length == 0)
+		return false;
+	
+	MCGGradientRampTable *t_table;
+	if (!MCMemoryNew(t_table))
+		return false;
+	
+	t_table -> hash = p_hash;
+	t_table -> length = t_length;
+	
+	// The colours after the last stop are all the last stop's colour.
+	size_t t_interpolated_length;
+	t_interpolated_length = t_length * GRADIENT_RAMP_WEIGHTS;
+	
+	if (!MCMemoryNewArray(t_length, t_table -> stops) ||
+		!MCMemoryNewArray(t_length, t_table -> colors) ||
+		!MCMemoryNewArray(t_length, t_table -> fill_stops) ||
+		!MCMemoryNewArray(t_interpolated_length, t_table -> interpolated) ||
+		!MCMemoryNewArray(t_interpolated_length, t_table -> premultiplied))
+	{
+		MCGGradientRampTableDestroy(t_table);
+		return false;
+	}
+	
+	MCMemoryCopy(t_table -> stops, p_ramp -> GetStops(), sizeof(SkScalar) * t_length);
+	MCMemoryCopy(t_table -> colors, p_ramp -> GetColors(), sizeof(SkColor) * t_length);
+	
+	MCGradientFillStop *t_stops;
+	t_stops = t_table -> fill_stops;
+	
+	uint32_t i;
+	for (i = 0; i < t_length; i++)
+	{
+		t_stops[i].offset = (uint32_t) (p_ramp->GetStops()[i] * STOP_INT_MAX);
+		t_stops[i].color = p_ramp->GetColors()[i];
+		
+		if (i != 0)
+		{
+			// MM-2013-11-20: [[ Bug 11479 ]] Make sure we don't divide by zero.
+			if (t_stops[i].offset != t_stops[i - 1].offset)
+			{
+				t_stops[i - 1].difference = (uint32_t)(STOP_DIFF_MULT / (t_stops[i] . offset - t_stops[i - 1] . offset));
+			}
+			else
+			{
+				t_stops[i - 1].difference = (uint32_t) (STOP_DIFF_MULT / STOP_INT_MAX);
+			}
+		}
+		// AL-2014-07-21: [[ Bug 12867 ]] Ensure RBGA values are always packed in native format
+		t_stops[i].hw_color = MCGPixelToNative(kMCGPixelFormatBGRA, t_stops[i] . color);
+	}
+	
+	// MW-2013-10-26: [[ Bug 11315 ]] Index shuold be i - 1 (otherwise memory overrun occurs!).
+	t_stops[i - 1].difference = (uint32_t) (STOP_DIFF_MULT / STOP_INT_MAX);
+	
+	for (i = 0; i < t_length; i++)
+		for (uint32_t b = 0; b < GRADIENT_RAMP_WEIGHTS; b++)
+		{
+			uint32_t s;
+			s = packed_bilinear_bounded(t_stops[i] . hw_color, 255 - b, t_stops[MCMin(i + 1, (uint32_t)t_length - 1)] . hw_color, b);
+			t_table -> interpolated[i * GRADIENT_RAMP_WEIGHTS + b] = s;
+			t_table -> premultiplied[i * GRADIENT_RAMP_WEIGHTS + b] = packed_scale_bounded(s | 0xFF000000, s >> 24);
+		}
+	
+	uint32_t t_first, t_last;
+	t_first = t_stops[0] . hw_color;
+	t_last = t_stops[t_length - 1] . hw_color;
+	t_table -> first_premultiplied = packed_scale_bounded(t_first | 0xFF000000, t_first >> 24);
+	t_table -> last_premultiplied = packed_scale_bounded(t_last | 0xFF000000, t_last >> 24);
+	
+	r_table = t_table;
+	
+	return true;
+}
+
+// Destroys the least recently used unused tables, so that at most p_max_unused
+// remain.
+static void MCGGradientRampCacheTrim(uint32_t p_max_unused)
+{
+	uint32_t t_unused;
+	t_unused = 0;
+	
+	MCGGradientRampTable **t_link;
+	t_link = &s_ramp_tables;
+	while (*t_link != nil)
+	{
+		MCGGradientRampTable *t_table;
+		t_table = *t_link;
+		if (t_table -> references == 0 && t_unused++ >= p_max_unused)
+		{
+			*t_link = t_table -> next;
+			MCGGradientRampTableDestroy(t_table);
+		}
+		else
+			t_link = &t_table -> next;
+	}
+}
+
+static bool MCGGradientRampTableAcquire(MCGRampRef p_ramp, MCGGradientRampTable*& r_table)
+{
+	hash_t t_hash;
+	t_hash = MCGGradientRampHash(p_ramp);
+	
+	MCGGradientRampTable **t_link;
+	t_link = &s_ramp_tables;
+	while (*t_link != nil && !MCGGradientRampTableMatches(*t_link, t_hash, p_ramp))
+		t_link = &(*t_link) -> next;
+	
+	MCGGradientRampTable *t_table;
+	if (*t_link != nil)
+	{
+		t_table = *t_link;
+		*t_link = t_table -> next;
+	}
+	else if (!MCGGradientRampTableCreate(p_ramp, t_hash, t_table))
+		return false;
+	
+	t_table -> next = s_ramp_tables;
+	s_ramp_tables = t_table;
+	
+	t_table -> references += 1;
+	r_table = t_table;
+	
+	return true;
+}
+
+static void MCGGradientRampTableRelease(MCGGradientRampTable *p_table)
+{
+	if (p_table == nil)
+		return;
+	
+	p_table -> references -= 1;
+	if (p_table -> references == 0)
+		MCGGradientRampCacheTrim(kMCGGradientRampCacheSize);
+}
+
+void MCGGradientRampCacheInitialize(void)
+{
+	s_ramp_tables = nil;
+}
+
+void MCGGradientRampCacheFinalize(void)
+{
+	MCGGradientRampCacheTrim(0);
+}
+
+void MCGGradientRampCacheCompact(void)
+{
+	MCGGradientRampCacheTrim(0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 class MCGGeneralizedGradientShader : public SkShader
 {
 public:
     MCGGeneralizedGradientShader(MCGGeneralizedGradientRef p_gradient)
     {
         m_gradient = MCGRetain(p_gradient);
+        
+        // The ramp table is fetched here rather than by each context, as the
+        // ramp cache is not thread-safe but display lists containing the
+        // shader can be replayed on several threads at once.
+        if (!MCGGradientRampTableAcquire(m_gradient->m_ramp, m_table))
+            m_table = nullptr;
     }
     
     ~MCGGeneralizedGradientShader()
     {
+        MCGGradientRampTableRelease(m_table);
         MCGRelease(m_gradient);
     }
     
@@ -193,38 +420,14 @@ public:
             
             int32_t d = vy * wx - vx *wy;
             
-            MCGRampRef t_ramp = p_shader.m_gradient->m_ramp;
-            if (!MCMemoryNewArray(t_ramp->GetLength(), m_ramp))
+            m_table = p_shader.m_table;
+            if (m_table == nullptr)
             {
                 return;
             }
             
-            m_ramp_length = t_ramp->GetLength();
-            
-            uint32_t i;
-            for (i = 0; i < m_ramp_length; i++)
-            {
-                m_ramp[i].offset = (uint32_t) (t_ramp->GetStops()[i] * STOP_INT_MAX);
-                m_ramp[i].color = t_ramp->GetColors()[i];
-                
-                if (i != 0)
-                {
-                    // MM-2013-11-20: [[ Bug 11479 ]] Make sure we don't divide by zero.
-                    if (m_ramp[i].offset != m_ramp[i - 1].offset)
-                    {
-                        m_ramp[i - 1].difference = (uint32_t)(STOP_DIFF_MULT / (m_ramp[i] . offset - m_ramp[i - 1] . offset));
-                    }
-                    else
-                    {
-                        m_ramp[i - 1].difference = (uint32_t) (STOP_DIFF_MULT / STOP_INT_MAX);
-                    }
-                }
-                // AL-2014-07-21: [[ Bug 12867 ]] Ensure RBGA values are always packed in native format
-                m_ramp[i].hw_color = MCGPixelToNative(kMCGPixelFormatBGRA, m_ramp[i] . color);
-            }
-            
-            // MW-2013-10-26: [[ Bug 11315 ]] Index shuold be i - 1 (otherwise memory overrun occurs!).
-            m_ramp[i - 1].difference = (uint32_t) (STOP_DIFF_MULT / STOP_INT_MAX);
+            m_ramp = m_table->fill_stops;
+            m_ramp_length = m_table->length;
             
             m_bilinear = p_shader.m_gradient->m_filter != kMCGImageFilterNone;
             m_origin_x = t_transform.tx;
@@ -319,7 +522,7 @@ public:
 		~Context()
 		{
 			MCMemoryDeleteArray(m_buffer);
-			MCMemoryDeleteArray(m_ramp);
+			MCMemoryDeleteArray(m_indices);
 		}
 
         virtual void shadeSpan(int x, int y, SkPMColor dstC[], int count) override
@@ -333,9 +536,10 @@ public:
             m_x_inc += m_x_coef_b * t_dy;
             m_y_inc += m_y_coef_b * t_dy;
             m_y = y;
-            memset(dstC, 0x00, count * sizeof(SkPMColor));
             m_bits = dstC - x;
             
+            // Every pixel of the span is written by the combiner, so the
+            // span only needs clearing if it cannot be filled.
             if (m_bilinear)
             {
                 if ((int)m_buffer_width < count * GRADIENT_AA_SCALE)
@@ -343,17 +547,28 @@ public:
                     uindex_t t_size = m_buffer_width * GRADIENT_AA_SCALE;
                     if (!MCMemoryResizeArray(count * GRADIENT_AA_SCALE * GRADIENT_AA_SCALE, m_buffer, t_size))
                     {
+                        memset(dstC, 0x00, count * sizeof(SkPMColor));
                         return;
                     }
                     m_buffer_width = count * GRADIENT_AA_SCALE;
                 }
             }
             
+            uindex_t t_indices_needed = count * (m_bilinear ? GRADIENT_AA_SCALE : 1);
+            if (m_indices_length < t_indices_needed)
+            {
+                if (!MCMemoryResizeArray(t_indices_needed, m_indices, m_indices_length))
+                {
+                    memset(dstC, 0x00, count * sizeof(SkPMColor));
+                    return;
+                }
+            }
+            
             m_combine(this, x, x + count);
         }
         
         template<MCGGradientFunction x_type>
-        static inline int32_t compute_index(int32_t p_x, int32_t p_y, bool p_mirror, uint32_t p_repeat, bool p_wrap)
+        static inline int32_t compute_raw_index(int32_t p_x, int32_t p_y, bool p_wrap)
         {
             int32_t t_index;
             switch(x_type)
@@ -402,7 +617,18 @@ public:
                 }
                     break;
             }
-            
+            return t_index;
+        }
+        
+        // Returns true if adjust_index() leaves the index as it is.
+        static inline bool index_is_unadjusted(bool p_mirror, uint32_t p_repeat, bool p_wrap)
+        {
+            return !p_mirror && !p_wrap && p_repeat <= 1;
+        }
+        
+        // Applies the mirroring, repeats and wrapping to a ramp index.
+        static inline int32_t adjust_index(int32_t t_index, bool p_mirror, uint32_t p_repeat, bool p_wrap)
+        {
             if (p_mirror)
             {
                 if (p_wrap)
@@ -445,62 +671,193 @@ public:
             }
             return t_index;
         }
+        
+        // Computes the raw ramp indices of p_count pixels, starting at (p_x, p_y)
+        // and stepping by (p_dx, p_dy), using vector instructions. Returns the
+        // number of indices computed, which is zero for the gradient functions
+        // without a vector implementation (those which need atan2).
+        template<MCGGradientFunction x_type>
+        static int32_t compute_raw_indices_vector(int32_t p_x, int32_t p_y, int32_t p_dx, int32_t p_dy, bool p_wrap, int32_t p_count, int32_t *r_indices)
+        {
+            if (x_type != kMCGGradientFunctionLinear &&
+                x_type != kMCGGradientFunctionRadial &&
+                x_type != kMCGLegacyGradientDiamond)
+                return 0;
+            
+            int32_t i = 0;
+#if defined(GRADIENT_SSE2)
+            __m128i t_x = _mm_add_epi32(_mm_set1_epi32(p_x), _mm_setr_epi32(0, p_dx, p_dx * 2, p_dx * 3));
+            __m128i t_y = _mm_add_epi32(_mm_set1_epi32(p_y), _mm_setr_epi32(0, p_dy, p_dy * 2, p_dy * 3));
+            __m128i t_step_x = _mm_set1_epi32(p_dx * 4);
+            __m128i t_step_y = _mm_set1_epi32(p_dy * 4);
+            for (; i + 4 <= p_count; i += 4)
+            {
+                __m128i t_index;
+                switch(x_type)
+                {
+                    case kMCGGradientFunctionLinear:
+                        t_index = t_x;
+                        break;
+                    case kMCGLegacyGradientDiamond:
+                    {
+                        __m128i t_x_sign = _mm_srai_epi32(t_x, 31);
+                        __m128i t_y_sign = _mm_srai_epi32(t_y, 31);
+                        __m128i t_abs_x = _mm_sub_epi32(_mm_xor_si128(t_x, t_x_sign), t_x_sign);
+                        __m128i t_abs_y = _mm_sub_epi32(_mm_xor_si128(t_y, t_y_sign), t_y_sign);
+                        __m128i t_x_greater = _mm_cmpgt_epi32(t_abs_x, t_abs_y);
+                        t_index = _mm_or_si128(_mm_and_si128(t_x_greater, t_abs_x), _mm_andnot_si128(t_x_greater, t_abs_y));
+                    }
+                        break;
+                    case kMCGGradientFunctionRadial:
+                    default:
+                    {
+                        __m128i t_halves[2];
+                        for (int h = 0; h < 2; h++)
+                        {
+                            __m128d t_dx = _mm_cvtepi32_pd(h == 0 ? t_x : _mm_shuffle_epi32(t_x, _MM_SHUFFLE(1, 0, 3, 2)));
+                            __m128d t_dy = _mm_cvtepi32_pd(h == 0 ? t_y : _mm_shuffle_epi32(t_y, _MM_SHUFFLE(1, 0, 3, 2)));
+                            __m128d t_dist = _mm_add_pd(_mm_mul_pd(t_dx, t_dx), _mm_mul_pd(t_dy, t_dy));
+                            __m128d t_root = _mm_sqrt_pd(t_dist);
+                            if (!p_wrap)
+                            {
+                                __m128d t_outside = _mm_cmpgt_pd(t_dist, _mm_set1_pd((double)STOP_INT_MAX * STOP_INT_MAX));
+                                t_root = _mm_or_pd(_mm_and_pd(t_outside, _mm_set1_pd(STOP_INT_MAX + 1)), _mm_andnot_pd(t_outside, t_root));
+                            }
+                            t_halves[h] = _mm_cvttpd_epi32(_mm_add_pd(t_root, _mm_set1_pd(0.5)));
+                        }
+                        t_index = _mm_unpacklo_epi64(t_halves[0], t_halves[1]);
+                    }
+                        break;
+                }
+                _mm_storeu_si128((__m128i *)(r_indices + i), t_index);
+                t_x = _mm_add_epi32(t_x, t_step_x);
+                t_y = _mm_add_epi32(t_y, t_step_y);
+            }
+#elif defined(GRADIENT_NEON)
+            const int32_t t_lanes[4] = { 0, 1, 2, 3 };
+            int32x4_t t_lane = vld1q_s32(t_lanes);
+            int32x4_t t_x = vmlaq_n_s32(vdupq_n_s32(p_x), t_lane, p_dx);
+            int32x4_t t_y = vmlaq_n_s32(vdupq_n_s32(p_y), t_lane, p_dy);
+            int32x4_t t_step_x = vdupq_n_s32(p_dx * 4);
+            int32x4_t t_step_y = vdupq_n_s32(p_dy * 4);
+            for (; i + 4 <= p_count; i += 4)
+            {
+                int32x4_t t_index;
+                switch(x_type)
+                {
+                    case kMCGGradientFunctionLinear:
+                        t_index = t_x;
+                        break;
+                    case kMCGLegacyGradientDiamond:
+                        t_index = vmaxq_s32(vabsq_s32(t_x), vabsq_s32(t_y));
+                        break;
+                    case kMCGGradientFunctionRadial:
+                    default:
+                    {
+                        int32x2_t t_halves[2];
+                        for (int h = 0; h < 2; h++)
+                        {
+                            float64x2_t t_dx = vcvtq_f64_s64(vmovl_s32(h == 0 ? vget_low_s32(t_x) : vget_high_s32(t_x)));
+                            float64x2_t t_dy = vcvtq_f64_s64(vmovl_s32(h == 0 ? vget_low_s32(t_y) : vget_high_s32(t_y)));
+                            float64x2_t t_dist = vaddq_f64(vmulq_f64(t_dx, t_dx), vmulq_f64(t_dy, t_dy));
+                            float64x2_t t_root = vsqrtq_f64(t_dist);
+                            if (!p_wrap)
+                            {
+                                uint64x2_t t_outside = vcgtq_f64(t_dist, vdupq_n_f64((double)STOP_INT_MAX * STOP_INT_MAX));
+                                t_root = vbslq_f64(t_outside, vdupq_n_f64(STOP_INT_MAX + 1), t_root);
+                            }
+                            t_halves[h] = vmovn_s64(vcvtq_s64_f64(vaddq_f64(t_root, vdupq_n_f64(0.5))));
+                        }
+                        t_index = vcombine_s32(t_halves[0], t_halves[1]);
+                    }
+                        break;
+                }
+                vst1q_s32(r_indices + i, t_index);
+                t_x = vaddq_s32(t_x, t_step_x);
+                t_y = vaddq_s32(t_y, t_step_y);
+            }
+#endif
+            return i;
+        }
+        
+        // Computes the ramp index of each pixel from fx to tx on the current
+        // row.
+        template<MCGGradientFunction x_type>
+        static void compute_indices(Context *self, int32_t fx, int32_t tx, int32_t *r_indices)
+        {
+            int32_t t_x = self->m_x_inc + self->m_x_coef_a * ((int32_t)fx);
+            int32_t t_y = self->m_y_inc + self->m_y_coef_a * ((int32_t)fx);
+            int32_t t_count = tx - fx;
+            
+            bool t_mirror = self->m_mirror;
+            uint32_t t_repeat = self->m_repeats;
+            bool t_wrap = self->m_wrap;
+            
+            int32_t i = compute_raw_indices_vector<x_type>(t_x, t_y, self->m_x_coef_a, self->m_y_coef_a, t_wrap, t_count, r_indices);
+            t_x += self->m_x_coef_a * i;
+            t_y += self->m_y_coef_a * i;
+            for (; i < t_count; i++)
+            {
+                r_indices[i] = compute_raw_index<x_type>(t_x, t_y, t_wrap);
+                t_x += self->m_x_coef_a;
+                t_y += self->m_y_coef_a;
+            }
+            
+            if (!index_is_unadjusted(t_mirror, t_repeat, t_wrap))
+            {
+                for (i = 0; i < t_count; i++)
+                    r_indices[i] = adjust_index(r_indices[i], t_mirror, t_repeat, t_wrap);
+            }
+        }
 
         template<MCGGradientFunction x_type>
         static void fill_combine(Context *self, int32_t fx, int32_t tx)
         {
             uint32_t *d;
-            uint32_t s;
             
             d = self->m_bits;
             
-            int32_t t_index;
-            int32_t t_x = self->m_x_inc + self->m_x_coef_a * ((int32_t)fx);
-            int32_t t_y = self->m_y_inc + self->m_y_coef_a * ((int32_t)fx);
+            if (fx == tx) return;
             
-            int32_t t_min = (int32_t)self->m_ramp[0].offset;
-            int32_t t_max = (int32_t)self->m_ramp[self->m_ramp_length - 1].offset;
+            // Each pixel is set to its premultiplied colour from the ramp
+            // table, overwriting whatever the span held before.
+            const uint32_t *t_colors = self->m_table->premultiplied;
             
-            if (fx == tx) return;
+            int32_t *t_indices = self->m_indices - fx;
+            compute_indices<x_type>(self, fx, tx, self->m_indices);
             
-            bool t_mirror = self->m_mirror;
-            uint32_t t_repeat = self->m_repeats;
-            bool t_wrap = self->m_wrap;
+            int32_t t_index;
+            int32_t t_min = (int32_t)self->m_ramp[0].offset;
+            int32_t t_max = (int32_t)self->m_ramp[self->m_ramp_length - 1].offset;
             
             uint32_t t_stop_pos = 0;
             
-            t_index = compute_index<x_type>(t_x, t_y, t_mirror, t_repeat, t_wrap);
+            t_index = t_indices[fx];
             while (fx < tx)
             {
                 if (t_index <= t_min)
                 {
-                    s = self->m_ramp[0].hw_color;
+                    uint32_t sa = self->m_table->first_premultiplied;
                     while (t_index <= t_min)
                     {
-                        uint32_t sa = packed_scale_bounded(s | 0xFF000000, (s >> 24));
-                        d[fx] = packed_scale_bounded(d[fx], 255 - (sa >> 24)) + sa;
+                        d[fx] = sa;
                         fx += 1;
                         if (fx == tx)
                             return;
-                        t_x += self->m_x_coef_a;
-                        t_y += self->m_y_coef_a;
-                        t_index = compute_index<x_type>(t_x, t_y, t_mirror, t_repeat, t_wrap);
+                        t_index = t_indices[fx];
                     }
                 }
                 
                 if (t_index >= t_max)
                 {
-                    s = self->m_ramp[self->m_ramp_length - 1].hw_color;
+                    uint32_t sa = self->m_table->last_premultiplied;
                     while (t_index >= t_max)
                     {
-                        uint32_t sa = packed_scale_bounded(s | 0xFF000000, (s >> 24));
-                        d[fx] = packed_scale_bounded(d[fx], 255 - (sa >> 24)) + sa;
+                        d[fx] = sa;
                         fx += 1;
                         if (fx == tx)
                             return;
-                        t_x += self->m_x_coef_a;
-                        t_y += self->m_y_coef_a;
-                        t_index = compute_index<x_type>(t_x, t_y, t_mirror, t_repeat, t_wrap);
+                        t_index = t_indices[fx];
                     }
                 }
                 
@@ -509,25 +866,18 @@ public:
                     MCGradientFillStop *t_current_stop = &self->m_ramp[t_stop_pos];
                     int32_t t_current_offset = t_current_stop->offset;
                     int32_t t_current_difference = t_current_stop->difference;
-                    uint32_t t_current_color = t_current_stop->hw_color;
+                    const uint32_t *t_current_colors = t_colors + t_stop_pos * GRADIENT_RAMP_WEIGHTS;
                     MCGradientFillStop *t_next_stop = &self->m_ramp[t_stop_pos+1];
                     int32_t t_next_offset = t_next_stop->offset;
-                    uint32_t t_next_color = t_next_stop->hw_color;
                     
                     while (t_next_offset >= t_index && t_current_offset <= t_index)
                     {
                         uint8_t b = ((t_index - t_current_offset) * t_current_difference) >> STOP_DIFF_PRECISION ;
-                        uint8_t a = 255 - b;
-                        
-                        s = packed_bilinear_bounded(t_current_color, a, t_next_color, b);
-                        uint32_t sa = packed_scale_bounded(s | 0xFF000000, (s >> 24));
-                        d[fx] = packed_scale_bounded(d[fx], 255 - (sa >> 24)) + sa;
+                        d[fx] = t_current_colors[b];
                         fx += 1;
                         if (fx == tx)
                             return;
-                        t_x += self->m_x_coef_a;
-                        t_y += self->m_y_coef_a;
-                        t_index = compute_index<x_type>(t_x, t_y, t_mirror, t_repeat, t_wrap);
+                        t_index = t_indices[fx];
                     }
                     if (t_current_offset > t_index && t_stop_pos > 0)
                         t_stop_pos -= 1;
@@ -542,20 +892,20 @@ public:
         {
             uint32_t s;
             
-            int32_t t_index;
-            int32_t t_x = self->m_x_inc + self->m_x_coef_a * ((int32_t)fx);
-            int32_t t_y = self->m_y_inc + self->m_y_coef_a * ((int32_t)fx);
+            if (fx == tx) return;
+            
+            const uint32_t *t_colors = self->m_table->interpolated;
             
+            int32_t *t_indices = self->m_indices - fx;
+            compute_indices<x_type>(self, fx, tx, self->m_indices);
+            
+            int32_t t_index;
             int32_t t_min = (int32_t)self->m_ramp[0].offset;
             int32_t t_max = (int32_t)self->m_ramp[self->m_ramp_length - 1].offset;
             
             uint32_t t_stop_pos = 0;
             
-            bool t_mirror = self->m_mirror;
-            uint32_t t_repeat = self->m_repeats;
-            bool t_wrap = self->m_wrap;
-            
-            t_index = compute_index<x_type>(t_x, t_y, t_mirror, t_repeat, t_wrap);
+            t_index = t_indices[fx];
             while (fx < tx)
             {
                 if (t_index <= t_min)
@@ -568,9 +918,7 @@ public:
                         if (fx == tx)
                             return;
                         p_buff++;
-                        t_x += self->m_x_coef_a;
-                        t_y += self->m_y_coef_a;
-                        t_index = compute_index<x_type>(t_x, t_y, t_mirror, t_repeat, t_wrap);
+                        t_index = t_indices[fx];
                     }
                 }
                 
@@ -584,9 +932,7 @@ public:
                         if (fx == tx)
                             return;
                         p_buff++;
-                        t_x += self->m_x_coef_a;
-                        t_y += self->m_y_coef_a;
-                        t_index = compute_index<x_type>(t_x, t_y, t_mirror, t_repeat, t_wrap);
+                        t_index = t_indices[fx];
                     }
                 }
                 
@@ -595,25 +941,19 @@ public:
                     MCGradientFillStop *t_current_stop = &self->m_ramp[t_stop_pos];
                     int32_t t_current_offset = t_current_stop->offset;
                     int32_t t_current_difference = t_current_stop->difference;
-                    uint32_t t_current_color = t_current_stop->hw_color;
+                    const uint32_t *t_current_colors = t_colors + t_stop_pos * GRADIENT_RAMP_WEIGHTS;
                     MCGradientFillStop *t_next_stop = &self->m_ramp[t_stop_pos+1];
                     int32_t t_next_offset = t_next_stop->offset;
-                    uint32_t t_next_color = t_next_stop->hw_color;
                     
                     while (t_next_offset >= t_index && t_current_offset <= t_index)
                     {
                         uint8_t b = ((t_index - t_current_offset) * t_current_difference) >> STOP_DIFF_PRECISION ;
-                        uint8_t a = 255 - b;
-                        
-                        s = packed_bilinear_bounded(t_current_color, a, t_next_color, b);
-                        *p_buff = s;
+                        *p_buff = t_current_colors[b];
                         fx += 1;
                         if (fx == tx)
                             return;
                         p_buff++;
-                        t_x += self->m_x_coef_a;
-                        t_y += self->m_y_coef_a;
-                        t_index = compute_index<x_type>(t_x, t_y, t_mirror, t_repeat, t_wrap);
+                        t_index = t_indices[fx];
                     }
                     if (t_current_offset > t_index && t_stop_pos > 0)
                         t_stop_pos -= 1;
@@ -669,18 +1009,20 @@ public:
                 i++;
                 
                 s = u | v;
-                uint8_t alpha = (s >> 24);
-                d[fx] = packed_bilinear_bounded(d[fx], 255 - alpha, s | 0xFF000000, alpha);
+                d[fx] = packed_scale_bounded(s | 0xFF000000, s >> 24);
             }
         }
         
     private:
+        MCGGradientRampTable *m_table = nullptr;
         MCGradientFillStop *m_ramp = nullptr;
         uint32_t *m_bits;
         void (*m_combine)(Context* self, int32_t fx, int32_t tx) = nullptr;
         size_t m_ramp_length = 0;
-        uindex_t m_buffer_width;
-        uint32_t *m_buffer;
+        uindex_t m_buffer_width = 0;
+        uint32_t *m_buffer = nullptr;
+        uindex_t m_indices_length = 0;
+        int32_t *m_indices = nullptr;
         int32_t m_origin_x, m_origin_y;
         uint32_t m_repeats;
         int32_t m_x_coef_a, m_x_coef_b;
@@ -709,6 +1051,7 @@ protected:
     
 private:
     MCGGeneralizedGradientRef m_gradient;
+    MCGGradientRampTable *m_table = nullptr;
     
     typedef SkShader::Context INHERITED;
 };
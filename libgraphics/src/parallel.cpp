@@ -0,0 +1,362 @@
+/* Copyright (C) 2003-2017 LiveCode Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+#include "graphics.h"
+#include "graphics-internal.h"
+
+#if defined(__WINDOWS__)
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Work is shared between the calling thread and at most this many workers.
+#define kMCGParallelMaxWorkers 3
+
+#if defined(__EMSCRIPTEN__)
+
+void MCGParallelInitialize(void)
+{
+}
+
+void MCGParallelFinalize(void)
+{
+}
+
+uint32_t MCGParallelGetThreadCount(void)
+{
+	return 1;
+}
+
+void MCGParallelFor(uint32_t p_count, MCGParallelCallback p_callback, void *p_context)
+{
+	for(uint32_t i = 0; i < p_count; i++)
+		p_callback(p_context, i);
+}
+
+#else
+
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__WINDOWS__)
+
+typedef SRWLOCK MCGParallelLock;
+typedef CONDITION_VARIABLE MCGParallelCondition;
+typedef HANDLE MCGParallelThread;
+
+static void MCGParallelLockInitialize(MCGParallelLock& x_lock)
+{
+	InitializeSRWLock(&x_lock);
+}
+
+static void MCGParallelLockFinalize(MCGParallelLock& x_lock)
+{
+}
+
+static void MCGParallelLockAcquire(MCGParallelLock& x_lock)
+{
+	AcquireSRWLockExclusive(&x_lock);
+}
+
+static bool MCGParallelLockTryAcquire(MCGParallelLock& x_lock)
+{
+	return TryAcquireSRWLockExclusive(&x_lock) != 0;
+}
+
+static void MCGParallelLockRelease(MCGParallelLock& x_lock)
+{
+	ReleaseSRWLockExclusive(&x_lock);
+}
+
+static void MCGParallelConditionInitialize(MCGParallelCondition& x_condition)
+{
+	InitializeConditionVariable(&x_condition);
+}
+
+static void MCGParallelConditionFinalize(MCGParallelCondition& x_condition)
+{
+}
+
+static void MCGParallelConditionWait(MCGParallelCondition& x_condition, MCGParallelLock& x_lock)
+{
+	SleepConditionVariableSRW(&x_condition, &x_lock, INFINITE, 0);
+}
+
+static void MCGParallelConditionBroadcast(MCGParallelCondition& x_condition)
+{
+	WakeAllConditionVariable(&x_condition);
+}
+
+static void MCGParallelWorker(void);
+
+static DWORD WINAPI MCGParallelWorkerThread(LPVOID p_context)
+{
+	MCGParallelWorker();
+	return 0;
+}
+
+static bool MCGParallelThreadStart(MCGParallelThread& r_thread)
+{
+	r_thread = CreateThread(NULL, 0, MCGParallelWorkerThread, NULL, 0, NULL);
+	return r_thread != NULL;
+}
+
+static void MCGParallelThreadJoin(MCGParallelThread p_thread)
+{
+	WaitForSingleObject(p_thread, INFINITE);
+	CloseHandle(p_thread);
+}
+
+static uint32_t MCGParallelGetNumberOfCores(void)
+{
+	SYSTEM_INFO t_info;
+	GetSystemInfo(&t_info);
+	return t_info . dwNumberOfProcessors;
+}
+
+#else
+
+typedef pthread_mutex_t MCGParallelLock;
+typedef pthread_cond_t MCGParallelCondition;
+typedef pthread_t MCGParallelThread;
+
+static void MCGParallelLockInitialize(MCGParallelLock& x_lock)
+{
+	pthread_mutex_init(&x_lock, NULL);
+}
+
+static void MCGParallelLockFinalize(MCGParallelLock& x_lock)
+{
+	pthread_mutex_destroy(&x_lock);
+}
+
+static void MCGParallelLockAcquire(MCGParallelLock& x_lock)
+{
+	pthread_mutex_lock(&x_lock);
+}
+
+static bool MCGParallelLockTryAcquire(MCGParallelLock& x_lock)
+{
+	return pthread_mutex_trylock(&x_lock) == 0;
+}
+
+static void MCGParallelLockRelease(MCGParallelLock& x_lock)
+{
+	pthread_mutex_unlock(&x_lock);
+}
+
+static void MCGParallelConditionInitialize(MCGParallelCondition& x_condition)
+{
+	pthread_cond_init(&x_condition, NULL);
+}
+
+static void MCGParallelConditionFinalize(MCGParallelCondition& x_condition)
+{
+	pthread_cond_destroy(&x_condition);
+}
+
+static void MCGParallelConditionWait(MCGParallelCondition& x_condition, MCGParallelLock& x_lock)
+{
+	pthread_cond_wait(&x_condition, &x_lock);
+}
+
+static void MCGParallelConditionBroadcast(MCGParallelCondition& x_condition)
+{
+	pthread_cond_broadcast(&x_condition);
+}
+
+static void MCGParallelWorker(void);
+
+static void *MCGParallelWorkerThread(void *p_context)
+{
+	MCGParallelWorker();
+	return NULL;
+}
+
+static bool MCGParallelThreadStart(MCGParallelThread& r_thread)
+{
+	return pthread_create(&r_thread, NULL, MCGParallelWorkerThread, NULL) == 0;
+}
+
+static void MCGParallelThreadJoin(MCGParallelThread p_thread)
+{
+	pthread_join(p_thread, NULL);
+}
+
+static uint32_t MCGParallelGetNumberOfCores(void)
+{
+	long t_count;
+	t_count = sysconf(_SC_NPROCESSORS_ONLN);
+	return t_count > 0 ? (uint32_t)t_count : 1;
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// s_lock protects all the state below. s_busy is held by the thread whose
+// request the workers are running, so that requests made by other threads (or
+// from within a callback) run on the thread making them instead of waiting.
+static MCGParallelLock s_lock;
+static MCGParallelLock s_busy;
+static MCGParallelCondition s_work_available;
+static MCGParallelCondition s_work_done;
+
+// The workers are started on demand, and then kept until finalization.
+static MCGParallelThread s_workers[kMCGParallelMaxWorkers];
+static uint32_t s_worker_count = 0;
+static uint32_t s_max_worker_count = 0;
+static bool s_stopping = false;
+
+// The request being run. Indices below s_next have been claimed, and s_pending
+// is the number of calls which have not yet finished.
+static MCGParallelCallback s_callback = nil;
+static void *s_context = nil;
+static uint32_t s_count = 0;
+static uint32_t s_next = 0;
+static uint32_t s_pending = 0;
+
+static void MCGParallelWorker(void)
+{
+	MCGParallelLockAcquire(s_lock);
+	for(;;)
+	{
+		while(!s_stopping && s_next >= s_count)
+			MCGParallelConditionWait(s_work_available, s_lock);
+
+		if (s_stopping)
+			break;
+
+		uint32_t t_index;
+		t_index = s_next++;
+
+		MCGParallelCallback t_callback;
+		void *t_context;
+		t_callback = s_callback;
+		t_context = s_context;
+
+		MCGParallelLockRelease(s_lock);
+		t_callback(t_context, t_index);
+		MCGParallelLockAcquire(s_lock);
+
+		if (--s_pending == 0)
+			MCGParallelConditionBroadcast(s_work_done);
+	}
+	MCGParallelLockRelease(s_lock);
+}
+
+void MCGParallelInitialize(void)
+{
+	MCGParallelLockInitialize(s_lock);
+	MCGParallelLockInitialize(s_busy);
+	MCGParallelConditionInitialize(s_work_available);
+	MCGParallelConditionInitialize(s_work_done);
+
+	s_worker_count = 0;
+	s_max_worker_count = MCMin(MCGParallelGetNumberOfCores() - 1, (uint32_t)kMCGParallelMaxWorkers);
+	s_stopping = false;
+}
+
+void MCGParallelFinalize(void)
+{
+	MCGParallelLockAcquire(s_lock);
+	s_stopping = true;
+	MCGParallelConditionBroadcast(s_work_available);
+	MCGParallelLockRelease(s_lock);
+
+	for(uint32_t i = 0; i < s_worker_count; i++)
+		MCGParallelThreadJoin(s_workers[i]);
+	s_worker_count = 0;
+	s_max_worker_count = 0;
+
+	MCGParallelConditionFinalize(s_work_done);
+	MCGParallelConditionFinalize(s_work_available);
+	MCGParallelLockFinalize(s_busy);
+	MCGParallelLockFinalize(s_lock);
+}
+
+uint32_t MCGParallelGetThreadCount(void)
+{
+	return s_max_worker_count + 1;
+}
+
+void MCGParallelFor(uint32_t p_count, MCGParallelCallback p_callback, void *p_context)
+{
+	if (p_count > 1 && s_max_worker_count > 0 && MCGParallelLockTryAcquire(s_busy))
+	{
+		MCGParallelLockAcquire(s_lock);
+
+		while(s_worker_count < s_max_worker_count)
+		{
+			if (!MCGParallelThreadStart(s_workers[s_worker_count]))
+			{
+				s_max_worker_count = s_worker_count;
+				break;
+			}
+			s_worker_count++;
+		}
+
+		bool t_shared;
+		t_shared = s_worker_count > 0;
+		if (t_shared)
+		{
+			s_callback = p_callback;
+			s_context = p_context;
+			s_count = p_count;
+			s_next = 0;
+			s_pending = p_count;
+			MCGParallelConditionBroadcast(s_work_available);
+
+			// Take a share of the calls, then wait for the workers to finish
+			// theirs.
+			while(s_next < s_count)
+			{
+				uint32_t t_index;
+				t_index = s_next++;
+
+				MCGParallelLockRelease(s_lock);
+				p_callback(p_context, t_index);
+				MCGParallelLockAcquire(s_lock);
+
+				s_pending--;
+			}
+
+			while(s_pending > 0)
+				MCGParallelConditionWait(s_work_done, s_lock);
+
+			s_callback = nil;
+			s_context = nil;
+			s_count = 0;
+			s_next = 0;
+		}
+
+		MCGParallelLockRelease(s_lock);
+		MCGParallelLockRelease(s_busy);
+
+		if (t_shared)
+			return;
+	}
+
+	for(uint32_t i = 0; i < p_count; i++)
+		p_callback(p_context, i);
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
@@ -21,321 +21,249 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #include <SkMath.h>
 
-// Dilate the input by using a distance transform. A pixel in the new mask
-// is taken to be in the dilated mask if it is within the ellipse with radii
-// xradius and yradius of a set pixel in the original mask. The maximum
-// radii is 254 pixels.
-void dilateDistanceXY(const uint8_t *src, uint8_t *dst, int xradius, int yradius, int width, int height, int& r_new_width, int& r_new_height)
-{
-/*
-    int new_width = width + 2 * xradius;
-	int new_height = height + 2 * yradius;
-    
-	// Compute the x distance of each pixel from the nearest set pixel.
-	uint8_t *xd;
-	xd = new (nothrow) uint8_t[new_width * height];
-	for(int y = 0; y < height; y++)
-	{
-		uint8_t *xdptr;
-		xdptr = xd + new_width * y;
-		
-		const uint8_t *sptr;
-		sptr = src + width * y;
-		for(int x = 0; x < width; x++)
-		{
-			// If there is a value at x, take it
-			if (sptr[x] != 0)
-			{
-				xdptr[x + xradius] = 0;
-				continue;
-			}
-			
-			// Otherwise search back...
-			int db;
-			db = 255;
-			for(int z = x; z >= 0 && (x - z) < 255; z--)
-			{
-				if (sptr[z] != 0)
-				{
-					db = x - z;
-					break;
-				}
-			}
-			
-			// Now search forwards...
-			int df;
-			df = 255;
-			for(int z = x; (z < width) && (z - x) < 255; z++)
-			{
-				if (sptr[z] != 0)
-				{
-					df = z - x;
-					break;
-				}
-			}
-			
-			// Distance is the minimum.
-			int d;
-			d = SkMin32(db, df);
-			xdptr[x + xradius] = d;
-		}
-		
-		// Now expand the fringes.
-		for(int x = 0; x < xradius; x++)
-		{
-			if (xdptr[xradius] + (xradius - x) < 255)
-				xdptr[x] = ((xradius - x) + xdptr[xradius]);
-			else
-				xdptr[x] = 255;
-            
-			if (xdptr[width + xradius - 1] + x + 1 < 255)
-				xdptr[width + xradius + x] = xdptr[width + xradius - 1] + x + 1;
-			else
-				xdptr[width + xradius + x] = 255;
-		}
-	}
-	
-	unsigned int rf;
-	rf = xradius * xradius * yradius * yradius;
-	
-	memset(dst, 0, new_width * new_height);
-	
-	// Now use xd to compute the spread mask.
-	for(int x = 0; x < new_width; x++)
-	{
-		for(int y = 0; y < new_height; y++)
-		{
-			uint8_t *dptr = dst + y * new_width + x;
-			
-			// If the distance at x, y is 0 then we are done.
-			if (y >= yradius && y < (new_height - yradius) && xd[(y - yradius) * new_width + x] == 0)
-			{
-				*dptr = 255;
-				continue;
-			}
-			
-			// Otherwise, search up.
-			*dptr = 0;
-			for(int z = y; z >= 0; z--)
-			{
-				unsigned int yf;
-				yf = (y - z) * xradius;
-				yf *= yf;
-				if (yf >= rf)
-					break;
-				
-				unsigned int xf;
-				if (z >= yradius && z < (new_height - yradius))
-					xf = yradius * xd[(z - yradius) * new_width + x];
-				else
-					xf = yradius * 255;
-				xf *= xf;
-				if (xf < rf - yf)
-				{
-					*dptr = 255;
-					break;
-				}
-			}
-			
-			if (*dptr == 255)
-				continue;
-			
-			// Search downwards
-			for(int z = y; z < new_height; z++)
-			{
-				unsigned int yf;
-				yf = (z - y) * xradius;
-				yf *= yf;
-				if (yf >= rf)
-					break;
-				
-				unsigned int xf;
-				if (z >= yradius && z < (new_height - yradius))
-					xf = yradius * xd[(z - yradius) * new_width + x];
-				else
-					xf = yradius * 255;
-				xf *= xf;
-				if (xf < rf - yf)
-				{
-					*dptr = 255;
-					break;
-				}
-			}
-		}
-	}
-	
-	r_new_width = new_width;
-	r_new_height = new_height;
-*/
-    int new_width = width + 2 * xradius;
-	int new_height = height + 2 * yradius;
+// Masks with fewer pixels than this are dilated on a single thread.
+#define kSpreadMinBandPixels 32768
 
-    // Allocate memory for the loop
-    size_t t_mem_size = new_width * new_height;
-	uint8_t *buffer;
-	/* UNCHECKED */ buffer = (uint8_t*)malloc(t_mem_size);
+// Columns are gathered from the x distances this many at a time, so that each
+// row is read in one go.
+#define kSpreadColumnGroup 16
 
-    // All the destination pixels are set to the infinite distance initially
-    memset(buffer, 255, t_mem_size);
+struct SpreadBands
+{
+    const uint8_t *src;
+    int src_stride;
+    uint8_t *dst;
+    uint8_t *xd;
+    int xradius, yradius;
+    int width, height;
+    int new_width, new_height;
+    int band_size;
     
-    // Only this part of the buffer can have non-infinite x distances
-    uint8_t *xd = buffer + new_width * yradius;
+    // Each band has its own scratch space for gathering columns and for the
+    // lower envelope.
+    uint8_t *columns;
+    int32_t *sites;
+    int32_t *starts;
+};
+
+// Compute the x distance of each pixel in rows y0 to y1 from the nearest set
+// pixel, capped at 255 ("infinite"). The distances to the nearest set pixel on
+// the left are found in one pass, and then lowered to those on the right in a
+// second pass back along the row.
+static void spreadRows(SpreadBands *bands, int y0, int y1)
+{
+    int width = bands->width;
+    int new_width = bands->new_width;
+    int xradius = bands->xradius;
     
-	// Compute the x distance of each pixel from the nearest set pixel
-	for(int y = 0; y < height; y++)
+	for(int y = y0; y < y1; y++)
 	{
 		uint8_t *xdptr;
-		xdptr = xd + new_width * y;
+		xdptr = bands->xd + new_width * y;
 		
 		const uint8_t *sptr;
-		sptr = src + width * y;
+		sptr = bands->src + bands->src_stride * y;
+        
+        // All the pixels are at the infinite distance until a set pixel is
+        // found. The source pixel at x is at x + xradius in the row.
+        int last = -1;
+        for(int x = 0; x < new_width; x++)
+        {
+            int sx = x - xradius;
+            if (sx >= 0 && sx < width && sptr[sx] != 0)
+                last = x;
+            xdptr[x] = last < 0 ? 255 : SkMin32(x - last, 255);
+        }
+        
+        // Rows with no set pixels are left at the infinite distance.
+        if (last < 0)
+            continue;
         
-        int x = 0;
-        int next = 0;
-        while (x < new_width)
+        int next = -1;
+        for(int x = last; x >= 0; x--)
         {
-            // Scan along the line for the next pixel that is set in the source mask
-            while (next < width && sptr[next] == 0)
-                next++;
-            
-            // If no more set pixels in the source mask, go to the end of the line
-            int dnext;
-            if (next >= width)
-                dnext = new_width;
-            else
-                dnext = next + xradius;    // Account for position shift between src and dst
-            
-            // If we're starting at the left edge, there isn't a mask point there
-            int distance = dnext - x;
-            int halfway = distance / 2;
-            if (x == 0)
-                halfway = 0;
-            
-            // If we're ending at the right edge, there isn't a mask point there
-            if (dnext >= new_width)
-                halfway = distance;
-            
-            // Ensure that we do nothing for empty lines
-            if (next >= width && x == 0)
-                halfway = distance = 0;
-            
-            int i;
-            for (i = 0; i < halfway; i++)
-                xdptr[x + i] = SkMin32(i, 255);
-            for (; i < distance; i++)
-                xdptr[x + i] = SkMin32(distance - i, 255);
-            
-            // Move on to the next pixel
-            //
-            // Optimisation: scan for the next clear pixel in the mask
-            //      Avoids excessive processing for rows of non-zero pixels
-            x = dnext;
-            next = next + 1;
-            
-            // MW-2014-06-24: [[ Bug ]] Only loop up to (width - 1), otherwise we get
-            //   an access overflow.
-            while (next < (width - 1) && sptr[next + 1] != 0)
-            {
-                xdptr[x] = 0;
-                x++, next++;
-            }
-            
-            // MW-2014-08-27: [[ Bug 13221 ]] If we reached the edge of the source, then we
-            //   assume the next pixel is clear.
-            if (next == width - 1)
-            {
-                xdptr[x] = 0;
-                x++, next++;
-            }
+            if (xdptr[x] == 0)
+                next = x;
+            if (next >= 0 && next - x < xdptr[x])
+                xdptr[x] = next - x;
         }
 	}
+}
+
+static void spreadRowBand(void *context, uint32_t index)
+{
+    SpreadBands *bands = (SpreadBands *)context;
+    int y0 = index * bands->band_size;
+    spreadRows(bands, y0, SkMin32(y0 + bands->band_size, bands->height));
+}
+
+// Divides, rounding towards negative infinity. The divisor must be positive.
+static inline int64_t floorDivide(int64_t n, int64_t d)
+{
+    return n >= 0 ? n / d : -((-n + d - 1) / d);
+}
+
+// Dilate one column of x distances (of the source's height), writing the
+// new_height result to dst.
+//
+// A pixel is in the dilated mask if, for some source row z with x distance d,
+// bb * d^2 + aa * (y - z)^2 < aabb. For each row z this is a parabola in y, so
+// the smallest over all z is found by building their lower envelope, which
+// takes time linear in the height whatever the radius.
+static void spreadColumn(const uint8_t *xd, uint8_t *dst, int height, int new_height, int yradius, int64_t aa, int64_t bb, int32_t *sites, int32_t *starts)
+{
+    // Build the lower envelope of the finite parabolas, in source rows.
+    // Parabola sites[k] is the lowest from destination row starts[k] onwards.
+    int k = -1;
+    for(int u = 0; u < height; u++)
+    {
+        if (xd[u] == 255)
+            continue;
+        
+        // Find the first row at which parabola u is lower than the last one in
+        // the envelope, discarding those it is lower than everywhere they are
+        // the lowest.
+        int64_t w = 0;
+        while (k >= 0)
+        {
+            int i = sites[k];
+            int64_t n = aa * ((int64_t)u * u - (int64_t)i * i) + bb * ((int64_t)xd[u] * xd[u] - (int64_t)xd[i] * xd[i]);
+            w = floorDivide(n, 2 * aa * (u - i)) + yradius + 1;
+            if (w > starts[k])
+                break;
+            k--;
+        }
+        
+        if (k < 0)
+        {
+            k = 0;
+            sites[0] = u;
+            starts[0] = 0;
+        }
+        else if (w < new_height)
+        {
+            k++;
+            sites[k] = u;
+            starts[k] = (int32_t)w;
+        }
+    }
     
-    // Destination pointer stride
-    int ydstride = new_width;
-	
-    // a-squared, b-squared and a-squared*b-squared
-	uint32_t aa, bb, aabb;
-    aa = xradius * xradius;
-    bb = yradius * yradius;
-    aabb = aa*bb;
+    if (k < 0)
+    {
+        memset(dst, 0, new_height);
+        return;
+    }
+    
+    int64_t aabb = aa * bb;
+    int count = k + 1;
+    k = 0;
+    for(int y = 0; y < new_height; y++)
+    {
+        while (k + 1 < count && starts[k + 1] <= y)
+            k++;
+        
+        int64_t d = xd[sites[k]];
+        int64_t dy = y - yradius - sites[k];
+        dst[y] = bb * d * d + aa * dy * dy < aabb ? 255 : 0;
+    }
+}
+
+static void spreadColumnBand(void *context, uint32_t index)
+{
+    SpreadBands *bands = (SpreadBands *)context;
+    int x0 = index * bands->band_size;
+    int x1 = SkMin32(x0 + bands->band_size, bands->new_width);
     
-    // Look-up tables for pre-calculated multiplications
-    uint32_t t_xlut[256], t_ylut[256];
-    for (int i = 0; i < 256; i++)
-        t_xlut[i] = bb*i*i, t_ylut[i] = aa*i*i;
+    int height = bands->height;
+    int new_height = bands->new_height;
+    int64_t aa = (int64_t)bands->xradius * bands->xradius;
+    int64_t bb = (int64_t)bands->yradius * bands->yradius;
     
-    // Ensure that the "infinite" distance never compares < anything else
-    t_xlut[255] = t_ylut[255] = 0xFFFFFFFF;
-	
-	memset(dst, 0, new_width * new_height);
+    uint8_t *columns = bands->columns + index * kSpreadColumnGroup * height;
+    int32_t *sites = bands->sites + index * new_height;
+    int32_t *starts = bands->starts + index * new_height;
     
-    // X distance array
-    const uint8_t *xdist = buffer;
-	
-    // Be careful:
-    //
-    //  Minor, seemingly inconsequential, changes to this loop can slow it down
-    //  considerably. On the other hand, they could speed it up...
-    int offset = 0;
-    for (int y = 0; y < new_height; y++)
+    for(int x = x0; x < x1; x += kSpreadColumnGroup)
     {
-        for (int x = 0; x < new_width; x++, offset++)
+        int group = SkMin32(kSpreadColumnGroup, x1 - x);
+        
+        const uint8_t *xdptr = bands->xd + x;
+        for(int y = 0; y < height; y++)
         {
-            // Starting at this position, scan down for a pixel that is within
-            // the dilation radius.
-            int ny = y;
-            int noffset = offset;
-            int max = SkMin32(new_height, y + yradius);
-            do
-            {
-                uint8_t xval, yval;
-                xval = xdist[noffset];
-                yval = ny - y;
-                
-                // Note that care is needed to avoid overflow errors
-                uint64_t t_dist64 = uint64_t(t_xlut[xval]) + uint64_t(t_ylut[yval]);
-                if (t_dist64 == uint32_t(t_dist64) && uint32_t(t_dist64) < aabb)
-                {
-                    dst[offset] = 255;
-                    break;
-                }
-                
-                ny += 1;
-                noffset += ydstride;
-            }
-            while (ny < max);
-            
-            // Early escape to avoid processing another loop
-            if (dst[offset])
-                continue;
-            
-            // Starting at this position, scan up for a pixel that is within
-            // the dilation radius
-            ny = y - 1;
-            noffset = offset - ydstride;
-            int min = SkMax32(0, y - yradius);
-            while (ny >= min)
-            {
-                uint8_t xval, yval;
-                xval = xdist[noffset];
-                yval = y - ny;
-                
-                // Note that care is needed to avoid overflow errors
-                uint64_t t_dist64 = uint64_t(t_xlut[xval]) + uint64_t(t_ylut[yval]);
-                if (t_dist64 == uint32_t(t_dist64) && uint32_t(t_dist64) < aabb)
-                {
-                    dst[offset] = 255;
-                    break;
-                }
-                
-                ny -= 1;
-                noffset -= ydstride;
-            }
+            for(int c = 0; c < group; c++)
+                columns[c * height + y] = xdptr[c];
+            xdptr += bands->new_width;
         }
+        
+        for(int c = 0; c < group; c++)
+            spreadColumn(columns + c * height, bands->dst + (x + c) * new_height, height, new_height, bands->yradius, aa, bb, sites, starts);
     }
-	
-    free(buffer);
+}
+
+// Dilate the input by using a distance transform. A pixel in the new mask
+// is taken to be in the dilated mask if it is within the ellipse with radii
+// xradius and yradius of a set pixel in the original mask. The maximum
+// radii is 254 pixels.
+//
+// The dilated mask is written to dst transposed - with a row for each of its
+// columns - as that is how it is first blurred. The scratch buffer must have
+// room for (width + 2 * xradius) * height bytes.
+bool dilateDistanceXY(const uint8_t *src, int src_stride, uint8_t *dst, uint8_t *scratch, int xradius, int yradius, int width, int height, int& r_new_width, int& r_new_height)
+{
+    int new_width = width + 2 * xradius;
+	int new_height = height + 2 * yradius;
     
 	r_new_width = new_width;
 	r_new_height = new_height;
+    
+    // Nothing is within an ellipse with a zero radius.
+    if (xradius == 0 || yradius == 0 || height == 0)
+    {
+        memset(dst, 0, new_width * new_height);
+        return true;
+    }
+    
+    SpreadBands bands;
+    bands.src = src;
+    bands.src_stride = src_stride;
+    bands.dst = dst;
+    bands.xd = scratch;
+    bands.xradius = xradius;
+    bands.yradius = yradius;
+    bands.width = width;
+    bands.height = height;
+    bands.new_width = new_width;
+    bands.new_height = new_height;
+    
+    uint32_t t_band_count;
+    t_band_count = MCMin(MCGParallelGetThreadCount(), MCMax(1U, uint32_t((int64_t)new_width * new_height / kSpreadMinBandPixels)));
+    
+    // First the x distances for the rows of the source.
+    bands.band_size = (height + t_band_count - 1) / t_band_count;
+    MCGParallelFor((height + bands.band_size - 1) / bands.band_size, spreadRowBand, &bands);
+    
+    // Then the dilation of each column, in bands of whole column groups.
+    bands.band_size = (new_width + t_band_count - 1) / t_band_count;
+    bands.band_size = (bands.band_size + kSpreadColumnGroup - 1) / kSpreadColumnGroup * kSpreadColumnGroup;
+    t_band_count = (new_width + bands.band_size - 1) / bands.band_size;
+    
+    bands.columns = nil;
+    bands.sites = nil;
+    bands.starts = nil;
+    if (!MCMemoryNewArray(t_band_count * kSpreadColumnGroup * height, bands.columns) ||
+        !MCMemoryNewArray(t_band_count * new_height, bands.sites) ||
+        !MCMemoryNewArray(t_band_count * new_height, bands.starts))
+    {
+        MCMemoryDeleteArray(bands.sites);
+        MCMemoryDeleteArray(bands.columns);
+        return false;
+    }
+    
+    MCGParallelFor(t_band_count, spreadColumnBand, &bands);
+    
+    MCMemoryDeleteArray(bands.starts);
+    MCMemoryDeleteArray(bands.sites);
+    MCMemoryDeleteArray(bands.columns);
+    
+    return true;
 }
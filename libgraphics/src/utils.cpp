@@ -35,6 +35,8 @@ void MCGraphicsInitialize(void)
 	MCGPlatformInitialize();
 	MCGTextMeasureCacheInitialize();
 	MCGBlendModesInitialize();
+	MCGParallelInitialize();
+	MCGGradientRampCacheInitialize();
     
     MCGSolidColor::Create(0.0, 0.0, 0.0, 1.0, kMCGBlackSolidColor);
 }
@@ -46,6 +48,8 @@ void MCGraphicsFinalize(void)
 	MCGPlatformFinalize();
 	MCGTextMeasureCacheFinalize();
 	MCGBlendModesFinalize();
+	MCGParallelFinalize();
+	MCGGradientRampCacheFinalize();
     
 #ifdef _DEBUG
     MCLog("Graphic object count = %d", MCGObject::s_object_count);
@@ -55,6 +59,7 @@ void MCGraphicsFinalize(void)
 void MCGraphicsCompact(void)
 {
 	MCGTextMeasureCacheCompact();
+	MCGGradientRampCacheCompact();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,42 @@
+/* Copyright (C) 2003-2017 LiveCode Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+#include "gtest/gtest.h"
+
+#include "foundation.h"
+#include "graphics.h"
+
+//
+// The libgraphics testing environment
+//
+class LibgraphicsEnvironment : public ::testing::Environment {
+public:
+	virtual ~LibgraphicsEnvironment() {}
+
+	virtual void SetUp() {
+		ASSERT_TRUE(MCInitialize());
+		MCGraphicsInitialize();
+	}
+
+	virtual void TearDown() {
+		MCGraphicsFinalize();
+		MCFinalize();
+	}
+};
+
+// Register the environment
+::testing::Environment* const libgraphics_env =
+	::testing::AddGlobalTestEnvironment(new LibgraphicsEnvironment);
@@ -0,0 +1,200 @@
+/* Copyright (C) 2003-2017 LiveCode Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+#include "gtest/gtest.h"
+
+#include "graphics.h"
+#include "graphics-internal.h"
+
+#include <SkMask.h>
+
+#include <vector>
+
+static uint32_t s_random = 1;
+
+static uint8_t random_byte(void)
+{
+	s_random = s_random * 1103515245 + 12345;
+	return (s_random >> 16) & 0xff;
+}
+
+/* Fills a mask with runs of clear, opaque and random pixels, which gives both
+ * the edges of shapes and the largest column sums. */
+static void random_mask(std::vector<uint8_t>& x_mask)
+{
+	size_t i = 0;
+	while (i < x_mask.size())
+	{
+		uint8_t t_kind = random_byte() % 3;
+		size_t t_end = MCMin(x_mask.size(), i + 1 + random_byte() % 64);
+		for (; i < t_end; i++)
+			x_mask[i] = t_kind == 0 ? 0 : (t_kind == 1 ? 255 : random_byte());
+	}
+}
+
+/* Box blurs "length" values of src, spaced "src_step" apart, into the
+ * length + 2 * radius values of dst, one pixel at a time, in the same way as
+ * the original scalar kernel. */
+static void reference_blur_line(const uint8_t *src, int src_step, uint8_t *dst, int dst_step, int radius, int length)
+{
+	int t_diameter = radius * 2;
+	uint32_t t_scale = (1 << 24) / (t_diameter + 1);
+	uint32_t t_sum = 0;
+	for (int x = 0; x < length + t_diameter; x++)
+	{
+		if (x < length)
+			t_sum += src[x * src_step];
+		dst[x * dst_step] = (t_sum * t_scale) >> 24;
+		if (x >= t_diameter)
+			t_sum -= src[(x - t_diameter) * src_step];
+	}
+}
+
+/* Splits a radius into the radii of the three box blur passes. */
+static void reference_pass_radii(int p_radius, int r_radii[3])
+{
+	r_radii[0] = (p_radius + 2) / 3;
+	p_radius -= r_radii[0];
+	r_radii[1] = (p_radius + 1) / 2;
+	p_radius -= r_radii[1];
+	r_radii[2] = p_radius;
+}
+
+/* Blurs the width x height mask with three box blur passes along the rows and
+ * then three down the columns, returning the padded result. */
+static std::vector<uint8_t> reference_blur(const uint8_t *p_src, int p_stride, int p_width, int p_height, int p_x_radius, int p_y_radius)
+{
+	std::vector<uint8_t> t_buffer(p_height * p_width);
+	for (int y = 0; y < p_height; y++)
+		MCMemoryCopy(&t_buffer[y * p_width], p_src + y * p_stride, p_width);
+
+	int t_radii[3];
+	int w = p_width;
+	int h = p_height;
+
+	reference_pass_radii(p_x_radius, t_radii);
+	for (int i = 0; i < 3; i++)
+	{
+		int t_new_width = w + t_radii[i] * 2;
+		std::vector<uint8_t> t_next(h * t_new_width);
+		for (int y = 0; y < h; y++)
+			reference_blur_line(&t_buffer[y * w], 1, &t_next[y * t_new_width], 1, t_radii[i], w);
+		t_buffer.swap(t_next);
+		w = t_new_width;
+	}
+
+	reference_pass_radii(p_y_radius, t_radii);
+	for (int i = 0; i < 3; i++)
+	{
+		int t_new_height = h + t_radii[i] * 2;
+		std::vector<uint8_t> t_next(t_new_height * w);
+		for (int x = 0; x < w; x++)
+			reference_blur_line(&t_buffer[x], w, &t_next[x], w, t_radii[i], h);
+		t_buffer.swap(t_next);
+		h = t_new_height;
+	}
+
+	return t_buffer;
+}
+
+/* Blurs a random mask with MCGBlurBox and checks every byte against the
+ * reference. The source rows are padded so that the stride differs from the
+ * width. */
+static void check_blur(int p_width, int p_height, SkScalar p_x_radius, SkScalar p_y_radius)
+{
+	SCOPED_TRACE(testing::Message() << p_width << "x" << p_height << " radius " << p_x_radius << "," << p_y_radius);
+
+	int t_stride = p_width + 3;
+	std::vector<uint8_t> t_src(t_stride * p_height);
+	random_mask(t_src);
+
+	SkMask t_mask;
+	t_mask . fBounds . setXYWH(0, 0, p_width, p_height);
+	t_mask . fRowBytes = t_stride;
+	t_mask . fFormat = SkMask::kA8_Format;
+	t_mask . fImage = &t_src[0];
+
+	SkMask t_blurred;
+	ASSERT_TRUE(MCGBlurBox(t_mask, p_x_radius, p_y_radius, 0, 0, t_blurred));
+
+	int t_x_radius = SkScalarCeilToInt(p_x_radius);
+	int t_y_radius = SkScalarCeilToInt(p_y_radius);
+	std::vector<uint8_t> t_expected;
+	t_expected = reference_blur(&t_src[0], t_stride, p_width, p_height, t_x_radius, t_y_radius);
+
+	int t_new_width = p_width + t_x_radius * 2;
+	int t_new_height = p_height + t_y_radius * 2;
+	EXPECT_EQ(t_new_width, t_blurred . fBounds . width());
+	EXPECT_EQ(t_new_height, t_blurred . fBounds . height());
+	EXPECT_EQ(-t_x_radius, t_blurred . fBounds . fLeft);
+	EXPECT_EQ(-t_y_radius, t_blurred . fBounds . fTop);
+
+	if (t_blurred . fBounds . width() == t_new_width &&
+		t_blurred . fBounds . height() == t_new_height)
+	{
+		int t_mismatches = 0;
+		for (int y = 0; y < t_new_height && t_mismatches < 8; y++)
+			for (int x = 0; x < t_new_width && t_mismatches < 8; x++)
+			{
+				uint8_t t_pixel = t_blurred . fImage[y * t_blurred . fRowBytes + x];
+				if (t_pixel != t_expected[y * t_new_width + x])
+				{
+					ADD_FAILURE() << "pixel " << x << "," << y << " is " << int(t_pixel) << ", expected " << int(t_expected[y * t_new_width + x]);
+					t_mismatches++;
+				}
+			}
+	}
+
+	SkMask::FreeImage(t_blurred . fImage);
+}
+
+/* The vector kernels work on 16 columns at a time, so the widths either side
+ * of multiples of 16 check that the scalar tail picks up where they stop. */
+TEST(blur, matches_scalar_kernels)
+{
+	static const int kWidths[] = { 1, 2, 15, 16, 17, 31, 33, 47, 100 };
+	static const int kHeights[] = { 1, 5, 16, 19 };
+	static const int kRadii[][2] = { { 0, 0 }, { 1, 1 }, { 2, 3 }, { 3, 0 }, { 0, 5 }, { 7, 7 }, { 13, 4 }, { 40, 40 } };
+
+	for (size_t w = 0; w < sizeof(kWidths) / sizeof(kWidths[0]); w++)
+		for (size_t h = 0; h < sizeof(kHeights) / sizeof(kHeights[0]); h++)
+			for (size_t r = 0; r < sizeof(kRadii) / sizeof(kRadii[0]); r++)
+			{
+				check_blur(kWidths[w], kHeights[h], kRadii[r][0], kRadii[r][1]);
+				check_blur(kHeights[h], kWidths[w], kRadii[r][1], kRadii[r][0]);
+			}
+}
+
+/* Non-integer radii are rounded up to the next whole radius. */
+TEST(blur, rounds_fractional_radii_up)
+{
+	check_blur(37, 23, 2.5f, 0.25f);
+	check_blur(23, 37, 6.75f, 11.5f);
+}
+
+/* Masks of more than twice kBlurMinBandPixels are split into bands which are
+ * blurred on separate threads, when more than one is available. The widths
+ * leave a final band which is narrower than the others and not a multiple of
+ * 16 columns. */
+TEST(blur, matches_scalar_kernels_across_bands)
+{
+	static const int kSizes[][2] = { { 509, 300 }, { 1023, 97 }, { 97, 1023 }, { 4001, 17 } };
+	static const int kRadii[][2] = { { 2, 2 }, { 9, 30 }, { 31, 1 } };
+
+	for (size_t s = 0; s < sizeof(kSizes) / sizeof(kSizes[0]); s++)
+		for (size_t r = 0; r < sizeof(kRadii) / sizeof(kRadii[0]); r++)
+			check_blur(kSizes[s][0], kSizes[s][1], kRadii[r][0], kRadii[r][1]);
+}
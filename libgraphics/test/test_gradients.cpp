@@ -0,0 +1,409 @@
+/* Copyright (C) 2003-2017 LiveCode Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+#include "gtest/gtest.h"
+
+#include "graphics.h"
+
+#include <math.h>
+#include <vector>
+
+/* The legacy gradients are checked against a copy of the original shader,
+ * which computed the colour of each pixel in turn from its two stops. The
+ * surface is an odd width so that the vector code has a tail to finish. */
+#define kSurfaceWidth 67
+#define kSurfaceHeight 23
+
+#define STOP_DIFF_PRECISION 24
+#define STOP_DIFF_MULT ((1 << STOP_DIFF_PRECISION) * (uint32_t)255)
+#define STOP_INT_PRECISION 16
+#define STOP_INT_MAX ((1 << STOP_INT_PRECISION) - 1)
+#define STOP_INT_MIRROR_MAX ((2 << STOP_INT_PRECISION) - 1)
+#define GRADIENT_AA_SCALE (2)
+#define FP_2PI ((int32_t)(2 * M_PI * (1<<8)))
+#define FP_INV_2PI ((STOP_INT_MAX << 8) / FP_2PI)
+
+#ifdef _LINUX
+static int32_t reference_rint(double p_value)
+{
+	return (int32_t)(p_value + 0.5);
+}
+#else
+static int32_t reference_rint(double p_value)
+{
+	return (int32_t)lrint(p_value);
+}
+#endif
+
+// r_i = (x_i * a) / 255
+static uint32_t packed_scale_bounded(uint32_t x, uint8_t a)
+{
+	uint32_t u, v;
+	
+	u = ((x & 0xff00ff) * a) + 0x800080;
+	u = ((u + ((u >> 8) & 0xff00ff)) >> 8) & 0xff00ff;
+	
+	v = (((x >> 8) & 0xff00ff) * a) + 0x800080;
+	v = (v + ((v >> 8) & 0xff00ff)) & 0xff00ff00;
+	
+	return u | v;
+}
+
+// r_i = (x_i * a + y_i * b) / 255
+static uint32_t packed_bilinear_bounded(uint32_t x, uint8_t a, uint32_t y, uint8_t b)
+{
+	uint32_t u, v;
+	
+	u = (x & 0xff00ff) * a + (y & 0xff00ff) * b + 0x800080;
+	u = ((u + ((u >> 8) & 0xff00ff)) >> 8) & 0xff00ff;
+	
+	v = ((x >> 8) & 0xff00ff) * a + ((y >> 8) & 0xff00ff) * b + 0x800080;
+	v = (v + ((v >> 8) & 0xff00ff)) & 0xff00ff00;
+	
+	return u | v;
+}
+
+struct ReferenceStop
+{
+	int32_t offset;
+	uint32_t hw_color;
+	int32_t difference;
+};
+
+struct ReferenceGradient
+{
+	MCGGradientFunction function;
+	std::vector<ReferenceStop> ramp;
+	bool mirror;
+	bool wrap;
+	uint32_t repeats;
+	int32_t x_coef_a, x_coef_b, x_inc;
+	int32_t y_coef_a, y_coef_b, y_inc;
+};
+
+static int32_t reference_index(const ReferenceGradient& p_gradient, int32_t p_x, int32_t p_y)
+{
+	bool p_mirror = p_gradient . mirror;
+	bool p_wrap = p_gradient . wrap;
+	uint32_t p_repeat = p_gradient . repeats;
+	
+	int32_t t_index = 0;
+	switch(p_gradient . function)
+	{
+		case kMCGGradientFunctionLinear:
+			t_index = p_x;
+			break;
+		case kMCGGradientFunctionSweep:
+		{
+			int32_t t_angle = reference_rint((atan2((double)p_y, p_x) * (1<<8)));
+			if (t_angle < 0)
+				t_angle += FP_2PI;
+			t_index = (t_angle * FP_INV_2PI) >> 8;
+		}
+			break;
+		case kMCGGradientFunctionRadial:
+		{
+			double t_dist = ((double)(p_x)*p_x + (double)(p_y)*p_y);
+			t_index = !p_wrap && t_dist > ((double)STOP_INT_MAX * STOP_INT_MAX) ? STOP_INT_MAX + 1 : reference_rint(sqrt(t_dist));
+		}
+			break;
+		case kMCGLegacyGradientDiamond:
+			t_index = MCMax(MCAbs(p_x), MCAbs(p_y));
+			break;
+		case kMCGLegacyGradientSpiral:
+		{
+			int32_t t_angle = reference_rint((atan2((double)p_y, p_x) * (1<<8)));
+			double t_dist = sqrt((double)(p_x)*p_x + (double)(p_y)*p_y);
+			t_index = reference_rint(t_dist);
+			if (t_angle > 0)
+				t_angle -= FP_2PI;
+			t_index -= (t_angle * FP_INV_2PI) >> 8;
+			t_index %= STOP_INT_MAX;
+		}
+			break;
+		case kMCGLegacyGradientXY:
+		{
+			uint32_t t_x = MCAbs(p_x);  uint32_t t_y = MCAbs(p_y);
+			t_index = (int32_t) ((int64_t)t_x * t_y / STOP_INT_MAX);
+		}
+			break;
+		case kMCGLegacyGradientSqrtXY:
+		{
+			double t_x = MCAbs(p_x);  double t_y = MCAbs(p_y);
+			t_index = reference_rint(sqrt(t_x * t_y));
+		}
+			break;
+	}
+	
+	if (p_mirror)
+	{
+		if (p_wrap)
+		{
+			if (p_repeat > 1)
+				t_index = (t_index * p_repeat);
+			t_index &= STOP_INT_MIRROR_MAX;
+			if (t_index > STOP_INT_MAX)
+			{
+				t_index = STOP_INT_MAX - (t_index & STOP_INT_MAX);
+			}
+		}
+		else
+		{
+			if (t_index >= STOP_INT_MAX)
+			{
+				if ((p_repeat & 1) == 0)
+					t_index = -t_index;
+			}
+			else if (p_repeat > 1 && t_index > 0)
+			{
+				t_index = (t_index * p_repeat);
+				t_index &= STOP_INT_MIRROR_MAX;
+				if (t_index > STOP_INT_MAX)
+				{
+					t_index = STOP_INT_MAX - (t_index & STOP_INT_MAX);
+				}
+			}
+		}
+	}
+	else
+	{
+		if (p_wrap)
+			t_index &= STOP_INT_MAX;
+		if (p_repeat > 1 && t_index > 0 && t_index < STOP_INT_MAX)
+		{
+			t_index = (t_index * p_repeat);
+			t_index &= 0xFFFF;
+		}
+	}
+	return t_index;
+}
+
+/* Computes the unpremultiplied colours of p_count pixels from (p_x, p_y),
+ * stepping by (p_dx, p_dy), walking between the stops as the original shader
+ * did. */
+static void reference_row(const ReferenceGradient& p_gradient, int32_t p_x, int32_t p_y, int32_t p_dx, int32_t p_dy, int32_t p_count, uint32_t *r_colors)
+{
+	const std::vector<ReferenceStop>& t_ramp = p_gradient . ramp;
+	int32_t t_min = t_ramp[0] . offset;
+	int32_t t_max = t_ramp[t_ramp . size() - 1] . offset;
+	uint32_t t_stop_pos = 0;
+	
+	int32_t fx = 0;
+	int32_t t_index = reference_index(p_gradient, p_x, p_y);
+	while (fx < p_count)
+	{
+		while (fx < p_count && t_index <= t_min)
+		{
+			r_colors[fx++] = t_ramp[0] . hw_color;
+			p_x += p_dx, p_y += p_dy;
+			t_index = reference_index(p_gradient, p_x, p_y);
+		}
+		
+		while (fx < p_count && t_index >= t_max)
+		{
+			r_colors[fx++] = t_ramp[t_ramp . size() - 1] . hw_color;
+			p_x += p_dx, p_y += p_dy;
+			t_index = reference_index(p_gradient, p_x, p_y);
+		}
+		
+		while (fx < p_count && t_index >= t_min && t_index <= t_max)
+		{
+			const ReferenceStop& t_current = t_ramp[t_stop_pos];
+			const ReferenceStop& t_next = t_ramp[t_stop_pos + 1];
+			while (fx < p_count && t_next . offset >= t_index && t_current . offset <= t_index)
+			{
+				uint8_t b = ((t_index - t_current . offset) * t_current . difference) >> STOP_DIFF_PRECISION;
+				r_colors[fx++] = packed_bilinear_bounded(t_current . hw_color, 255 - b, t_next . hw_color, b);
+				p_x += p_dx, p_y += p_dy;
+				t_index = reference_index(p_gradient, p_x, p_y);
+			}
+			if (t_current . offset > t_index && t_stop_pos > 0)
+				t_stop_pos -= 1;
+			else if (t_next . offset < t_index && t_stop_pos < t_ramp . size() - 1)
+				t_stop_pos += 1;
+		}
+	}
+}
+
+static uint32_t reference_premultiply(uint32_t p_color)
+{
+	return packed_scale_bounded(p_color | 0xFF000000, p_color >> 24);
+}
+
+/* Renders the gradient as the original shader did, with each span one row of
+ * the surface. */
+static void reference_render(ReferenceGradient p_gradient, bool p_bilinear, uint32_t *r_pixels)
+{
+	if (!p_bilinear)
+	{
+		p_gradient . x_inc += (p_gradient . x_coef_a + p_gradient . x_coef_b) >> 1;
+		p_gradient . y_inc += (p_gradient . y_coef_a + p_gradient . y_coef_b) >> 1;
+		for (int32_t y = 0; y < kSurfaceHeight; y++)
+		{
+			uint32_t *t_row = r_pixels + y * kSurfaceWidth;
+			reference_row(p_gradient, p_gradient . x_inc + p_gradient . x_coef_b * y, p_gradient . y_inc + p_gradient . y_coef_b * y,
+						  p_gradient . x_coef_a, p_gradient . y_coef_a, kSurfaceWidth, t_row);
+			for (int32_t x = 0; x < kSurfaceWidth; x++)
+				t_row[x] = reference_premultiply(t_row[x]);
+		}
+		return;
+	}
+	
+	// The bilinear shader renders two rows at twice the resolution, and
+	// averages each 2x2 block.
+	p_gradient . x_inc += (p_gradient . x_coef_a + p_gradient . x_coef_b) >> 2;
+	p_gradient . y_inc += (p_gradient . y_coef_a + p_gradient . y_coef_b) >> 2;
+	int32_t t_x_a = p_gradient . x_coef_a / GRADIENT_AA_SCALE;
+	int32_t t_x_b = p_gradient . x_coef_b / GRADIENT_AA_SCALE;
+	int32_t t_y_a = p_gradient . y_coef_a / GRADIENT_AA_SCALE;
+	int32_t t_y_b = p_gradient . y_coef_b / GRADIENT_AA_SCALE;
+	uint32_t t_buffer[GRADIENT_AA_SCALE][kSurfaceWidth * GRADIENT_AA_SCALE];
+	for (int32_t y = 0; y < kSurfaceHeight; y++)
+	{
+		int32_t t_x_inc = p_gradient . x_inc + p_gradient . x_coef_b * y;
+		int32_t t_y_inc = p_gradient . y_inc + p_gradient . y_coef_b * y;
+		for (int i = 0; i < GRADIENT_AA_SCALE; i++)
+		{
+			reference_row(p_gradient, t_x_inc, t_y_inc, t_x_a, t_y_a, kSurfaceWidth * GRADIENT_AA_SCALE, t_buffer[i]);
+			t_x_inc += t_x_b;
+			t_y_inc += t_y_b;
+		}
+		
+		for (int32_t x = 0; x < kSurfaceWidth; x++)
+		{
+			uint32_t u = (t_buffer[0][x*2] & 0xFF00FF) + (t_buffer[0][x*2 + 1] & 0xFF00FF) +
+				(t_buffer[1][x*2] & 0xFF00FF) + (t_buffer[1][x*2 + 1] & 0xFF00FF);
+			uint32_t v = ((t_buffer[0][x*2] >> 8) & 0xFF00FF) + ((t_buffer[0][x*2 + 1] >> 8) & 0xFF00FF) +
+				((t_buffer[1][x*2] >> 8) & 0xFF00FF) + ((t_buffer[1][x*2 + 1] >> 8) & 0xFF00FF);
+			u = (u >> 2) & 0xFF00FF;
+			v = (v << 6) & 0xFF00FF00;
+			r_pixels[y * kSurfaceWidth + x] = reference_premultiply(u | v);
+		}
+	}
+}
+
+/* Sets up the stops and the fixed point coefficients in the same way as the
+ * shader, for drawing with the gradient transform alone. */
+static void reference_gradient(MCGGradientFunction p_function, const MCGFloat *p_stops, const MCGColor *p_colors, uindex_t p_length, bool p_mirror, bool p_wrap, uint32_t p_repeats, const MCGAffineTransform& p_transform, ReferenceGradient& r_gradient)
+{
+	r_gradient . function = p_function;
+	r_gradient . mirror = p_mirror;
+	r_gradient . wrap = p_wrap;
+	r_gradient . repeats = p_repeats;
+	
+	r_gradient . ramp . resize(p_length);
+	for (uindex_t i = 0; i < p_length; i++)
+	{
+		ReferenceStop& t_stop = r_gradient . ramp[i];
+		t_stop . offset = (uint32_t) (p_stops[i] * STOP_INT_MAX);
+		t_stop . hw_color = MCGPixelToNative(kMCGPixelFormatBGRA, p_colors[i]);
+		t_stop . difference = (uint32_t) (STOP_DIFF_MULT / STOP_INT_MAX);
+		if (i != 0 && t_stop . offset != r_gradient . ramp[i - 1] . offset)
+			r_gradient . ramp[i - 1] . difference = (uint32_t)(STOP_DIFF_MULT / (t_stop . offset - r_gradient . ramp[i - 1] . offset));
+	}
+	
+	int32_t vx = (int32_t) p_transform . a;
+	int32_t vy = (int32_t) p_transform . b;
+	int32_t wx = (int32_t) p_transform . c;
+	int32_t wy = (int32_t) p_transform . d;
+	int32_t d = vy * wx - vx * wy;
+	int32_t t_origin_x = p_transform . tx;
+	int32_t t_origin_y = p_transform . ty;
+	
+	r_gradient . x_coef_a = STOP_INT_MAX * -wy / d;
+	r_gradient . x_coef_b = STOP_INT_MAX * wx / d;
+	r_gradient . x_inc = (uint32_t) (STOP_INT_MAX * (int64_t)(t_origin_x * wy - t_origin_y * wx) / d);
+	r_gradient . y_coef_a = STOP_INT_MAX * vy / d;
+	r_gradient . y_coef_b = STOP_INT_MAX * -vx / d;
+	r_gradient . y_inc = (uint32_t) (STOP_INT_MAX * -(int64_t)(t_origin_x * vy - t_origin_y * vx) / d);
+}
+
+static void check_gradient(MCGGradientFunction p_function, const MCGFloat *p_stops, const MCGColor *p_colors, uindex_t p_length, bool p_mirror, bool p_wrap, uint32_t p_repeats, const MCGAffineTransform& p_transform, MCGImageFilter p_filter)
+{
+	SCOPED_TRACE(testing::Message() << "function " << p_function << " stops " << p_length << " mirror " << p_mirror << " wrap " << p_wrap << " repeats " << p_repeats << " transform " << p_transform . a << "," << p_transform . b << "," << p_transform . c << "," << p_transform . d << " filter " << p_filter);
+	
+	std::vector<uint32_t> t_pixels(kSurfaceWidth * kSurfaceHeight, 0);
+	MCGContextRef t_context;
+	ASSERT_TRUE(MCGContextCreateWithPixels(kSurfaceWidth, kSurfaceHeight, kSurfaceWidth * sizeof(uint32_t), &t_pixels[0], true, t_context));
+	MCGContextSetShouldAntialias(t_context, false);
+	MCGContextSetFillGradient(t_context, p_function, p_stops, p_colors, p_length, p_mirror, p_wrap, p_repeats, p_transform, p_filter);
+	MCGContextAddRectangle(t_context, MCGRectangleMake(0, 0, kSurfaceWidth, kSurfaceHeight));
+	MCGContextFill(t_context);
+	MCGContextRelease(t_context);
+	
+	ReferenceGradient t_gradient;
+	reference_gradient(p_function, p_stops, p_colors, p_length, p_mirror, p_wrap, p_repeats, p_transform, t_gradient);
+	std::vector<uint32_t> t_expected(kSurfaceWidth * kSurfaceHeight);
+	reference_render(t_gradient, p_filter != kMCGImageFilterNone, &t_expected[0]);
+	
+	int t_mismatches = 0;
+	for (int32_t i = 0; i < kSurfaceWidth * kSurfaceHeight && t_mismatches < 8; i++)
+		if (t_pixels[i] != t_expected[i])
+		{
+			ADD_FAILURE() << "pixel " << i % kSurfaceWidth << "," << i / kSurfaceWidth << " is " << std::hex << t_pixels[i] << ", expected " << t_expected[i] << std::dec;
+			t_mismatches++;
+		}
+}
+
+/* Every gradient function is drawn with the repeats, mirroring and wrapping
+ * on and off, through both the point sampled and the bilinear fillers. The
+ * linear, radial and sweep gradients are only drawn by the legacy shader when
+ * filtered, so are checked with the bilinear filler alone. */
+TEST(gradients, legacy_shader_matches_per_pixel_ramp)
+{
+	static const MCGGradientFunction kFunctions[] =
+	{
+		kMCGGradientFunctionLinear,
+		kMCGGradientFunctionRadial,
+		kMCGGradientFunctionSweep,
+		kMCGLegacyGradientDiamond,
+		kMCGLegacyGradientSpiral,
+		kMCGLegacyGradientXY,
+		kMCGLegacyGradientSqrtXY,
+	};
+	
+	// The second ramp has two stops at the same offset, and translucent
+	// colours which are premultiplied after interpolation.
+	static const MCGFloat kStops[][4] = { { 0.0f, 0.4f, 1.0f }, { 0.1f, 0.5f, 0.5f, 0.8f } };
+	static const MCGColor kColors[][4] =
+	{
+		{ 0xFFFF0000, 0xFF00FF00, 0xFF2040C0 },
+		{ 0x80FF8000, 0x00000000, 0xFFFFFFFF, 0x4020A0E0 },
+	};
+	static const uindex_t kLengths[] = { 3, 4 };
+	
+	static const MCGAffineTransform kTransforms[] =
+	{
+		MCGAffineTransformMake(40, 0, 0, 16, 20, 9),
+		MCGAffineTransformMake(23, 11, -7, 19, 31, -4),
+	};
+	
+	static const uint32_t kRepeats[] = { 1, 3, 4 };
+	static const MCGImageFilter kFilters[] = { kMCGImageFilterNone, kMCGImageFilterLow };
+	
+	for (size_t f = 0; f < sizeof(kFunctions) / sizeof(kFunctions[0]); f++)
+		for (size_t i = 0; i < sizeof(kFilters) / sizeof(kFilters[0]); i++)
+		{
+			if (kFunctions[f] < kMCGLegacyGradientDiamond && kFilters[i] == kMCGImageFilterNone)
+				continue;
+			
+			for (size_t s = 0; s < sizeof(kLengths) / sizeof(kLengths[0]); s++)
+				for (size_t t = 0; t < sizeof(kTransforms) / sizeof(kTransforms[0]); t++)
+					for (size_t r = 0; r < sizeof(kRepeats) / sizeof(kRepeats[0]); r++)
+						for (int m = 0; m < 4; m++)
+							check_gradient(kFunctions[f], kStops[s], kColors[s], kLengths[s], (m & 1) != 0, (m & 2) != 0, kRepeats[r], kTransforms[t], kFilters[i]);
+		}
+}
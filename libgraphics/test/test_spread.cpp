@@ -0,0 +1,122 @@
+/* Copyright (C) 2003-2017 LiveCode Ltd.
+
+This file is part of LiveCode.
+
+LiveCode is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License v3 as published by the Free
+Software Foundation.
+
+LiveCode is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
+
+#include "gtest/gtest.h"
+
+#include "graphics.h"
+#include "graphics-internal.h"
+
+#include <vector>
+
+static uint32_t s_random = 1;
+
+static uint8_t random_byte(void)
+{
+	s_random = s_random * 1103515245 + 12345;
+	return (s_random >> 16) & 0xff;
+}
+
+/* Fills a mask with pixels which are set with the given chance in 256. The
+ * values of the set pixels are random, as any non-zero value counts. */
+static void random_mask(std::vector<uint8_t>& x_mask, uint8_t p_density)
+{
+	for (size_t i = 0; i < x_mask.size(); i++)
+		x_mask[i] = random_byte() < p_density ? 1 + random_byte() % 255 : 0;
+}
+
+/* Returns whether the destination pixel x, y is strictly inside the ellipse
+ * with the given radii of any of the set pixels of the source. */
+static bool reference_spread_pixel(const std::vector<int>& p_set_pixels, int p_x_radius, int p_y_radius, int x, int y)
+{
+	int64_t aa = (int64_t)p_x_radius * p_x_radius;
+	int64_t bb = (int64_t)p_y_radius * p_y_radius;
+	for (size_t i = 0; i < p_set_pixels.size(); i += 2)
+	{
+		int64_t dx = x - p_x_radius - p_set_pixels[i];
+		int64_t dy = y - p_y_radius - p_set_pixels[i + 1];
+		if (bb * dx * dx + aa * dy * dy < aa * bb)
+			return true;
+	}
+	return false;
+}
+
+/* Dilates a random mask and checks every pixel of the transposed result
+ * against a brute force dilation of each set pixel. */
+static void check_spread(int p_width, int p_height, int p_x_radius, int p_y_radius, uint8_t p_density)
+{
+	SCOPED_TRACE(testing::Message() << p_width << "x" << p_height << " radius " << p_x_radius << "," << p_y_radius << " density " << int(p_density));
+
+	int t_stride = p_width + 5;
+	std::vector<uint8_t> t_src(t_stride * p_height);
+	random_mask(t_src, p_density);
+
+	std::vector<int> t_set_pixels;
+	for (int y = 0; y < p_height; y++)
+		for (int x = 0; x < p_width; x++)
+			if (t_src[y * t_stride + x] != 0)
+			{
+				t_set_pixels.push_back(x);
+				t_set_pixels.push_back(y);
+			}
+
+	int t_new_width = p_width + p_x_radius * 2;
+	int t_new_height = p_height + p_y_radius * 2;
+	std::vector<uint8_t> t_dst(t_new_width * t_new_height, 0x5a);
+	std::vector<uint8_t> t_scratch(t_new_width * p_height);
+
+	int t_width, t_height;
+	ASSERT_TRUE(dilateDistanceXY(&t_src[0], t_stride, &t_dst[0], &t_scratch[0], p_x_radius, p_y_radius, p_width, p_height, t_width, t_height));
+	ASSERT_EQ(t_new_width, t_width);
+	ASSERT_EQ(t_new_height, t_height);
+
+	int t_mismatches = 0;
+	for (int x = 0; x < t_new_width && t_mismatches < 8; x++)
+		for (int y = 0; y < t_new_height && t_mismatches < 8; y++)
+		{
+			uint8_t t_expected = reference_spread_pixel(t_set_pixels, p_x_radius, p_y_radius, x, y) ? 255 : 0;
+			uint8_t t_pixel = t_dst[x * t_new_height + y];
+			if (t_pixel != t_expected)
+			{
+				ADD_FAILURE() << "pixel " << x << "," << y << " is " << int(t_pixel) << ", expected " << int(t_expected);
+				t_mismatches++;
+			}
+		}
+}
+
+TEST(spread, matches_brute_force_dilation)
+{
+	static const int kSizes[][2] = { { 1, 1 }, { 1, 9 }, { 9, 1 }, { 7, 5 }, { 16, 16 }, { 17, 13 }, { 33, 31 }, { 45, 3 } };
+	static const int kRadii[][2] = { { 0, 0 }, { 0, 3 }, { 4, 0 }, { 1, 1 }, { 1, 6 }, { 6, 1 }, { 2, 5 }, { 7, 3 }, { 12, 12 }, { 20, 9 } };
+	static const uint8_t kDensities[] = { 0, 8, 64, 200, 255 };
+
+	for (size_t s = 0; s < sizeof(kSizes) / sizeof(kSizes[0]); s++)
+		for (size_t r = 0; r < sizeof(kRadii) / sizeof(kRadii[0]); r++)
+			for (size_t d = 0; d < sizeof(kDensities) / sizeof(kDensities[0]); d++)
+				check_spread(kSizes[s][0], kSizes[s][1], kRadii[r][0], kRadii[r][1], kDensities[d]);
+}
+
+/* The rows and columns are split into bands on separate threads once the
+ * dilated mask has more than kSpreadMinBandPixels, and the radii here are
+ * large enough for the ellipses to reach across the band boundaries. */
+TEST(spread, matches_brute_force_dilation_across_bands)
+{
+	static const int kSizes[][2] = { { 201, 157 }, { 331, 61 } };
+	static const int kRadii[][2] = { { 3, 40 }, { 37, 5 }, { 254, 2 } };
+
+	for (size_t s = 0; s < sizeof(kSizes) / sizeof(kSizes[0]); s++)
+		for (size_t r = 0; r < sizeof(kRadii) / sizeof(kRadii[0]); r++)
+			check_spread(kSizes[s][0], kSizes[s][1], kRadii[r][0], kRadii[r][1], 2);
+}
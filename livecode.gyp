@@ -198,6 +198,7 @@
 			[
 				'libcpptest/libcpptest.gyp:run-test-libcpptest',
 				'libfoundation/libfoundation.gyp:run-test-libFoundation',
+				'libgraphics/libgraphics.gyp:run-test-libGraphics',
 				'engine/kernel-standalone.gyp:run-test-kernel-standalone',
 			],
 
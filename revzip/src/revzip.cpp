@@ -17,15 +17,21 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 #include <map>
 #include <string>
 #include <list>
+#include <vector>
 #include <iostream>
 #include <sstream>
 #include <cstring>
 #include <cstdlib>
+#include <cctype>
+#include <ctime>
 
 #include <fcntl.h>
 #include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include <zip.h>
+#include <zlib.h>
 
 #include <revolution/external.h>
 #include <revolution/support.h>
@@ -37,6 +43,11 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #ifdef _WINDOWS
 #define stricmp _stricmp
+#include <windows.h>
+#include <direct.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
 #endif
 
 #ifdef _LINUX
@@ -51,6 +62,14 @@ along with LiveCode.  If not see <http://www.gnu.org/licenses/>.  */
 
 #define REVZIP_READ_BUFFER_SIZE 8192
 
+// Items are streamed to and from disk through a buffer of this size, so that
+// extraction needs a fixed amount of memory however large the item is.
+#define REVZIP_STREAM_BUFFER_SIZE 65536
+
+// The most threads used to deflate the items added to an archive when it is
+// closed.
+#define REVZIP_MAX_DEFLATE_THREADS 8
+
 typedef std::map<std::string, struct zip *> zipmap_t;
 typedef zipmap_t::iterator zipmap_iterator_t;
 typedef zipmap_t::const_iterator zipmap_const_iterator_t;
@@ -98,6 +117,358 @@ void* imemdup(const void *p_sptr, size_t p_size)
   return t_dptr;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+// Runs p_callback for every index below p_count, sharing the calls between the
+// calling thread and as many short-lived worker threads as there are cores.
+typedef void (*revzip_parallel_callback_t)(void *p_context, unsigned int p_index);
+
+struct revzip_parallel_t
+{
+	revzip_parallel_callback_t callback;
+	void *context;
+	unsigned int count;
+	unsigned int next;
+#ifdef _WINDOWS
+	CRITICAL_SECTION lock;
+#else
+	pthread_mutex_t lock;
+#endif
+};
+
+static void revZipParallelWork(revzip_parallel_t *p_parallel)
+{
+	for(;;)
+	{
+		unsigned int t_index;
+#ifdef _WINDOWS
+		EnterCriticalSection(&p_parallel -> lock);
+		t_index = p_parallel -> next;
+		if (t_index < p_parallel -> count)
+			p_parallel -> next++;
+		LeaveCriticalSection(&p_parallel -> lock);
+#else
+		pthread_mutex_lock(&p_parallel -> lock);
+		t_index = p_parallel -> next;
+		if (t_index < p_parallel -> count)
+			p_parallel -> next++;
+		pthread_mutex_unlock(&p_parallel -> lock);
+#endif
+
+		if (t_index >= p_parallel -> count)
+			break;
+
+		p_parallel -> callback(p_parallel -> context, t_index);
+	}
+}
+
+#ifdef _WINDOWS
+static DWORD WINAPI revZipParallelThread(LPVOID p_context)
+{
+	revZipParallelWork((revzip_parallel_t *)p_context);
+	return 0;
+}
+#else
+static void *revZipParallelThread(void *p_context)
+{
+	revZipParallelWork((revzip_parallel_t *)p_context);
+	return NULL;
+}
+#endif
+
+static unsigned int revZipGetNumberOfCores(void)
+{
+#ifdef _WINDOWS
+	SYSTEM_INFO t_info;
+	GetSystemInfo(&t_info);
+	return t_info . dwNumberOfProcessors;
+#else
+	long t_count;
+	t_count = sysconf(_SC_NPROCESSORS_ONLN);
+	return t_count > 0 ? (unsigned int)t_count : 1;
+#endif
+}
+
+static void revZipParallelFor(unsigned int p_count, revzip_parallel_callback_t p_callback, void *p_context)
+{
+	unsigned int t_thread_count;
+	t_thread_count = revZipGetNumberOfCores();
+	if (t_thread_count > p_count)
+		t_thread_count = p_count;
+	if (t_thread_count > REVZIP_MAX_DEFLATE_THREADS)
+		t_thread_count = REVZIP_MAX_DEFLATE_THREADS;
+
+	if (t_thread_count <= 1)
+	{
+		for(unsigned int i = 0; i < p_count; i++)
+			p_callback(p_context, i);
+		return;
+	}
+
+	revzip_parallel_t t_parallel;
+	t_parallel . callback = p_callback;
+	t_parallel . context = p_context;
+	t_parallel . count = p_count;
+	t_parallel . next = 0;
+
+#ifdef _WINDOWS
+	InitializeCriticalSection(&t_parallel . lock);
+	HANDLE t_threads[REVZIP_MAX_DEFLATE_THREADS];
+#else
+	pthread_mutex_init(&t_parallel . lock, NULL);
+	pthread_t t_threads[REVZIP_MAX_DEFLATE_THREADS];
+#endif
+
+	// If a thread can't be started, the ones that were (and this one) just take
+	// a bigger share of the work.
+	unsigned int t_started;
+	t_started = 0;
+	for(unsigned int i = 1; i < t_thread_count; i++)
+	{
+#ifdef _WINDOWS
+		t_threads[t_started] = CreateThread(NULL, 0, revZipParallelThread, &t_parallel, 0, NULL);
+		if (t_threads[t_started] == NULL)
+			break;
+#else
+		if (pthread_create(&t_threads[t_started], NULL, revZipParallelThread, &t_parallel) != 0)
+			break;
+#endif
+		t_started++;
+	}
+
+	revZipParallelWork(&t_parallel);
+
+	for(unsigned int i = 0; i < t_started; i++)
+	{
+#ifdef _WINDOWS
+		WaitForSingleObject(t_threads[i], INFINITE);
+		CloseHandle(t_threads[i]);
+#else
+		pthread_join(t_threads[i], NULL);
+#endif
+	}
+
+#ifdef _WINDOWS
+	DeleteCriticalSection(&t_parallel . lock);
+#else
+	pthread_mutex_destroy(&t_parallel . lock);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Compressed items added with data are not handed to libzip as plain buffers,
+// as then every one of them would be deflated in turn on the engine thread
+// inside zip_close. Instead they are kept here until the archive is closed,
+// deflated in parallel, and then given to libzip as raw deflated data which it
+// copies into the archive as-is. Should an item fail to deflate, libzip is
+// given the uncompressed data and compresses it itself.
+struct revzip_deferred_item_t
+{
+	struct zip *archive;
+	char *data;
+	size_t length;
+	unsigned char *deflated;
+	size_t deflated_length;
+	unsigned long crc;
+	time_t mtime;
+	size_t offset;
+};
+
+typedef std::list<revzip_deferred_item_t *> deferredlist_t;
+typedef std::map<struct zip *, deferredlist_t> deferredmap_t;
+
+static deferredmap_t s_deferred_items;
+
+static void revZipFreeDeferredItem(revzip_deferred_item_t *p_item)
+{
+	deferredmap_t::iterator t_it;
+	t_it = s_deferred_items.find(p_item -> archive);
+	if (t_it != s_deferred_items.end())
+	{
+		t_it -> second.remove(p_item);
+		if (t_it -> second.empty())
+			s_deferred_items.erase(t_it);
+	}
+
+	if (p_item -> data != NULL)
+		free(p_item -> data);
+	if (p_item -> deflated != NULL)
+		free(p_item -> deflated);
+	free(p_item);
+}
+
+static ssize_t revZipDeferredItemCallback(void *p_state, void *p_data, size_t p_length, enum zip_source_cmd p_command)
+{
+	revzip_deferred_item_t *t_item;
+	t_item = (revzip_deferred_item_t *)p_state;
+
+	switch(p_command)
+	{
+	case ZIP_SOURCE_OPEN:
+		t_item -> offset = 0;
+		return 0;
+
+	case ZIP_SOURCE_READ:
+	{
+		const char *t_bytes;
+		size_t t_available;
+		if (t_item -> deflated != NULL)
+		{
+			t_bytes = (const char *)t_item -> deflated;
+			t_available = t_item -> deflated_length - t_item -> offset;
+		}
+		else
+		{
+			t_bytes = t_item -> data;
+			t_available = t_item -> length - t_item -> offset;
+		}
+
+		if (p_length > t_available)
+			p_length = t_available;
+		if (p_length > 0)
+			memcpy(p_data, t_bytes + t_item -> offset, p_length);
+		t_item -> offset += p_length;
+		return p_length;
+	}
+
+	case ZIP_SOURCE_CLOSE:
+		return 0;
+
+	case ZIP_SOURCE_STAT:
+	{
+		if (p_length < sizeof(struct zip_stat))
+			return -1;
+
+		struct zip_stat *t_stat;
+		t_stat = (struct zip_stat *)p_data;
+		zip_stat_init(t_stat);
+		t_stat -> mtime = t_item -> mtime;
+		t_stat -> size = t_item -> length;
+		if (t_item -> deflated != NULL)
+		{
+			t_stat -> comp_method = ZIP_CM_DEFLATE;
+			t_stat -> comp_size = t_item -> deflated_length;
+			t_stat -> crc = t_item -> crc;
+		}
+		return sizeof(struct zip_stat);
+	}
+
+	case ZIP_SOURCE_ERROR:
+	{
+		if (p_length < sizeof(int) * 2)
+			return -1;
+
+		int *t_error;
+		t_error = (int *)p_data;
+		t_error[0] = ZIP_ER_INTERNAL;
+		t_error[1] = 0;
+		return sizeof(int) * 2;
+	}
+
+	case ZIP_SOURCE_FREE:
+		revZipFreeDeferredItem(t_item);
+		return 0;
+	}
+
+	return -1;
+}
+
+// Creates a source for a compressed item whose data is deflated when the
+// archive is closed. The data is copied, as the engine's buffer is only valid
+// for the duration of the call.
+static struct zip_source *revZipCreateDeferredSource(struct zip *p_archive, const char *p_data, size_t p_length)
+{
+	revzip_deferred_item_t *t_item;
+	t_item = (revzip_deferred_item_t *)calloc(1, sizeof(revzip_deferred_item_t));
+	if (t_item == NULL)
+		return NULL;
+
+	t_item -> archive = p_archive;
+	t_item -> length = p_length;
+	t_item -> mtime = time(NULL);
+	if (p_length > 0)
+	{
+		t_item -> data = (char *)malloc(p_length);
+		if (t_item -> data == NULL)
+		{
+			free(t_item);
+			return NULL;
+		}
+		memcpy(t_item -> data, p_data, p_length);
+	}
+
+	struct zip_source *t_source;
+	t_source = zip_source_function(p_archive, revZipDeferredItemCallback, t_item);
+	if (t_source == NULL)
+	{
+		free(t_item -> data);
+		free(t_item);
+		return NULL;
+	}
+
+	// From here on the item is owned by the source, and freed with it.
+	s_deferred_items[p_archive].push_back(t_item);
+
+	return t_source;
+}
+
+static void revZipDeflateDeferredItem(void *p_context, unsigned int p_index)
+{
+	revzip_deferred_item_t *t_item;
+	t_item = ((revzip_deferred_item_t **)p_context)[p_index];
+
+	// zlib takes 32-bit lengths, so anything larger is left to libzip.
+	if (t_item -> deflated != NULL || t_item -> length > 0x7fffffff)
+		return;
+
+	// These are the settings libzip itself uses, so the archive is the same
+	// as it would have been without deferring.
+	z_stream t_stream;
+	memset(&t_stream, 0, sizeof(z_stream));
+	if (deflateInit2(&t_stream, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+		return;
+
+	uLong t_bound;
+	t_bound = deflateBound(&t_stream, (uLong)t_item -> length);
+
+	unsigned char *t_deflated;
+	t_deflated = (unsigned char *)malloc(t_bound);
+	if (t_deflated != NULL)
+	{
+		t_stream . next_in = (Bytef *)t_item -> data;
+		t_stream . avail_in = (uInt)t_item -> length;
+		t_stream . next_out = t_deflated;
+		t_stream . avail_out = (uInt)t_bound;
+		if (deflate(&t_stream, Z_FINISH) == Z_STREAM_END)
+		{
+			t_item -> crc = crc32(crc32(0, NULL, 0), (const Bytef *)t_item -> data, (uInt)t_item -> length);
+			t_item -> deflated = t_deflated;
+			t_item -> deflated_length = t_stream . total_out;
+
+			// Only the deflated data is needed from now on.
+			free(t_item -> data);
+			t_item -> data = NULL;
+		}
+		else
+			free(t_deflated);
+	}
+
+	deflateEnd(&t_stream);
+}
+
+// Deflates all the deferred items of an archive which is about to be closed.
+static void revZipDeflateDeferredItems(struct zip *p_archive)
+{
+	deferredmap_t::iterator t_it;
+	t_it = s_deferred_items.find(p_archive);
+	if (t_it == s_deferred_items.end())
+		return;
+
+	std::vector<revzip_deferred_item_t *> t_items(t_it -> second.begin(), t_it -> second.end());
+	revZipParallelFor((unsigned int)t_items.size(), revZipDeflateDeferredItem, &t_items[0]);
+}
+
 
 int zip_progress_callback(void *p_context, struct zip *p_archive, const char *p_item, 
 						   int p_type, unsigned long p_item_progress, unsigned long p_item_total, 
@@ -252,6 +623,8 @@ void revZipCloseArchive(char *p_arguments[], int p_argument_count, char **r_resu
 		int t_err;
 		char t_errstr[1024]; 
 
+		revZipDeflateDeferredItems(t_archive);
+
 		s_operation_in_progress = true;
 		s_operation_cancelled = false;
 		t_err = zip_close(t_archive);
@@ -372,9 +745,18 @@ static void revZipAddItemWithDataAndCompression(char *p_arguments[], int p_argum
 		}
 		else
 		{
-			char* t_data = NULL;
-			t_data = (char*) imemdup(mcData.buffer, mcData.length);
-			if (((t_source = zip_source_buffer(t_archive, t_data, mcData.length, 1)) == NULL) ||
+			// Compressed items are deflated in parallel when the archive is
+			// closed, uncompressed ones are just copied.
+			if (p_compressed)
+				t_source = revZipCreateDeferredSource(t_archive, mcData.buffer, mcData.length);
+			else
+			{
+				char* t_data = NULL;
+				t_data = (char*) imemdup(mcData.buffer, mcData.length);
+				t_source = zip_source_buffer(t_archive, t_data, mcData.length, 1);
+			}
+
+			if ((t_source == NULL) ||
 				 (zip_add(t_archive, p_arguments[1], t_source) < 0))
 			{
 				zip_source_free(t_source);
@@ -550,7 +932,10 @@ void revZipExtractItemToVariable(char *p_arguments[], int p_argument_count, char
 	char *t_data = NULL;
 	if (t_result == NULL)
 	{
-		t_data = (char *)malloc(t_stat . size);
+		// The variable takes the whole item, so it has to be read into a single
+		// buffer; at least one byte is asked for so empty items don't look like
+		// a failed allocation.
+		t_data = (char *)malloc(t_stat . size > 0 ? t_stat . size : 1);
 		if (t_data == NULL)
 		{
 			t_result = strdup("ziperr,out of memory");
@@ -578,16 +963,22 @@ void revZipExtractItemToVariable(char *p_arguments[], int p_argument_count, char
 		
 		s_operation_in_progress = true;
 		s_operation_cancelled = false;
-		do
+		while(t_read != t_stat . size && !s_operation_cancelled)
 		{
+			// Read straight into the buffer, a stream buffer's worth at a time
+			// so that cancellation is still noticed promptly.
+			size_t t_to_read;
+			t_to_read = t_stat . size - t_read;
+			if (t_to_read > REVZIP_STREAM_BUFFER_SIZE)
+				t_to_read = REVZIP_STREAM_BUFFER_SIZE;
+
 			ssize_t t_bytes_read;
-			t_bytes_read = zip_fread(t_file, t_data + t_read, REVZIP_READ_BUFFER_SIZE);
+			t_bytes_read = zip_fread(t_file, t_data + t_read, t_to_read);
 			if (t_bytes_read <= 0)
 				break;
 
 			t_read += t_bytes_read;
 		}
-		while(t_read != t_stat . size && !s_operation_cancelled);
 		s_operation_in_progress = false;
 
 		if (s_operation_cancelled)
@@ -640,6 +1031,39 @@ void revZipExtractItemToVariable(char *p_arguments[], int p_argument_count, char
 }
 
 
+// Copies an opened item to a file a buffer at a time, so the memory needed
+// doesn't depend on the size of the item. Stops early if the operation is
+// cancelled, which the caller is left to check. Returns an error to be used as
+// the result, or NULL on success.
+static char *revZipCopyItemToStream(struct zip_file *p_file, FILE *p_stream)
+{
+	char *t_buffer;
+	t_buffer = (char *)malloc(REVZIP_STREAM_BUFFER_SIZE);
+	if (t_buffer == NULL)
+		return strdup("ziperr,out of memory");
+
+	char *t_result;
+	t_result = NULL;
+
+	ssize_t t_read;
+	do
+	{
+		t_read = zip_fread(p_file, t_buffer, REVZIP_STREAM_BUFFER_SIZE);
+		if (t_read > 0)
+		{
+			if (fwrite(t_buffer, t_read, 1, p_stream) != 1)
+				t_result = strdup("ziperr,error while writing file");
+		}
+		else if (t_read == -1)
+			t_result = strdup("ziperr,error while reading zipped data");
+	}
+	while(t_read > 0 && t_result == NULL && !s_operation_cancelled);
+
+	free(t_buffer);
+
+	return t_result;
+}
+
 void revZipExtractItemToFile(char *p_arguments[], int p_argument_count, char **r_result, Bool *r_pass, Bool *r_err)
 {
 	char *t_result = NULL;
@@ -715,34 +1139,14 @@ void revZipExtractItemToFile(char *p_arguments[], int p_argument_count, char **r
 	
 	if (t_result == NULL)
 	{
-		char t_buffer[REVZIP_READ_BUFFER_SIZE];
-		int t_read;
-		t_read = 0;
-		
 		s_operation_in_progress = true;
 		s_operation_cancelled = false;
-		do
-		{
-			t_read = zip_fread(t_file, t_buffer, REVZIP_READ_BUFFER_SIZE);
-			if (t_read > 0)
-			{
-				int t_written;
-				t_written = fwrite(t_buffer, t_read, 1, t_out_stream);
-				if (t_written != 1)
-				{
-					t_result = strdup("ziperr,error while writing file");
-					t_error = False;
-				}
-			}
-			else if (t_read == -1)
-			{
-				t_result = strdup("ziperr,error while reading zipped data");
-				t_error = False;
-			}
-		}
-		while(t_read != 0 && t_result == NULL && !s_operation_cancelled);
+		t_result = revZipCopyItemToStream(t_file, t_out_stream);
 		s_operation_in_progress = false;
 
+		if (t_result != NULL)
+			t_error = False;
+
 		if (s_operation_cancelled)
 		{
 			s_operation_cancelled = false;
@@ -778,6 +1182,272 @@ void revZipExtractItemToFile(char *p_arguments[], int p_argument_count, char **r
 	*r_result = t_result;
 }
 
+// Matches an item name against a pattern in which '*' matches any run of
+// characters and '?' any single character, ignoring case as item lookups do.
+static bool revZipMatchPattern(const char *p_pattern, const char *p_name)
+{
+	const char *t_star;
+	const char *t_resume;
+	t_star = NULL;
+	t_resume = NULL;
+
+	while(*p_name != '\0')
+	{
+		if (*p_pattern == '*')
+		{
+			t_star = ++p_pattern;
+			t_resume = p_name;
+		}
+		else if (*p_pattern == '?' ||
+				 tolower((unsigned char)*p_pattern) == tolower((unsigned char)*p_name))
+		{
+			p_pattern++;
+			p_name++;
+		}
+		else if (t_star != NULL)
+		{
+			p_pattern = t_star;
+			p_name = ++t_resume;
+		}
+		else
+			return false;
+	}
+
+	while(*p_pattern == '*')
+		p_pattern++;
+
+	return *p_pattern == '\0';
+}
+
+// Items may only be extracted below the target folder: absolute names and
+// names with '..' components are refused.
+static bool revZipItemNameIsSafe(const char *p_name)
+{
+	if (*p_name == '/' || *p_name == '\\' || strchr(p_name, ':') != NULL)
+		return false;
+
+	const char *t_component;
+	t_component = p_name;
+	for(;;)
+	{
+		size_t t_length;
+		t_length = strcspn(t_component, "/\\");
+		if (t_length == 2 && t_component[0] == '.' && t_component[1] == '.')
+			return false;
+		if (t_component[t_length] == '\0')
+			break;
+		t_component += t_length + 1;
+	}
+
+	return true;
+}
+
+// Creates all the folders leading up to the last component of p_path, which is
+// a resolved native path.
+static bool revZipCreateFolders(char *p_path)
+{
+	for(char *t_char = p_path + 1; *t_char != '\0'; t_char++)
+	{
+#ifdef _WINDOWS
+		if (*t_char != '/' && *t_char != '\\')
+			continue;
+#else
+		if (*t_char != '/')
+			continue;
+#endif
+
+		char t_separator;
+		t_separator = *t_char;
+		*t_char = '\0';
+
+		int t_status;
+#ifdef _WINDOWS
+		t_status = _mkdir(p_path);
+#else
+		t_status = mkdir(p_path, 0777);
+#endif
+		// Drive roots and existing folders can fail to be created for reasons
+		// other than already existing, so check what's there instead.
+		struct stat t_stat;
+		bool t_exists;
+		t_exists = t_status == 0 || (stat(p_path, &t_stat) == 0 && (t_stat.st_mode & S_IFDIR) != 0);
+
+		*t_char = t_separator;
+
+		if (!t_exists)
+			return false;
+	}
+
+	return true;
+}
+
+// Extracts the item at p_index to p_folder/p_name, creating any folders it is
+// in. Items whose names end with '/' are folders, and are just created.
+static char *revZipExtractItemIntoFolder(struct zip *p_archive, int p_index, const char *p_name, const char *p_folder)
+{
+	std::string t_target;
+	t_target = std::string(p_folder) + "/" + std::string(p_name);
+
+	char *t_out_filename;
+	t_out_filename = utilityProcessPath(t_target.c_str());
+	if (t_out_filename == NULL)
+		return strdup("ziperr,illegal path");
+
+	char *t_result;
+	t_result = NULL;
+
+	if (!revZipCreateFolders(t_out_filename))
+		t_result = strdup("ziperr,unable to create folder");
+
+	size_t t_name_length;
+	t_name_length = strlen(p_name);
+	if (t_result == NULL && t_name_length > 0 && p_name[t_name_length - 1] != '/')
+	{
+		struct zip_file *t_file;
+		t_file = zip_fopen_index(p_archive, p_index, ZIP_FL_UNCHANGED);
+		if (t_file == NULL)
+		{
+			std::string t_outerr = "ziperr," + std::string((zip_strerror(p_archive)));
+			t_result = strdup(t_outerr.c_str());
+		}
+
+		FILE *t_out_stream;
+		t_out_stream = NULL;
+		if (t_result == NULL)
+		{
+			t_out_stream = fopen(t_out_filename, "wb");
+			if (t_out_stream == NULL)
+				t_result = strdup("ziperr,unable to open output file");
+		}
+
+		if (t_result == NULL)
+			t_result = revZipCopyItemToStream(t_file, t_out_stream);
+
+		if (t_out_stream != NULL)
+		{
+			fclose(t_out_stream);
+			if (t_result != NULL || s_operation_cancelled)
+				unlink(t_out_filename);
+		}
+
+		if (t_file != NULL)
+			zip_fclose(t_file);
+	}
+
+	free(t_out_filename);
+
+	return t_result;
+}
+
+// Extracts every item whose name matches the pattern (or every item, if the
+// pattern is empty) into a folder, keeping the folder structure stored in the
+// archive. Doing this in one call saves going back and forth to the engine for
+// each item.
+void revZipExtractItemsToFolder(char *p_arguments[], int p_argument_count, char **r_result, Bool *r_pass, Bool *r_err)
+{
+	char *t_result = NULL;
+	Bool t_error = False;
+
+	if (p_argument_count != 3)
+	{
+		t_result = strdup("ziperr,illegal arguments");
+		t_error = True;
+	}
+
+	char *t_path = NULL;
+	if (t_result == NULL)
+	{
+		t_path = utilityProcessPath(p_arguments[0]);
+		if (t_path == NULL)
+		{
+			t_result = strdup("ziperr,illegal path");
+			t_error = False;
+		}
+	}
+
+	struct zip *t_archive;
+	t_archive = NULL;
+	if (t_result == NULL)
+	{
+		t_archive = find_zip_by_name( t_path );
+		if (!t_archive)
+		{
+			t_result = strdup("ziperr,archive not open");
+			t_error = False;
+		}
+	}
+
+	if (t_result == NULL)
+	{
+		int t_num_files;
+		t_num_files = zip_get_num_files(t_archive);
+
+		s_operation_in_progress = true;
+		s_operation_cancelled = false;
+		for(int i = 0; i < t_num_files && t_result == NULL && !s_operation_cancelled; i++)
+		{
+			struct zip_stat t_stat;
+			if (zip_stat_index(t_archive, i, 0, &t_stat) != 0)
+			{
+				std::string t_outerr = "ziperr," + std::string((zip_strerror(t_archive)));
+				t_result = strdup(t_outerr.c_str());
+				break;
+			}
+
+			// Names are matched and used as paths in UTF-8, in the same way
+			// that revZipEnumerateItems returns them.
+			const char *t_name;
+			int t_success;
+			if (t_stat.bitflags & ZIP_UTF8_FLAG)
+			{
+				t_success = EXTERNAL_SUCCESS;
+				t_name = t_stat.name;
+			}
+			else
+				t_name = ConvertCStringFromNativeToUTF8(t_stat.name, &t_success);
+
+			if (t_success != EXTERNAL_SUCCESS)
+			{
+				t_result = strdup("ziperr,illegal item name");
+				break;
+			}
+
+			if (*p_arguments[1] != '\0' && !revZipMatchPattern(p_arguments[1], t_name))
+				continue;
+
+			if (!revZipItemNameIsSafe(t_name))
+			{
+				t_result = strdup("ziperr,illegal item name");
+				break;
+			}
+
+			t_result = revZipExtractItemIntoFolder(t_archive, i, t_name, p_arguments[2]);
+		}
+		s_operation_in_progress = false;
+
+		if (s_operation_cancelled)
+		{
+			s_operation_cancelled = false;
+			if (t_result != NULL)
+				free(t_result);
+			t_result = strdup("cancelled");
+		}
+	}
+
+	if (t_path != NULL)
+		free(t_path);
+
+	if (t_result == NULL)
+	{
+		t_result = strdup("");
+		t_error = False;
+	}
+
+	*r_pass = False;
+	*r_err = t_error;
+	*r_result = t_result;
+}
+
 void revZipReplaceItemWithFile(char *p_arguments[], int p_argument_count, char **r_result, Bool *r_pass, Bool *r_err)
 {
 	char *t_result = NULL;
@@ -1501,6 +2171,7 @@ EXTERNAL_BEGIN_DECLARATIONS("revZip")
 	EXTERNAL_DECLARE_FUNCTION_UTF8("revZipOpenArchives", revZipOpenArchives)
 	EXTERNAL_DECLARE_COMMAND_UTF8("revZipExtractItemToVariable", revZipExtractItemToVariable)
 	EXTERNAL_DECLARE_COMMAND_UTF8("revZipExtractItemToFile", revZipExtractItemToFile)
+	EXTERNAL_DECLARE_COMMAND_UTF8("revZipExtractItemsToFolder", revZipExtractItemsToFolder)
 	EXTERNAL_DECLARE_COMMAND_UTF8("revZipReplaceItemWithFile", revZipReplaceItemWithFile)
 	EXTERNAL_DECLARE_COMMAND_UTF8("revZipReplaceItemWithData", revZipReplaceItemWithData)
 	EXTERNAL_DECLARE_COMMAND_UTF8("revZipRenameItem", revZipRenameItem)